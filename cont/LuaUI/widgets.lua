@@ -130,6 +130,7 @@ local flexCallIns = {
   'UnitCommand',
   'UnitCmdDone',
   'UnitDamaged',
+  'UnitDamagedBatch',
   'UnitStunned',
   'UnitEnteredRadar',
   'UnitEnteredLos',
@@ -148,6 +149,7 @@ local flexCallIns = {
   'UnitDecloaked',
   'UnitMoveFailed',
   'UnitHarvestStorageFull',
+  'FeatureDamagedBatch',
   'RecvLuaMsg',
   'StockpileChanged',
   'DrawGenesis',
@@ -1913,6 +1915,13 @@ function widgetHandler:UnitDamaged(unitID, unitDefID, unitTeam, damage, paralyze
   return
 end
 
+function widgetHandler:UnitDamagedBatch(count, unitIDs, unitDefIDs, unitTeams, damages, paralyzers, weaponDefIDs, projectileIDs, attackerIDs, attackerDefIDs, attackerTeams)
+  for _,w in ipairs(self.UnitDamagedBatchList) do
+    w:UnitDamagedBatch(count, unitIDs, unitDefIDs, unitTeams, damages, paralyzers, weaponDefIDs, projectileIDs, attackerIDs, attackerDefIDs, attackerTeams)
+  end
+  return
+end
+
 function widgetHandler:UnitStunned(unitID, unitDefID, unitTeam, stunned)
   for _,w in ipairs(self.UnitStunnedList) do
     w:UnitStunned(unitID, unitDefID, unitTeam, stunned)
@@ -2058,6 +2067,14 @@ function widgetHandler:UnitHarvestStorageFull(unitID, unitDefID, unitTeam)
 end
 
 
+function widgetHandler:FeatureDamagedBatch(count, featureIDs, featureDefIDs, featureTeams, damages, weaponDefIDs, projectileIDs, attackerIDs, attackerDefIDs, attackerTeams)
+  for _,w in ipairs(self.FeatureDamagedBatchList) do
+    w:FeatureDamagedBatch(count, featureIDs, featureDefIDs, featureTeams, damages, weaponDefIDs, projectileIDs, attackerIDs, attackerDefIDs, attackerTeams)
+  end
+  return
+end
+
+
 function widgetHandler:RecvLuaMsg(msg, playerID)
   local retval = false
   for _,w in ipairs(self.RecvLuaMsgList) do
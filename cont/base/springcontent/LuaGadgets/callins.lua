@@ -55,6 +55,7 @@ CALLIN_LIST = {
 	"UnitCmdDone",
 	"UnitPreDamaged",
 	"UnitDamaged",
+	"UnitDamagedBatch",
 	"UnitStunned",
 	"UnitTaken",
 	"UnitGiven",
@@ -87,11 +88,13 @@ CALLIN_LIST = {
 	"FeatureCreated",
 	"FeatureDestroyed",
 	"FeatureDamaged",
+	"FeatureDamagedBatch",
 	"FeatureMoved",            -- FIXME: not exposed to Lua yet (as of 95.0)
 	"FeaturePreDamaged",
 
 	-- projectile callins
 	"ProjectileCreated",
+	"ProjectileCreatedBatch",
 	"ProjectileDestroyed",
 
 	-- shield callins
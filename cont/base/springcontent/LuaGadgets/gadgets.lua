@@ -1509,6 +1509,26 @@ function gadgetHandler:UnitDamaged(
   end
 end
 
+function gadgetHandler:UnitDamagedBatch(
+  count,
+  unitIDs,
+  unitDefIDs,
+  unitTeams,
+  damages,
+  paralyzers,
+  weaponDefIDs,
+  projectileIDs,
+  attackerIDs,
+  attackerDefIDs,
+  attackerTeams
+)
+  for _,g in r_ipairs(self.UnitDamagedBatchList) do
+    g:UnitDamagedBatch(count, unitIDs, unitDefIDs, unitTeams,
+                       damages, paralyzers, weaponDefIDs, projectileIDs,
+                       attackerIDs, attackerDefIDs, attackerTeams)
+  end
+end
+
 function gadgetHandler:UnitStunned(unitID, unitDefID, unitTeam, stunned)
   for _,g in r_ipairs(self.UnitStunnedList) do
     g:UnitStunned(unitID, unitDefID, unitTeam, stunned)
@@ -1711,6 +1731,25 @@ function gadgetHandler:FeatureDamaged(
   end
 end
 
+function gadgetHandler:FeatureDamagedBatch(
+  count,
+  featureIDs,
+  featureDefIDs,
+  featureTeams,
+  damages,
+  weaponDefIDs,
+  projectileIDs,
+  attackerIDs,
+  attackerDefIDs,
+  attackerTeams
+)
+  for _,g in r_ipairs(self.FeatureDamagedBatchList) do
+    g:FeatureDamagedBatch(count, featureIDs, featureDefIDs, featureTeams,
+                          damages, weaponDefIDs, projectileIDs,
+                          attackerIDs, attackerDefIDs, attackerTeams)
+  end
+end
+
 function gadgetHandler:FeaturePreDamaged(
   featureID,
   featureDefID,
@@ -1752,6 +1791,12 @@ function gadgetHandler:ProjectileCreated(proID, proOwnerID, proWeaponDefID)
   end
 end
 
+function gadgetHandler:ProjectileCreatedBatch(count, proIDs, proOwnerIDs, proWeaponDefIDs)
+  for _,g in r_ipairs(self.ProjectileCreatedBatchList) do
+    g:ProjectileCreatedBatch(count, proIDs, proOwnerIDs, proWeaponDefIDs)
+  end
+end
+
 function gadgetHandler:ProjectileDestroyed(proID)
   for _,g in r_ipairs(self.ProjectileDestroyedList) do
     g:ProjectileDestroyed(proID)
@@ -73,4 +73,5 @@ void ClientSetup::LoadFromStartScript(const std::string& setup)
 
 	file.GetDef(saveFile, "", "GAME\\SaveFile");
 	file.GetDef(demoFile, "", "GAME\\DemoFile");
+	file.GetDef(demoSeekFrame, "0", "GAME\\DemoSeekFrame");
 }
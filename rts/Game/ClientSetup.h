@@ -19,6 +19,9 @@ public:
 	std::string saveFile;
 	std::string demoFile;
 
+	//! if non-zero, demo playback resumes from the closest snapshot before this frame
+	int demoSeekFrame = 0;
+
 	//! if this client is not the server player, the IP address we connect to
 	//! if this client is the server player, the IP address that other players connect to
 	std::string hostIP;
@@ -116,6 +116,7 @@
 #include "System/SpringMath.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/LoadSave/LoadSaveHandler.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Misc.h"
@@ -207,6 +208,7 @@ CR_REG_METADATA(CGame, (
 
 	CR_MEMBER(speedControl),
 	CR_MEMBER(luaGCControl),
+	CR_IGNORED(luaGCIdleBudget),
 
 	CR_IGNORED(jobDispatcher),
 	CR_IGNORED(curKeyCodeChain),
@@ -250,6 +252,7 @@ CGame::CGame(const std::string& mapFileName, const std::string& modFileName, ILo
 	showSpeed = configHandler->GetBool("ShowSpeed");
 
 	speedControl = configHandler->GetInt("SpeedControl");
+	luaGCIdleBudget = configHandler->GetFloat("LuaGarbageCollectionFrameBudget");
 
 	playerRoster.SetSortTypeByCode((PlayerRoster::SortType)configHandler->GetInt("ShowPlayerInfo"));
 
@@ -452,7 +455,14 @@ void CGame::Load(const std::string& mapFileName)
 			loadscreen->SetLoadMessage("Loading Saved Game");
 			{
 				auto lock = CLoadLock::GetUniqueLock();
+				// demo snapshots store the recording player, keep being the spectator
+				const int myPlayerNum = gu->myPlayerNum;
+
 				saveFileHandler->LoadGame();
+
+				if (gameSetup->hostDemo)
+					gu->SetMyPlayer(myPlayerNum);
+
 				Watchdog::ClearTimer(WDT_LOAD);
 			}
 			LoadLua(false, true);
@@ -1163,6 +1173,8 @@ bool CGame::Update()
 	if (playing && gameServer != nullptr && videoCapturing->AllowRecord())
 		gameServer->CreateNewFrame(false, true);
 
+	const int prevSimFrame = gs->frameNum;
+
 	ENTER_SYNCED_CODE();
 	SendClientProcUsage();
 	ClientReadNet(); // issues new SimFrame()s
@@ -1177,6 +1189,10 @@ bool CGame::Update()
 
 	LEAVE_SYNCED_CODE();
 
+	// no sim-frame this time, catch up on gc work that did not fit into their budget
+	if (luaGCIdleBudget > 0.0f && prevSimFrame == gs->frameNum && !skipping)
+		eventHandler.CollectDeferredGarbage(spring_gettime() + spring_msecs(luaGCIdleBudget));
+
 	{
 		SLuaAllocError error = {};
 
@@ -1741,6 +1757,11 @@ void CGame::SimFrame() {
 			SCOPED_TIMER("Sim::Script");
 			unitScriptEngine->Tick(33);
 		}
+		{
+			// apply terrain changes made by builders and scripts before LOS is updated
+			SCOPED_TIMER("Sim::BasicMapDamage");
+			mapDamage->FlushRecalcAreas();
+		}
 		envResHandler.Update();
 		losHandler->Update();
 		// dead ghosts have to be updated in sim, after los,
@@ -1748,9 +1769,15 @@ void CGame::SimFrame() {
 		// should probably be split from drawer
 		CUnitDrawer::UpdateGhostedBuildings();
 		interceptHandler.Update(false);
+		quadField.Update();
 
 		teamHandler.GameFrame(gs->frameNum);
 		playerHandler.GameFrame(gs->frameNum);
+
+		{
+			SCOPED_TIMER("Sim::BatchedEvents");
+			eventHandler.DeliverBatchedEvents();
+		}
 	}
 
 	lastSimFrameTime = spring_gettime();
@@ -2073,6 +2100,51 @@ void CGame::Save(std::string&& fileName, std::string&& saveArgs)
 	globalSaveFileData.args = std::move(saveArgs);
 }
 
+void CGame::SaveDemoSnapshot()
+{
+	CDemoRecorder* record = clientNet->GetDemoRecorder();
+
+	if (!record->IsValid() || !record->WantSnapshot(gs->frameNum))
+		return;
+
+	SCOPED_TIMER("Game::SaveDemoSnapshot");
+
+	CCregLoadSaveHandler handler;
+	std::string data;
+
+	handler.SaveInfo(gameSetup->mapName, gameSetup->modName);
+
+	if (handler.SaveSnapshot(data))
+		record->SaveSnapshot(gs->frameNum, data);
+}
+
+void CGame::SeekDemo(int toFrame)
+{
+	// the server only asks when there is a snapshot to resume from
+	// (see CGameServer::SkipTo), so restart playback from it
+	if (!gameSetup->hostDemo)
+		return;
+
+	std::string myPlayerName = playerHandler.Player(gu->myPlayerNum)->name;
+	std::ostringstream script;
+
+	// SpringApp::LoadDemoFile appends this again
+	if (myPlayerName.size() > 7 && myPlayerName.compare(myPlayerName.size() - 7, 7, " (spec)") == 0)
+		myPlayerName.resize(myPlayerName.size() - 7);
+
+	script << "[GAME]\n{\n";
+	script << "\tIsHost=1;\n";
+	script << "\tMyPlayerName=" << myPlayerName << ";\n";
+	script << "\tDemoFile=" << gameSetup->demoName << ";\n";
+	script << "\tDemoSeekFrame=" << toFrame << ";\n";
+	script << "}\n";
+
+	LOG("[Game::%s] reloading demo to resume from the closest snapshot before frame %d", __func__, toFrame);
+
+	gameSetup->reloadScript = script.str();
+	gu->globalReload = true;
+}
+
 
 
 
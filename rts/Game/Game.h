@@ -96,6 +96,7 @@ public:
 
 	void StartSkip(int toFrame);
 	void EndSkip();
+	void SeekDemo(int toFrame);
 
 	void ParseInputTextGeometry(const std::string& geo);
 
@@ -142,6 +143,7 @@ private:
 	void UpdateNumQueuedSimFrames();
 	void UpdateNetMessageProcessingTimeLeft();
 	void SimFrame();
+	void SaveDemoSnapshot();
 	void StartPlaying();
 
 public:
@@ -212,6 +214,8 @@ public:
 
 	// 0 := 1/f rate, 1 := 30/s rate
 	int luaGCControl = 0;
+	// msecs per Update spent on gc deferred by sim-frames, see LuaGarbageCollectionFrameBudget
+	float luaGCIdleBudget = 0.0f;
 
 private:
 	JobDispatcher jobDispatcher;
@@ -37,6 +37,7 @@
 #include "Sim/Weapons/Weapon.h"
 #include "System/EventHandler.h"
 #include "System/SpringMath.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/Sound/ISoundChannels.h"
 
 
@@ -361,13 +362,18 @@ void CGameHelper::Explosion(const CExplosionParams& params) {
  * The area as returned by Query is approximate; exact circular filtering
  * should be implemented in the Query object if desired.
  * (It isn't necessary for e.g. GetClosest** methods.)
+ *
+ * Safe to call from pool threads as long as Filter and Query are.
  */
 template<typename TFilter, typename TQuery>
 static inline void QueryUnits(TFilter filter, TQuery& query)
 {
+	const int curThread = ThreadPool::GetThreadNum();
+	const int tempNum = gs->GetMtTempNum(curThread);
+
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = curThread;
 	quadField.GetQuads(qfQuery, query.pos, query.radius);
-	const int tempNum = gs->GetTempNum();
 
 	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) { //FIXME
 		if (!filter.Team(t))
@@ -377,10 +383,10 @@ static inline void QueryUnits(TFilter filter, TQuery& query)
 			const auto& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
 
 			for (CUnit* u: allyTeamUnits) {
-				if (u->tempNum == tempNum)
+				if (u->mtTempNum[curThread] == tempNum)
 					continue;
 
-				u->tempNum = tempNum;
+				u->mtTempNum[curThread] = tempNum;
 
 				if (!filter.Unit(u))
 					continue;
@@ -641,10 +647,12 @@ namespace {
 
 
 
-size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets)
+// [0] := default, [1,2,3,4,5,6] := target is {avoidee, in bad category, crashing, last attacker, paralyzed, outside unboosted range}
+static constexpr float tgtPriorityMults[] = {1.0f, 10.0f, 100.0f, 1000.0f, 0.5f, 4.0f, 100000.0f};
+
+void CGameHelper::GenerateWeaponTargetCandidates(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<SWeaponTargetCandidate>& candidates)
 {
 	const CUnit*  weaponOwner = weapon->owner;
-	const CUnit* lastAttacker = ((weaponOwner->lastAttackFrame + 200) <= gs->frameNum) ? weaponOwner->lastAttacker : nullptr;
 
 	const      WeaponDef* weaponDef = weapon->weaponDef;
 	const DynDamageArray* weaponDmg = weapon->damages;
@@ -668,19 +676,18 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 	// const float scanRadius = weapon->GetRange2D(rangeBoost, (minMapHeight - aimPosHeight) * heightMod);
 	const float scanRadius = baseRange + rangeBoost + (aimPosHeight - minMapHeight) * heightMod;
 
-	// [0] := default, [1,2,3,4,5,6] := target is {avoidee, in bad category, crashing, last attacker, paralyzed, outside unboosted range}
-	constexpr float tgtPriorityMults[] = {1.0f, 10.0f, 100.0f, 1000.0f, 0.5f, 4.0f, 100000.0f};
-
 	const bool paralyzer = (weaponDmg->paralyzeDamageTime != 0);
 
-	// copy on purpose since the below calls lua
+	// may be called from a worker thread, dedup through the per-thread tempNum's
+	const int curThread = ThreadPool::GetThreadNum();
+	const int tempNum = gs->GetMtTempNum(curThread);
+
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = curThread;
 	quadField.GetQuads(qfQuery, ownerPos, scanRadius);
 
-	targets.clear();
-	targets.reserve(32);
-
-	const int tempNum = gs->GetTempNum();
+	candidates.clear();
+	candidates.reserve(32);
 
 	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
 		if (teamHandler.Ally(weaponOwner->allyteam, t))
@@ -690,10 +697,10 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 			const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
 
 			for (CUnit* targetUnit: allyTeamUnits) {
-				if (targetUnit->tempNum == tempNum)
+				if (targetUnit->mtTempNum[curThread] == tempNum)
 					continue;
 
-				targetUnit->tempNum = tempNum;
+				targetUnit->mtTempNum[curThread] = tempNum;
 
 				if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
 					continue;
@@ -729,7 +736,6 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 
 				const float dist2D = math::sqrt(sqDist2D);
 				const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
-				const float damageMul = std::max(0.0001f, weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple);
 
 				targetPriority *= angleMul;
 				targetPriority *= rangeMul;
@@ -740,32 +746,49 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 
 					if (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health))
 						targetPriority *= tgtPriorityMults[5];
-
-					if (weapon->hasTargetWeight)
-						targetPriority *= weapon->TargetWeight(targetUnit);
-
 				} else {
 					targetPriority *= (secDamage + 10000.0f);
 				}
 
-				if (targetLOSState & LOS_PREVLOS) {
-					targetPriority /= (damageMul * targetUnit->power * (0.7f + gsRNG.NextFloat() * 0.6f));
-					targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
-					targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
-					targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
-				}
+				candidates.push_back({targetUnit, targetPriority, targetLOSState});
+			}
+		}
+	}
+}
 
-				const bool allowTarget = eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority);
+size_t CGameHelper::ScoreWeaponTargets(const CWeapon* weapon, const std::vector<SWeaponTargetCandidate>& candidates, std::vector<std::pair<float, CUnit*>>& targets)
+{
+	const CUnit*  weaponOwner = weapon->owner;
+	const CUnit* lastAttacker = ((weaponOwner->lastAttackFrame + 200) <= gs->frameNum) ? weaponOwner->lastAttacker : nullptr;
 
-				// Lua call may have changed tempNum, so needs to be set again
-				targetUnit->tempNum = tempNum;
+	const      WeaponDef* weaponDef = weapon->weaponDef;
+	const DynDamageArray* weaponDmg = weapon->damages;
 
-				if (!allowTarget)
-					continue;
+	targets.clear();
+	targets.reserve(candidates.size());
 
-				targets.emplace_back(targetPriority, targetUnit);
-			}
+	// same order as the candidates were found in, keeps gsRNG draws and callins deterministic
+	for (const SWeaponTargetCandidate& candidate: candidates) {
+		CUnit* targetUnit = candidate.unit;
+
+		float targetPriority = candidate.priority;
+
+		if ((candidate.losStatus & LOS_INLOS) && weapon->hasTargetWeight)
+			targetPriority *= weapon->TargetWeight(targetUnit);
+
+		if (candidate.losStatus & LOS_PREVLOS) {
+			const float damageMul = std::max(0.0001f, weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple);
+
+			targetPriority /= (damageMul * targetUnit->power * (0.7f + gsRNG.NextFloat() * 0.6f));
+			targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
+			targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
+			targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
 		}
+
+		if (!eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority))
+			continue;
+
+		targets.emplace_back(targetPriority, targetUnit);
 	}
 
 	std::stable_sort(targets.begin(), targets.end(), [](const std::pair<float, CUnit*>& a, const std::pair<float, CUnit*>& b) { return (a.first < b.first); });
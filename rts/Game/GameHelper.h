@@ -6,6 +6,7 @@
 #include "Sim/Misc/DamageArray.h"
 #include "Sim/Projectiles/ExplosionListener.h"
 #include "Sim/Units/CommandAI/Command.h"
+#include "Sim/Weapons/WeaponTarget.h"
 #include "System/float3.h"
 #include "System/float4.h"
 #include "System/type2.h"
@@ -142,7 +143,10 @@ public:
 		bool synced = false
 	);
 
-	static size_t GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets);
+	/// read-only part of target generation, may run for different weapons concurrently
+	static void GenerateWeaponTargetCandidates(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<SWeaponTargetCandidate>& candidates);
+	/// serial part; applies script weights, synced randomness and Lua filtering, then sorts
+	static size_t ScoreWeaponTargets(const CWeapon* weapon, const std::vector<SWeaponTargetCandidate>& candidates, std::vector<std::pair<float, CUnit*>>& targets);
 
 	void Init();
 	void Update();
@@ -200,7 +204,8 @@ private:
 
 public:
 	std::vector<int> targetUnitIDs; // GetEnemyUnits{NoLosTest}
-	std::vector<std::pair<float, CUnit*>> targetPairs; // GenerateWeaponTargets
+	std::vector<std::pair<float, CUnit*>> targetPairs; // ScoreWeaponTargets
+	std::vector<SWeaponTargetCandidate> targetCandidates; // GenerateWeaponTargetCandidates
 };
 
 extern CGameHelper* helper;
@@ -42,6 +42,7 @@
 #include "System/FileSystem/VFSHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/LoadSave/DemoReader.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
 #include "System/LoadSave/LoadSaveHandler.h"
 #include "System/Log/ILog.h"
 #include "System/Net/RawPacket.h"
@@ -58,6 +59,7 @@
 
 
 CONFIG(bool, DemoFromDemo).defaultValue(false).description("Enable recording a demo while playing back a demo.");
+CONFIG(int, DemoSnapshotInterval).defaultValue(0).minimumValue(0).description("Seconds of game-time between game-state snapshots embedded in recorded demos, which allow skipping ahead during playback without simulating every frame. Each snapshot briefly stalls the game while it is taken. 0 disables snapshots.");
 CONFIG(bool, LoadBadSaves).defaultValue(false);
 
 static char mapChecksumMsgBuf[1024] = {0};
@@ -494,6 +496,9 @@ void CPreGame::ReadDataFromDemo(const std::string& demoName)
 		assert(gameData->GetSetupText() == scanner.GetSetupScript());
 
 		if (CGameSetup::LoadReceivedScript(gameData->GetSetupText(), true)) {
+			if (clientSetup->demoSeekFrame > 0)
+				LoadDemoSnapshot(scanner, demoName);
+
 			StartServerForDemo(demoName);
 		} else {
 			throw content_error("Demo contains incorrect script");
@@ -503,6 +508,29 @@ void CPreGame::ReadDataFromDemo(const std::string& demoName)
 	assert(gameServer != nullptr);
 }
 
+void CPreGame::LoadDemoSnapshot(CDemoReader& scanner, const std::string& demoName)
+{
+	// the server picks the same snapshot and continues the stream from there
+	const int snapshotNum = scanner.FindSnapshot(0, clientSetup->demoSeekFrame);
+
+	if (snapshotNum < 0)
+		return;
+
+	std::string snapshotData;
+	CCregLoadSaveHandler* snapshotHandler = new CCregLoadSaveHandler();
+
+	if (scanner.ReadSnapshot(snapshotNum, snapshotData) && snapshotHandler->LoadSnapshotStartInfo(demoName, snapshotData)) {
+		LOG("[PreGame::%s] resuming demo from snapshot at frame %d", __func__, (scanner.GetSnapshots())[snapshotNum].frameNum);
+		saveFileHandler = snapshotHandler;
+		return;
+	}
+
+	LOG_L(L_WARNING, "[PreGame::%s] unusable snapshot at frame %d, playing demo from the start", __func__, (scanner.GetSnapshots())[snapshotNum].frameNum);
+	delete snapshotHandler;
+
+	clientSetup->demoSeekFrame = 0;
+}
+
 void CPreGame::GameDataReceived(std::shared_ptr<const netcode::RawPacket> packet)
 {
 	SCOPED_ONCE_TIMER("PreGame::GameDataReceived");
@@ -607,6 +635,10 @@ void CPreGame::GameDataReceived(std::shared_ptr<const netcode::RawPacket> packet
 		recorder.WriteSetupText(gameData->GetSetupText());
 		recorder.SaveToDemo(packet->data, packet->length, clientNet->GetPacketTime(gs->frameNum));
 
+		// demo playback has its snapshots in the original, and may itself start from one
+		if (!gameSetup->hostDemo)
+			recorder.SetSnapshotInterval(configHandler->GetInt("DemoSnapshotInterval") * GAME_SPEED);
+
 		assert(!clientNet->GetDemoRecorder()->IsValid());
 		clientNet->SetDemoRecorder(std::move(recorder));
 		assert(clientNet->GetDemoRecorder()->IsValid());
@@ -540,7 +540,13 @@ public:
 	}
 
 	bool Execute(const SyncedAction& action) const final {
-		if (action.GetArgs().find_first_of("start") == 0) {
+		if (action.GetArgs().compare(0, 5, "seek ") == 0) {
+			std::istringstream buf(action.GetArgs().substr(5));
+			int targetFrame;
+			buf >> targetFrame;
+			game->SeekDemo(targetFrame);
+		}
+		else if (action.GetArgs().find_first_of("start") == 0) {
 			std::istringstream buf(action.GetArgs().substr(6));
 			int targetFrame;
 			buf >> targetFrame;
@@ -90,10 +90,14 @@
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/Misc/ModInfo.h"
+#include "Sim/Misc/QuadField.h"
 #include "Sim/Projectiles/ProjectileHandler.h"
 #include "Sim/Units/UnitDef.h"
 #include "Sim/Units/UnitDefHandler.h"
 #include "Sim/Units/UnitHandler.h"
+#include "Sim/Units/Scripts/CobEngine.h"
+#include "Sim/Units/Scripts/CobFile.h"
+#include "Sim/Units/Scripts/CobFileHandler.h"
 #include "Sim/Units/CommandAI/CommandDescription.h"
 
 #include "System/EventHandler.h"
@@ -1762,6 +1766,130 @@ public:
 
 
 
+class QuadFieldStatsActionExecutor : public IUnsyncedActionExecutor {
+public:
+	QuadFieldStatsActionExecutor() : IUnsyncedActionExecutor(
+		"QuadFieldStats",
+		"Logs the quad-field occupancy and query counts, pass \"start\" or \"stop\" to toggle query counting or \"reset\" to restart it"
+	) {
+	}
+
+	bool Execute(const UnsyncedAction& action) const final {
+		const std::string& args = action.GetArgs();
+
+		if (args == "start" || args == "stop") {
+			quadField.SetCountQueries(args == "start");
+			LOG("[QuadFieldStats] query counting %s", quadField.IsCountingQueries()? "enabled": "disabled");
+			return true;
+		}
+
+		const CQuadField::Stats stats = quadField.GetStats();
+
+		LOG("[QuadFieldStats] quads=%dx%d size=%dx%d occupied=%d avgUnits=%.2f maxUnits=%d maxFeatures=%d maxProjectiles=%d",
+			quadField.GetNumQuadsX(), quadField.GetNumQuadsZ(),
+			quadField.GetQuadSizeX(), quadField.GetQuadSizeZ(),
+			stats.numOccupiedQuads, stats.avgUnits,
+			stats.maxUnits, stats.maxFeatures, stats.maxProjectiles
+		);
+
+		for (size_t i = 0; i < stats.unitHistogram.size(); i++) {
+			if (stats.unitHistogram[i] == 0)
+				continue;
+
+			LOG("\tquads with %d+ units: %d", (i == 0)? 0: (1 << (i - 1)), stats.unitHistogram[i]);
+		}
+
+		for (int i = 0; i < CQuadField::QUERY_COUNT; i++) {
+			const CQuadField::QueryCounter& qc = stats.queryCounters[i];
+
+			if (qc.numCalls == 0)
+				continue;
+
+			LOG("\t%s: calls=%lu candidates/call=%.1f results/call=%.1f",
+				CQuadField::GetQueryName(CQuadField::QueryType(i)),
+				static_cast<unsigned long>(qc.numCalls),
+				qc.numCandidates / double(qc.numCalls),
+				qc.numResults / double(qc.numCalls)
+			);
+		}
+
+		if (!quadField.IsCountingQueries())
+			LOG("\tquery counting disabled, pass \"start\" to enable it");
+
+		if (args == "reset")
+			quadField.ResetQueryCounters();
+
+		return true;
+	}
+};
+
+
+
+class CobProfileActionExecutor : public IUnsyncedActionExecutor {
+public:
+	CobProfileActionExecutor() : IUnsyncedActionExecutor(
+		"CobProfile",
+		"Pass \"start\" or \"stop\" to toggle per-function COB script counters, \"reset\" to clear them, or nothing to log the most expensive functions"
+	) {
+	}
+
+	bool Execute(const UnsyncedAction& action) const final {
+		const std::string& args = action.GetArgs();
+
+		if (args == "start" || args == "stop") {
+			cobEngine->SetProfiling(args == "start");
+			LOG("[CobProfile] profiling %s", cobEngine->IsProfiling()? "enabled": "disabled");
+			return true;
+		}
+
+		if (args == "reset") {
+			for (CCobFile& cobFile: cobFileHandler->GetCobFiles()) {
+				cobFile.ResetFunctionStats();
+			}
+
+			return true;
+		}
+
+		struct Entry {
+			const CCobFile* file;
+			size_t funcID;
+		};
+
+		std::vector<Entry> entries;
+
+		for (const CCobFile& cobFile: cobFileHandler->GetCobFiles()) {
+			for (size_t i = 0; i < cobFile.functionStats.size(); i++) {
+				if (cobFile.functionStats[i].numCalls == 0 && cobFile.functionStats[i].numInstrs == 0)
+					continue;
+
+				entries.push_back({&cobFile, i});
+			}
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+			return (a.file->functionStats[a.funcID].execTime > b.file->functionStats[b.funcID].execTime);
+		});
+
+		LOG("[CobProfile] %u functions executed%s", static_cast<unsigned int>(entries.size()), cobEngine->IsProfiling()? "": " (profiling disabled)");
+
+		for (size_t i = 0, n = std::min(entries.size(), size_t(25)); i < n; i++) {
+			const CCobFile* file = entries[i].file;
+			const CCobFile::FunctionStats& stats = file->functionStats[entries[i].funcID];
+
+			LOG("\t%s:%s calls=%lu instrs=%lu time=%.3fms",
+				file->name.c_str(), file->scriptNames[entries[i].funcID].c_str(),
+				static_cast<unsigned long>(stats.numCalls),
+				static_cast<unsigned long>(stats.numInstrs),
+				stats.execTime * 1e-6
+			);
+		}
+
+		return true;
+	}
+};
+
+
+
 class HideInterfaceActionExecutor : public IUnsyncedActionExecutor {
 public:
 	HideInterfaceActionExecutor() : IUnsyncedActionExecutor("HideInterface", "Hide/Show the GUI controlls") {
@@ -3913,6 +4041,8 @@ void UnsyncedGameCommands::AddDefaultActionExecutors()
 	AddActionExecutor(AllocActionExecutor<NetMsgSmoothingActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<SpeedControlActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<GameInfoActionExecutor>());
+	AddActionExecutor(AllocActionExecutor<QuadFieldStatsActionExecutor>());
+	AddActionExecutor(AllocActionExecutor<CobProfileActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<HideInterfaceActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<HardwareCursorActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<FullscreenActionExecutor>());
@@ -15,6 +15,8 @@ struct SLuaAllocState {
 	std::atomic<uint64_t> numLuaAllocs;
 	std::atomic<uint64_t> luaAllocTime;
 	std::atomic<uint64_t> numLuaStates;
+	// cumulative, never decreases; used to derive allocation rates
+	std::atomic<uint64_t> grossAllocBytes;
 };
 
 #endif
@@ -4,12 +4,19 @@
 #define LUA_CALL_IN_CHECK_H
 
 #include "System/TimeProfiler.h"
+#include "LuaContextData.h"
 #include "LuaUtils.h"
 
+// blocks the main thread until the threaded Update (if any) of L's handle has
+// returned; call-ins must not enter a state that is running on a worker
+void WaitForThreadedLuaUpdate(const lua_State* L);
+
+#define LUA_CALL_IN_WAIT(L) if (GetLuaContextData(L)->threadedUpdate) { WaitForThreadedLuaUpdate(L); }
+
 #if DEBUG_LUA
-#  define LUA_CALL_IN_CHECK_NAMED(L, name, ...) SCOPED_SPECIAL_TIMER_NOREG(name); LuaUtils::ScopedStackChecker ciCheck((L));
+#  define LUA_CALL_IN_CHECK_NAMED(L, name, ...) LUA_CALL_IN_WAIT((L)); SCOPED_SPECIAL_TIMER_NOREG(name); LuaUtils::ScopedStackChecker ciCheck((L));
 #else
-#  define LUA_CALL_IN_CHECK_NAMED(L, name, ...) SCOPED_SPECIAL_TIMER_NOREG(name);
+#  define LUA_CALL_IN_CHECK_NAMED(L, name, ...) LUA_CALL_IN_WAIT((L)); SCOPED_SPECIAL_TIMER_NOREG(name);
 #endif
 
 #define LUA_CALL_IN_CHECK(L, ...) LUA_CALL_IN_CHECK_NAMED(L, (GetLuaContextData(L)->synced)? "Lua::Callins::Synced": "Lua::Callins::Unsynced", __VA_ARGS__);
@@ -36,6 +36,7 @@ public:
 	, synced(false)
 	, allowChanges(false)
 	, drawingEnabled(false)
+	, threadedUpdate(false)
 
 	, running(0)
 
@@ -47,7 +48,7 @@ public:
 	, readAllyTeam(0)
 	, selectTeam(CEventClient::NoAccessTeam)
 
-	, allocState{{0}, {0}, {0}, {0}}
+	, allocState{{0}, {0}, {0}, {0}, {0}}
 	{}
 
 	~luaContextData() {
@@ -86,6 +87,8 @@ public:
 	bool synced;
 	bool allowChanges;
 	bool drawingEnabled;
+	// true if the owner's Update runs on a worker thread, see CLuaHandle::AllowConcurrentUpdate
+	bool threadedUpdate;
 
 	// greater than 0 if currently running a callin; 0 if not
 	int running;
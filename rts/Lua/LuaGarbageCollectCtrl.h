@@ -3,6 +3,7 @@
 #ifndef SPRING_LUA_GARBAGE_COLLECT_CTRL_H
 #define SPRING_LUA_GARBAGE_COLLECT_CTRL_H
 
+#include <cstdint>
 #include <limits>
 
 struct SLuaGarbageCollectCtrl {
@@ -20,6 +21,29 @@ struct SLuaGarbageCollectCtrl {
 
 	float baseRunTimeMult = 0.0f;
 	float baseMemLoadMult = 0.0f;
+
+	// runtime budget of a non-forced CollectGarbage call for all
+	// handles together, in milliseconds (0 disables the budget)
+	// each handle gets the part matching its allocation share
+	float frameBudget = 0.0f;
+	// fraction of the global allocation limit beyond which full
+	// cycles are run regardless of the budget
+	float memPressure = 1.0f;
+	// another full cycle is only forced after usage fell below
+	// (memPressure - memPressureHysteresis) or once this many
+	// CollectGarbage calls passed, live data alone can exceed
+	// memPressure and must not cause a full cycle every frame
+	float memPressureHysteresis = 0.1f;
+	int memPressureInterval = 300;
+	int memPressureWaitCalls = 0;
+
+	// smoothed fraction of all Lua allocations made by this handle
+	float allocShare = 0.0f;
+	// runtime that did not fit in the budget, paid off when idle
+	float deferredRunTime = 0.0f;
+
+	uint64_t prevHandleAllocBytes = 0;
+	uint64_t prevTotalAllocBytes = 0;
 };
 
 #endif
@@ -30,6 +30,7 @@
 #include "Sim/Features/FeatureDef.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
+#include "Sim/Units/UnitHandler.h"
 #include "Sim/Weapons/Weapon.h"
 #include "Sim/Weapons/WeaponDef.h"
 #include "System/creg/SerializeLuaState.h"
@@ -43,6 +44,7 @@
 #include "System/Log/ILog.h"
 #include "System/Input/KeyInput.h"
 #include "System/Platform/SDL1_keysym.h"
+#include "System/Platform/Threading.h"
 
 #include "LuaInclude.h"
 
@@ -54,11 +56,15 @@
 #include <tracy/TracyLua.hpp>
 
 #include <algorithm>
+#include <cstring>
 #include <string>
 
 
 CONFIG(float, LuaGarbageCollectionMemLoadMult).defaultValue(1.33f).minimumValue(1.0f).maximumValue(100.0f).description("How much the amount of Lua memory in use increases the rate of garbage collection.");
 CONFIG(float, LuaGarbageCollectionRunTimeMult).defaultValue(5.0f).minimumValue(1.0f).description("How many milliseconds the garbage collected can run for in each GC cycle");
+CONFIG(float, LuaGarbageCollectionFrameBudget).defaultValue(0.0f).minimumValue(0.0f).maximumValue(100.0f).description("Milliseconds all Lua states together may spend on garbage collection per sim-frame, split by their allocation rates. Work that does not fit is done between draw-frames when no sim-frame ran. 0 disables the budget.");
+CONFIG(bool, LuaThreadedUIUpdate).defaultValue(false).description("Allow LuaUI and LuaMenu to run their Update call-in on a worker thread, concurrently with the other Lua handles (experimental). A handle has to request this via Script.SetThreadedUpdate, and may then only read engine state from Update: control, GL, VFS, cross-handle and some render and pathing callouts raise an error there.");
+CONFIG(float, LuaGarbageCollectionMemPressure).defaultValue(0.8f).minimumValue(0.1f).maximumValue(1.0f).description("Fraction of the Lua memory limit beyond which budgeted garbage collection runs full cycles.");
 
 
 static spring::unsynced_set<const luaContextData*>    SYNCED_LUAHANDLE_CONTEXTS;
@@ -123,13 +129,18 @@ CLuaHandle::CLuaHandle(const string& _name, int _order, bool _userMode, bool _sy
 	// do not use it for LuaMenu either; too many blocks allocated
 	// by *other* states end up not being recycled which presently
 	// forces clearing the shared pool on reload
-	, D(_name != "LuaIntro" && name != "LuaMenu", true)
+	// LuaUI has its own so reloading it returns all its slabs at once
+	// (pools are not locked, each is only used by the thread running
+	// the states that allocate from it)
+	, D(_order < LUA_HANDLE_ORDER_UI, true)
 {
 	D.owner = this;
 	D.synced = _synced;
 
 	D.gcCtrl.baseMemLoadMult = configHandler->GetFloat("LuaGarbageCollectionMemLoadMult");
 	D.gcCtrl.baseRunTimeMult = configHandler->GetFloat("LuaGarbageCollectionRunTimeMult");
+	D.gcCtrl.frameBudget = configHandler->GetFloat("LuaGarbageCollectionFrameBudget");
+	D.gcCtrl.memPressure = configHandler->GetFloat("LuaGarbageCollectionMemPressure");
 
 	L = LUA_OPEN(&D);
 	L_GC = lua_newthread(L);
@@ -162,7 +173,10 @@ CLuaHandle::~CLuaHandle()
 void CLuaHandle::KillLua(bool inFreeHandler)
 {
 	// 1. unlink from eventHandler, so no new events are getting triggered
-	//FIXME when multithreaded lua is enabled, wait for all running events to finish (possible via a mutex?)
+	// (after a threaded Update of this handle, if any, has returned)
+	if (IsValid())
+		WaitForThreadedLuaUpdate(L);
+
 	eventHandler.RemoveClient(this);
 
 	if (!IsValid())
@@ -233,6 +247,101 @@ bool CLuaHandle::AddEntriesToTable(lua_State* L, const char* name,
 }
 
 
+static bool ThreadedUIUpdateEnabled() { return (configHandler->GetBool("LuaThreadedUIUpdate")); }
+
+// callouts in otherwise main-thread only tables that are safe from any thread
+static bool IsThreadSafeCallOut(const char* name)
+{
+	return (strcmp(name, "Echo") == 0 || strcmp(name, "Log") == 0);
+}
+
+// replaces the function at the top of the stack by a wrapper closure
+static void PushMainThreadCallOut(lua_State* L, const char* name, lua_CFunction wrapper)
+{
+	lua_pushstring(L, name);
+	lua_pushcclosure(L, wrapper, 2);
+}
+
+bool CLuaHandle::AddMainThreadEntriesToTable(lua_State* L, const char* name,
+                                             bool (*entriesFunc)(lua_State*))
+{
+	if (!ThreadedUIUpdateEnabled())
+		return AddEntriesToTable(L, name, entriesFunc);
+
+	// collect the entries separately so only these get wrapped
+	const int top = lua_gettop(L);
+	lua_newtable(L);
+
+	if (!entriesFunc(L)) {
+		lua_settop(L, top);
+		return false;
+	}
+
+	lua_pushstring(L, name);
+	lua_rawget(L, top);
+
+	if (!lua_istable(L, -1)) {
+		lua_pop(L, 1);
+		lua_newtable(L);
+		lua_pushstring(L, name);
+		lua_pushvalue(L, -2);
+		lua_rawset(L, top);
+	}
+
+	for (lua_pushnil(L); lua_next(L, top + 1) != 0; lua_pop(L, 1)) {
+		lua_pushvalue(L, -2); // key
+		lua_pushvalue(L, -2); // value
+
+		if (lua_isstring(L, -2) && lua_iscfunction(L, -1) && !IsThreadSafeCallOut(lua_tostring(L, -2)))
+			PushMainThreadCallOut(L, lua_tostring(L, -2), CallOutMainThreadOnly);
+
+		lua_rawset(L, top + 2);
+	}
+
+	lua_settop(L, top);
+	return true;
+}
+
+bool CLuaHandle::WrapMainThreadEntries(lua_State* L, std::initializer_list<const char*> names)
+{
+	if (!ThreadedUIUpdateEnabled())
+		return true;
+
+	for (const char* name: names) {
+		lua_pushstring(L, name);
+		lua_rawget(L, -2);
+
+		// not every handle has all of them
+		if (!lua_iscfunction(L, -1)) {
+			lua_pop(L, 1);
+			continue;
+		}
+
+		PushMainThreadCallOut(L, name, CallOutNotThreaded);
+		lua_pushstring(L, name);
+		lua_insert(L, -2);
+		lua_rawset(L, -3);
+	}
+
+	return true;
+}
+
+
+/******************************************************************************/
+/******************************************************************************/
+
+void WaitForThreadedLuaUpdate(const lua_State* L)
+{
+	// nothing to wait for on the thread running the Update itself
+	if (!Threading::IsMainThread())
+		return;
+	if (!eventHandler.IsUpdatingConcurrently(GetLuaContextData(L)->owner))
+		return;
+
+	eventHandler.WaitForConcurrentUpdates();
+}
+
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -251,6 +360,8 @@ void CLuaHandle::CheckStack()
 
 int CLuaHandle::XCall(lua_State* srcState, const char* funcName)
 {
+	WaitForThreadedLuaUpdate(L);
+
 	const int top = lua_gettop(L);
 
 	// push the function
@@ -1245,6 +1356,119 @@ void CLuaHandle::UnitDamaged(
 	RunCallInTraceback(L, cmdStr, argCount, 0, traceBack.GetErrFuncIdx(), false);
 }
 
+// entries of the current batch readable by the receiving handle
+static std::vector<int> batchIndices;
+
+template<typename T>
+static void PushBatchColumn(lua_State* L, const std::vector<T>& column)
+{
+	lua_createtable(L, batchIndices.size(), 0);
+
+	for (size_t i = 0; i < batchIndices.size(); i++) {
+		lua_pushnumber(L, column[ batchIndices[i] ]);
+		lua_rawseti(L, -2, i + 1);
+	}
+}
+
+static void PushBatchFlags(lua_State* L, const std::vector<uint8_t>& column)
+{
+	lua_createtable(L, batchIndices.size(), 0);
+
+	for (size_t i = 0; i < batchIndices.size(); i++) {
+		lua_pushboolean(L, column[ batchIndices[i] ]);
+		lua_rawseti(L, -2, i + 1);
+	}
+}
+
+// attackers are resolved at delivery time, the same visibility
+// rules as for PushAttackerInfo apply but hidden (or since then
+// removed) attackers are reported as -1 to keep the arrays dense
+static void PushBatchAttackers(lua_State* L, const std::vector<int>& attackerIDs)
+{
+	lua_createtable(L, batchIndices.size(), 0);
+	lua_createtable(L, batchIndices.size(), 0);
+	lua_createtable(L, batchIndices.size(), 0);
+
+	for (size_t i = 0; i < batchIndices.size(); i++) {
+		const int attackerID = attackerIDs[ batchIndices[i] ];
+		const CUnit* attacker = (attackerID >= 0)? unitHandler.GetUnit(attackerID): nullptr;
+
+		int attackerDefID = -1;
+		int attackerTeam = -1;
+
+		if (attacker == nullptr || !LuaUtils::IsUnitVisible(L, attacker)) {
+			attacker = nullptr;
+		} else {
+			attackerTeam = attacker->team;
+
+			if (LuaUtils::IsUnitTyped(L, attacker))
+				attackerDefID = LuaUtils::EffectiveUnitDef(L, attacker)->id;
+		}
+
+		lua_pushnumber(L, (attacker != nullptr)? attacker->id: -1);
+		lua_rawseti(L, -4, i + 1);
+		lua_pushnumber(L, attackerDefID);
+		lua_rawseti(L, -3, i + 1);
+		lua_pushnumber(L, attackerTeam);
+		lua_rawseti(L, -2, i + 1);
+	}
+}
+
+/*** Called once per game frame with all UnitDamaged events of that frame.
+ *
+ * Defining this call-in enables recording of the batch; UnitDamaged is still
+ * called as usual if it is also defined. Each array holds one entry per event,
+ * attackers not visible to the receiver (or removed before the end of the
+ * frame) are given as -1.
+ *
+ * @function UnitDamagedBatch
+ * @number count
+ * @tparam {number,...} unitIDs
+ * @tparam {number,...} unitDefIDs
+ * @tparam {number,...} unitTeams
+ * @tparam {number,...} damages
+ * @tparam {bool,...} paralyzers
+ * @tparam {number,...} weaponDefIDs
+ * @tparam {number,...} projectileIDs
+ * @tparam {number,...} attackerIDs
+ * @tparam {number,...} attackerDefIDs
+ * @tparam {number,...} attackerTeams
+ */
+void CLuaHandle::UnitDamagedBatch(const UnitDamagedEventBatch& batch)
+{
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 13, __func__);
+
+	static const LuaHashString cmdStr(__func__);
+	const LuaUtils::ScopedDebugTraceBack traceBack(L);
+
+	batchIndices.clear();
+
+	for (size_t i = 0, n = batch.Size(); i < n; i++) {
+		if (CanReadAllyTeam(batch.unitAllyTeams[i]))
+			batchIndices.push_back(i);
+	}
+
+	if (batchIndices.empty())
+		return;
+
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	lua_pushnumber(L, batchIndices.size());
+	PushBatchColumn(L, batch.unitIDs);
+	PushBatchColumn(L, batch.unitDefIDs);
+	PushBatchColumn(L, batch.unitTeams);
+	PushBatchColumn(L, batch.damages);
+	PushBatchFlags(L, batch.paralyzers);
+	PushBatchColumn(L, batch.weaponDefIDs);
+	PushBatchColumn(L, batch.projectileIDs);
+	PushBatchAttackers(L, batch.attackerIDs);
+
+	// call the routine
+	RunCallInTraceback(L, cmdStr, 11, 0, traceBack.GetErrFuncIdx(), false);
+}
+
 /*** Called when a unit changes its stun status.
  *
  * @function UnitStunned
@@ -1915,6 +2139,59 @@ void CLuaHandle::FeatureDamaged(
 }
 
 
+/*** Called once per game frame with all FeatureDamaged events of that frame.
+ *
+ * See UnitDamagedBatch.
+ *
+ * @function FeatureDamagedBatch
+ * @number count
+ * @tparam {number,...} featureIDs
+ * @tparam {number,...} featureDefIDs
+ * @tparam {number,...} featureTeams
+ * @tparam {number,...} damages
+ * @tparam {number,...} weaponDefIDs
+ * @tparam {number,...} projectileIDs
+ * @tparam {number,...} attackerIDs
+ * @tparam {number,...} attackerDefIDs
+ * @tparam {number,...} attackerTeams
+ */
+void CLuaHandle::FeatureDamagedBatch(const FeatureDamagedEventBatch& batch)
+{
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 12, __func__);
+
+	static const LuaHashString cmdStr(__func__);
+	const LuaUtils::ScopedDebugTraceBack traceBack(L);
+
+	batchIndices.clear();
+
+	for (size_t i = 0, n = batch.Size(); i < n; i++) {
+		const int featureAllyTeam = batch.featureAllyTeams[i];
+
+		if (featureAllyTeam < 0 || CanReadAllyTeam(featureAllyTeam))
+			batchIndices.push_back(i);
+	}
+
+	if (batchIndices.empty())
+		return;
+
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	lua_pushnumber(L, batchIndices.size());
+	PushBatchColumn(L, batch.featureIDs);
+	PushBatchColumn(L, batch.featureDefIDs);
+	PushBatchColumn(L, batch.featureTeams);
+	PushBatchColumn(L, batch.damages);
+	PushBatchColumn(L, batch.weaponDefIDs);
+	PushBatchColumn(L, batch.projectileIDs);
+	PushBatchAttackers(L, batch.attackerIDs);
+
+	// call the routine
+	RunCallInTraceback(L, cmdStr, 10, 0, traceBack.GetErrFuncIdx(), false);
+}
+
+
 /******************************************************************************
  * Projectiles
  * @section projectiles
@@ -1971,6 +2248,64 @@ void CLuaHandle::ProjectileCreated(const CProjectile* p)
 }
 
 
+/*** Called once per game frame with all ProjectileCreated events of that frame.
+ *
+ * Only contains projectiles passing the same Script.SetWatchWeapon filter as
+ * ProjectileCreated; weaponDefIDs entries are -1 for piece-projectiles.
+ *
+ * @function ProjectileCreatedBatch
+ * @number count
+ * @tparam {number,...} proIDs
+ * @tparam {number,...} proOwnerIDs
+ * @tparam {number,...} weaponDefIDs
+ */
+void CLuaHandle::ProjectileCreatedBatch(const ProjectileCreatedEventBatch& batch)
+{
+	// if empty, we are not a LuaHandleSynced
+	if (watchProjectileDefs.empty())
+		return;
+
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 6, __func__);
+
+	static const LuaHashString cmdStr(__func__);
+
+	batchIndices.clear();
+
+	for (size_t i = 0, n = batch.Size(); i < n; i++) {
+		const int allyTeam = batch.allyTeams[i];
+
+		if (allyTeam >= 0 && !CanReadAllyTeam(allyTeam))
+			continue;
+
+		// if this weapon-type is not being watched, skip
+		if (batch.isPiece[i]) {
+			if (!watchProjectileDefs[watchProjectileDefs.size() - 1])
+				continue;
+		} else {
+			if (!watchProjectileDefs[ batch.weaponDefIDs[i] ])
+				continue;
+		}
+
+		batchIndices.push_back(i);
+	}
+
+	if (batchIndices.empty())
+		return;
+
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	lua_pushnumber(L, batchIndices.size());
+	PushBatchColumn(L, batch.projectileIDs);
+	PushBatchColumn(L, batch.ownerIDs);
+	PushBatchColumn(L, batch.weaponDefIDs);
+
+	// call the routine
+	RunCallIn(L, cmdStr, 4, 0);
+}
+
+
 /*** Called when the projectile is destroyed.
  *
  * @function ProjectileDestroyed
@@ -2248,14 +2583,26 @@ void CLuaHandle::UnsyncedHeightMapUpdate(const SRectangle& rect)
  */
 void CLuaHandle::Update()
 {
-	LUA_CALL_IN_CHECK(L);
-	luaL_checkstack(L, 2, __func__);
 	static const LuaHashString cmdStr(__func__);
-	if (!cmdStr.GetGlobalFunc(L))
+
+	const auto RunUpdate = [&]() {
+		luaL_checkstack(L, 2, __func__);
+		if (!cmdStr.GetGlobalFunc(L))
+			return;
+
+		// call the routine
+		RunCallIn(L, cmdStr, 0, 0);
+	};
+
+	if (eventHandler.IsUpdatingConcurrently(this)) {
+		// pool task, see CEventHandler::Update; special timers are main-thread only
+		SCOPED_MT_TIMER("Lua::Callins::Unsynced");
+		RunUpdate();
 		return;
+	}
 
-	// call the routine
-	RunCallIn(L, cmdStr, 0, 0);
+	LUA_CALL_IN_CHECK(L);
+	RunUpdate();
 }
 
 
@@ -3552,21 +3899,46 @@ void CLuaHandle::DownloadProgress(int ID, long downloaded, long total)
 
 void CLuaHandle::CollectGarbage(bool forced)
 {
-	const float gcMemLoadMult = D.gcCtrl.baseMemLoadMult;
-	const float gcRunTimeMult = D.gcCtrl.baseRunTimeMult;
+	SLuaGarbageCollectCtrl& gcCtrl = D.gcCtrl;
+	SLuaAllocState gcAllocState;
 
-	if (!forced && spring_lua_alloc_skip_gc(gcMemLoadMult))
-		return;
+	spring_lua_alloc_get_stats(&gcAllocState);
 
-	LUA_CALL_IN_CHECK_NAMED(L, (GetLuaContextData(L)->synced)? "Lua::CollectGarbage::Synced": "Lua::CollectGarbage::Unsynced");
+	{
+		// share of all bytes allocated by Lua since the previous call that came from us
+		const uint64_t handleAllocBytes = D.allocState.grossAllocBytes.load();
+		const uint64_t totalAllocBytes = gcAllocState.grossAllocBytes.load();
+		const uint64_t handleAllocDelta = handleAllocBytes - gcCtrl.prevHandleAllocBytes;
+		const uint64_t totalAllocDelta = totalAllocBytes - gcCtrl.prevTotalAllocBytes;
 
-	lua_lock(L_GC);
-	SetHandleRunning(L_GC, true);
+		gcCtrl.prevHandleAllocBytes = handleAllocBytes;
+		gcCtrl.prevTotalAllocBytes = totalAllocBytes;
+
+		if (totalAllocDelta > 0)
+			gcCtrl.allocShare = mix(gcCtrl.allocShare, handleAllocDelta / float(totalAllocDelta), 0.25f);
+	}
+
+	const bool budgeted = (gcCtrl.frameBudget > 0.0f);
+
+	// only do full cycles outside of the budget when running out of memory
+	if (budgeted) {
+		const float memUsage = gcAllocState.allocedBytes.load() / float(SLuaAllocLimit::MAX_ALLOC_BYTES);
+
+		if (memUsage < (gcCtrl.memPressure - gcCtrl.memPressureHysteresis)) {
+			gcCtrl.memPressureWaitCalls = 0;
+		} else if (gcCtrl.memPressureWaitCalls > 0) {
+			gcCtrl.memPressureWaitCalls--;
+		} else if (memUsage > gcCtrl.memPressure) {
+			gcCtrl.memPressureWaitCalls = gcCtrl.memPressureInterval;
+			forced = true;
+		}
+	}
+
+	if (!forced && spring_lua_alloc_skip_gc(gcCtrl.baseMemLoadMult))
+		return;
 
 	// note: total footprint INCLUDING garbage, in KB
-	int  gcMemFootPrint = lua_gc(L_GC, LUA_GCCOUNT, 0);
-	int  gcItersInBatch = 0;
-	int& gcStepsPerIter = D.gcCtrl.numStepsPerIter;
+	const int gcMemFootPrint = lua_gc(L, LUA_GCCOUNT, 0);
 
 	// if gc runs at a fixed rate, the upper limit to base runtime will
 	// quickly be reached since Lua's footprint can easily exceed 100MB
@@ -3575,7 +3947,61 @@ void CLuaHandle::CollectGarbage(bool forced)
 	// mean too much time is spent on it, must weigh the per-call period
 	const float gcSpeedFactor = Clamp(gs->speedFactor * (1 - gs->PreSimFrame()) * (1 - gs->paused), 1.0f, 50.0f);
 	const float gcBaseRunTime = smoothstep(10.0f, 100.0f, gcMemFootPrint / 1024);
-	const float gcLoopRunTime = Clamp((gcBaseRunTime * gcRunTimeMult) / gcSpeedFactor, D.gcCtrl.minLoopRunTime, D.gcCtrl.maxLoopRunTime);
+	const float gcLoopRunTime = Clamp((gcBaseRunTime * gcCtrl.baseRunTimeMult) / gcSpeedFactor, gcCtrl.minLoopRunTime, gcCtrl.maxLoopRunTime);
+
+	if (forced || !budgeted) {
+		if (RunGarbageCollector(gcLoopRunTime, forced))
+			gcCtrl.deferredRunTime = 0.0f;
+
+		return;
+	}
+
+	// whatever does not fit in our part of the budget is deferred to CollectDeferredGarbage
+	const float gcWantedRunTime = gcLoopRunTime + gcCtrl.deferredRunTime;
+	const float gcBudgetRunTime = std::min(gcWantedRunTime, gcCtrl.frameBudget * gcCtrl.allocShare);
+
+	if (gcBudgetRunTime > 0.0f && RunGarbageCollector(gcBudgetRunTime, false)) {
+		gcCtrl.deferredRunTime = 0.0f;
+	} else {
+		gcCtrl.deferredRunTime = std::min(gcWantedRunTime - gcBudgetRunTime, gcCtrl.maxLoopRunTime);
+	}
+}
+
+void CLuaHandle::CollectDeferredGarbage(spring_time deadline)
+{
+	SLuaGarbageCollectCtrl& gcCtrl = D.gcCtrl;
+
+	if (gcCtrl.deferredRunTime <= 0.0f)
+		return;
+
+	const float gcIdleRunTime = std::min(gcCtrl.deferredRunTime, (deadline - spring_gettime()).toMilliSecsf());
+
+	if (gcIdleRunTime <= 0.0f)
+		return;
+
+	if (RunGarbageCollector(gcIdleRunTime, false)) {
+		gcCtrl.deferredRunTime = 0.0f;
+	} else {
+		gcCtrl.deferredRunTime -= gcIdleRunTime;
+	}
+}
+
+bool CLuaHandle::RunGarbageCollector(float gcLoopRunTime, bool forced)
+{
+	LUA_CALL_IN_CHECK_NAMED(L, (GetLuaContextData(L)->synced)? "Lua::CollectGarbage::Synced": "Lua::CollectGarbage::Unsynced");
+
+	lua_lock(L_GC);
+	SetHandleRunning(L_GC, true);
+
+	// note: total footprint INCLUDING garbage, in KB
+	int  gcMemFootPrint = lua_gc(L_GC, LUA_GCCOUNT, 0);
+	int  gcItersInBatch = 0;
+	int& gcStepsPerIter = D.gcCtrl.numStepsPerIter;
+
+	// set when a cycle finished without freeing anything
+	bool gcCycleDone = false;
+
+	const float gcRunTimeMult = D.gcCtrl.baseRunTimeMult;
 
 	const spring_time startTime = spring_gettime();
 	const spring_time   endTime = startTime + spring_msecs(gcLoopRunTime);
@@ -3594,7 +4020,7 @@ void CLuaHandle::CollectGarbage(bool forced)
 		gcMemFootPrint = gcMemFootPrintNow;
 
 		// early-exit if cycle didn't free any memory
-		if (gcMemFootPrintDif == 0)
+		if ((gcCycleDone = (gcMemFootPrintDif == 0)))
 			break;
 	}
 
@@ -3616,6 +4042,7 @@ void CLuaHandle::CollectGarbage(bool forced)
 	}
 
 	eventHandler.DbgTimingInfo(TIMING_GC, startTime, finishTime);
+	return gcCycleDone;
 }
 
 /******************************************************************************/
@@ -3640,6 +4067,7 @@ bool CLuaHandle::AddBasicCalls(lua_State* L)
 		HSTR_PUSH_CFUNC(L, "GetCallInList",   CallOutGetCallInList);
 		HSTR_PUSH_CFUNC(L, "DelayByFrames",   CallOutDelayByFrames);
 		HSTR_PUSH_CFUNC(L, "IsEngineMinVersion", CallOutIsEngineMinVersion);
+		HSTR_PUSH_CFUNC(L, "SetThreadedUpdate", CallOutSetThreadedUpdate);
 		// special team constants
 		HSTR_PUSH_NUMBER(L, "NO_ACCESS_TEAM",  CEventClient::NoAccessTeam);
 		HSTR_PUSH_NUMBER(L, "ALL_ACCESS_TEAM", CEventClient::AllAccessTeam);
@@ -3761,6 +4189,64 @@ int CLuaHandle::CallOutDelayByFrames(lua_State* L)
 	return 0;
 }
 
+/***
+ * @function Script.SetThreadedUpdate
+ *
+ * Requests that the Update call-in of this handle runs on a worker thread, concurrently
+ * with the other handles. Only LuaUI and LuaMenu can do so, and only if the LuaThreadedUIUpdate
+ * springsetting is enabled. In a threaded Update the control, GL, VFS and Script cross-handle
+ * callouts and some render and pathing reads raise an error, and GL objects (VBOs, VAOs, shaders,
+ * fonts, ...) must not be used.
+ *
+ * @bool enable
+ * @treturn bool whether Update now runs threaded
+ */
+int CLuaHandle::CallOutSetThreadedUpdate(lua_State* L)
+{
+	CLuaHandle* lh = GetHandle(L);
+
+	if (eventHandler.IsUpdatingConcurrently(lh))
+		return luaL_error(L, "[%s] can not be called from a threaded Update", __func__);
+
+	// only these have no synced half and a memory pool of their own
+	const bool uiHandle = (lh->GetOrder() == LUA_HANDLE_ORDER_UI || lh->GetOrder() == LUA_HANDLE_ORDER_MENU);
+
+	lh->D.threadedUpdate = (luaL_checkboolean(L, 1) && uiHandle && ThreadedUIUpdateEnabled());
+	lua_pushboolean(L, lh->D.threadedUpdate);
+	return 1;
+}
+
+// calls the function wrapped by a CallOutMainThreadOnly or CallOutNotThreaded closure
+static int CallWrappedCallOut(lua_State* L)
+{
+	lua_pushvalue(L, lua_upvalueindex(1));
+	lua_insert(L, 1);
+	lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+	return (lua_gettop(L));
+}
+
+int CLuaHandle::CallOutMainThreadOnly(lua_State* L)
+{
+	if (eventHandler.InConcurrentUpdate()) {
+		// a handle updating on a worker may only read engine state
+		if (eventHandler.IsUpdatingConcurrently(GetHandle(L)))
+			return luaL_error(L, "%s can not be called from a threaded Update", lua_tostring(L, lua_upvalueindex(2)));
+
+		// do not change state the threaded Updates are reading
+		eventHandler.WaitForConcurrentUpdates();
+	}
+
+	return (CallWrappedCallOut(L));
+}
+
+int CLuaHandle::CallOutNotThreaded(lua_State* L)
+{
+	if (eventHandler.IsUpdatingConcurrently(GetHandle(L)))
+		return luaL_error(L, "%s can not be called from a threaded Update", lua_tostring(L, lua_upvalueindex(2)));
+
+	return (CallWrappedCallOut(L));
+}
+
 int CLuaHandle::CallOutGetCallInList(lua_State* L)
 {
 	std::vector<std::string> eventList;
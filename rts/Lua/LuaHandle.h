@@ -10,6 +10,7 @@
 #include "LuaHashString.h"
 #include "lib/lua/include/LuaInclude.h" //FIXME needed for GetLuaContextData
 
+#include <initializer_list>
 #include <map>
 #include <string>
 #include <tuple>
@@ -87,6 +88,8 @@ class CLuaHandle : public CEventClient
 		// virtual bool PersistOnReload() const { return (GetName() == "LuaMenu"); }
 		virtual bool PersistOnReload() const { return false; }
 		virtual bool SecondaryGLContext() const { return false; }
+		// Update runs on a worker thread (LuaThreadedUIUpdate, Script.SetThreadedUpdate)
+		bool AllowConcurrentUpdate() const override { return (D.threadedUpdate); }
 
 		// used by LuaSyncedTable and creg save
 		lua_State* GetLuaState() const { return L; }
@@ -140,6 +143,7 @@ class CLuaHandle : public CEventClient
 			int projectileID,
 			bool paralyzer
 		) override;
+		void UnitDamagedBatch(const UnitDamagedEventBatch& batch) override;
 		void UnitStunned(const CUnit* unit, bool stunned) override;
 		void UnitExperience(const CUnit* unit, float oldExperience) override;
 		void UnitHarvestStorageFull(const CUnit* unit) override;
@@ -179,9 +183,11 @@ class CLuaHandle : public CEventClient
 			int weaponDefID,
 			int projectileID
 		) override;
+		void FeatureDamagedBatch(const FeatureDamagedEventBatch& batch) override;
 
 		void ProjectileCreated(const CProjectile* p) override;
 		void ProjectileDestroyed(const CProjectile* p) override;
+		void ProjectileCreatedBatch(const ProjectileCreatedEventBatch& batch) override;
 
 		bool Explosion(int weaponID, int projectileID, const float3& pos, const CUnit* owner) override;
 
@@ -273,6 +279,7 @@ class CLuaHandle : public CEventClient
 		//FIXME void MetalMapChanged(const int x, const int z);
 
 		void CollectGarbage(bool forced) override;
+		void CollectDeferredGarbage(spring_time deadline) override;
 
 		void DownloadQueued(int ID, const std::string& archiveName, const std::string& archiveType) override;
 		void DownloadStarted(int ID) override;
@@ -300,6 +307,9 @@ class CLuaHandle : public CEventClient
 		bool AddBasicCalls(lua_State* L);
 		bool LoadCode(lua_State* L, std::string code, const std::string& debug);
 		static bool AddEntriesToTable(lua_State* L, const char* name, bool (*entriesFunc)(lua_State*));
+		/// as above, but with LuaThreadedUIUpdate enabled the added functions raise an error
+		/// in a threaded Update and wait for all threaded Updates to finish on the main thread
+		static bool AddMainThreadEntriesToTable(lua_State* L, const char* name, bool (*entriesFunc)(lua_State*));
 
 		/// returns error code and sets traceback on error
 		int  RunCallInTraceback(lua_State* L, const LuaHashString* hs, std::string* ts, int inArgs, int outArgs, int errFuncIndex, bool popErrFunc);
@@ -316,6 +326,9 @@ class CLuaHandle : public CEventClient
 		void RunDrawCallIn(const LuaHashString& hs);
 
 		void DrawObjectsLua(std::initializer_list<bool> bools, const char* func);
+
+		/// returns true if a GC cycle finished without freeing any memory
+		bool RunGarbageCollector(float gcLoopRunTime, bool forced);
 	protected:
 		bool userMode = false;
 		bool killMe = false; // set for handles that fail to RunCallIn
@@ -353,8 +366,16 @@ class CLuaHandle : public CEventClient
 		static int CallOutUpdateCallIn(lua_State* L);
 		static int CallOutIsEngineMinVersion(lua_State* L);
 		static int CallOutDelayByFrames(lua_State* L);
+		static int CallOutSetThreadedUpdate(lua_State* L);
+		static int CallOutMainThreadOnly(lua_State* L);
+		static int CallOutNotThreaded(lua_State* L);
 
 	public: // static
+		/// with LuaThreadedUIUpdate enabled, makes the named functions in the table at
+		/// the top of the stack raise an error when called from a threaded Update; for
+		/// callouts that read main-thread only state or scratch buffers
+		static bool WrapMainThreadEntries(lua_State* L, std::initializer_list<const char*> names);
+
 #if (!defined(UNITSYNC) && !defined(DEDICATED))
 		static inline LuaShaders& GetActiveShaders(lua_State* L) { return GetLuaContextData(L)->shaders; }
 		static inline LuaTextures& GetActiveTextures(lua_State* L) { return GetLuaContextData(L)->textures; }
@@ -128,10 +128,11 @@ bool CUnsyncedLuaHandle::Init(std::string code, const std::string& file)
 		if (!AddEntriesToTable(L, "Script",          LuaInterCall::PushEntriesUnsynced)) KILL
 		if (!AddEntriesToTable(L, "Script",             LuaScream::PushEntries        )) KILL
 		if (!AddEntriesToTable(L, "Spring",         LuaSyncedRead::PushEntries        )) KILL
-		if (!AddEntriesToTable(L, "Spring",       LuaUnsyncedCtrl::PushEntries        )) KILL
+		// control, UI command and GL callouts first wait for threaded LuaUI/LuaMenu Updates
+		if (!AddMainThreadEntriesToTable(L, "Spring", LuaUnsyncedCtrl::PushEntries    )) KILL
 		if (!AddEntriesToTable(L, "Spring",       LuaUnsyncedRead::PushEntries        )) KILL
-		if (!AddEntriesToTable(L, "Spring",          LuaUICommand::PushEntries        )) KILL
-		if (!AddEntriesToTable(L, "gl",                 LuaOpenGL::PushEntries        )) KILL
+		if (!AddMainThreadEntriesToTable(L, "Spring",    LuaUICommand::PushEntries    )) KILL
+		if (!AddMainThreadEntriesToTable(L, "gl",           LuaOpenGL::PushEntries    )) KILL
 		if (!AddEntriesToTable(L, "GL",                LuaConstGL::PushEntries        )) KILL
 		if (!AddEntriesToTable(L, "Engine",        LuaConstEngine::PushEntries        )) KILL
 		if (!AddEntriesToTable(L, "Platform",      LuaConstPlatform::PushEntries      )) KILL
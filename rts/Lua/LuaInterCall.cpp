@@ -9,6 +9,7 @@
 #include "LuaGaia.h"
 #include "LuaRules.h"
 #include "LuaUI.h"
+#include "System/EventHandler.h"
 
 
 enum {
@@ -66,6 +67,10 @@ static int HandleXCall(lua_State* L)
 	if (lh == nullptr)
 		return 0;
 
+	// the target state may be in use by the main thread
+	if (eventHandler.IsUpdatingConcurrently(CLuaHandle::GetHandle(L)))
+		return luaL_error(L, "Script.%s: cross-calls are not allowed from a threaded Update", funcName);
+
 	return lh->XCall(L, funcName);
 }
 
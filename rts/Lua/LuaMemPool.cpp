@@ -1,9 +1,11 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include <algorithm> // std::min
+#include <cassert>
 #include <cstdint> // std::uint8_t
 #include <cstring> // std::mem{cpy,set}
 #include <new>
+#include <string>
 
 #include "LuaMemPool.h"
 #include "System/MainDefines.h"
@@ -61,10 +63,15 @@ void LuaMemPool::ReleasePtr(LuaMemPool* p, const CLuaHandle* o)
 	gCount -= (o != nullptr);
 
 	if (p == GetSharedPtr()) {
-		p->GetSharedCount() -= 1;
+		if ((p->GetSharedCount() -= 1) == 0)
+			p->Clear();
+
 		return;
 	}
 
+	// hand the slabs of a closed state back in bulk
+	p->Clear();
+
 	gMutex.lock();
 	gIndcs.push_back(p->GetGlobalIndex());
 	gMutex.unlock();
@@ -86,127 +93,188 @@ void LuaMemPool::KillStatic()
 
 
 
+// maps (size + 7) / 8 to the smallest class whose slots can hold size bytes
+const std::array<uint8_t, (LuaMemPool::MAX_SLOT_SIZE >> 3) + 1> LuaMemPool::SIZE_CLASS_INDICES = []() {
+	std::array<uint8_t, (MAX_SLOT_SIZE >> 3) + 1> indices = {};
+
+	for (size_t i = 0, c = 0; i < indices.size(); i++) {
+		while (SIZE_CLASS_SLOTS[c] < (i << 3))
+			c++;
+
+		indices[i] = c;
+	}
+
+	return indices;
+}();
+
+
+
 LuaMemPool::LuaMemPool(bool isEnabled): LuaMemPool(size_t(-1)) { assert(isEnabled == LuaMemPool::enabled); }
 LuaMemPool::LuaMemPool(size_t lmpIndex): globalIndex(lmpIndex)
 {
-	if (!LuaMemPool::enabled)
-		return;
-
-	luaMemPoolImpl = std::make_unique<LuaMemPool::LuaMemPoolImpl>();
+	static_assert(SIZE_CLASS_SLOTS[NUM_SIZE_CLASSES - 1] == MAX_SLOT_SIZE, "");
+	static_assert((SLAB_SIZE / MAX_SLOT_SIZE) >= 64, "");
 }
 
 void LuaMemPool::Clear()
 {
-	//allocStats = {};
+	// pools are cleared when (re)acquired and released, by then all
+	// states using it are closed and slabs can be dropped as a whole
+	if (slotBytes == 0)
+		ReleaseSlabs();
+
+	peakSlotBytes = slotBytes;
+	peakReservedBytes = slabs.size() * SLAB_SIZE;
 }
 
-void* LuaMemPool::Alloc(size_t size)
+void LuaMemPool::ReleaseSlabs()
 {
-	if (!LuaMemPool::enabled) {
-		allocStats[STAT_NAE] += 1 * (size > 0);
-		allocStats[STAT_NBE] += size;
-		auto t0 = spring_now();
-		void* ptr = ::operator new(size);
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-		return ptr;
+	for (void* slab: slabs) {
+		::operator delete(slab);
 	}
 
-	auto t0 = spring_now();
-	auto* ptr = luaMemPoolImpl->allocMem(size);
-	
-	if (size > NUM_BUCKETS * BUCKET_STEP) {
-		allocStats[STAT_NAE] += 1 * (size > 0);
-		allocStats[STAT_NBE] += size;
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-	} else if (luaMemPoolImpl->isAllocInternal(ptr)) {
-		allocStats[STAT_NAI] += 1 * (size > 0);
-		allocStats[STAT_NBI] += size;
-		allocStats[STAT_NTI] += (spring_now() - t0).toMicroSecsi();
+	allocStats[STAT_NSR] += slabs.size();
+
+	slabs.clear();
+	sizeClasses = {};
+	requestedBytes = 0;
+}
+
+
+void* LuaMemPool::AllocSlot(size_t size)
+{
+	const uint32_t sci = GetSizeClass(size);
+	const size_t slotSize = SIZE_CLASS_SLOTS[sci];
+
+	SizeClass& sc = sizeClasses[sci];
+
+	void* ptr = sc.freeSlots;
+
+	if (ptr != nullptr) {
+		sc.freeSlots = *reinterpret_cast<void**>(ptr);
 	} else {
-		allocStats[STAT_NAF] += 1 * (size > 0);
-		allocStats[STAT_NBF] += size;
-		allocStats[STAT_NTF] += (spring_now() - t0).toMicroSecsi();
+		if (sc.slabCurr == sc.slabLast) {
+			uint8_t* slab = static_cast<uint8_t*>(::operator new(SLAB_SIZE));
+
+			slabs.push_back(slab);
+
+			sc.slabCurr = slab;
+			sc.slabLast = slab + (SLAB_SIZE / slotSize) * slotSize;
+			sc.numSlabs += 1;
+
+			peakReservedBytes = std::max(peakReservedBytes, slabs.size() * SLAB_SIZE);
+		}
+
+		ptr = sc.slabCurr;
+		sc.slabCurr += slotSize;
 	}
 
+	sc.numSlotsUsed += 1;
+
+	slotBytes += slotSize;
+	requestedBytes += size;
+	peakSlotBytes = std::max(peakSlotBytes, slotBytes);
+
+	allocStats[STAT_NAI] += 1;
+	allocStats[STAT_NBI] += size;
 	return ptr;
 }
 
-void* LuaMemPool::Realloc(void* ptr, size_t nsize, size_t osize)
+void LuaMemPool::FreeSlot(void* ptr, size_t size)
 {
-	if (ptr == nullptr || osize == 0)
-		return Alloc(nsize);
+	const uint32_t sci = GetSizeClass(size);
 
-	if (!LuaMemPool::enabled) {
-		void* newPtr = ::operator new(nsize);
+	SizeClass& sc = sizeClasses[sci];
 
-		if (newPtr == nullptr)
-			return nullptr;
+	assert(sc.numSlotsUsed > 0);
 
-		allocStats[STAT_NBE] -= osize;
-		allocStats[STAT_NBE] += nsize;
+	*reinterpret_cast<void**>(ptr) = sc.freeSlots;
+	sc.freeSlots = ptr;
+	sc.numSlotsUsed -= 1;
 
-		auto t0 = spring_now();
-		std::memcpy(newPtr, ptr, std::min(nsize, osize));
-		std::memset(ptr, 0, osize);
-		::operator delete(ptr);
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
+	slotBytes -= SIZE_CLASS_SLOTS[sci];
+	requestedBytes -= size;
+}
 
-		return newPtr;
-	}
 
-	auto t0 = spring_now();
-	auto* ret = luaMemPoolImpl->reAllocMem(ptr, nsize);
-	if (nsize > NUM_BUCKETS * BUCKET_STEP) {
-		allocStats[STAT_NAE] += 1 * (nsize > 0);
-		allocStats[STAT_NBE] += nsize;
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-	}
-	else if (luaMemPoolImpl->isAllocInternal(ret)) {
-		allocStats[STAT_NAI] += 1 * (nsize > 0);
-		allocStats[STAT_NBI] += nsize;
-		allocStats[STAT_NTI] += (spring_now() - t0).toMicroSecsi();
-	}
-	else {
-		allocStats[STAT_NAF] += 1 * (nsize > 0);
-		allocStats[STAT_NBF] += nsize;
-		allocStats[STAT_NTF] += (spring_now() - t0).toMicroSecsi();
+void* LuaMemPool::Alloc(size_t size)
+{
+	if (LuaMemPool::enabled && size <= MAX_SLOT_SIZE)
+		return (AllocSlot(size));
+
+	externalBytes += size;
+
+	allocStats[STAT_NAE] += 1;
+	allocStats[STAT_NBE] += size;
+	return (::operator new(size));
+}
+
+void* LuaMemPool::Realloc(void* ptr, size_t nsize, size_t osize)
+{
+	if (ptr == nullptr || osize == 0)
+		return Alloc(nsize);
+
+	const bool slotted = (LuaMemPool::enabled && osize <= MAX_SLOT_SIZE && nsize <= MAX_SLOT_SIZE);
+
+	// same slot fits both sizes, e.g. when Lua shrinks a small array
+	if (slotted && GetSizeClass(osize) == GetSizeClass(nsize)) {
+		requestedBytes -= osize;
+		requestedBytes += nsize;
+		return ptr;
 	}
-	return ret;
+
+	void* newPtr = Alloc(nsize);
+
+	std::memcpy(newPtr, ptr, std::min(nsize, osize));
+	Free(ptr, osize);
+	return newPtr;
 }
 
 void LuaMemPool::Free(void* ptr, size_t size)
 {
-	if (!LuaMemPool::enabled) {
-		::operator delete(ptr);
+	// Lua legally frees NULL blocks (with osize=0), e.g. for empty arrays
+	if (ptr == nullptr || size == 0)
+		return;
+
+	if (LuaMemPool::enabled && size <= MAX_SLOT_SIZE) {
+		FreeSlot(ptr, size);
 		return;
 	}
 
-	luaMemPoolImpl->freeMem(ptr);
+	externalBytes -= size;
+	::operator delete(ptr);
+}
+
+
+LuaMemPool::SlabStats LuaMemPool::GetSlabStats() const
+{
+	return {slabs.size() * SLAB_SIZE, slotBytes, requestedBytes, externalBytes, peakSlotBytes, peakReservedBytes, slabs.size()};
 }
 
 void LuaMemPool::LogStats(const char* handle, const char* lctype)
 {
 	static constexpr auto one = uint64_t(1);
-	const float intPerc = 100.0f * static_cast<float>(allocStats[STAT_NAI]) / static_cast<float>(std::max(allocStats[STAT_NAI] + allocStats[STAT_NAF] + allocStats[STAT_NAE], one));
-	const float avgAllocTimeI = static_cast<float>(allocStats[STAT_NTI]) / static_cast<float>(std::max(allocStats[STAT_NAI], one));
-	const float avgAllocTimeF = static_cast<float>(allocStats[STAT_NTF]) / static_cast<float>(std::max(allocStats[STAT_NAF], one));
-	const float avgAllocTimeE = static_cast<float>(allocStats[STAT_NTE]) / static_cast<float>(std::max(allocStats[STAT_NAE], one));
+
+	// share of the slab memory held at the high-water mark that was never handed out
+	const float peakFragPerc = 100.0f * (1.0f - static_cast<float>(peakSlotBytes) / static_cast<float>(std::max(uint64_t(peakReservedBytes), one)));
+	const float intPerc = 100.0f * static_cast<float>(allocStats[STAT_NAI]) / static_cast<float>(std::max(allocStats[STAT_NAI] + allocStats[STAT_NAE], one));
+
 	std::string msg = fmt::sprintf(
-		"[LuaMemPool::%s][handle=%s (%s)] index=%u numAllocs{int+, int-, ext, int_p}={%u, %u, %u, %.1f} allocedSize{int+, int-, ext}={%u, %u, %u}, avgAllocTime{int+, int-, ext}={%.4f, %.4f, %.4f}",
+		"[LuaMemPool::%s][handle=%s (%s)] index=%u numAllocs{int, ext, int_p}={%u, %u, %.1f} allocedSize{int, ext}={%u, %u} numSlabs{live, released}={%u, %u} peakSize{slots, slabs}={%u, %u} peakFragmentation=%.1f%%",
 		__func__,
 		handle,
 		lctype,
 		globalIndex,
 		allocStats[STAT_NAI],
-		allocStats[STAT_NAF],
 		allocStats[STAT_NAE],
 		intPerc,
 		allocStats[STAT_NBI],
-		allocStats[STAT_NBF],
 		allocStats[STAT_NBE],
-		avgAllocTimeI,
-		avgAllocTimeF,
-		avgAllocTimeE
+		slabs.size(),
+		allocStats[STAT_NSR],
+		peakSlotBytes,
+		peakReservedBytes,
+		peakFragPerc
 	);
 	LOG("%s", msg.c_str());
 	allocStats = {};
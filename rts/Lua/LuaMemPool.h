@@ -2,13 +2,10 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <memory>
-
-#include "System/bitops.h"
-#include "System/MemPoolTypes.h"
-#include "System/UnorderedMap.hpp"
 
 #define LMP_USE_CHUNK_TABLE 0
 
@@ -18,14 +15,7 @@ public:
 	explicit LuaMemPool(bool isEnabled);
 	explicit LuaMemPool(size_t lmpIndex);
 
-	~LuaMemPool() {
-		Clear();
-
-		if (!LuaMemPool::enabled)
-			return;
-
-		luaMemPoolImpl = nullptr;
-	}
+	~LuaMemPool() { ReleaseSlabs(); }
 
 	LuaMemPool(const LuaMemPool& p) = delete;
 	LuaMemPool(LuaMemPool&& p) = delete;
@@ -33,6 +23,17 @@ public:
 	LuaMemPool& operator = (const LuaMemPool& p) = delete;
 	LuaMemPool& operator = (LuaMemPool&& p) = delete;
 
+public:
+	struct SlabStats {
+		size_t reservedBytes; // slab memory held by the pool
+		size_t slotBytes;     // slab memory occupied by live allocations
+		size_t requestedBytes; // bytes requested by live slab allocations
+		size_t externalBytes; // bytes of live allocations too large for a slab
+		size_t peakSlotBytes;
+		size_t peakReservedBytes;
+		size_t numSlabs;
+	};
+
 public:
 	static size_t GetPoolCount();
 
@@ -51,6 +52,7 @@ public:
 	void Free(void* ptr, size_t size);
 
 	void LogStats(const char* handle, const char* lctype);
+	SlabStats GetSlabStats() const;
 
 	size_t  GetGlobalIndex() const { return globalIndex; }
 	size_t  GetSharedCount() const { return sharedCount; }
@@ -58,26 +60,64 @@ public:
 
 public:
 	static bool enabled;
+
 private:
-	static constexpr uint32_t NUM_BUCKETS = 32;
-	static constexpr uint32_t BUCKET_STEP = 16;
-	using LuaMemPoolImpl = PassThroughPool<NUM_BUCKETS, 4 * (1024 * 1024)>;
-	std::unique_ptr<LuaMemPoolImpl> luaMemPoolImpl;
+	// returns all slabs to the OS, only valid while nothing is allocated from them
+	void ReleaseSlabs();
+
+	void* AllocSlot(size_t size);
+	void FreeSlot(void* ptr, size_t size);
+
+	static uint32_t GetSizeClass(size_t size) { return SIZE_CLASS_INDICES[(size + 7) >> 3]; }
+
+private:
+	static constexpr size_t SLAB_SIZE = 64 * 1024;
+	static constexpr size_t MAX_SLOT_SIZE = 512;
+
+	// tuned to Lua 5.1 objects on 64-bit platforms: TValue and Node arrays
+	// come in multiples of 16 and 40 bytes, tables and upvalues take 64 and
+	// 40 bytes, closures 40 bytes plus 8 (Lua) or 16 (C) per upvalue, and
+	// strings 24 bytes plus their length; most requests are below 128
+	static constexpr uint32_t NUM_SIZE_CLASSES = 24;
+	static constexpr std::array<uint16_t, NUM_SIZE_CLASSES> SIZE_CLASS_SLOTS = {{
+		 16,  24,  32,  40,  48,  56,  64,  72,
+		 80,  88,  96, 104, 112, 120, 128, 160,
+		192, 224, 256, 320, 384, 448, 480, 512,
+	}};
+	static const std::array<uint8_t, (MAX_SLOT_SIZE >> 3) + 1> SIZE_CLASS_INDICES;
+
+	struct SizeClass {
+		// intrusive list of freed slots
+		void* freeSlots = nullptr;
+
+		// unused tail of the most recently added slab
+		uint8_t* slabCurr = nullptr;
+		uint8_t* slabLast = nullptr;
+
+		size_t numSlabs = 0;
+		size_t numSlotsUsed = 0;
+	};
+
+	std::array<SizeClass, NUM_SIZE_CLASSES> sizeClasses;
+	std::vector<void*> slabs;
 
 	enum {
-		STAT_NAI = 0, // number of internal allocs
-		STAT_NAF = 1, // number of int fail allocs
-		STAT_NAE = 2, // number of external allocs
-		STAT_NBI = 3, // number of bytes alloced (internal)
-		STAT_NBF = 4, // number of bytes alloced (int fail)
-		STAT_NBE = 5, // number of bytes alloced (external)
-		STAT_NTI = 6, // cumulative time spent on internal allocs
-		STAT_NTF = 7, // cumulative time spent on int fail allocs
-		STAT_NTE = 8, // cumulative time spent on external allocs
+		STAT_NAI = 0, // number of internal (slab) allocs
+		STAT_NAE = 1, // number of external allocs
+		STAT_NBI = 2, // number of bytes alloced (internal)
+		STAT_NBE = 3, // number of bytes alloced (external)
+		STAT_NSR = 4, // number of slabs released in bulk
 	};
 
-	std::array<uint64_t, 9> allocStats = { 0, 0, 0, 0, 0 };
+	// cumulative, reset by LogStats
+	std::array<uint64_t, 5> allocStats = {0, 0, 0, 0, 0};
+
+	size_t slotBytes = 0;
+	size_t requestedBytes = 0;
+	size_t externalBytes = 0;
+	size_t peakSlotBytes = 0;
+	size_t peakReservedBytes = 0;
 
 	size_t globalIndex = 0;
 	size_t sharedCount = 0;
-};
\ No newline at end of file
+};
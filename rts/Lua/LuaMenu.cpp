@@ -107,20 +107,21 @@ CLuaMenu::CLuaMenu()
 
 	// load the spring libraries
 	if (
-		!AddEntriesToTable(L, "Spring",    LoadUnsyncedCtrlFunctions)      ||
-		!AddEntriesToTable(L, "Spring",    LoadUnsyncedReadFunctions)      ||
-		!AddEntriesToTable(L, "Spring",    LoadLuaMenuFunctions)           ||
-		!AddEntriesToTable(L, "Engine",    LuaConstEngine::PushEntries)    ||
-		!AddEntriesToTable(L, "Platform",  LuaConstPlatform::PushEntries)  ||
-		!AddEntriesToTable(L, "Script",    LuaScream::PushEntries)         ||
-		!AddEntriesToTable(L, "VFS",       LuaVFS::PushUnsynced)           ||
-		!AddEntriesToTable(L, "VFS",       LuaZipFileReader::PushUnsynced) ||
-		!AddEntriesToTable(L, "VFS",       LuaZipFileWriter::PushUnsynced) ||
-		!AddEntriesToTable(L, "VFS",       LuaArchive::PushEntries)        ||
-		!AddEntriesToTable(L, "gl",        LuaOpenGL::PushEntries)         ||
-		!AddEntriesToTable(L, "GL",        LuaConstGL::PushEntries)        ||
-		!AddEntriesToTable(L, "LOG",       LuaUtils::PushLogEntries)       ||
-		!AddEntriesToTable(L, "VFS",       LuaVFSDownload::PushEntries)
+		!AddMainThreadEntriesToTable(L, "Spring",   LoadUnsyncedCtrlFunctions)              ||
+		!AddEntriesToTable(          L, "Spring",   LoadUnsyncedReadFunctions)              ||
+		!AddEntriesToTable(          L, "Spring",   LuaUnsyncedRead::MarkMainThreadEntries) ||
+		!AddMainThreadEntriesToTable(L, "Spring",   LoadLuaMenuFunctions)                   ||
+		!AddEntriesToTable(          L, "Engine",   LuaConstEngine::PushEntries)            ||
+		!AddEntriesToTable(          L, "Platform", LuaConstPlatform::PushEntries)          ||
+		!AddEntriesToTable(          L, "Script",   LuaScream::PushEntries)                 ||
+		!AddMainThreadEntriesToTable(L, "VFS",      LuaVFS::PushUnsynced)                   ||
+		!AddMainThreadEntriesToTable(L, "VFS",      LuaZipFileReader::PushUnsynced)         ||
+		!AddMainThreadEntriesToTable(L, "VFS",      LuaZipFileWriter::PushUnsynced)         ||
+		!AddMainThreadEntriesToTable(L, "VFS",      LuaArchive::PushEntries)                ||
+		!AddMainThreadEntriesToTable(L, "gl",       LuaOpenGL::PushEntries)                 ||
+		!AddEntriesToTable(          L, "GL",       LuaConstGL::PushEntries)                ||
+		!AddEntriesToTable(          L, "LOG",      LuaUtils::PushLogEntries)               ||
+		!AddMainThreadEntriesToTable(L, "VFS",      LuaVFSDownload::PushEntries)
 	) {
 		KillLua();
 		return;
@@ -74,8 +74,10 @@
 #include "System/SpringMath.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/FileSystem/FileSystem.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/StringUtil.h"
 
+#include <array>
 #include <cctype>
 #include <type_traits>
 
@@ -218,6 +220,7 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetUnitDirection);
 	REGISTER_LUA_CFUNC(GetUnitHeading);
 	REGISTER_LUA_CFUNC(GetUnitVelocity);
+	REGISTER_LUA_CFUNC(GetUnitArrayState);
 	REGISTER_LUA_CFUNC(GetUnitBuildFacing);
 	REGISTER_LUA_CFUNC(GetUnitIsBuilding);
 	REGISTER_LUA_CFUNC(GetUnitWorkerTask);
@@ -376,6 +379,31 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	return true;
 }
 
+bool LuaSyncedRead::MarkMainThreadEntries(lua_State* L)
+{
+	// these use quadfield query caches only the main thread may use (projectiles,
+	// CGameHelper) or touch pathfinder and model loader state
+	return (CLuaHandle::WrapMainThreadEntries(L, {
+		"GetProjectilesInRectangle",
+		"GetUnitNearestAlly",
+		"GetUnitNearestEnemy",
+		"GetUnitEstimatedPath",
+		"TestMoveOrder",
+		"TestBuildOrder",
+		"Pos2BuildPos",
+		"ClosestBuildPos",
+		"GetModelPieceMap",
+		"GetModelPieceList",
+		"RequestPath",
+		"InitPathNodeCostsArray",
+		"FreePathNodeCostsArray",
+		"SetPathNodeCosts",
+		"GetPathNodeCosts",
+		"SetPathNodeCost",
+		"GetPathNodeCost",
+	}));
+}
+
 
 /******************************************************************************/
 /******************************************************************************/
@@ -2346,9 +2374,10 @@ int LuaSyncedRead::GetTeamUnits(lua_State* L)
 
 
 // used by GetTeamUnitsSorted (PushVisibleUnits) and GetTeamUnitsByDefs (InsertSearchUnitDefs)
-static std::vector<int> gtuObjectIDs;
+// one per thread since unsynced handles may call these from a threaded Update
+static std::array<std::vector<int>, ThreadPool::MAX_THREADS> gtuObjectIDsMT;
 // used by GetTeamUnitsCounts
-static std::vector< std::pair<int, int> > gtuDefCounts;
+static std::array<std::vector< std::pair<int, int> >, ThreadPool::MAX_THREADS> gtuDefCountsMT;
 
 static bool PushVisibleUnits(
 	lua_State* L,
@@ -2357,6 +2386,7 @@ static bool PushVisibleUnits(
 	unsigned int* unitCount,
 	unsigned int* defCount
 ) {
+	std::vector<int>& gtuObjectIDs = gtuObjectIDsMT[ThreadPool::GetThreadNum()];
 	bool createdTable = false;
 
 	for (const CUnit* unit: defUnits) {
@@ -2388,6 +2418,7 @@ static bool PushVisibleUnits(
 
 static inline void InsertSearchUnitDefs(const UnitDef* ud, bool allied)
 {
+	std::vector<int>& gtuObjectIDs = gtuObjectIDsMT[ThreadPool::GetThreadNum()];
 	if (ud == nullptr)
 		return;
 
@@ -2421,6 +2452,7 @@ static inline void InsertSearchUnitDefs(const UnitDef* ud, bool allied)
  */
 int LuaSyncedRead::GetTeamUnitsSorted(lua_State* L)
 {
+	std::vector<int>& gtuObjectIDs = gtuObjectIDsMT[ThreadPool::GetThreadNum()];
 	if (CLuaHandle::GetHandleReadAllyTeam(L) == CEventClient::NoAccessTeam)
 		return 0;
 
@@ -2517,6 +2549,7 @@ int LuaSyncedRead::GetTeamUnitsSorted(lua_State* L)
  */
 int LuaSyncedRead::GetTeamUnitsCounts(lua_State* L)
 {
+	std::vector< std::pair<int, int> >& gtuDefCounts = gtuDefCountsMT[ThreadPool::GetThreadNum()];
 	if (CLuaHandle::GetHandleReadAllyTeam(L) == CEventClient::NoAccessTeam)
 		return 0;
 
@@ -2601,6 +2634,7 @@ int LuaSyncedRead::GetTeamUnitsCounts(lua_State* L)
  */
 int LuaSyncedRead::GetTeamUnitsByDefs(lua_State* L)
 {
+	std::vector<int>& gtuObjectIDs = gtuObjectIDsMT[ThreadPool::GetThreadNum()];
 	if (CLuaHandle::GetHandleReadAllyTeam(L) == CEventClient::NoAccessTeam)
 		return 0;
 
@@ -2835,6 +2869,7 @@ int LuaSyncedRead::GetUnitsInRectangle(lua_State* L)
 #define RECTANGLE_TEST ; // no test, GetUnitsExact is sufficient
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = ThreadPool::GetThreadNum();
 	quadField.GetUnitsExact(qfQuery, mins, maxs);
 	const auto& units = (*qfQuery.units);
 
@@ -2896,6 +2931,7 @@ int LuaSyncedRead::GetUnitsInBox(lua_State* L)
 	}
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = ThreadPool::GetThreadNum();
 	quadField.GetUnitsExact(qfQuery, mins, maxs);
 	const auto& units = (*qfQuery.units);
 
@@ -2954,6 +2990,7 @@ int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
 	}                                           \
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = ThreadPool::GetThreadNum();
 	quadField.GetUnitsExact(qfQuery, mins, maxs);
 	const auto& units = (*qfQuery.units);
 
@@ -3017,6 +3054,7 @@ int LuaSyncedRead::GetUnitsInSphere(lua_State* L)
 	}                                           \
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = ThreadPool::GetThreadNum();
 	quadField.GetUnitsExact(qfQuery, mins, maxs);
 	const auto& units = (*qfQuery.units);
 
@@ -3287,6 +3325,7 @@ int LuaSyncedRead::GetFeaturesInRectangle(lua_State* L)
 	const float3 maxs(xmax, 0.0f, zmax);
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = ThreadPool::GetThreadNum();
 	quadField.GetFeaturesExact(qfQuery, mins, maxs);
 	ProcessFeatures(L, *qfQuery.features);
 	return 1;
@@ -3312,6 +3351,7 @@ int LuaSyncedRead::GetFeaturesInSphere(lua_State* L)
 	const float3 pos(x, y, z);
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = ThreadPool::GetThreadNum();
 	quadField.GetFeaturesExact(qfQuery, pos, rad, true);
 	ProcessFeatures(L, *qfQuery.features);
 	return 1;
@@ -3336,6 +3376,7 @@ int LuaSyncedRead::GetFeaturesInCylinder(lua_State* L)
 	const float3 pos(x, 0, z);
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = ThreadPool::GetThreadNum();
 	quadField.GetFeaturesExact(qfQuery, pos, rad, false);
 	ProcessFeatures(L, *qfQuery.features);
 	return 1;
@@ -4177,6 +4218,191 @@ int LuaSyncedRead::GetUnitVelocity(lua_State* L)
 }
 
 
+/*** Reads the state of many units at once into caller-provided arrays
+ *
+ * @function Spring.GetUnitArrayState
+ *
+ * Each requested field of `buffers` is either an existing table, which is
+ * overwritten in place (so it can be reused across frames), or `true` to have
+ * a new one created and stored under that key. Entry `(i - 1) * stride + k`
+ * holds component k of `unitIDs[i]`; entries of units that are invalid or not
+ * visible enough for a field are set to nil, entries beyond `#unitIDs * stride`
+ * are left untouched.
+ *
+ *     positions  (stride 3) = base position, with radar error like GetUnitPosition
+ *     velocities (stride 4) = x, y, z and length, requires LOS
+ *     health     (stride 1) = requires LOS, same rules as GetUnitHealth
+ *     maxHealth  (stride 1) = requires LOS, same rules as GetUnitHealth
+ *     teams      (stride 1)
+ *     defIDs     (stride 1) = requires the unit type to be known, like GetUnitDefID
+ *
+ * @tparam {number,...} unitIDs
+ * @tparam table buffers
+ * @treturn number numVisible number of unitIDs that are valid and visible
+ * @treturn table buffers
+ */
+int LuaSyncedRead::GetUnitArrayState(lua_State* L)
+{
+	if (!lua_istable(L, 1) || !lua_istable(L, 2))
+		luaL_error(L, "Incorrect arguments to GetUnitArrayState(unitIDs, buffers)");
+
+	enum {
+		UNIT_VIS_ALLY  = (1 << 0),
+		UNIT_VIS_RADAR = (1 << 1),
+		UNIT_VIS_LOS   = (1 << 2),
+		UNIT_VIS_TYPED = (1 << 3),
+	};
+
+	// resolve all IDs and evaluate their visibility once, the
+	// per-field passes below only consult the cached flags
+	static std::array<std::vector<const CUnit*>, ThreadPool::MAX_THREADS> unitsMT;
+	static std::array<std::vector<uint8_t>, ThreadPool::MAX_THREADS> unitVisMT;
+
+	std::vector<const CUnit*>& units = unitsMT[ThreadPool::GetThreadNum()];
+	std::vector<uint8_t>& unitVis = unitVisMT[ThreadPool::GetThreadNum()];
+
+	const int readAllyTeam = CLuaHandle::GetHandleReadAllyTeam(L);
+	const bool fullRead = CLuaHandle::GetHandleFullRead(L);
+	const int numUnits = lua_objlen(L, 1);
+
+	int numVisible = 0;
+
+	units.clear();
+	unitVis.clear();
+	units.reserve(numUnits);
+	unitVis.reserve(numUnits);
+
+	for (int i = 0; i < numUnits; i++) {
+		lua_rawgeti(L, 1, i + 1);
+
+		const CUnit* unit = lua_isnumber(L, -1)? unitHandler.GetUnit(lua_toint(L, -1)): nullptr;
+		uint8_t vis = 0;
+
+		lua_pop(L, 1);
+
+		if (unit != nullptr) {
+			if ((readAllyTeam < 0)? fullRead: (unit->allyteam == readAllyTeam)) {
+				vis = UNIT_VIS_ALLY | UNIT_VIS_RADAR | UNIT_VIS_LOS | UNIT_VIS_TYPED;
+			} else if (readAllyTeam >= 0) {
+				const unsigned short losStatus = unit->losStatus[readAllyTeam];
+				const unsigned short prevMask = (LOS_PREVLOS | LOS_CONTRADAR);
+
+				vis |= (UNIT_VIS_RADAR * ((losStatus & (LOS_INLOS | LOS_INRADAR)) != 0));
+				vis |= (UNIT_VIS_LOS   * ((losStatus &  LOS_INLOS               ) != 0));
+				vis |= (UNIT_VIS_TYPED * ((losStatus & LOS_INLOS) != 0 || (losStatus & prevMask) == prevMask));
+			}
+		}
+
+		numVisible += ((vis & UNIT_VIS_RADAR) != 0);
+
+		units.push_back(unit);
+		unitVis.push_back(vis);
+	}
+
+	const auto FillField = [&](const char* name, int stride, uint8_t visMask, const auto& getValues) {
+		lua_getfield(L, 2, name);
+
+		if (!lua_toboolean(L, -1)) {
+			lua_pop(L, 1);
+			return;
+		}
+
+		if (!lua_istable(L, -1)) {
+			if (!lua_isboolean(L, -1))
+				luaL_error(L, "[GetUnitArrayState] buffers.%s must be a table or true", name);
+
+			lua_pop(L, 1);
+			lua_createtable(L, numUnits * stride, 0);
+			lua_pushvalue(L, -1);
+			lua_setfield(L, 2, name);
+		}
+
+		float values[4];
+
+		for (int i = 0; i < numUnits; i++) {
+			const bool valid = ((unitVis[i] & visMask) == visMask) && getValues(units[i], unitVis[i], values);
+
+			for (int k = 0; k < stride; k++) {
+				if (valid) {
+					lua_pushnumber(L, values[k]);
+				} else {
+					lua_pushnil(L);
+				}
+
+				lua_rawseti(L, -2, i * stride + k + 1);
+			}
+		}
+
+		lua_pop(L, 1);
+	};
+
+	FillField("positions", 3, UNIT_VIS_RADAR, [&](const CUnit* unit, uint8_t vis, float* values) {
+		const float3 errorVec = ((vis & UNIT_VIS_ALLY) == 0)? unit->GetLuaErrorVector(readAllyTeam, fullRead): ZeroVector;
+		const float3 pos = unit->pos + errorVec;
+
+		values[0] = pos.x;
+		values[1] = pos.y;
+		values[2] = pos.z;
+		return true;
+	});
+	FillField("velocities", 4, UNIT_VIS_LOS, [&](const CUnit* unit, uint8_t vis, float* values) {
+		values[0] = unit->speed.x;
+		values[1] = unit->speed.y;
+		values[2] = unit->speed.z;
+		values[3] = unit->speed.w;
+		return true;
+	});
+
+	const auto GetHealthScale = [&](const CUnit* unit, uint8_t vis, float& scale) {
+		const UnitDef* ud = unit->unitDef;
+
+		if ((vis & UNIT_VIS_ALLY) != 0 || ud->decoyDef == nullptr) {
+			scale = 1.0f;
+		} else {
+			scale = ud->decoyDef->health / ud->health;
+		}
+
+		return ((vis & UNIT_VIS_ALLY) != 0 || !ud->hideDamage);
+	};
+
+	FillField("health", 1, UNIT_VIS_LOS, [&](const CUnit* unit, uint8_t vis, float* values) {
+		float scale = 1.0f;
+
+		if (!GetHealthScale(unit, vis, scale))
+			return false;
+
+		values[0] = scale * unit->health;
+		return true;
+	});
+	FillField("maxHealth", 1, UNIT_VIS_LOS, [&](const CUnit* unit, uint8_t vis, float* values) {
+		float scale = 1.0f;
+
+		if (!GetHealthScale(unit, vis, scale))
+			return false;
+
+		values[0] = scale * unit->maxHealth;
+		return true;
+	});
+	FillField("teams", 1, UNIT_VIS_RADAR, [&](const CUnit* unit, uint8_t vis, float* values) {
+		values[0] = unit->team;
+		return true;
+	});
+	FillField("defIDs", 1, UNIT_VIS_TYPED, [&](const CUnit* unit, uint8_t vis, float* values) {
+		const UnitDef* ud = unit->unitDef;
+
+		if ((vis & UNIT_VIS_ALLY) == 0 && ud->decoyDef != nullptr)
+			ud = ud->decoyDef;
+
+		values[0] = ud->id;
+		return true;
+	});
+
+	lua_pushnumber(L, numVisible);
+	lua_pushvalue(L, 2);
+	return 2;
+}
+
+
 /***
  *
  * @function Spring.GetUnitBuildFacing
@@ -11,6 +11,8 @@ class LuaSyncedRead {
 
 	public:
 		static bool PushEntries(lua_State* L);
+		/// makes the callouts that are unsafe in a threaded Update raise an error there
+		static bool MarkMainThreadEntries(lua_State* L);
 
 		static void AllowGameChanges(bool value);
 
@@ -128,6 +130,7 @@ class LuaSyncedRead {
 		static int GetUnitDirection(lua_State* L);
 		static int GetUnitHeading(lua_State* L);
 		static int GetUnitVelocity(lua_State* L);
+		static int GetUnitArrayState(lua_State* L);
 		static int GetUnitBuildFacing(lua_State* L);
 		static int GetUnitIsBuilding(lua_State* L);
 		static int GetUnitWorkerTask(lua_State* L);
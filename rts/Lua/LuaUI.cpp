@@ -136,29 +136,31 @@ CLuaUI::CLuaUI()
 	AddBasicCalls(L); // into Global
 
 	// load the spring libraries
-	if (!LoadCFunctions(L)                                                      ||
-	    !AddEntriesToTable(L, "VFS",         LuaVFS::PushUnsynced)              ||
-	    !AddEntriesToTable(L, "VFS",         LuaZipFileReader::PushUnsynced)    ||
-	    !AddEntriesToTable(L, "VFS",         LuaZipFileWriter::PushUnsynced)    ||
-	    !AddEntriesToTable(L, "VFS",         LuaArchive::PushEntries)           ||
-	    !AddEntriesToTable(L, "UnitDefs",    LuaUnitDefs::PushEntries)          ||
-	    !AddEntriesToTable(L, "WeaponDefs",  LuaWeaponDefs::PushEntries)        ||
-	    !AddEntriesToTable(L, "FeatureDefs", LuaFeatureDefs::PushEntries)       ||
-	    !AddEntriesToTable(L, "Script",      LuaInterCall::PushEntriesUnsynced) ||
-	    !AddEntriesToTable(L, "Script",      LuaScream::PushEntries)            ||
-	    !AddEntriesToTable(L, "Spring",      LuaSyncedRead::PushEntries)        ||
-	    !AddEntriesToTable(L, "Spring",      LuaUnsyncedCtrl::PushEntries)      ||
-	    !AddEntriesToTable(L, "Spring",      LuaUnsyncedRead::PushEntries)      ||
-	    !AddEntriesToTable(L, "Spring",      LuaUICommand::PushEntries)         ||
-	    !AddEntriesToTable(L, "gl",          LuaOpenGL::PushEntries)            ||
-	    !AddEntriesToTable(L, "GL",          LuaConstGL::PushEntries)           ||
-	    !AddEntriesToTable(L, "Engine",      LuaConstEngine::PushEntries)       ||
-	    !AddEntriesToTable(L, "Platform",    LuaConstPlatform::PushEntries)     ||
-	    !AddEntriesToTable(L, "Game",        LuaConstGame::PushEntries)         ||
-	    !AddEntriesToTable(L, "CMD",         LuaConstCMD::PushEntries)          ||
-	    !AddEntriesToTable(L, "CMDTYPE",     LuaConstCMDTYPE::PushEntries)      ||
-	    !AddEntriesToTable(L, "LOG",         LuaUtils::PushLogEntries)          ||
-	    !AddEntriesToTable(L, "VFS",         LuaVFSDownload::PushEntries)
+	if (!LoadCFunctions(L)                                                                     ||
+	    !AddMainThreadEntriesToTable(L, "VFS",         LuaVFS::PushUnsynced)                   ||
+	    !AddMainThreadEntriesToTable(L, "VFS",         LuaZipFileReader::PushUnsynced)         ||
+	    !AddMainThreadEntriesToTable(L, "VFS",         LuaZipFileWriter::PushUnsynced)         ||
+	    !AddMainThreadEntriesToTable(L, "VFS",         LuaArchive::PushEntries)                ||
+	    !AddEntriesToTable(          L, "UnitDefs",    LuaUnitDefs::PushEntries)               ||
+	    !AddEntriesToTable(          L, "WeaponDefs",  LuaWeaponDefs::PushEntries)             ||
+	    !AddEntriesToTable(          L, "FeatureDefs", LuaFeatureDefs::PushEntries)            ||
+	    !AddEntriesToTable(          L, "Script",      LuaInterCall::PushEntriesUnsynced)      ||
+	    !AddEntriesToTable(          L, "Script",      LuaScream::PushEntries)                 ||
+	    !AddEntriesToTable(          L, "Spring",      LuaSyncedRead::PushEntries)             ||
+	    !AddMainThreadEntriesToTable(L, "Spring",      LuaUnsyncedCtrl::PushEntries)           ||
+	    !AddEntriesToTable(          L, "Spring",      LuaUnsyncedRead::PushEntries)           ||
+	    !AddEntriesToTable(          L, "Spring",      LuaSyncedRead::MarkMainThreadEntries)   ||
+	    !AddEntriesToTable(          L, "Spring",      LuaUnsyncedRead::MarkMainThreadEntries) ||
+	    !AddMainThreadEntriesToTable(L, "Spring",      LuaUICommand::PushEntries)              ||
+	    !AddMainThreadEntriesToTable(L, "gl",          LuaOpenGL::PushEntries)                 ||
+	    !AddEntriesToTable(          L, "GL",          LuaConstGL::PushEntries)                ||
+	    !AddEntriesToTable(          L, "Engine",      LuaConstEngine::PushEntries)            ||
+	    !AddEntriesToTable(          L, "Platform",    LuaConstPlatform::PushEntries)          ||
+	    !AddEntriesToTable(          L, "Game",        LuaConstGame::PushEntries)              ||
+	    !AddEntriesToTable(          L, "CMD",         LuaConstCMD::PushEntries)               ||
+	    !AddEntriesToTable(          L, "CMDTYPE",     LuaConstCMDTYPE::PushEntries)           ||
+	    !AddEntriesToTable(          L, "LOG",         LuaUtils::PushLogEntries)               ||
+	    !AddMainThreadEntriesToTable(L, "VFS",         LuaVFSDownload::PushEntries)
 	) {
 		KillLua();
 		return;
@@ -262,6 +264,7 @@ bool CLuaUI::LoadCFunctions(lua_State* L)
 	lua_newtable(L);
 
 	REGISTER_LUA_CFUNC(SetShockFrontFactors);
+	CLuaHandle::WrapMainThreadEntries(L, {"SetShockFrontFactors"});
 
 	lua_setglobal(L, "Spring");
 	return true;
@@ -74,6 +74,7 @@
 #include "System/StringUtil.h"
 #include "System/Misc/SpringTime.h"
 #include "System/ScopedResource.h"
+#include "System/Threading/ThreadPool.h"
 
 #if !defined(HEADLESS) && !defined(NO_SOUND)
 	#include "System/Sound/OpenAL/EFX.h"
@@ -82,6 +83,7 @@
 
 #include <cctype>
 #include <algorithm>
+#include <array>
 
 #include <SDL_keyboard.h>
 #include <SDL_clipboard.h>
@@ -108,7 +110,9 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetProfilerRecordNames);
 
 	REGISTER_LUA_CFUNC(GetLuaMemUsage);
+	REGISTER_LUA_CFUNC(GetLuaMemPoolStats);
 	REGISTER_LUA_CFUNC(GetVidMemUsage);
+	REGISTER_LUA_CFUNC(GetQuadFieldStats);
 
 	REGISTER_LUA_CFUNC(GetDrawFrame);
 	REGISTER_LUA_CFUNC(GetFrameTimeOffset);
@@ -299,6 +303,37 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 	return true;
 }
 
+bool LuaUnsyncedRead::MarkMainThreadEntries(lua_State* L)
+{
+	// these touch render, window or input state the main thread is not done
+	// with during Update, share scratch buffers, or read other Lua states
+	return (CLuaHandle::WrapMainThreadEntries(L, {
+		"GetLuaMemPoolStats",
+		"GetVidMemUsage",
+		"GetQuadFieldStats",
+		"GetNumDisplays",
+		"GetScreenGeometry",
+		"GetVisibleUnits",
+		"GetVisibleFeatures",
+		"GetVisibleProjectiles",
+		"GetRenderUnits",
+		"GetRenderUnitsDrawFlagChanged",
+		"GetRenderFeatures",
+		"GetRenderFeaturesDrawFlagChanged",
+		"ClearUnitsPreviousDrawFlag",
+		"ClearFeaturesPreviousDrawFlag",
+		"GetUnitsInScreenRectangle",
+		"GetFeaturesInScreenRectangle",
+		"GetMapSquareTexture",
+		"TraceScreenRay",
+		"GetClipboard",
+		"GetCurrentTooltip",
+		"MakeGLDBQuery",
+		"GetGLDBQuery",
+		"GetSyncedGCInfo",
+	}));
+}
+
 
 
 
@@ -576,6 +611,33 @@ int LuaUnsyncedRead::GetLuaMemUsage(lua_State* L)
 }
 
 
+/***
+ *
+ * @function Spring.GetLuaMemPoolStats
+ *
+ * Slab statistics of the memory pool backing the calling state; the pool can
+ * be shared with other states. All sizes are in kilobytes.
+ *
+ * @treturn {reserved=number,used=number,requested=number,external=number,peakUsed=number,peakReserved=number,numSlabs=number,fragmentation=number}
+ *   fragmentation is the fraction of reserved slab memory not occupied by live allocations
+ */
+int LuaUnsyncedRead::GetLuaMemPoolStats(lua_State* L)
+{
+	const LuaMemPool::SlabStats stats = GetLuaContextData(L)->memPool->GetSlabStats();
+
+	lua_createtable(L, 0, 8);
+	LuaPushNamedNumber(L, "reserved", stats.reservedBytes / 1024.0f);
+	LuaPushNamedNumber(L, "used", stats.slotBytes / 1024.0f);
+	LuaPushNamedNumber(L, "requested", stats.requestedBytes / 1024.0f);
+	LuaPushNamedNumber(L, "external", stats.externalBytes / 1024.0f);
+	LuaPushNamedNumber(L, "peakUsed", stats.peakSlotBytes / 1024.0f);
+	LuaPushNamedNumber(L, "peakReserved", stats.peakReservedBytes / 1024.0f);
+	LuaPushNamedNumber(L, "numSlabs", stats.numSlabs);
+	LuaPushNamedNumber(L, "fragmentation", 1.0f - stats.slotBytes / std::max(float(stats.reservedBytes), 1.0f));
+	return 1;
+}
+
+
 /***
  *
  * @function Spring.GetVidMemUsage
@@ -595,6 +657,66 @@ int LuaUnsyncedRead::GetVidMemUsage(lua_State* L)
 }
 
 
+/***
+ *
+ * @function Spring.GetQuadFieldStats
+ *
+ * @bool[opt=false] resetQueryCounters after reading them
+ *
+ * @treturn table stats with fields quadSizeX, quadSizeZ, numQuadsX, numQuadsZ,
+ *   numOccupiedQuads, avgUnits (per occupied quad), maxUnits, maxFeatures, maxProjectiles,
+ *   unitHistogram (array, entry 1 counts the empty quads and entry i > 1 those holding
+ *   [2^(i-2), 2^(i-1)) units) and queries ({[queryName] = {calls=number, candidates=number, results=number}, ...});
+ *   query counts stay zero unless counting was enabled with `/quadfieldstats start`
+ */
+int LuaUnsyncedRead::GetQuadFieldStats(lua_State* L)
+{
+	const CQuadField::Stats stats = quadField.GetStats();
+
+	lua_createtable(L, 0, 11);
+	LuaPushNamedNumber(L, "quadSizeX", quadField.GetQuadSizeX());
+	LuaPushNamedNumber(L, "quadSizeZ", quadField.GetQuadSizeZ());
+	LuaPushNamedNumber(L, "numQuadsX", quadField.GetNumQuadsX());
+	LuaPushNamedNumber(L, "numQuadsZ", quadField.GetNumQuadsZ());
+	LuaPushNamedNumber(L, "numOccupiedQuads", stats.numOccupiedQuads);
+	LuaPushNamedNumber(L, "avgUnits", stats.avgUnits);
+	LuaPushNamedNumber(L, "maxUnits", stats.maxUnits);
+	LuaPushNamedNumber(L, "maxFeatures", stats.maxFeatures);
+	LuaPushNamedNumber(L, "maxProjectiles", stats.maxProjectiles);
+
+	lua_pushliteral(L, "unitHistogram");
+	lua_createtable(L, stats.unitHistogram.size(), 0);
+
+	for (size_t i = 0; i < stats.unitHistogram.size(); i++) {
+		lua_pushnumber(L, stats.unitHistogram[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+
+	lua_rawset(L, -3);
+
+	lua_pushliteral(L, "queries");
+	lua_createtable(L, 0, CQuadField::QUERY_COUNT);
+
+	for (int i = 0; i < CQuadField::QUERY_COUNT; i++) {
+		const CQuadField::QueryCounter& qc = stats.queryCounters[i];
+
+		lua_pushstring(L, CQuadField::GetQueryName(CQuadField::QueryType(i)));
+		lua_createtable(L, 0, 3);
+		LuaPushNamedNumber(L, "calls", qc.numCalls);
+		LuaPushNamedNumber(L, "candidates", qc.numCandidates);
+		LuaPushNamedNumber(L, "results", qc.numResults);
+		lua_rawset(L, -3);
+	}
+
+	lua_rawset(L, -3);
+
+	if (luaL_optboolean(L, 1, false))
+		quadField.ResetQueryCounters();
+
+	return 1;
+}
+
+
 static void PushTimer(lua_State* L, const spring_time& time, bool microseconds)
 {
 	// use time since Spring's epoch in MILLIseconds because that
@@ -2289,11 +2411,12 @@ int LuaUnsyncedRead::GetSelectedUnits(lua_State* L)
 }
 
 
-static std::vector< std::pair<int, std::vector<const CUnit*> > > gsusUnitDefMap;
-static std::vector< std::pair<int, int> > gsucCountMap;
+// one per thread since LuaUI may call these from a threaded Update
+static std::array<std::vector< std::pair<int, std::vector<const CUnit*> > >, ThreadPool::MAX_THREADS> gsusUnitDefMapMT;
+static std::array<std::vector< std::pair<int, int> >, ThreadPool::MAX_THREADS> gsucCountMapMT;
 
-static std::vector< std::pair<int, std::vector<const CUnit*> > > ggusUnitDefMap;
-static std::vector< std::pair<int, int> > ggucCountMap;
+static std::array<std::vector< std::pair<int, std::vector<const CUnit*> > >, ThreadPool::MAX_THREADS> ggusUnitDefMapMT;
+static std::array<std::vector< std::pair<int, int> >, ThreadPool::MAX_THREADS> ggucCountMapMT;
 
 
 /*** Get selected units aggregated by unitDefID
@@ -2304,6 +2427,7 @@ static std::vector< std::pair<int, int> > ggucCountMap;
  */
 int LuaUnsyncedRead::GetSelectedUnitsSorted(lua_State* L)
 {
+	std::vector< std::pair<int, std::vector<const CUnit*> > >& gsusUnitDefMap = gsusUnitDefMapMT[ThreadPool::GetThreadNum()];
 	gsusUnitDefMap.clear();
 	gsusUnitDefMap.resize(unitDefHandler->NumUnitDefs() + 1);
 
@@ -2357,6 +2481,7 @@ int LuaUnsyncedRead::GetSelectedUnitsSorted(lua_State* L)
  */
 int LuaUnsyncedRead::GetSelectedUnitsCounts(lua_State* L)
 {
+	std::vector< std::pair<int, int> >& gsucCountMap = gsucCountMapMT[ThreadPool::GetThreadNum()];
 	gsucCountMap.clear();
 	gsucCountMap.resize(unitDefHandler->NumUnitDefs() + 1, {0, 0});
 
@@ -4079,6 +4204,7 @@ int LuaUnsyncedRead::GetGroupUnitsSorted(lua_State* L)
 
 	const CGroup* group = uiGroupHandlers[gu->myTeam].GetGroup(groupID);
 
+	std::vector< std::pair<int, std::vector<const CUnit*> > >& ggusUnitDefMap = ggusUnitDefMapMT[ThreadPool::GetThreadNum()];
 	ggusUnitDefMap.clear();
 	ggusUnitDefMap.resize(unitDefHandler->NumUnitDefs() + 1);
 
@@ -4128,6 +4254,7 @@ int LuaUnsyncedRead::GetGroupUnitsCounts(lua_State* L)
 
 	const CGroup* group = uiGroupHandlers[gu->myTeam].GetGroup(groupID);
 
+	std::vector< std::pair<int, int> >& ggucCountMap = ggucCountMapMT[ThreadPool::GetThreadNum()];
 	ggucCountMap.clear();
 	ggucCountMap.resize(unitDefHandler->NumUnitDefs() + 1, {0, 0});
 
@@ -11,6 +11,8 @@ class LuaUnsyncedRead {
 
 	public:
 		static bool PushEntries(lua_State* L);
+		/// makes the callouts that are unsafe in a threaded Update raise an error there
+		static bool MarkMainThreadEntries(lua_State* L);
 
 	public:
 		static int IsReplay(lua_State* L);
@@ -23,7 +25,9 @@ class LuaUnsyncedRead {
 		static int GetProfilerRecordNames(lua_State* L);
 
 		static int GetLuaMemUsage(lua_State* L);
+		static int GetLuaMemPoolStats(lua_State* L);
 		static int GetVidMemUsage(lua_State* L);
+		static int GetQuadFieldStats(lua_State* L);
 
 		static int GetDrawFrame(lua_State* L);
 		static int GetFrameTimeOffset(lua_State* L);
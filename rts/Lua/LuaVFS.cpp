@@ -79,6 +79,7 @@ bool LuaVFS::PushSynced(lua_State* L)
 	HSTR_PUSH_CFUNC(L, "FileExists", SyncFileExists);
 	HSTR_PUSH_CFUNC(L, "DirList",    SyncDirList);
 	HSTR_PUSH_CFUNC(L, "SubDirs",    SyncSubDirs);
+	HSTR_PUSH_CFUNC(L, "PrefetchFiles", SyncPrefetchFiles);
 
 	return true;
 }
@@ -93,6 +94,7 @@ bool LuaVFS::PushUnsynced(lua_State* L)
 	HSTR_PUSH_CFUNC(L, "FileExists",          UnsyncFileExists);
 	HSTR_PUSH_CFUNC(L, "DirList",             UnsyncDirList);
 	HSTR_PUSH_CFUNC(L, "SubDirs",             UnsyncSubDirs);
+	HSTR_PUSH_CFUNC(L, "PrefetchFiles",       UnsyncPrefetchFiles);
 
 	HSTR_PUSH_CFUNC(L, "GetFileAbsolutePath",      GetFileAbsolutePath);
 	HSTR_PUSH_CFUNC(L, "GetArchiveContainingFile", GetArchiveContainingFile);
@@ -329,6 +331,41 @@ int LuaVFS::UnsyncSubDirs(lua_State* L)
 }
 
 
+/******************************************************************************/
+
+int LuaVFS::PrefetchFiles(lua_State* L, bool synced)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	std::vector<std::string> filePaths;
+	filePaths.reserve(lua_objlen(L, 1));
+
+	for (int i = 1, n = lua_objlen(L, 1); i <= n; i++) {
+		lua_rawgeti(L, 1, i);
+
+		if (lua_israwstring(L, -1))
+			filePaths.emplace_back(lua_tostring(L, -1));
+
+		lua_pop(L, 1);
+	}
+
+	// only affects how soon LoadFile returns, not what it returns
+	CFileHandler::PrefetchFiles(filePaths, GetModes(L, 2, synced));
+	return 0;
+}
+
+
+int LuaVFS::SyncPrefetchFiles(lua_State* L)
+{
+	return PrefetchFiles(L, true);
+}
+
+int LuaVFS::UnsyncPrefetchFiles(lua_State* L)
+{
+	return PrefetchFiles(L, false);
+}
+
+
 int LuaVFS::GetFileAbsolutePath(lua_State* L)
 {
 	const std::string filename = luaL_checkstring(L, 1);
@@ -14,6 +14,9 @@
 #include "Sim/Path/IPathManager.h"
 #include "Sim/Features/FeatureHandler.h"
 #include "System/TimeProfiler.h"
+#include "System/Threading/ThreadPool.h"
+
+#include <atomic>
 
 
 void CBasicMapDamage::Init()
@@ -52,6 +55,7 @@ void CBasicMapDamage::Init()
 	explosionSquaresPool.resize(4 * 1024 * 1024);
 	explosionUpdateQueue.clear();
 	explosionUpdateQueue.reserve(64);
+	recalcAreas.clear();
 
 	std::fill(explosionSquaresPool.begin(), explosionSquaresPool.end(), 0.0f);
 }
@@ -99,7 +103,7 @@ void CBasicMapDamage::Explosion(const float3& pos, float strength, float radius)
 	e.x2 = Clamp<int>((pos.x + radius) / SQUARE_SIZE, 1, mapDims.mapxm1);
 	e.y1 = Clamp<int>((pos.z - radius) / SQUARE_SIZE, 1, mapDims.mapym1);
 	e.y2 = Clamp<int>((pos.z + radius) / SQUARE_SIZE, 1, mapDims.mapym1);
-	e.idx = explSquaresPoolIdx;
+	e.idx = AllocExplosionSquares((e.x2 - e.x1 + 1) * (e.y2 - e.y1 + 1));
 
 	const float* curHeightMap = readMap->GetCornerHeightMapSynced();
 	const float* orgHeightMap = readMap->GetOriginalHeightMapSynced();
@@ -108,59 +112,53 @@ void CBasicMapDamage::Explosion(const float3& pos, float strength, float radius)
 	const float baseStrength = -math::pow(strength, 0.6f) * 3.0f;
 	const float invRadius = 1.0f / radius;
 
-	// figure out how much height to add to each square
-	for (int y = e.y1; y <= e.y2; ++y) {
-		for (int x = e.x1; x <= e.x2; ++x) {
-			const CSolidObject* so = groundBlockingObjectMap.GroundBlockedUnsafe(y * mapDims.mapx + x);
+	{
+		const int tx1 = e.x1 >> 1;
+		const int tz1 = e.y1 >> 1;
+		const int numTypeCols = (e.x2 >> 1) - tx1 + 1;
+		const int numTypeRows = (e.y2 >> 1) - tz1 + 1;
+
+		craterInvHardness.clear();
+		craterInvHardness.resize(numTypeCols * numTypeRows);
+
+		// prevent formation of spikes from isolated "soft spots"
+		// (one or two random squares with extremely low hardness
+		// surrounded by high-strength terrain)
+		for_mt_chunk(tz1, tz1 + numTypeRows, [&](const int tz) {
+			float* rowInvHardness = &craterInvHardness[(tz - tz1) * numTypeCols];
+
+			for (int tx = tx1; tx < (tx1 + numTypeCols); ++tx) {
+				float sumRawHardness = 0.0f;
+
+				for (int j = -1; j <= 1; j++) {
+					for (int i = -1; i <= 1; i++) {
+						const int tmz = Clamp(tz + j, 0, mapDims.hmapy - 1);
+						const int tmx = Clamp(tx + i, 0, mapDims.hmapx - 1);
+						const int tti = typeMap[tmz * mapDims.hmapx + tmx];
+
+						sumRawHardness += (rawHardness[tti] * weightTable[(j + 1) * 3 + (i + 1)]);
+					}
+				}
 
-			// do not change squares with buildings on them here
-			if (so != nullptr && so->blockHeightChanges) {
-				SetExplosionSquare(0.0f);
-				continue;
+				rowInvHardness[tx - tx1] = 1.0f / sumRawHardness;
 			}
+		}, -32);
+	}
 
-			// calculate the distance and normalize it
-			const float expDist = pos.distance2D(float3(x * SQUARE_SIZE, 0.0f, y * SQUARE_SIZE));
-			const float relDist = std::min(1.0f, expDist * invRadius);
-
-			const unsigned int tableIdx = relDist * CRATER_TABLE_SIZE;
-			// const unsigned int ttypeIdx = typeMap[(y >> 1) * mapDims.hmapx + (x >> 1)];
-
-
-			// prevent formation of spikes from isolated "soft spots"
-			// (one or two random squares with extremely low hardness
-			// surrounded by high-strength terrain)
-			float sumRawHardness = 0.0f;
-			float avgInvHardness = 0.0f;
+	// figure out how much height to add to each square; rows are independent
+	// so large craters are split over threads without affecting the result
+	for_mt_chunk(e.y1, e.y2 + 1, [&](const int y) {
+		CalcCraterRow(e, y, baseStrength, invRadius);
+	}, -32);
 
-			for (int j = -1; j <= 1; j++) {
-				for (int i = -1; i <= 1; i++) {
-					const int tmz = Clamp((y >> 1) + j, 0, mapDims.hmapy - 1);
-					const int tmx = Clamp((x >> 1) + i, 0, mapDims.hmapx - 1);
-					const int tti = typeMap[tmz * mapDims.hmapx + tmx];
+	if (strength > 200.0f) {
+		const float* exploSquares = &explosionSquaresPool[e.idx];
 
-					sumRawHardness += (rawHardness[tti] * weightTable[(j + 1) * 3 + (i + 1)]);
-				}
+		for (int y = e.y1; y <= e.y2; ++y) {
+			for (int x = e.x1; x <= e.x2; ++x) {
+				if (*(exploSquares++) < -0.3f)
+					grassDrawer->RemoveGrass(float3(x * SQUARE_SIZE, 0.0f, y * SQUARE_SIZE));
 			}
-
-			avgInvHardness = 1.0f / sumRawHardness;
-
-
-			// FIXME: compensate for flattened ground under dead buildings
-			const float prevDif = curHeightMap[y * mapDims.mapxp1 + x] - orgHeightMap[y * mapDims.mapxp1 + x];
-			      float explDif = baseStrength;
-
-			explDif *= craterTable[tableIdx];
-			explDif *= avgInvHardness;
-			// explDif *= invHardness[ttypeIdx];
-
-			if ((prevDif * explDif) > 0.0f)
-				explDif /= ((math::fabs(prevDif) / EXPLOSION_LIFETIME) + 1);
-
-			if (explDif < -0.3f && strength > 200.0f)
-				grassDrawer->RemoveGrass(float3(x * SQUARE_SIZE, 0.0f, y * SQUARE_SIZE));
-
-			SetExplosionSquare(explDif);
 		}
 	}
 
@@ -213,6 +211,52 @@ void CBasicMapDamage::Explosion(const float3& pos, float strength, float radius)
 	}
 }
 
+void CBasicMapDamage::CalcCraterRow(const Explo& e, int y, float baseStrength, float invRadius)
+{
+	const float* curHeightMap = readMap->GetCornerHeightMapSynced();
+	const float* orgHeightMap = readMap->GetOriginalHeightMapSynced();
+	const float* rowInvHardness = &craterInvHardness[((y >> 1) - (e.y1 >> 1)) * ((e.x2 >> 1) - (e.x1 >> 1) + 1)];
+
+	const int numCols = e.x2 - e.x1 + 1;
+	const int tx1 = e.x1 >> 1;
+
+	const float dz = e.pos.z - y * SQUARE_SIZE;
+
+	float* rowSquares = &explosionSquaresPool[e.idx + (y - e.y1) * numCols];
+
+	// normalized distances first, without any lookups
+	for (int i = 0; i < numCols; ++i) {
+		const float dx = e.pos.x - (e.x1 + i) * SQUARE_SIZE;
+
+		rowSquares[i] = std::min(1.0f, math::sqrt(dx * dx + dz * dz) * invRadius);
+	}
+
+	for (int i = 0; i < numCols; ++i) {
+		const int x = e.x1 + i;
+		const int hmIdx = y * mapDims.mapxp1 + x;
+
+		const CSolidObject* so = groundBlockingObjectMap.GroundBlockedUnsafe(y * mapDims.mapx + x);
+
+		const unsigned int tableIdx = rowSquares[i] * CRATER_TABLE_SIZE;
+
+		// FIXME: compensate for flattened ground under dead buildings
+		const float prevDif = curHeightMap[hmIdx] - orgHeightMap[hmIdx];
+		      float explDif = baseStrength;
+
+		explDif *= craterTable[tableIdx];
+		explDif *= rowInvHardness[(x >> 1) - tx1];
+
+		if ((prevDif * explDif) > 0.0f)
+			explDif /= ((math::fabs(prevDif) / EXPLOSION_LIFETIME) + 1);
+
+		// do not change squares with buildings on them here
+		if (so != nullptr && so->blockHeightChanges)
+			explDif = 0.0f;
+
+		rowSquares[i] = explDif;
+	}
+}
+
 void CBasicMapDamage::RecalcArea(int x1, int x2, int y1, int y2)
 {
 	if (!readMap->GetHeightMapUpdated())
@@ -221,22 +265,41 @@ void CBasicMapDamage::RecalcArea(int x1, int x2, int y1, int y2)
 	x1 = std::max(x1, 0); x2 = std::clamp(x2, x1, mapDims.mapx);
 	y1 = std::max(y1, 0); y2 = std::clamp(y2, y1, mapDims.mapy);
 
-	// do not bother with zero-area updates
-	const SRectangle updRect(x1, y1, x2, y2);
-	if (updRect.GetArea() <= 0)
+	// zero-area updates are dropped by the handler
+	recalcAreas.push_back(SRectangle(x1, y1, x2, y2));
+}
+
+void CBasicMapDamage::FlushRecalcAreas()
+{
+	if (recalcAreas.empty())
 		return;
 
-	readMap->UpdateHeightMapSynced(updRect);
-	featureHandler.TerrainChanged(x1, y1, x2, y2);
-	smoothGround.MapChanged(x1, y1, x2, y2);
+	// craters, terraform and Lua height changes within a frame tend to overlap,
+	// merge them so each consumer only processes every square once
+	recalcAreas.Process(true);
+
+	// the readmap has to go first, everything else depends on its derived maps
+	for (const SRectangle& r: recalcAreas) {
+		readMap->UpdateHeightMapSynced(r);
+	}
+	for (const SRectangle& r: recalcAreas) {
+		featureHandler.TerrainChanged(r.x1, r.z1, r.x2, r.z2);
+		smoothGround.MapChanged(r.x1, r.z1, r.x2, r.z2);
+	}
 	{
 		SCOPED_TIMER("Sim::BasicMapDamage::Los");
-		losHandler->UpdateHeightMapSynced(updRect);
+		for (const SRectangle& r: recalcAreas) {
+			losHandler->UpdateHeightMapSynced(r);
+		}
 	}
 	{
 		SCOPED_TIMER("Sim::BasicMapDamage::Path");
-		pathManager->TerrainChange(x1, y1, x2, y2, TERRAINCHANGE_DAMAGE_RECALCULATION);
+		for (const SRectangle& r: recalcAreas) {
+			pathManager->TerrainChange(r.x1, r.z1, r.x2, r.z2, TERRAINCHANGE_DAMAGE_RECALCULATION);
+		}
 	}
+
+	recalcAreas.clear();
 }
 
 
@@ -244,21 +307,54 @@ void CBasicMapDamage::Update()
 {
 	SCOPED_TIMER("Sim::BasicMapDamage");
 
+	int minY = mapDims.mapy;
+	int maxY = -1;
+
+	activeExplosions.clear();
+
 	for (unsigned int i = explUpdateQueueIdx, n = explosionUpdateQueue.size(); i < n; i++) {
 		Explo& e = explosionUpdateQueue[i];
 
 		if ((e.ttl--) <= 0)
 			continue;
 
+		activeExplosions.push_back(i);
 
-		unsigned int expSquarePoolIdx = e.idx;
+		minY = std::min(minY, e.y1);
+		maxY = std::max(maxY, e.y2);
+	}
 
-		for (int y = e.y1; y <= e.y2; ++y) {
-			for (int x = e.x1; x <= e.x2; ++x) {
-				readMap->AddHeight(y * mapDims.mapxp1 + x, explosionSquaresPool[ (expSquarePoolIdx++) % explosionSquaresPool.size() ]);
+	{
+		std::atomic<bool> heightsChanged = {false};
+
+		// map rows are independent and each square still receives its
+		// additions in explosion order, so the result does not depend
+		// on how rows are distributed over threads
+		for_mt_chunk(minY, maxY + 1, [&](const int y) {
+			bool rowChanged = false;
+
+			for (const unsigned int i: activeExplosions) {
+				const Explo& e = explosionUpdateQueue[i];
+
+				if (y < e.y1 || y > e.y2)
+					continue;
+
+				const int numCols = e.x2 - e.x1 + 1;
+				const float* rowSquares = &explosionSquaresPool[e.idx + (y - e.y1) * numCols];
+
+				rowChanged |= readMap->AddHeights(y * mapDims.mapxp1 + e.x1, rowSquares, numCols);
 			}
-		}
 
+			if (rowChanged)
+				heightsChanged.store(true, std::memory_order_relaxed);
+		}, -32);
+
+		if (heightsChanged.load())
+			readMap->SetHeightMapUpdated();
+	}
+
+	for (const unsigned int i: activeExplosions) {
+		const Explo& e = explosionUpdateQueue[i];
 
 		for (const ExploBuilding& b: e.buildings) {
 			CUnit* unit = unitHandler.GetUnit(b.id);
@@ -282,6 +378,8 @@ void CBasicMapDamage::Update()
 		RecalcArea(e.x1 - 1, e.x2 + 1, e.y1 - 1, e.y2 + 1);
 	}
 
+	// also picks up areas queued by Lua (GameFrame) and terraforming since the last frame
+	FlushRecalcAreas();
 
 	// pop explosions that are no longer being processed
 	while (explUpdateQueueIdx < explosionUpdateQueue.size()) {
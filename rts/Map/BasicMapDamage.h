@@ -4,6 +4,7 @@
 #define _BASIC_MAP_DAMAGE_H
 
 #include "MapDamage.h"
+#include "System/Misc/RectangleOverlapHandler.h"
 
 #include <vector>
 
@@ -12,6 +13,7 @@ class CBasicMapDamage : public IMapDamage
 public:
 	void Explosion(const float3& pos, float strength, float radius) override;
 	void RecalcArea(int x1, int x2, int y1, int y2) override;
+	void FlushRecalcAreas() override;
 	void TerrainTypeHardnessChanged(int ttIndex) override;
 	void TerrainTypeSpeedModChanged(int ttIndex) override;
 
@@ -21,11 +23,16 @@ public:
 	bool Disabled() const override { return false; }
 
 private:
-	void SetExplosionSquare(float v) {
-		explosionSquaresPool[explSquaresPoolIdx] = v;
-
-		explSquaresPoolIdx += 1;
-		explSquaresPoolIdx %= explosionSquaresPool.size();
+	// reserves a contiguous range of pool squares so crater rows can be handled as spans
+	unsigned int AllocExplosionSquares(unsigned int numSquares) {
+		if (numSquares > explosionSquaresPool.size())
+			explosionSquaresPool.resize(numSquares, 0.0f);
+		if ((explSquaresPoolIdx + numSquares) > explosionSquaresPool.size())
+			explSquaresPoolIdx = 0;
+
+		const unsigned int idx = explSquaresPoolIdx;
+		explSquaresPoolIdx += numSquares;
+		return idx;
 	}
 
 	struct ExploBuilding {
@@ -58,9 +65,19 @@ private:
 		std::vector<ExploBuilding> buildings;
 	};
 
+	void CalcCraterRow(const Explo& e, int y, float baseStrength, float invRadius);
+
 	std::vector<float> explosionSquaresPool;
 	std::vector<Explo> explosionUpdateQueue;
 
+	// scratch buffers; smoothed inverse hardness of the typemap squares under
+	// the current explosion and indices of the explosions updated this frame
+	std::vector<float> craterInvHardness;
+	std::vector<unsigned int> activeExplosions;
+
+	// areas changed since the last flush, merged before being recalculated
+	CRectangleOverlapHandler recalcAreas;
+
 	static constexpr unsigned int CRATER_TABLE_SIZE = 200;
 	static constexpr unsigned int EXPLOSION_LIFETIME = 10;
 
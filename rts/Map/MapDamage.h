@@ -15,7 +15,13 @@ public:
 	virtual ~IMapDamage() {}
 
 	virtual void Explosion(const float3& pos, float strength, float radius) = 0;
+	/**
+	 * Queues the heightmap rectangle [x1,x2]x[y1,y2] for recalculation of
+	 * everything derived from it (normals, LOS, pathing, features, ...).
+	 * Queued rectangles are merged and only applied by FlushRecalcAreas.
+	 */
 	virtual void RecalcArea(int x1, int x2, int y1, int y2) = 0;
+	virtual void FlushRecalcAreas() {}
 	virtual void TerrainTypeHardnessChanged(int ttIndex) {}
 	virtual void TerrainTypeSpeedModChanged(int ttIndex) {}
 
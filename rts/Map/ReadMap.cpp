@@ -282,6 +282,7 @@ void CReadMap::PostLoad()
 	hmUpdated = true;
 
 	mapDamage->RecalcArea(0, mapDims.mapx, 0, mapDims.mapy);
+	mapDamage->FlushRecalcAreas();
 }
 #endif //USING_CREG
 
@@ -198,6 +198,10 @@ public:
 	/// if you modify the heightmap through these, call UpdateHeightMapSynced
 	float SetHeight(const int idx, const float h, const int add = 0);
 	float AddHeight(const int idx, const float a);
+	/// span version of AddHeight, does not touch hmUpdated so that disjoint
+	/// spans can be added from multiple threads; returns if any height changed
+	bool AddHeights(const int idx, const float* a, const int n);
+	void SetHeightMapUpdated() { hmUpdated = true; }
 
 	/// These will not modify the current heightmap, only the original
 	float SetOriginalHeight(const int idx, const float h, const int add = 0);
@@ -320,6 +324,19 @@ inline float CReadMap::SetHeight(const int idx, const float h, const int add) {
 	return SetHeightValue((*heightMapSyncedPtr)[idx], idx, h, add);
 }
 
+inline bool CReadMap::AddHeights(const int idx, const float* a, const int n) {
+	float* heights = &(*heightMapSyncedPtr)[idx];
+	bool changed = false;
+
+	for (int i = 0; i < n; i++) {
+		const float newHeight = heights[i] + a[i];
+		changed |= (newHeight != heights[i]);
+		heights[i] = newHeight;
+	}
+
+	return changed;
+}
+
 inline float CReadMap::AddOriginalHeight(const int idx, const float a) { return SetOriginalHeight(idx, a, 1); }
 inline float CReadMap::SetOriginalHeight(const int idx, const float h, const int add) {
 	return SetHeightValue((*originalHeightMapPtr)[idx], idx, h, add);
@@ -4,6 +4,7 @@
 #include "System/Net/UDPConnection.h"
 
 #include <functional>
+#include <limits>
 
 #if defined DEDICATED || defined DEBUG
 	#include <iostream>
@@ -110,6 +111,9 @@ static constexpr unsigned gameProgressFrameInterval = GAME_SPEED * 5;
 
 static constexpr unsigned syncResponseEchoInterval = GAME_SPEED * 2;
 
+/// skipping fewer demo frames than this is faster than reloading from a snapshot
+static constexpr int demoSnapshotMinSkipFrames = GAME_SPEED * 60 * 2;
+
 
 //FIXME remodularize server commands, so they get registered in word completion etc.
 decltype(CGameServer::commandBlacklist) CGameServer::commandBlacklist{
@@ -185,6 +189,10 @@ void CGameServer::Initialize()
 	if (myGameSetup->hostDemo) {
 		Message(spring::format(PlayingDemo, myGameSetup->demoName.c_str()));
 		demoReader.reset(new CDemoReader(myGameSetup->demoName, modGameTime + 0.1f));
+
+		// PreGame picked the same snapshot for our local client to load
+		if ((demoSeekFrame = myClientSetup->demoSeekFrame) > 0)
+			demoSnapshotNum = demoReader->FindSnapshot(0, demoSeekFrame);
 	}
 
 	// initialize players, teams & ais
@@ -406,6 +414,19 @@ void CGameServer::SkipTo(int targetFrameNum)
 	if (serverFrameNum >= targetFrameNum) { return; }
 	if (demoReader == nullptr) { return; }
 
+	// reloading from a snapshot is much faster than simulating a long
+	// stretch of the demo, but only the local client can do that (and
+	// would leave remote spectators behind)
+	if (HasLocalClient() && demoReader->FindSnapshot(serverFrameNum + demoSnapshotMinSkipFrames, targetFrameNum) >= 0) {
+		const auto isRemote = [](const GameParticipant& p) { return (p.clientLink != nullptr && !p.isLocal); };
+
+		if (std::find_if(players.begin(), players.end(), isRemote) == players.end()) {
+			CommandMessage seekMsg(spring::format("skip seek %d", targetFrameNum), SERVER_PLAYER);
+			players[localClientNumber].SendData(std::shared_ptr<const netcode::RawPacket>(seekMsg.Pack()));
+			return;
+		}
+	}
+
 	CommandMessage startMsg(spring::format("skip start %d", targetFrameNum), SERVER_PLAYER);
 	CommandMessage endMsg("skip end", SERVER_PLAYER);
 	Broadcast(std::shared_ptr<const netcode::RawPacket>(startMsg.Pack()));
@@ -469,6 +490,12 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 		switch (msgCode) {
 			case NETMSG_NEWFRAME:
 			case NETMSG_KEYFRAME: {
+				// the local client loaded a snapshot instead of simulating up to it
+				if (demoSnapshotNum >= 0) {
+					SkipToDemoSnapshot();
+					continue;
+				}
+
 				// we can't use CreateNewFrame() here
 				lastNewFrameTick = spring_gettime();
 				serverFrameNum++;
@@ -486,19 +513,8 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 			}
 
 			case NETMSG_CREATE_NEWPLAYER: {
-				try {
-					netcode::UnpackPacket pckt(rpkt, 3);
-					unsigned char spectator, team, playerNum;
-					std::string name;
-					pckt >> playerNum;
-					pckt >> spectator;
-					pckt >> team;
-					pckt >> name;
-					AddAdditionalUser(name, "", true, (bool)spectator, (int)team, playerNum); // even though this is a demo, keep the players vector properly updated
-				} catch (const netcode::UnpackPacketException& ex) {
-					Message(spring::format("Warning: Discarding invalid new player packet in demo: %s", ex.what()));
+				if (!AddDemoPlayer(rpkt))
 					continue;
-				}
 
 				Broadcast(rpkt);
 				break;
@@ -545,6 +561,54 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 	return ret;
 }
 
+bool CGameServer::AddDemoPlayer(std::shared_ptr<const netcode::RawPacket> packet)
+{
+	try {
+		netcode::UnpackPacket pckt(packet, 3);
+		unsigned char spectator, team, playerNum;
+		std::string name;
+		pckt >> playerNum;
+		pckt >> spectator;
+		pckt >> team;
+		pckt >> name;
+		AddAdditionalUser(name, "", true, (bool)spectator, (int)team, playerNum); // even though this is a demo, keep the players vector properly updated
+	} catch (const netcode::UnpackPacketException& ex) {
+		Message(spring::format("Warning: Discarding invalid new player packet in demo: %s", ex.what()));
+		return false;
+	}
+
+	return true;
+}
+
+void CGameServer::SkipToDemoSnapshot()
+{
+	const DemoSnapshotEntry& snapshot = (demoReader->GetSnapshots())[demoSnapshotNum];
+
+	// everything up to the snapshot is part of its state except for
+	// players joining, which the server and clients track separately
+	while (!demoReader->ReachedEnd() && demoReader->GetStreamOffset() < snapshot.streamOffset) {
+		std::shared_ptr<const RawPacket> rpkt(demoReader->GetData(std::numeric_limits<float>::max()));
+
+		if (rpkt == nullptr)
+			break;
+		if (rpkt->length <= 0 || rpkt->data[0] != NETMSG_CREATE_NEWPLAYER)
+			continue;
+		if (!AddDemoPlayer(rpkt))
+			continue;
+
+		Broadcast(rpkt);
+	}
+
+	Message(spring::format("Resuming demo from snapshot at frame %d", snapshot.frameNum));
+
+	serverFrameNum = snapshot.frameNum;
+	lastNewFrameTick = spring_gettime();
+
+	// as in SkipTo, maintain <modGameTime> ourselves
+	modGameTime = demoReader->GetNextDemoReadTime();
+	demoSnapshotNum = -1;
+}
+
 void CGameServer::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
 {
 	for (GameParticipant& p: players) {
@@ -2564,6 +2628,12 @@ void CGameServer::CreateNewFrame(bool fromServerThread, bool fixedFrameTime)
 	if (demoReader != nullptr) {
 		CheckSync();
 		SendDemoData(-1);
+
+		// simulate the remainder of a skip that was resumed from a snapshot
+		if (demoSeekFrame > 0 && demoSnapshotNum < 0 && gameHasStarted) {
+			SkipTo(demoSeekFrame);
+			demoSeekFrame = 0;
+		}
 		return;
 	}
 
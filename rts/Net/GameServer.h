@@ -172,6 +172,10 @@ private:
 	void WriteDemoData();
 	/// read data from demo and send it to clients
 	bool SendDemoData(int targetFrameNum);
+	/// add a player that joined during the game recorded in a demo
+	bool AddDemoPlayer(std::shared_ptr<const netcode::RawPacket> packet);
+	/// continue the demo stream after the snapshot the local client resumed from
+	void SkipToDemoSnapshot();
 
 	void Broadcast(std::shared_ptr<const netcode::RawPacket> packet);
 
@@ -261,6 +265,10 @@ private:
 
 	unsigned localClientNumber = -1u;
 
+	/// snapshot the demo is resumed from (until the stream reaches it), and where to skip to from there
+	int demoSnapshotNum = -1;
+	int demoSeekFrame = 0;
+
 
 	/// The maximum speed users are allowed to set
 	float maxUserSpeed = 1.0f;
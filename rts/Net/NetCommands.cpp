@@ -615,6 +615,7 @@ void CGame::ClientReadNet()
 				lastSimFrameNetPacketTime = spring_gettime();
 
 				SimFrame();
+				SaveDemoSnapshot();
 
 #ifdef SYNCCHECK
 				// both NETMSG_SYNCRESPONSE and NETMSG_NEWFRAME are used for ping calculation by server
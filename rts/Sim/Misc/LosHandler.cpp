@@ -41,7 +41,8 @@ CR_REG_METADATA(CLosHandler,(
 	CR_MEMBER(baseRadarErrorSize),
 	CR_MEMBER(baseRadarErrorMult),
 	CR_MEMBER(radarErrorSizes),
-	CR_IGNORED(losTypes)
+	CR_IGNORED(losTypes),
+	CR_IGNORED(losMapJobs)
 ))
 
 
@@ -90,6 +91,7 @@ void ILosType::Init(const int mipLevel_, LosType type_)
 
 	freeIDs.reserve(4096);
 	losMaps.resize(teamHandler.ActiveAllyTeams());
+	losMapUpdates.resize(losMaps.size());
 
 	const float* ctrHeightMap = readMap->GetCenterHeightMapSynced();
 	const float* mipHeightMap = readMap->GetMIPHeightMapSynced(mipLevel_);
@@ -118,8 +120,10 @@ void ILosType::Kill()
 	losUpdate.clear();
 	losCache.clear();
 
-	losRemove.clear();
-	losAdd.clear();
+	for (LosMapUpdate& lmu: losMapUpdates) {
+		lmu.Clear();
+	}
+
 	losDeleted.clear();
 	losRecalc.clear();
 
@@ -292,6 +296,59 @@ inline void ILosType::LosRemove(SLosInstance* li)
 }
 
 
+inline void ILosType::LosMove(SLosInstance* prv, SLosInstance* cur)
+{
+	assert(prv->allyteam == cur->allyteam);
+
+	if (algoType == LOS_ALGO_RAYCAST) {
+		losMaps[cur->allyteam].MoveRaycast(prv, cur);
+	} else {
+		losMaps[cur->allyteam].MoveCircle(prv, cur);
+	}
+}
+
+
+inline void ILosType::QueueLosRemove(SLosInstance* li, bool moveSource)
+{
+	LosMapUpdate& lmu = losMapUpdates[li->allyteam];
+	lmu.queued = true;
+
+	if (moveSource) {
+		lmu.unpaired.push_back(li);
+	} else {
+		lmu.removed.push_back(li);
+	}
+}
+
+
+inline void ILosType::QueueLosAdd(SLosInstance* li, bool moveTarget)
+{
+	LosMapUpdate& lmu = losMapUpdates[li->allyteam];
+	lmu.queued = true;
+
+	if (moveTarget) {
+		// instances are queued in unit order, so the old instance of a unit
+		// that moved is (almost) always among the latest unpaired removals
+		const auto beg = lmu.unpaired.rbegin();
+		const auto end = beg + std::min(lmu.unpaired.size(), size_t(MOVE_PAIR_WINDOW));
+		const auto pred = [&](const SLosInstance* prv) {
+			const int2 dif = prv->basePos - li->basePos;
+			const int rad = std::min(prv->radius, li->radius);
+			return ((Square(dif.x) + Square(dif.y)) < Square(rad));
+		};
+		const auto iter = std::find_if(beg, end, pred);
+
+		if (iter != end) {
+			lmu.moved.emplace_back(*iter, li);
+			lmu.unpaired.erase(std::next(iter).base());
+			return;
+		}
+	}
+
+	lmu.added.push_back(li);
+}
+
+
 inline void ILosType::RefInstance(SLosInstance* li)
 {
 	if ((++li->refCount) != 1)
@@ -475,7 +532,7 @@ inline int ILosType::GetHashNum(const int allyteam, const int2 baseLos, const fl
 }
 
 
-void ILosType::Update()
+void ILosType::QueueUpdates()
 {
 	// delayed delete
 	while (!delayedDeleteQue.empty() && delayedDeleteQue.front().timeoutTime < gs->frameNum) {
@@ -498,10 +555,6 @@ void ILosType::Update()
 		return;
 
 
-	losRemove.clear();
-	losRemove.reserve(losUpdate.size());
-	losAdd.clear();
-	losAdd.reserve(losUpdate.size());
 	losDeleted.clear();
 	losDeleted.reserve(losUpdate.size());
 
@@ -510,7 +563,7 @@ void ILosType::Update()
 		losRecalc.reserve(losUpdate.size());
 	}
 
-	// filter the updates into their subparts
+	// filter the updates into their subparts, batched per map
 	for (SLosInstance* li: losUpdate) {
 		const auto status = OptimizeInstanceUpdate(li);
 		li->isQueuedForUpdate = false;
@@ -518,18 +571,19 @@ void ILosType::Update()
 		switch (status) {
 			case SLosInstance::TLosStatus::NEW: {
 				if (algoType == LOS_ALGO_RAYCAST) losRecalc.push_back(li);
-				losAdd.push_back(li);
+				QueueLosAdd(li, true);
 			} break;
 			case SLosInstance::TLosStatus::REACTIVATE: {
-				losAdd.push_back(li);
+				QueueLosAdd(li, true);
 			} break;
 			case SLosInstance::TLosStatus::RECALC: {
-				losRemove.push_back(li);
+				// squares change in-place, can not be diffed
+				QueueLosRemove(li, false);
 				if (algoType == LOS_ALGO_RAYCAST) losRecalc.push_back(li);
-				losAdd.push_back(li);
+				QueueLosAdd(li, false);
 			} break;
 			case SLosInstance::TLosStatus::REMOVE: {
-				losRemove.push_back(li);
+				QueueLosRemove(li, true);
 				losDeleted.push_back(li);
 			} break;
 			case SLosInstance::TLosStatus::NONE: {
@@ -546,27 +600,58 @@ void ILosType::Update()
 		}
 	}
 
-	// remove sight
-	//FIXME multithread?
-	for (SLosInstance* li: losRemove) {
+	for (LosMapUpdate& lmu: losMapUpdates) {
+		lmu.removed.insert(lmu.removed.end(), lmu.unpaired.begin(), lmu.unpaired.end());
+		lmu.unpaired.clear();
+	}
+}
+
+
+void ILosType::RemoveInstances(int allyTeam)
+{
+	for (SLosInstance* li: losMapUpdates[allyTeam].removed) {
 		LosRemove(li);
 	}
+}
+
+
+void ILosType::RecalcInstances()
+{
+	if (algoType != LOS_ALGO_RAYCAST)
+		return;
+	if (losUpdate.empty())
+		return;
 
 	// raycast terrain
-	if (algoType == LOS_ALGO_RAYCAST)  {
-		for_mt(0, losRecalc.size(), [&](const int idx) {
-			auto li = losRecalc[idx];
-			assert(li->refCount > 0);
-			li->squares.clear();
-			losMaps[li->allyteam].PrepareRaycast(li);
-		});
+	for_mt(0, losRecalc.size(), [&](const int idx) {
+		auto li = losRecalc[idx];
+		assert(li->refCount > 0);
+		li->squares.clear();
+		losMaps[li->allyteam].PrepareRaycast(li);
+	});
+}
+
+
+void ILosType::AddInstances(int allyTeam)
+{
+	const LosMapUpdate& lmu = losMapUpdates[allyTeam];
+
+	for (const auto& p: lmu.moved) {
+		assert(p.second->refCount > 0);
+		LosMove(p.first, p.second);
 	}
 
-	// add sight
-	for (SLosInstance* li: losAdd) {
+	for (SLosInstance* li: lmu.added) {
 		assert(li->refCount > 0);
 		LosAdd(li);
 	}
+}
+
+
+void ILosType::FinishUpdates()
+{
+	if (losUpdate.empty())
+		return;
 
 	// delete / move to cache unused instances
 	if (algoType == LOS_ALGO_RAYCAST) {
@@ -588,6 +673,11 @@ void ILosType::Update()
 		}
 	}
 
+	for (LosMapUpdate& lmu: losMapUpdates) {
+		if (lmu.queued)
+			lmu.Clear();
+	}
+
 	losUpdate.clear();
 }
 
@@ -799,6 +889,7 @@ void CLosHandler::Update()
 	const size_t maxUnitIndex = minUnitIndex + losBatchSize + (activeUnits.size() % losBatchRate) * (losBatchMult == (losBatchRate - 1));
 	#endif
 
+	// gather per-map operations, concurrently for all types
 	for_mt(0, losTypes.size(), [&](const int idx) {
 		ILosType* lt = losTypes[idx];
 
@@ -814,7 +905,37 @@ void CLosHandler::Update()
 		}
 		#endif
 
-		lt->Update();
+		lt->QueueUpdates();
+	});
+
+	losMapJobs.clear();
+
+	for (ILosType* lt: losTypes) {
+		for (int allyTeam = 0, numAllyTeams = lt->losMaps.size(); allyTeam < numAllyTeams; allyTeam++) {
+			if (!lt->HasMapUpdates(allyTeam))
+				continue;
+
+			losMapJobs.emplace_back(lt, allyTeam);
+		}
+	}
+
+	// every job owns a distinct CLosMap, so all maps of all types can be
+	// modified concurrently; removals have to be applied before the old
+	// squares of recalculated instances are overwritten
+	for_mt(0, losMapJobs.size(), [&](const int idx) {
+		losMapJobs[idx].first->RemoveInstances(losMapJobs[idx].second);
+	});
+
+	for (ILosType* lt: losTypes) {
+		lt->RecalcInstances();
+	}
+
+	for_mt(0, losMapJobs.size(), [&](const int idx) {
+		losMapJobs[idx].first->AddInstances(losMapJobs[idx].second);
+	});
+
+	for_mt(0, losTypes.size(), [&](const int idx) {
+		losTypes[idx]->FinishUpdates();
 	});
 }
 
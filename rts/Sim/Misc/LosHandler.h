@@ -128,7 +128,17 @@ public:
 	void Kill();
 
 public:
-	void Update();
+	// update phases, run in sequence by CLosHandler::Update
+	// the per-allyteam phases touch only losMaps[allyTeam] so
+	// can run concurrently for all maps of all ILosType's
+	void QueueUpdates();
+	void RemoveInstances(int allyTeam);
+	void RecalcInstances();
+	void AddInstances(int allyTeam);
+	void FinishUpdates();
+
+	bool HasMapUpdates(int allyTeam) const { return (losMapUpdates[allyTeam].queued); }
+
 	void UpdateHeightMapSynced(SRectangle rect);
 	void RemoveUnit(CUnit* unit, bool delayed = false);
 	void UpdateUnit(CUnit* unit, bool ignore = false);
@@ -138,6 +148,10 @@ private:
 
 	void LosAdd(SLosInstance* instance);
 	void LosRemove(SLosInstance* instance);
+	void LosMove(SLosInstance* prvInstance, SLosInstance* curInstance);
+
+	void QueueLosRemove(SLosInstance* instance, bool moveSource);
+	void QueueLosAdd(SLosInstance* instance, bool moveTarget);
 
 	void RefInstance(SLosInstance* instance);
 	void UnrefInstance(SLosInstance* instance);
@@ -187,12 +201,36 @@ private:
 	std::deque<SLosInstance*> losUpdate;
 	std::deque<SLosInstance*> losCache;
 
-	std::vector<SLosInstance*> losRemove;
-	std::vector<SLosInstance*> losAdd;
+	// add/remove operations batched per CLosMap
+	struct LosMapUpdate {
+		void Clear() {
+			removed.clear();
+			added.clear();
+			moved.clear();
+			unpaired.clear();
+			queued = false;
+		}
+
+		std::vector<SLosInstance*> removed;
+		std::vector<SLosInstance*> added;
+		// {old, new} instance pairs with overlapping footprints
+		// (mostly from units that moved a few squares), applied
+		// as a delta-ring instead of a full remove and re-add
+		std::vector<std::pair<SLosInstance*, SLosInstance*>> moved;
+		// removals that may still pair up with a later addition
+		std::vector<SLosInstance*> unpaired;
+
+		bool queued = false;
+	};
+
+	std::vector<LosMapUpdate> losMapUpdates;
 	std::vector<SLosInstance*> losDeleted;
 	std::vector<SLosInstance*> losRecalc;
 
 	static constexpr int CACHE_SIZE = 4096;
+	// how many of the most recent unpaired removals are
+	// checked for overlap with each addition to a map
+	static constexpr int MOVE_PAIR_WINDOW = 8;
 };
 
 
@@ -315,6 +353,9 @@ private:
 	*/
 
 	std::array<bool, MAX_TEAMS> globalLOS;
+
+	// {type, allyteam} maps with pending add/remove operations
+	std::vector<std::pair<ILosType*, int>> losMapJobs;
 private:
 	static constexpr float defBaseRadarErrorSize = 96.0f;
 	static constexpr float defBaseRadarErrorMult =  2.0f;
@@ -2,9 +2,11 @@
 
 #include <algorithm>
 #include <array>
+#include <limits>
 
 #include "LosMap.h"
 #include "LosHandler.h"
+#include "LosMapKernels.h"
 #include "Map/ReadMap.h"
 #include "System/SpringMath.h"
 #include "System/float3.h"
@@ -22,6 +24,9 @@ static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RADIUS_ISQRT_TABL
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RAYCAST_ANGLE_TABLES;
 static std::array<std::vector< char>, ThreadPool::MAX_THREADS> LOSRAY_SQUARE_TABLES; // visible squares per instance
 
+static std::array<std::vector<int2>, ThreadPool::MAX_THREADS> CIRCLE_ROW_SPAN_TABLES;
+static std::array<std::vector<SLosInstance::RLE>, ThreadPool::MAX_THREADS> CIRCLE_SQUARE_TABLES[2];
+
 
 static float isqrtTableLookup(unsigned r, int threadNum)
 {
@@ -106,6 +111,93 @@ void MidpointCircleAlgoPerLine(int radius, const F& func)
 
 
 
+// Calls func(start, length, amount) for every run of squares that is covered
+// by exactly one of two sorted and non-overlapping run-lists; amount is -1 for
+// squares only in prv and +1 for squares only in cur. Squares covered by both
+// (i.e. the bulk of a slightly moved instance) are skipped.
+template<typename F>
+static void DiffSquareRuns(
+	const std::vector<SLosInstance::RLE>& prv,
+	const std::vector<SLosInstance::RLE>& cur,
+	const F& func
+) {
+	constexpr int END = std::numeric_limits<int>::max();
+
+	size_t pi = 0;
+	size_t ci = 0;
+
+	int2 pr = {END, END}; // [start, end) of current prv run
+	int2 cr = {END, END}; // [start, end) of current cur run
+
+	const auto NextRun = [](const std::vector<SLosInstance::RLE>& runs, size_t& i, int2& r) {
+		// skip empty (e.g. EMPTY_RLE) runs
+		while (i < runs.size() && runs[i].length == 0)
+			++i;
+
+		if (i < runs.size()) {
+			r = {runs[i].start, runs[i].start + int(runs[i].length)};
+			++i;
+		} else {
+			r = {END, END};
+		}
+	};
+
+	NextRun(prv, pi, pr);
+	NextRun(cur, ci, cr);
+
+	while (pr.x != END || cr.x != END) {
+		if (pr.y <= cr.x) { func(pr.x, pr.y - pr.x, -1); NextRun(prv, pi, pr); continue; }
+		if (cr.y <= pr.x) { func(cr.x, cr.y - cr.x, +1); NextRun(cur, ci, cr); continue; }
+
+		// runs overlap; emit the leading part covered by only one of them
+		if (pr.x < cr.x) { func(pr.x, cr.x - pr.x, -1); pr.x = cr.x; }
+		if (cr.x < pr.x) { func(cr.x, pr.x - cr.x, +1); cr.x = pr.x; }
+
+		// skip the shared part
+		pr.x = (cr.x = std::min(pr.y, cr.y));
+
+		if (pr.x == pr.y) NextRun(prv, pi, pr);
+		if (cr.x == cr.y) NextRun(cur, ci, cr);
+	}
+}
+
+
+// converts the circular area covered by an instance into sorted square-runs,
+// equivalent to the squares touched by CLosMap::AddCircle
+static void GetCircleSquares(const SLosInstance* li, const int2 size, std::vector<SLosInstance::RLE>& squares)
+{
+	std::vector<int2>& rowSpans = CIRCLE_ROW_SPAN_TABLES[ThreadPool::GetThreadNum()];
+
+	rowSpans.clear();
+	rowSpans.resize((2 * li->radius) + 1, int2(0, 0));
+	squares.clear();
+
+	MidpointCircleAlgoPerLine(li->radius, [&](int width, int y) {
+		const unsigned y_ = li->basePos.y + y;
+
+		if (y_ < size.y) {
+			const unsigned sx = Clamp(li->basePos.x - width,     0, size.x);
+			const unsigned ex = Clamp(li->basePos.x + width + 1, 0, size.x);
+
+			rowSpans[y + li->radius] = int2(sx, ex);
+		}
+	});
+
+	for (int y = -li->radius; y <= li->radius; ++y) {
+		const int2 span = rowSpans[y + li->radius];
+
+		if (span.x >= span.y)
+			continue;
+
+		squares.push_back({(li->basePos.y + y) * size.x + span.x, unsigned(span.y - span.x)});
+	}
+}
+
+
+
+
+
+
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
 /// raycast precalculation helper
@@ -411,14 +503,28 @@ void CLosMap::AddCircle(SLosInstance* instance, int amount)
 			const unsigned sx = Clamp(instance->basePos.x - width,     0, size.x);
 			const unsigned ex = Clamp(instance->basePos.x + width + 1, 0, size.x);
 
-			for (unsigned x_ = sx; x_ < ex; ++x_) {
-				losmap[(y_ * size.x) + x_] += amount;
-			}
+			LosMapKernels::AddSquareSpan(&losmap[(y_ * size.x) + sx], ex - sx, amount);
 		}
 	});
 }
 
 
+void CLosMap::MoveCircle(const SLosInstance* prv, const SLosInstance* cur)
+{
+	const int threadNum = ThreadPool::GetThreadNum();
+
+	std::vector<SLosInstance::RLE>& prvSquares = CIRCLE_SQUARE_TABLES[0][threadNum];
+	std::vector<SLosInstance::RLE>& curSquares = CIRCLE_SQUARE_TABLES[1][threadNum];
+
+	GetCircleSquares(prv, size, prvSquares);
+	GetCircleSquares(cur, size, curSquares);
+
+	DiffSquareRuns(prvSquares, curSquares, [&](int start, int length, int amount) {
+		AddSquareRun(start, length, amount, false);
+	});
+}
+
+
 void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 {
 	const auto& losSquares = instance->squares;
@@ -426,36 +532,55 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 	if (losSquares.empty() || losSquares[0].length == SLosInstance::EMPTY_RLE.length)
 		return;
 
+	const bool updateUnsyncedHeightMap = UpdateUnsyncedHeightMap(instance);
+
+	for (const SLosInstance::RLE rle: losSquares) {
+		AddSquareRun(rle.start, rle.length, amount, updateUnsyncedHeightMap);
+	}
+}
+
+
+void CLosMap::MoveRaycast(const SLosInstance* prv, const SLosInstance* cur)
+{
+	// both instances belong to this map, so share an allyteam
+	const bool updateUnsyncedHeightMap = UpdateUnsyncedHeightMap(cur);
+
+	DiffSquareRuns(prv->squares, cur->squares, [&](int start, int length, int amount) {
+		AddSquareRun(start, length, amount, updateUnsyncedHeightMap);
+	});
+}
+
+
+bool CLosMap::UpdateUnsyncedHeightMap(const SLosInstance* instance) const
+{
 	// inform ReadMap when squares enter LoS
 	const bool visibleInstanceSquares = (instance->allyteam >= 0 && (instance->allyteam == gu->myAllyTeam || gu->spectatingFullView));
-	const bool updateUnsyncedHeightMap = sendReadmapEvents && visibleInstanceSquares;
+	return (sendReadmapEvents && visibleInstanceSquares);
+}
+
 
+void CLosMap::AddSquareRun(int start, int length, int amount, bool updateUnsyncedHeightMap)
+{
 	if ((amount > 0) && updateUnsyncedHeightMap) {
-		for (const SLosInstance::RLE rle: losSquares) {
-			for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
-				losmap[idx] += amount;
+		for (int idx = start, len = length; len > 0; --len, ++idx) {
+			losmap[idx] += amount;
 
-				// skip if this los-square did not *enter* LOS
-				if (losmap[idx] != amount)
-					continue;
+			// skip if this los-square did not *enter* LOS
+			if (losmap[idx] != amount)
+				continue;
 
-				const int2 lm = IdxToCoord(idx, size.x);
-				const int2 p1 = (lm             ) * LOS2HEIGHT;
-				const int2 p2 = (lm + int2(1, 1)) * LOS2HEIGHT;
-				const int2 p3 = {std::min(p2.x, mapDims.mapxm1), std::min(p2.y, mapDims.mapym1)};
+			const int2 lm = IdxToCoord(idx, size.x);
+			const int2 p1 = (lm             ) * LOS2HEIGHT;
+			const int2 p2 = (lm + int2(1, 1)) * LOS2HEIGHT;
+			const int2 p3 = {std::min(p2.x, mapDims.mapxm1), std::min(p2.y, mapDims.mapym1)};
 
-				readMap->UpdateLOS(SRectangle(p1.x, p1.y,  p3.x, p3.y));
-			}
+			readMap->UpdateLOS(SRectangle(p1.x, p1.y,  p3.x, p3.y));
 		}
 
 		return;
 	}
 
-	for (const SLosInstance::RLE rle: losSquares) {
-		for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
-			losmap[idx] += amount;
-		}
-	}
+	LosMapKernels::AddSquareSpan(&losmap[start], length, amount);
 }
 
 
@@ -607,6 +732,8 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 
 	isqrtTableExpand((radius + 1) * (radius + 1), threadNum);
 
+	const float* isqrtTable = RADIUS_ISQRT_TABLES[threadNum].data();
+
 	// Optimization: precalculate all angles
 	// 1. Center squares are accessed much more often by more rays than those on the border.
 	// 2. The heightmap is much bigger than the circle, and won't fit into the L2/L3. So
@@ -619,27 +746,17 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 
 		const size_t oidx = ToAngleMapIdx(int2(sx - pos.x, y), radius);
 
-		float* raycastAnglesPtr = &raycastAngles[oidx];
-		char* losRaySquaresPtr = &losRaySquares[oidx];
-
-		int idx = MAP_SQUARE(int2(sx, y_));
-
-		for (unsigned x_ = sx; x_ < ex; ++x_) {
-			const int2 off(x_ - pos.x, y);
-
-			if (off == int2(0, 0)) {
-				++idx;
-				++raycastAnglesPtr;
-				++losRaySquaresPtr;
-				continue;
-			}
-
-			const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
-			const float dh = std::max(0.0f, mipHeightMap[idx++]) - losHeight;
-
-			*(raycastAnglesPtr++) = (dh + LOS_BONUS_HEIGHT) * invR;
-			*(losRaySquaresPtr++) = true;
-		}
+		LosMapKernels::CalcRayAngles(
+			&raycastAngles[oidx],
+			&losRaySquares[oidx],
+			&mipHeightMap[MAP_SQUARE(int2(sx, y_))],
+			isqrtTable,
+			sx - pos.x,
+			y,
+			ex - sx,
+			losHeight,
+			LOS_BONUS_HEIGHT
+		);
 	});
 
 	// cast the rays
@@ -695,6 +812,8 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 
 	isqrtTableExpand((radius + 1) * (radius + 1), threadNum);
 
+	const float* isqrtTable = RADIUS_ISQRT_TABLES[threadNum].data();
+
 	// Optimization: precalc all angles
 	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
 		const unsigned y_ = pos.y + y;
@@ -707,27 +826,17 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 
 			const size_t oidx = ToAngleMapIdx(int2(sx - pos.x, y), radius);
 
-			float* raycastAnglesPtr = &raycastAngles[oidx];
-			char* losRaySquaresPtr = &losRaySquares[oidx];
-
-			int idx = MAP_SQUARE(int2(sx, y_));
-
-			for (unsigned x_ = sx; x_ < ex; ++x_) {
-				const int2 off(x_ - pos.x, y);
-
-				if (off == int2(0, 0)) {
-					++idx;
-					++raycastAnglesPtr;
-					++losRaySquaresPtr;
-					continue;
-				}
-
-				const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
-				const float dh = std::max(0.0f, mipHeightMap[idx++]) - losHeight;
-
-				*(raycastAnglesPtr++) = (dh + LOS_BONUS_HEIGHT) * invR;
-				*(losRaySquaresPtr++) = true;
-			}
+			LosMapKernels::CalcRayAngles(
+				&raycastAngles[oidx],
+				&losRaySquares[oidx],
+				&mipHeightMap[MAP_SQUARE(int2(sx, y_))],
+				isqrtTable,
+				sx - pos.x,
+				y,
+				ex - sx,
+				losHeight,
+				LOS_BONUS_HEIGHT
+			);
 		}
 	});
 
@@ -43,6 +43,13 @@ public:
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void PrepareRaycast(SLosInstance* instance) const;
 
+	/// same result as AddCircle(prv, -1) + AddCircle(cur, 1), but only
+	/// touches the squares covered by exactly one of both instances
+	void MoveCircle(const SLosInstance* prv, const SLosInstance* cur);
+
+	/// same result as AddRaycast(prv, -1) + AddRaycast(cur, 1), see above
+	void MoveRaycast(const SLosInstance* prv, const SLosInstance* cur);
+
 public:
 	int At(int2 p) const {
 		p.x = Clamp(p.x, 0, size.x - 1);
@@ -59,6 +66,9 @@ private:
 	void SafeLosAdd(SLosInstance* instance) const;
 
 	void AddSquaresToInstance(SLosInstance* li, const std::vector<char>& losRaySquares) const;
+	void AddSquareRun(int start, int length, int amount, bool updateUnsyncedHeightMap);
+
+	bool UpdateUnsyncedHeightMap(const SLosInstance* instance) const;
 
 protected:
 	int2 size;
@@ -0,0 +1,135 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOS_MAP_KERNELS_H
+#define LOS_MAP_KERNELS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "xsimd/xsimd.hpp"
+
+
+// row-span kernels used by CLosMap; the vectorized versions
+// must produce bit-identical output to the scalar ones since
+// the losmap is synced state (see test/engine/Sim/Misc)
+namespace LosMapKernels {
+	/// adds amount to each of count consecutive losmap squares
+	inline void AddSquareSpanScalar(unsigned short* squares, int count, int amount)
+	{
+		for (int i = 0; i < count; ++i) {
+			squares[i] += amount;
+		}
+	}
+
+	inline void AddSquareSpan(unsigned short* squares, int count, int amount)
+	{
+		int i = 0;
+
+		#if defined(XSIMD_BATCH_INT16_SIZE)
+		using BatchType = xsimd::batch<uint16_t, XSIMD_BATCH_INT16_SIZE>;
+
+		// two's complement wrap-around, same as the scalar narrowing
+		const BatchType inc(static_cast<uint16_t>(amount));
+
+		for (; (i + XSIMD_BATCH_INT16_SIZE) <= count; i += XSIMD_BATCH_INT16_SIZE) {
+			BatchType sqrs;
+			sqrs.load_unaligned(squares + i);
+			sqrs = sqrs + inc;
+			sqrs.store_unaligned(squares + i);
+		}
+		#endif
+
+		AddSquareSpanScalar(squares + i, count - i, amount);
+	}
+
+
+	/**
+	 * @brief computes the raycast angles of count consecutive squares in a row
+	 * offset (offX, offY) from the ray origin, and marks them as visible
+	 *
+	 * heights, angles and visible all point to the first square of the span,
+	 * isqrtTable[i] holds 1/sqrt(max(i, 1)); the origin square (if part of the
+	 * span) is left untouched
+	 */
+	inline void CalcRayAnglesScalar(
+		float* angles,
+		char* visible,
+		const float* heights,
+		const float* isqrtTable,
+		int offX,
+		int offY,
+		int count,
+		float losHeight,
+		float bonusHeight
+	) {
+		for (int i = 0; i < count; ++i) {
+			const int dx = offX + i;
+
+			if (dx == 0 && offY == 0)
+				continue;
+
+			const float invR = isqrtTable[dx * dx + offY * offY];
+			const float dh = std::max(0.0f, heights[i]) - losHeight;
+
+			angles[i] = (dh + bonusHeight) * invR;
+			visible[i] = true;
+		}
+	}
+
+	inline void CalcRayAngles(
+		float* angles,
+		char* visible,
+		const float* heights,
+		const float* isqrtTable,
+		int offX,
+		int offY,
+		int count,
+		float losHeight,
+		float bonusHeight
+	) {
+		int i = 0;
+
+		#if defined(XSIMD_BATCH_FLOAT_SIZE)
+		using BatchType = xsimd::batch<float, XSIMD_BATCH_FLOAT_SIZE>;
+
+		// the origin is never overwritten, restore it after the batched part
+		const bool hasOrigin = (offY == 0 && offX <= 0 && (offX + count) > 0);
+		const float originAngle = hasOrigin? angles[-offX]: 0.0f;
+		const char originVisible = hasOrigin? visible[-offX]: 0;
+
+		const BatchType zeros(0.0f);
+		const BatchType losHeights(losHeight);
+		const BatchType bonusHeights(bonusHeight);
+
+		alignas(64) float invRadii[XSIMD_BATCH_FLOAT_SIZE];
+
+		for (; (i + XSIMD_BATCH_FLOAT_SIZE) <= count; i += XSIMD_BATCH_FLOAT_SIZE) {
+			for (int j = 0; j < XSIMD_BATCH_FLOAT_SIZE; ++j) {
+				const int dx = offX + i + j;
+				invRadii[j] = isqrtTable[dx * dx + offY * offY];
+			}
+
+			BatchType hgts;
+			hgts.load_unaligned(heights + i);
+
+			// operand order matters: max(hgt, 0) is (hgt > 0)? hgt: 0 like
+			// std::max(0.0f, hgt), also for signed zeros and NaN's
+			const BatchType dh = xsimd::max(hgts, zeros) - losHeights;
+			const BatchType ang = (dh + bonusHeights) * BatchType(&invRadii[0], xsimd::aligned_mode());
+
+			ang.store_unaligned(angles + i);
+			std::memset(visible + i, true, XSIMD_BATCH_FLOAT_SIZE);
+		}
+
+		if (hasOrigin && -offX < i) {
+			angles[-offX] = originAngle;
+			visible[-offX] = originVisible;
+		}
+		#endif
+
+		CalcRayAnglesScalar(angles + i, visible + i, heights + i, isqrtTable, offX + i, offY, count - i, losHeight, bonusHeight);
+	}
+}
+
+#endif
@@ -37,7 +37,7 @@ void CModInfo::ResetState()
 
 		maxCollisionPushMultiplier = std::numeric_limits<float>::infinity();
 		unitQuadPositionUpdateRate = 3;
-		groundUnitCollisionAvoidanceUpdateRate = 3;
+		groundUnitCollisionAvoidanceUpdateRate = 1;
 
 		forceCollisionsSingleThreaded = false;
 		forceCollisionAvoidanceSingleThreaded = false;
@@ -112,9 +112,17 @@ void CModInfo::ResetState()
 		pfUpdateRateScale = 1.f;
 		pfForceSingleThreaded = false;
 		pfForceUpdateSingleThreaded = false;
+		qtpfsMultiThreadedSearches = false;
+		pfFlowFields = false;
 
 		enableSmoothMesh = true;
 		quadFieldQuadSizeInElmos = 128;
+		quadFieldAdaptiveResize = false;
+		quadFieldMinQuadSizeInElmos = 32;
+		quadFieldMaxQuadSizeInElmos = 512;
+		quadFieldTargetUnitsPerQuad = 8.0f;
+
+		multiThreadedSlowUpdate = false;
 
 		SLuaAllocLimit::MAX_ALLOC_BYTES = SLuaAllocLimit::MAX_ALLOC_BYTES_DEFAULT;
 
@@ -161,10 +169,18 @@ void CModInfo::Init(const std::string& modFileName)
 		pfUpdateRateScale = system.GetFloat("pathFinderUpdateRateScale", pfUpdateRateScale);
 		pfForceSingleThreaded = system.GetBool("pfForceSingleThreaded", pfForceSingleThreaded);
 		pfForceUpdateSingleThreaded = system.GetBool("pfForceUpdateSingleThreaded", pfForceUpdateSingleThreaded);
+		qtpfsMultiThreadedSearches = system.GetBool("qtpfsMultiThreadedSearches", qtpfsMultiThreadedSearches);
+		pfFlowFields = system.GetBool("pathFinderFlowFields", pfFlowFields);
 
 		enableSmoothMesh = system.GetBool("enableSmoothMesh", enableSmoothMesh);
 
 		quadFieldQuadSizeInElmos = Clamp(system.GetInt("quadFieldQuadSizeInElmos", quadFieldQuadSizeInElmos), 8, 1024);
+		quadFieldAdaptiveResize = system.GetBool("quadFieldAdaptiveResize", quadFieldAdaptiveResize);
+		quadFieldMinQuadSizeInElmos = Clamp(system.GetInt("quadFieldMinQuadSizeInElmos", quadFieldMinQuadSizeInElmos), 8, 1024);
+		quadFieldMaxQuadSizeInElmos = Clamp(system.GetInt("quadFieldMaxQuadSizeInElmos", quadFieldMaxQuadSizeInElmos), quadFieldMinQuadSizeInElmos, 1024);
+		quadFieldTargetUnitsPerQuad = std::max(system.GetFloat("quadFieldTargetUnitsPerQuad", quadFieldTargetUnitsPerQuad), 1.0f);
+
+		multiThreadedSlowUpdate = system.GetBool("multiThreadedSlowUpdate", multiThreadedSlowUpdate);
 
 		// Specify in megabytes: 1 << 20 = (1024 * 1024)
 		SLuaAllocLimit::MAX_ALLOC_BYTES = static_cast<decltype(SLuaAllocLimit::MAX_ALLOC_BYTES)>(system.GetInt("LuaAllocLimit", SLuaAllocLimit::MAX_ALLOC_BYTES >> 20u)) << 20u;
@@ -62,7 +62,7 @@ public:
 	// a lower number will increase CPU load, but increase accuracy of collision detection
 	int unitQuadPositionUpdateRate;
 
-	// rate in sim frames that ground/sea units update their unit collision avoidance vectors (default: 3)
+	// rate in sim frames that ground/sea units update their unit collision avoidance vectors (default: 1)
 	// a lower number will increase CPU load, but improve reaction time of collision avoidance
 	int groundUnitCollisionAvoidanceUpdateRate;
 
@@ -190,6 +190,10 @@ public:
 	int pathFinderSystem;
 	bool pfForceSingleThreaded;
 	bool pfForceUpdateSingleThreaded;
+	/// run queued QTPFS searches of different node-layers on the thread-pool
+	bool qtpfsMultiThreadedSearches;
+	/// serve long-range HAPFS requests towards the same goal from one shared flow field
+	bool pfFlowFields;
 
 	float pfRawDistMult;
 	float pfUpdateRate; // remove if Default PFS gets replaced/removed.
@@ -198,6 +202,14 @@ public:
 	bool enableSmoothMesh;
 
 	int quadFieldQuadSizeInElmos;
+	/// halve or double the quad-size during the game depending on the unit loading factor
+	bool quadFieldAdaptiveResize;
+	int quadFieldMinQuadSizeInElmos;
+	int quadFieldMaxQuadSizeInElmos;
+	float quadFieldTargetUnitsPerQuad;
+
+	/// run the read-only parts of unit SlowUpdate's on the thread-pool
+	bool multiThreadedSlowUpdate;
 
 	bool allowTake;
 	bool allowEnginePlayerlist;
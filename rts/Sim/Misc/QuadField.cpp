@@ -9,9 +9,11 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "System/ContainerUtil.h"
+#include "System/Log/ILog.h"
 #include "System/Threading/ThreadPool.h"
 
 #ifndef UNIT_TEST
+	#include "Sim/Misc/ModInfo.h"
 	#include "Sim/Features/Feature.h"
 	#include "Sim/Projectiles/Projectile.h"
 	#include "Sim/Units/Unit.h"
@@ -31,7 +33,9 @@ CR_REG_METADATA(CQuadField, (
 	CR_IGNORED(tempFeatures),
 	CR_IGNORED(tempProjectiles),
 	CR_IGNORED(tempSolids),
-	CR_IGNORED(tempQuads)
+	CR_IGNORED(tempQuads),
+	CR_IGNORED(queryCounters),
+	CR_IGNORED(countQueries)
 ))
 
 CR_BIND(CQuadField::Quad, )
@@ -48,54 +52,205 @@ CR_REG_METADATA_SUB(CQuadField, Quad, (
 
 CQuadField quadField;
 
+// frames between two adaptive resize checks
+static constexpr int RESIZE_CHECK_INTERVAL = GAME_SPEED * 10;
+
 
 #ifndef UNIT_TEST
-/*
-void CQuadField::Resize(int quad_size)
-{
-	CQuadField* oldQuadField = &quadField;
-	CQuadField newQuadField;
-
-	newQuadField.Init(int2(mapDims.mapx, mapDims.mapy), quad_size);
-
-	for (int zq = 0; zq < oldQuadField->GetNumQuadsZ(); zq++) {
-		for (int xq = 0; xq < oldQuadField->GetNumQuadsX(); xq++) {
-			const CQuadField::Quad& quad = oldQuadField->GetQuadAt(xq, zq);
-
-			// COPY the object lists because the Remove* functions modify them
-			// NOTE:
-			//   teamUnits is updated internally by RemoveUnit and MovedUnit
-			//
-			//   if a unit exists in multiple quads in the old field, it will
-			//   be removed from all of them and there is no danger of double
-			//   re-insertion (important if new grid has higher resolution)
-			const std::vector<CUnit*      > units       = quad.units;
-			const std::vector<CFeature*   > features    = quad.features;
-			const std::vector<CProjectile*> projectiles = quad.projectiles;
-
-			for (auto it = units.cbegin(); it != units.cend(); ++it) {
-				oldQuadField->RemoveUnit(*it);
-				newQuadField->MovedUnit(*it); // handles addition
-			}
+void CQuadField::Resize(int quadSize)
+{
+	if (quadSize == quadSizeX && quadSize == quadSizeZ)
+		return;
 
-			for (auto it = features.cbegin(); it != features.cend(); ++it) {
-				oldQuadField->RemoveFeature(*it);
-				newQuadField->AddFeature(*it);
-			}
+	std::vector<CUnit*> units;
+	std::vector<CFeature*> features;
+	std::vector<CProjectile*> projectiles;
+	std::vector<CPlasmaRepulser*> repulsers;
+
+	// objects can exist in multiple quads, collect each of them once
+	for (const Quad& quad: baseQuads) {
+		units.insert(units.end(), quad.units.begin(), quad.units.end());
+		features.insert(features.end(), quad.features.begin(), quad.features.end());
+		projectiles.insert(projectiles.end(), quad.projectiles.begin(), quad.projectiles.end());
+		repulsers.insert(repulsers.end(), quad.repulsers.begin(), quad.repulsers.end());
+	}
 
-			for (auto it = projectiles.cbegin(); it != projectiles.cend(); ++it) {
-				oldQuadField->RemoveProjectile(*it);
-				newQuadField->AddProjectile(*it);
-			}
-		}
+	// re-insertion order defines the order of the per-quad object lists and
+	// hence that of query results, so it must not depend on pointer values
+	const auto idCmp = [](const auto* a, const auto* b) { return (a->id < b->id); };
+	const auto weaponCmp = [](const CPlasmaRepulser* a, const CPlasmaRepulser* b) {
+		if (a->owner->id != b->owner->id)
+			return (a->owner->id < b->owner->id);
+
+		return (a->weaponNum < b->weaponNum);
+	};
+
+	std::sort(units.begin(), units.end(), idCmp);
+	std::sort(features.begin(), features.end(), idCmp);
+	std::sort(projectiles.begin(), projectiles.end(), idCmp);
+	std::sort(repulsers.begin(), repulsers.end(), weaponCmp);
+
+	units.erase(std::unique(units.begin(), units.end()), units.end());
+	features.erase(std::unique(features.begin(), features.end()), features.end());
+	projectiles.erase(std::unique(projectiles.begin(), projectiles.end()), projectiles.end());
+	repulsers.erase(std::unique(repulsers.begin(), repulsers.end()), repulsers.end());
+
+	const int2 mapDims = {(numQuadsX * quadSizeX) / SQUARE_SIZE, (numQuadsZ * quadSizeZ) / SQUARE_SIZE};
+
+	for (Quad& quad: baseQuads) {
+		quad.Clear();
 	}
 
-	quadField = std::move(newQuadField);
+	// NOTE: cells added by InsertUnitIf are not carried over, RemoveUnitIf is a no-op for those
+	for (CUnit* u: units) {
+		u->quads.clear();
+	}
+	for (CPlasmaRepulser* r: repulsers) {
+		r->ClearQuads();
+	}
+
+	Init(mapDims, quadSize);
+
+	for (CUnit* u: units) {
+		MovedUnit(u);
+	}
+	for (CFeature* f: features) {
+		AddFeature(f);
+	}
+	for (CProjectile* p: projectiles) {
+		AddProjectile(p);
+	}
+	for (CPlasmaRepulser* r: repulsers) {
+		MovedRepulser(r);
+	}
+}
+
+void CQuadField::Update()
+{
+	if (!modInfo.quadFieldAdaptiveResize)
+		return;
+	if ((gs->frameNum % RESIZE_CHECK_INTERVAL) != 0)
+		return;
+
+	// only synced state is looked at here, query counts are not
+	const Stats stats = GetStats();
+	const int2 mapSize = {numQuadsX * quadSizeX, numQuadsZ * quadSizeZ};
+	const int newQuadSize = GetAdaptiveQuadSize(
+		mapSize,
+		quadSizeX,
+		modInfo.quadFieldMinQuadSizeInElmos,
+		modInfo.quadFieldMaxQuadSizeInElmos,
+		stats.avgUnits,
+		modInfo.quadFieldTargetUnitsPerQuad
+	);
+
+	if (newQuadSize == quadSizeX)
+		return;
+
+	LOG("[QuadField::%s] resizing quads from %d to %d elmos (%.1f units per occupied quad)", __func__, quadSizeX, newQuadSize, stats.avgUnits);
+	Resize(newQuadSize);
 }
-*/
 #endif
 
 
+int CQuadField::GetAdaptiveQuadSize(int2 mapSize, int quadSize, int minQuadSize, int maxQuadSize, float avgLoad, float targetLoad)
+{
+	// Resize requires a uniform size, keep non-uniform custom setups as-is
+	if ((mapSize.x % quadSize) != 0 || (mapSize.y % quadSize) != 0)
+		return quadSize;
+
+	if (avgLoad > (targetLoad * 2.0f)) {
+		const int newQuadSize = quadSize >> 1;
+
+		if ((quadSize & 1) != 0 || newQuadSize < std::max(minQuadSize, SQUARE_SIZE))
+			return quadSize;
+
+		return newQuadSize;
+	}
+
+	if (avgLoad < (targetLoad * 0.125f)) {
+		const int newQuadSize = quadSize << 1;
+
+		if (newQuadSize > maxQuadSize)
+			return quadSize;
+		if ((mapSize.x % newQuadSize) != 0 || (mapSize.y % newQuadSize) != 0)
+			return quadSize;
+
+		return newQuadSize;
+	}
+
+	return quadSize;
+}
+
+int CQuadField::GetHistogramBin(size_t numObjects)
+{
+	int bin = 0;
+
+	for (; numObjects != 0 && bin < (Stats::NUM_HISTOGRAM_BINS - 1); numObjects >>= 1) {
+		bin += 1;
+	}
+
+	return bin;
+}
+
+const char* CQuadField::GetQueryName(QueryType type)
+{
+	constexpr const char* names[QUERY_COUNT] = {
+		"GetUnits",
+		"GetUnitsExact",
+		"GetUnitsExactRect",
+		"GetFeaturesExact",
+		"GetFeaturesExactRect",
+		"GetProjectilesExact",
+		"GetProjectilesExactRect",
+		"GetSolidsExact",
+		"NoSolidsExact",
+		"GetUnitsAndFeaturesColVol",
+		"GetQuadsOnRay",
+	};
+
+	return names[type];
+}
+
+CQuadField::Stats CQuadField::GetStats() const
+{
+	Stats stats;
+
+	size_t sumUnits = 0;
+
+	for (const Quad& quad: baseQuads) {
+		const size_t numUnits = quad.units.size();
+
+		stats.unitHistogram[GetHistogramBin(numUnits)] += 1;
+		stats.numOccupiedQuads += (numUnits != 0);
+
+		stats.maxUnits = std::max(stats.maxUnits, int(numUnits));
+		stats.maxFeatures = std::max(stats.maxFeatures, int(quad.features.size()));
+		stats.maxProjectiles = std::max(stats.maxProjectiles, int(quad.projectiles.size()));
+
+		sumUnits += numUnits;
+	}
+
+	if (stats.numOccupiedQuads > 0)
+		stats.avgUnits = sumUnits / float(stats.numOccupiedQuads);
+
+	for (const auto& threadCounters: queryCounters) {
+		for (int i = 0; i < QUERY_COUNT; ++i) {
+			stats.queryCounters[i].Add(threadCounters[i]);
+		}
+	}
+
+	return stats;
+}
+
+void CQuadField::ResetQueryCounters()
+{
+	for (auto& threadCounters: queryCounters) {
+		threadCounters.fill({});
+	}
+}
+
+
 void CQuadField::Quad::PostLoad()
 {
 #ifndef UNIT_TEST
@@ -159,6 +314,8 @@ void CQuadField::Kill()
 
 	for (auto cache : tempQuads)
 		cache.ReleaseAll();
+
+	ResetQueryCounters();
 }
 
 
@@ -251,6 +408,7 @@ void CQuadField::GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const f
 	if (noXdir && noZdir) {
 		queryQuads.push_back(WorldPosToQuadFieldIdx(start));
 		assert(static_cast<unsigned>(queryQuads.back()) < baseQuads.size());
+		CountQuery(QUERY_QUADS_ON_RAY, qfq.threadOwner, 1, 1);
 		return;
 	}
 
@@ -271,6 +429,7 @@ void CQuadField::GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const f
 			assert(static_cast<unsigned>(queryQuads.back()) < baseQuads.size());
 		}
 
+		CountQuery(QUERY_QUADS_ON_RAY, qfq.threadOwner, queryQuads.size(), queryQuads.size());
 		return;
 	}
 
@@ -317,6 +476,8 @@ void CQuadField::GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const f
 			assert(static_cast<unsigned>(queryQuads.back()) < baseQuads.size());
 		}
 	}
+
+	CountQuery(QUERY_QUADS_ON_RAY, qfq.threadOwner, queryQuads.size(), queryQuads.size());
 }
 
 
@@ -553,7 +714,11 @@ void CQuadField::GetUnits(QuadFieldQuery& qfq, const float3& pos, float radius)
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.units = tempUnits[curThread].ReserveVector();
 
+	size_t numCandidates = 0;
+
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += baseQuads[qi].units.size();
+
 		for (CUnit* u: baseQuads[qi].units) {
 			if (u->mtTempNum[curThread] == tempNum)
 				continue;
@@ -563,7 +728,7 @@ void CQuadField::GetUnits(QuadFieldQuery& qfq, const float3& pos, float radius)
 		}
 	}
 
-	return;
+	CountQuery(QUERY_UNITS, curThread, numCandidates, qfq.units->size());
 }
 
 void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float radius, bool spherical)
@@ -575,7 +740,11 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float rad
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.units = tempUnits[curThread].ReserveVector();
 
+	size_t numCandidates = 0;
+
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += baseQuads[qi].units.size();
+
 		for (CUnit* u: baseQuads[qi].units) {
 			if (u->mtTempNum[curThread] == tempNum)
 				continue;
@@ -595,19 +764,23 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float rad
 		}
 	}
 
-	return;
+	CountQuery(QUERY_UNITS_EXACT, curThread, numCandidates, qfq.units->size());
 }
 
 void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& mins, const float3& maxs)
 {
 	auto curThread = qfq.threadOwner;
 	QuadFieldQuery qfQuery;
-	GetQuadsRectangle(qfQuery, mins, maxs);
 	qfQuery.threadOwner = curThread;
+	GetQuadsRectangle(qfQuery, mins, maxs);
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.units = tempUnits[curThread].ReserveVector();
 
+	size_t numCandidates = 0;
+
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += baseQuads[qi].units.size();
+
 		for (CUnit* unit: baseQuads[qi].units) {
 
 			if (unit->mtTempNum[curThread] == tempNum)
@@ -625,7 +798,7 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& mins, const fl
 		}
 	}
 
-	return;
+	CountQuery(QUERY_UNITS_EXACT_RECT, curThread, numCandidates, qfq.units->size());
 }
 
 
@@ -638,7 +811,11 @@ void CQuadField::GetFeaturesExact(QuadFieldQuery& qfq, const float3& pos, float
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.features = tempFeatures[curThread].ReserveVector();
 
+	size_t numCandidates = 0;
+
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += baseQuads[qi].features.size();
+
 		for (CFeature* f: baseQuads[qi].features) {
 			if (f->mtTempNum[curThread] == tempNum)
 				continue;
@@ -658,7 +835,7 @@ void CQuadField::GetFeaturesExact(QuadFieldQuery& qfq, const float3& pos, float
 		}
 	}
 
-	return;
+	CountQuery(QUERY_FEATURES_EXACT, curThread, numCandidates, qfq.features->size());
 }
 
 void CQuadField::GetFeaturesExact(QuadFieldQuery& qfq, const float3& mins, const float3& maxs)
@@ -670,7 +847,11 @@ void CQuadField::GetFeaturesExact(QuadFieldQuery& qfq, const float3& mins, const
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.features = tempFeatures[curThread].ReserveVector();
 
+	size_t numCandidates = 0;
+
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += baseQuads[qi].features.size();
+
 		for (CFeature* feature: baseQuads[qi].features) {
 			if (feature->mtTempNum[curThread] == tempNum)
 				continue;
@@ -687,7 +868,7 @@ void CQuadField::GetFeaturesExact(QuadFieldQuery& qfq, const float3& mins, const
 		}
 	}
 
-	return;
+	CountQuery(QUERY_FEATURES_EXACT_RECT, curThread, numCandidates, qfq.features->size());
 }
 
 
@@ -699,7 +880,11 @@ void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& pos, flo
 	const int tempNum = gs->GetTempNum();
 	qfq.projectiles = tempProjectiles.ReserveVector();
 
+	size_t numCandidates = 0;
+
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += baseQuads[qi].projectiles.size();
+
 		for (CProjectile* p: baseQuads[qi].projectiles) {
 			if (p->tempNum == tempNum)
 				continue;
@@ -713,7 +898,7 @@ void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& pos, flo
 		}
 	}
 
-	return;
+	CountQuery(QUERY_PROJECTILES_EXACT, 0, numCandidates, qfq.projectiles->size());
 }
 
 void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& mins, const float3& maxs)
@@ -723,7 +908,11 @@ void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& mins, co
 	const int tempNum = gs->GetTempNum();
 	qfq.projectiles = tempProjectiles.ReserveVector();
 
+	size_t numCandidates = 0;
+
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += baseQuads[qi].projectiles.size();
+
 		for (CProjectile* p: baseQuads[qi].projectiles) {
 			if (p->tempNum == tempNum)
 				continue;
@@ -740,7 +929,7 @@ void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& mins, co
 		}
 	}
 
-	return;
+	CountQuery(QUERY_PROJECTILES_EXACT_RECT, 0, numCandidates, qfq.projectiles->size());
 }
 
 
@@ -758,9 +947,12 @@ void CQuadField::GetSolidsExact(
 	GetQuads(qfQuery, pos, radius);
 	const int tempNum = gs->GetMtTempNum(curThread);
 	qfq.solids = tempSolids[curThread].ReserveVector();
-	
+
+	size_t numCandidates = 0;
 
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += (baseQuads[qi].units.size() + baseQuads[qi].features.size());
+
 		for (CUnit* u: baseQuads[qi].units) {
 			if (u->mtTempNum[curThread] == tempNum)
 				continue;
@@ -794,7 +986,7 @@ void CQuadField::GetSolidsExact(
 		}
 	}
 
-	return;
+	CountQuery(QUERY_SOLIDS_EXACT, curThread, numCandidates, qfq.solids->size());
 }
 
 
@@ -808,7 +1000,11 @@ bool CQuadField::NoSolidsExact(
 	GetQuads(qfQuery, pos, radius);
 	const int tempNum = gs->GetTempNum();
 
+	size_t numCandidates = 0;
+
 	for (const int qi: *qfQuery.quads) {
+		numCandidates += (baseQuads[qi].units.size() + baseQuads[qi].features.size());
+
 		for (CUnit* u: baseQuads[qi].units) {
 			if (u->tempNum == tempNum)
 				continue;
@@ -822,6 +1018,7 @@ bool CQuadField::NoSolidsExact(
 			if ((pos - u->pos).SqLength() >= Square(radius + u->radius))
 				continue;
 
+			CountQuery(QUERY_NO_SOLIDS_EXACT, 0, numCandidates, 1);
 			return false;
 		}
 
@@ -838,10 +1035,12 @@ bool CQuadField::NoSolidsExact(
 			if ((pos - f->pos).SqLength() >= Square(radius + f->radius))
 				continue;
 
+			CountQuery(QUERY_NO_SOLIDS_EXACT, 0, numCandidates, 1);
 			return false;
 		}
 	}
 
+	CountQuery(QUERY_NO_SOLIDS_EXACT, 0, numCandidates, 0);
 	return true;
 }
 
@@ -859,10 +1058,16 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
 	// start counting from the previous object-cache sizes
+	const size_t numUnits = units.size();
+	const size_t numFeatures = features.size();
+
+	size_t numCandidates = 0;
 
 	for (const int qi: *qfQuery.quads) {
 		const Quad& quad = baseQuads[qi];
 
+		numCandidates += (quad.units.size() + quad.features.size());
+
 		for (CUnit* u: quad.units) {
 			// prevent double adding
 			if (u->tempNum == tempNum)
@@ -912,5 +1117,82 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 			}
 		}
 	}
+
+	CountQuery(QUERY_UNITS_FEATURES_COLVOL, 0, numCandidates, (units.size() - numUnits) + (features.size() - numFeatures));
+}
+
+void CQuadField::GetUnitsAndFeaturesColVol(
+	QuadFieldQuery& qfq,
+	const float3& pos,
+	const float radius,
+	std::vector<CPlasmaRepulser*>* repulsers
+) {
+	auto curThread = qfq.threadOwner;
+	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = curThread;
+	GetQuads(qfQuery, pos, radius);
+	const int tempNum = gs->GetMtTempNum(curThread);
+	qfq.units = tempUnits[curThread].ReserveVector();
+	qfq.features = tempFeatures[curThread].ReserveVector();
+
+	// repulsers are appended, only dedupe against those added here
+	const size_t numRepulsers = (repulsers != nullptr)? repulsers->size(): 0;
+
+	size_t numCandidates = 0;
+
+	for (const int qi: *qfQuery.quads) {
+		const Quad& quad = baseQuads[qi];
+
+		numCandidates += (quad.units.size() + quad.features.size());
+
+		for (CUnit* u: quad.units) {
+			if (u->mtTempNum[curThread] == tempNum)
+				continue;
+
+			u->mtTempNum[curThread] = tempNum;
+
+			const auto* colvol = &u->collisionVolume;
+			const float totRad = radius + colvol->GetBoundingRadius();
+
+			if (pos.SqDistance(colvol->GetWorldSpacePos(u)) >= (totRad * totRad))
+				continue;
+
+			qfq.units->push_back(u);
+		}
+
+		for (CFeature* f: quad.features) {
+			if (f->mtTempNum[curThread] == tempNum)
+				continue;
+
+			f->mtTempNum[curThread] = tempNum;
+
+			const auto* colvol = &f->collisionVolume;
+			const float totRad = radius + colvol->GetBoundingRadius();
+
+			if (pos.SqDistance(colvol->GetWorldSpacePos(f)) >= (totRad * totRad))
+				continue;
+
+			qfq.features->push_back(f);
+		}
+
+		if (repulsers == nullptr)
+			continue;
+
+		for (CPlasmaRepulser* r: quad.repulsers) {
+			// repulsers have no per-thread tempNum, but are few
+			if (std::find(repulsers->begin() + numRepulsers, repulsers->end(), r) != repulsers->end())
+				continue;
+
+			const auto* colvol = &r->collisionVolume;
+			const float totRad = radius + colvol->GetBoundingRadius();
+
+			if (pos.SqDistance(r->weaponMuzzlePos) >= (totRad * totRad))
+				continue;
+
+			repulsers->push_back(r);
+		}
+	}
+
+	CountQuery(QUERY_UNITS_FEATURES_COLVOL, curThread, numCandidates, qfq.units->size() + qfq.features->size());
 }
 #endif // UNIT_TEST
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <vector>
 
 #include "System/Misc/NonCopyable.h"
@@ -80,19 +81,86 @@ class CQuadField : spring::noncopyable
 	CR_DECLARE_SUB(Quad)
 
 public:
+	enum QueryType {
+		QUERY_UNITS,
+		QUERY_UNITS_EXACT,
+		QUERY_UNITS_EXACT_RECT,
+		QUERY_FEATURES_EXACT,
+		QUERY_FEATURES_EXACT_RECT,
+		QUERY_PROJECTILES_EXACT,
+		QUERY_PROJECTILES_EXACT_RECT,
+		QUERY_SOLIDS_EXACT,
+		QUERY_NO_SOLIDS_EXACT,
+		QUERY_UNITS_FEATURES_COLVOL,
+		QUERY_QUADS_ON_RAY,
+		QUERY_COUNT
+	};
+
+	struct QueryCounter {
+		void Add(const QueryCounter& c) {
+			numCalls += c.numCalls;
+			numCandidates += c.numCandidates;
+			numResults += c.numResults;
+		}
+
+		uint64_t numCalls = 0;
+		// objects tested in all visited quads, including duplicates
+		uint64_t numCandidates = 0;
+		uint64_t numResults = 0;
+	};
+
+	struct Stats {
+		// bin 0 counts the empty quads, bin i the quads holding
+		// [2^(i-1), 2^i) units, the last bin also those above
+		static constexpr int NUM_HISTOGRAM_BINS = 12;
 
-	/*
-	needed to support dynamic resizing (not used yet)
-	in large games the average loading factor (number of objects per quad)
-	can grow too large to maintain amortized constant performance so more
-	quads are needed
+		std::array<int, NUM_HISTOGRAM_BINS> unitHistogram = {};
+		std::array<QueryCounter, QUERY_COUNT> queryCounters = {};
 
-	static void Resize(int quadSize);
-	*/
+		int numOccupiedQuads = 0;
 
+		int maxUnits = 0;
+		int maxFeatures = 0;
+		int maxProjectiles = 0;
+
+		// average number of units per occupied quad
+		float avgUnits = 0.0f;
+	};
+
+public:
 	void Init(int2 mapDims, int quadSize);
 	void Kill();
 
+	/**
+	 * in large games the average loading factor (number of objects per quad)
+	 * can grow too large to maintain amortized constant performance so more
+	 * quads are needed; re-buckets all objects for the new quad-size, which
+	 * has to divide the map size and may only be changed by synced code at
+	 * a frame boundary (no queries in progress)
+	 */
+	void Resize(int quadSize);
+	/// adapts the quad-size to the unit loading factor if enabled by modrules
+	void Update();
+
+	/**
+	 * @brief returns the quad-size adaptive resizing switches to (or quadSize if unchanged)
+	 *
+	 * halves the size if the average load exceeds twice the target and doubles it if the
+	 * load drops below an eighth of the target; each step changes the load by about 4x so
+	 * this does not oscillate
+	 */
+	static int GetAdaptiveQuadSize(int2 mapSize, int quadSize, int minQuadSize, int maxQuadSize, float avgLoad, float targetLoad);
+	static int GetHistogramBin(size_t numObjects);
+	static const char* GetQueryName(QueryType type);
+
+	/// occupancy of the current quads and query counts since the last reset
+	Stats GetStats() const;
+	void ResetQueryCounters();
+
+	/// queries are only counted while enabled (off by default)
+	void SetCountQueries(bool b) { countQueries = b; }
+	bool IsCountingQueries() const { return countQueries; }
+
 	void GetQuads(QuadFieldQuery& qfq, float3 pos, float radius);
 	void GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, const float3& maxs);
 	void GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const float3& dir, float length);
@@ -104,6 +172,14 @@ public:
 		std::vector<CFeature*>& features,
 		std::vector<CPlasmaRepulser*>* repulsers = nullptr
 	);
+	/// thread-safe version of the above, fills qfq.units and qfq.features
+	/// and appends to repulsers (which must be owned by the calling thread)
+	void GetUnitsAndFeaturesColVol(
+		QuadFieldQuery& qfq,
+		const float3& pos,
+		const float radius,
+		std::vector<CPlasmaRepulser*>* repulsers = nullptr
+	);
 
 	/**
 	 * Returns all units within @c radius of @c pos,
@@ -238,6 +314,17 @@ private:
 	int2 WorldPosToQuadField(const float3 p) const;
 	int WorldPosToQuadFieldIdx(const float3 p) const;
 
+	// queries are counted per thread (owner) to avoid contention
+	void CountQuery(QueryType type, int curThread, size_t numCandidates, size_t numResults) {
+		if (!countQueries)
+			return;
+
+		QueryCounter& qc = queryCounters[curThread][type];
+		qc.numCalls += 1;
+		qc.numCandidates += numCandidates;
+		qc.numResults += numResults;
+	}
+
 private:
 	std::vector<Quad> baseQuads;
 
@@ -248,6 +335,10 @@ private:
 	std::array< QueryVectorCache<CSolidObject*>, ThreadPool::MAX_THREADS > tempSolids;
 	std::array< QueryVectorCache<int>, ThreadPool::MAX_THREADS > tempQuads;
 
+	std::array< std::array<QueryCounter, QUERY_COUNT>, ThreadPool::MAX_THREADS > queryCounters;
+
+	bool countQueries = false;
+
 	float2 invQuadSize;
 
 	int numQuadsX;
@@ -2,6 +2,7 @@
 
 #include "GroundMoveType.h"
 #include "MoveDefHandler.h"
+#include "UnitCollisionPairs.h"
 #include "ExternalAI/EngineOutHandler.h"
 #include "Game/Camera.h"
 #include "Game/GameHelper.h"
@@ -587,6 +588,15 @@ void CGroundMoveType::UpdateCollisionDetections() {
 	HandleObjectCollisions();
 }
 
+bool CGroundMoveType::HandlesUnitCollisions() const {
+	// must match the early-outs of UpdateCollisionDetections and HandleObjectCollisions
+	if (owner->GetTransporter() != nullptr) return false;
+	if (owner->IsSkidding()) return false;
+	if (owner->IsFalling()) return false;
+
+	return (!owner->beingBuilt);
+}
+
 void CGroundMoveType::ProcessCollisionEvents() {
 	SyncWaypoints();
 
@@ -1602,30 +1612,29 @@ float3 CGroundMoveType::GetObstacleAvoidanceDir(const float3& desiredDir) {
 	const float avoidanceRadius = std::max(currentSpeed, 1.0f) * (avoider->radius * 2.0f);
 	const float avoiderRadius = avoiderMD->CalcFootPrintMinExteriorRadius();
 
-	QuadFieldQuery qfQuery;
-	qfQuery.threadOwner = ThreadPool::GetThreadNum();
-	quadField.GetSolidsExact(qfQuery, avoider->pos, avoidanceRadius, 0xFFFFFFFF, CSolidObject::CSTATE_BIT_SOLIDOBJECTS);
-
-	for (const CSolidObject* avoidee: *qfQuery.solids) {
+	// features never have a MoveDef and were always skipped, only units are considered
+	const auto AvoidUnit = [&](const CUnit* avoidee, unsigned int avoideeFlags, float avoideeCrushResistance) {
 		const MoveDef* avoideeMD = avoidee->moveDef;
-		const UnitDef* avoideeUD = dynamic_cast<const UnitDef*>(avoidee->GetDef());
 
 		// cases in which there is no need to avoid this obstacle
 		if (avoidee == owner)
-			continue;
+			return;
 		// do not avoid statics (it interferes too much with PFS)
-		if (avoideeMD == nullptr)
-			continue;
+		if ((avoideeFlags & UnitNeighbourCache::FLAG_MOBILE) == 0)
+			return;
 		// ignore aircraft (or flying ground units)
-		if (avoidee->IsInAir() || avoidee->IsFlying())
-			continue;
-		if (CMoveMath::IsNonBlocking(*avoiderMD, avoidee, avoider))
-			continue;
-		if (!CMoveMath::CrushResistant(*avoiderMD, avoidee))
-			continue;
+		if ((avoideeFlags & UnitNeighbourCache::FLAG_AIRBORNE) != 0)
+			return;
+		// see CMoveMath::IsNonBlocking and CMoveMath::CrushResistant
+		if ((avoideeFlags & UnitNeighbourCache::FLAG_BLOCKING) == 0)
+			return;
+		if (CMoveMath::IsNonBlocking(avoidee, avoider))
+			return;
+		if ((avoideeFlags & UnitNeighbourCache::FLAG_CRUSHABLE) != 0 && avoideeCrushResistance <= avoiderMD->crushStrength)
+			return;
 
 		const bool avoideeMobile  = (avoideeMD != nullptr);
-		const bool avoideeMovable = (avoideeUD != nullptr && !static_cast<const CUnit*>(avoidee)->moveType->IsPushResistant());
+		const bool avoideeMovable = ((avoideeFlags & UnitNeighbourCache::FLAG_MOVABLE) != 0);
 
 		const float3 avoideeVector = (avoider->pos + avoider->speed) - (avoidee->pos + avoidee->speed);
 
@@ -1644,7 +1653,7 @@ float3 CGroundMoveType::GetObstacleAvoidanceDir(const float3& desiredDir) {
 		// (since collision handling will just push them aside)
 		if (avoideeMobile && avoideeMovable) {
 			if (!avoiderMD->avoidMobilesOnPath || (!avoidee->IsMoving() && avoidee->allyteam == avoider->allyteam))
-				continue;
+				return;
 		}
 
 		// ignore objects that are more than this many degrees off-center from us
@@ -1654,12 +1663,12 @@ float3 CGroundMoveType::GetObstacleAvoidanceDir(const float3& desiredDir) {
 		//   avoidance vector to oscillate --> units with turnInPlace = true will
 		//   slow to a crawl as a result
 		if (avoider->frontdir.dot(-(avoideeVector / avoideeDist)) < MAX_AVOIDEE_COSINE)
-			continue;
+			return;
 
 		if (avoideeDistSq >= Square(std::max(currentSpeed, 1.0f) * GAME_SPEED + avoidanceRadiusSum))
-			continue;
+			return;
 		if (avoideeDistSq >= avoider->pos.SqDistance2D(goalPos))
-			continue;
+			return;
 
 		// if object and unit in relative motion are closing in on one another
 		// (or not yet fully apart), then the object is on the path of the unit
@@ -1695,6 +1704,29 @@ float3 CGroundMoveType::GetObstacleAvoidanceDir(const float3& desiredDir) {
 
 		avoidanceDir = avoider->rightdir * AVOIDER_DIR_WEIGHT * avoiderTurnSign;
 		avoidanceVec += (avoidanceDir * avoidanceResponse * avoidanceFallOff * avoideeMassScale);
+	};
+
+	const UnitNeighbourCache& neighbourCache = unitHandler.GetUnitNeighbourCache();
+
+	if (neighbourCache.CoversQuery(avoider, avoidanceRadius)) {
+		// nobody has moved since the lists were gathered, no fast movers to consider
+		for (const int id: neighbourCache.GetNeighbours(avoider->id)) {
+			const CUnit* avoidee = unitHandler.GetUnitUnsafe(id);
+
+			// equivalent of the exact quadfield test
+			if (avoider->pos.SqDistance(avoidee->pos) >= Square(avoidanceRadius + avoidee->radius))
+				continue;
+
+			AvoidUnit(avoidee, neighbourCache.GetFlags(id), neighbourCache.GetCrushResistance(id));
+		}
+	} else {
+		QuadFieldQuery qfQuery;
+		qfQuery.threadOwner = ThreadPool::GetThreadNum();
+		quadField.GetUnitsExact(qfQuery, avoider->pos, avoidanceRadius);
+
+		for (const CUnit* avoidee: *qfQuery.units) {
+			AvoidUnit(avoidee, UnitNeighbourCache::CalcFlags(avoidee), avoidee->crushResistance);
+		}
 	}
 
 
@@ -2526,6 +2558,44 @@ bool CGroundMoveType::HandleStaticObjectCollision(
 	}
 }
 
+bool CGroundMoveType::TestUnitCollisionPair(const CUnit* u1, const CUnit* u2)
+{
+	const MoveDef* md1 = u1->moveDef;
+	const MoveDef* md2 = u2->moveDef;
+
+	// SAT wants the first party to be mobile
+	if (md1 == nullptr) {
+		std::swap(u1, u2);
+		std::swap(md1, md2);
+	}
+
+	assert(md1 != nullptr);
+
+	// don't push/crush either party if one does not block the other
+	if (CMoveMath::IsNonBlocking(*md1, u2, u1))
+		return false;
+	if (md2 != nullptr && CMoveMath::IsNonBlocking(*md2, u1, u2))
+		return false;
+
+	// disable collisions if either party is inside a transporter (this
+	// includes a collider being transported by its collidee) or if one
+	// has an order to load the other
+	if (u1->GetTransporter() != nullptr || u2->GetTransporter() != nullptr)
+		return false;
+	if (u1->loadingTransportId == u2->id || u2->loadingTransportId == u1->id)
+		return false;
+
+	const float r1 = md1->CalcFootPrintMaxInteriorRadius();
+	const float r2 = (md2 != nullptr)? md2->CalcFootPrintMaxInteriorRadius(): u2->CalcFootPrintMaxInteriorRadius();
+
+	const float4 separationVect = {u1->pos - u2->pos, Square(r1 + r2)};
+
+	const bool allowSAT = modInfo.allowSepAxisCollisionTest;
+	const bool forceSAT = (md1->CalcFootPrintAxisStretchFactor() > 0.1f) || (md2 != nullptr && md2->CalcFootPrintAxisStretchFactor() > 0.1f);
+
+	return (checkCollisionFuncs[allowSAT && forceSAT](separationVect, u1, u2, md1, md2));
+}
+
 void CGroundMoveType::HandleUnitCollisions(
 	CUnit* collider,
 	const float3& colliderParams, // .x := speed, .y := radius, .z := fpstretch
@@ -2539,18 +2609,31 @@ void CGroundMoveType::HandleUnitCollisions(
 	const bool allowUCO = modInfo.allowUnitCollisionOverlap;
 	const bool allowCAU = modInfo.allowCrushingAlliedUnits;
 	const bool allowPEU = modInfo.allowPushingEnemyUnits;
-	const bool allowSAT = modInfo.allowSepAxisCollisionTest;
-	const bool forceSAT = (colliderParams.z > 0.1f);
 
-	// copy on purpose, since the below can call Lua
-	QuadFieldQuery qfQuery;
-	qfQuery.threadOwner = curThread;
-	quadField.GetUnitsExact(qfQuery, collider->pos, colliderParams.x + (colliderParams.y * 2.0f));
+	const SolidObjectKinematics& unitKinematics = unitHandler.GetUnitKinematics();
+	const UnitCollisionPairs& unitCollisionPairs = unitHandler.GetUnitCollisionPairs();
 
-	for (CUnit* collidee: *qfQuery.units) {
-		if (collidee == collider) continue;
-		if (collidee->IsSkidding()) continue;
-		if (collidee->IsFlying()) continue;
+	if (collider->unloadingTransportId != -1) {
+		const CUnit* transport = unitHandler.GetUnit(collider->unloadingTransportId);
+
+		// request clearing the id while our transport is within query range,
+		// undone below if we still overlap it (i.e. it is one of our contacts)
+		const bool checkTransport = (transport != nullptr && !unitKinematics.HasPhysicalStateBit(transport->id, CSolidObject::PSTATE_BIT_SKIDDING | CSolidObject::PSTATE_BIT_FLYING));
+
+		// equivalent of the exact (spherical) quadfield test
+		if (checkTransport && collider->pos.SqDistance(transport->pos) < Square(colliderParams.x + (colliderParams.y * 2.0f) + transport->radius))
+			collider->requestRemoveUnloadTransportId = true;
+	}
+
+	// contacts have already passed the symmetric tests (blocking, transport
+	// and loading state, circle or SAT) in TestUnitCollisionPair, in ID order
+	for (const int collideeID: unitCollisionPairs.GetContacts(collider->id)) {
+		CUnit* collidee = unitHandler.GetUnitUnsafe(collideeID);
+
+		// the pair may have been found by the collidee, skip it here if it
+		// is airborne as we would have done when querying for ourselves
+		if (unitKinematics.HasPhysicalStateBit(collidee->id, CSolidObject::PSTATE_BIT_SKIDDING | CSolidObject::PSTATE_BIT_FLYING))
+			continue;
 
 		const UnitDef* collideeUD = collidee->unitDef;
 		const MoveDef* collideeMD = collidee->moveDef;
@@ -2561,34 +2644,11 @@ void CGroundMoveType::HandleUnitCollisions(
 		const bool unloadingCollidee = (collidee->unloadingTransportId == collider->id);
 		const bool unloadingCollider = (collider->unloadingTransportId == collidee->id);
 
-		if (unloadingCollider)
-			collider->requestRemoveUnloadTransportId = true;
-
-		// don't push/crush either party if the collidee does not block the collider (or vv.)
-		if (colliderMobile && CMoveMath::IsNonBlocking(*colliderMD, collidee, collider))
-			continue;
-		if (collideeMobile && CMoveMath::IsNonBlocking(*collideeMD, collider, collidee))
-			continue;
-
-		// disable collisions between collider and collidee
-		// if collidee is currently inside any transporter,
-		// or if collider is being transported by collidee
-		if (collider->GetTransporter() == collidee) continue;
-		if (collidee->GetTransporter() != nullptr) continue;
-		// also disable collisions if either party currently
-		// has an order to load units (TODO: do we want this
-		// for unloading as well?)
-		if (collider->loadingTransportId == collidee->id) continue;
-		if (collidee->loadingTransportId == collider->id) continue;
-
 		// use the collidee's MoveDef footprint as radius if it is mobile
 		// use the collidee's Unit (not UnitDef) footprint as radius otherwise
 		const float2 collideeParams = {collidee->speed.w, collideeMobile? collideeMD->CalcFootPrintMaxInteriorRadius(): collidee->CalcFootPrintMaxInteriorRadius()};
 		const float4 separationVect = {collider->pos - collidee->pos, Square(colliderParams.y + collideeParams.y)};
 
-		if (!checkCollisionFuncs[allowSAT && (forceSAT || (collideeMobile && collideeMD->CalcFootPrintAxisStretchFactor() > 0.1f))](separationVect, collider, collidee, colliderMD, collideeMD))
-			continue;
-
 		if (unloadingCollider) {
 			collider->requestRemoveUnloadTransportId = false;
 			continue;
@@ -35,6 +35,7 @@ public:
 	void SlowUpdate() override;
 	void UpdatePreCollisionsMt() override;
 	void UpdateCollisionDetections() override;
+	bool HandlesUnitCollisions() const override;
 	void ProcessCollisionEvents() override;
 
 	void UpdateObstacleAvoidance();
@@ -58,6 +59,10 @@ public:
 	void InitMemberPtrs(MemberData* memberData);
 	bool SetMemberValue(unsigned int memberHash, void* memberValue) override;
 
+	// symmetric part of the unit-unit collision test, at least one of the
+	// units must have a MoveDef; see UnitCollisionPairs
+	static bool TestUnitCollisionPair(const CUnit* u1, const CUnit* u2);
+
 	bool OnSlope(float minSlideTolerance);
 	bool IsReversing() const override { return reversing; }
 	bool IsPushResistant() const override { return pushResistant; }
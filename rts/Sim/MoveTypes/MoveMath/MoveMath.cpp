@@ -322,7 +322,7 @@ CMoveMath::BlockType CMoveMath::RangeIsBlocked(const MoveDef& moveDef, int xmin,
 	zmax = std::min(zmax, mapDims.mapy - 1);
 
 	BlockType ret = BLOCK_NONE;
-	if (ThreadPool::inMultiThreadedSection) {
+	if (ThreadPool::InMultiThreadedSection()) {
 		ret = CMoveMath::RangeIsBlockedMt(moveDef, xmin, xmax, zmin, zmax, collider, thread);
 	} else {
 		ret = CMoveMath::RangeIsBlockedSt(moveDef, xmin, xmax, zmin, zmax, collider);
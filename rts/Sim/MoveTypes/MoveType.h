@@ -67,6 +67,8 @@ public:
 	virtual void UpdatePreCollisionsMt() {};
 	virtual void UpdatePreCollisions() {};
 	virtual void UpdateCollisionDetections() {};
+	// true if UpdateCollisionDetections resolves unit collisions for the owner this frame
+	virtual bool HandlesUnitCollisions() const { return false; }
 	virtual void ProcessCollisionEvents() {};
 
 	virtual bool IsSkidding() const { return false; }
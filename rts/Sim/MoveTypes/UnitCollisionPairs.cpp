@@ -0,0 +1,167 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "UnitCollisionPairs.h"
+#include "GroundMoveType.h"
+#include "MoveDefHandler.h"
+#include "Sim/Misc/QuadField.h"
+#include "Sim/Units/Unit.h"
+#include "Sim/Units/UnitHandler.h"
+#include "System/Threading/ThreadPool.h"
+
+#include <algorithm>
+
+void UnitCollisionPairs::Init(unsigned int numObjects)
+{
+	candidatePairs.clear();
+	candidatePairs.reserve(1024);
+	pairCollisions.clear();
+
+	contacts.clear();
+	contactOffsets.clear();
+	contactOffsets.resize(numObjects + 1, 0);
+	contactCursors.clear();
+	contactCursors.resize(numObjects + 1, 0);
+}
+
+void UnitCollisionPairs::Kill()
+{
+	threadPairs.clear();
+
+	candidatePairs.clear();
+	pairCollisions.clear();
+
+	contacts.clear();
+	contactOffsets.clear();
+	contactCursors.clear();
+}
+
+void UnitCollisionPairs::Update(const std::vector<CUnit*>& units, bool multiThreaded)
+{
+	const auto ForEach = [multiThreaded](int numItems, auto&& func) {
+		if (multiThreaded) {
+			for_mt(0, numItems, func);
+			return;
+		}
+
+		for (int i = 0; i < numItems; i++) {
+			func(i);
+		}
+	};
+
+	threadPairs.resize(std::max(threadPairs.size(), size_t(ThreadPool::GetMaxThreads())));
+
+	{
+		// broad-phase, same query as each collider used to make for itself; served
+		// from the neighbour lists gathered before the pre-collision pass if those
+		// still cover it, from the quadfield otherwise
+		const SolidObjectKinematics& unitKinematics = unitHandler.GetUnitKinematics();
+		const UnitNeighbourCache& neighbourCache = unitHandler.GetUnitNeighbourCache();
+
+		ForEach(units.size(), [&](const int i) {
+			const CUnit* collider = units[i];
+
+			if (!collider->moveType->HandlesUnitCollisions())
+				return;
+
+			const int curThread = ThreadPool::GetThreadNum();
+			const float colliderRadius = collider->moveDef->CalcFootPrintMaxInteriorRadius();
+			const float queryRadius = collider->speed.w + (colliderRadius * 2.0f);
+
+			std::vector<IdPair>& pairs = threadPairs[curThread];
+
+			const auto AddCandidate = [&](const CUnit* collidee) {
+				if (collidee == collider)
+					return;
+				if (unitKinematics.HasPhysicalStateBit(collidee->id, CSolidObject::PSTATE_BIT_SKIDDING | CSolidObject::PSTATE_BIT_FLYING))
+					return;
+				if (!unitKinematics.MayCollide(collidee->id, collider->pos, colliderRadius))
+					return;
+
+				pairs.emplace_back(std::min(collider->id, collidee->id), std::max(collider->id, collidee->id));
+			};
+
+			if (neighbourCache.CoversQuery(collider, queryRadius)) {
+				const auto AddNeighbour = [&](int id) {
+					const CUnit* collidee = unitHandler.GetUnit(id);
+
+					if (collidee == nullptr)
+						return;
+					// equivalent of the exact quadfield test
+					if (collider->pos.SqDistance(collidee->pos) >= Square(queryRadius + collidee->radius))
+						return;
+
+					AddCandidate(collidee);
+				};
+
+				// fast movers can also appear in the list, duplicate pairs are removed below
+				for (const int id: neighbourCache.GetNeighbours(collider->id)) {
+					AddNeighbour(id);
+				}
+				for (const int id: neighbourCache.GetFastMovers()) {
+					AddNeighbour(id);
+				}
+
+				return;
+			}
+
+			QuadFieldQuery qfQuery;
+			qfQuery.threadOwner = curThread;
+			quadField.GetUnitsExact(qfQuery, collider->pos, queryRadius);
+
+			for (const CUnit* collidee: *qfQuery.units) {
+				AddCandidate(collidee);
+			}
+		});
+	}
+
+	candidatePairs.clear();
+
+	for (std::vector<IdPair>& pairs: threadPairs) {
+		candidatePairs.insert(candidatePairs.end(), pairs.begin(), pairs.end());
+		pairs.clear();
+	}
+
+	// most pairs are found from both sides
+	std::sort(candidatePairs.begin(), candidatePairs.end());
+	candidatePairs.erase(std::unique(candidatePairs.begin(), candidatePairs.end()), candidatePairs.end());
+
+	pairCollisions.clear();
+	pairCollisions.resize(candidatePairs.size(), 0);
+
+	ForEach(candidatePairs.size(), [&](const int i) {
+		const CUnit* u1 = unitHandler.GetUnitUnsafe(candidatePairs[i].first);
+		const CUnit* u2 = unitHandler.GetUnitUnsafe(candidatePairs[i].second);
+
+		pairCollisions[i] = CGroundMoveType::TestUnitCollisionPair(u1, u2);
+	});
+
+	std::fill(contactOffsets.begin(), contactOffsets.end(), 0);
+
+	for (size_t i = 0, n = candidatePairs.size(); i < n; i++) {
+		if (!pairCollisions[i])
+			continue;
+
+		contactOffsets[candidatePairs[i].first  + 1] += 1;
+		contactOffsets[candidatePairs[i].second + 1] += 1;
+	}
+
+	for (size_t i = 1, n = contactOffsets.size(); i < n; i++) {
+		contactOffsets[i] += contactOffsets[i - 1];
+	}
+
+	contacts.clear();
+	contacts.resize(contactOffsets.back());
+	contactCursors.assign(contactOffsets.begin(), contactOffsets.end());
+
+	// pairs are sorted, so every unit receives its lower-ID contacts
+	// first and each run in ascending order; no need to sort again
+	for (size_t i = 0, n = candidatePairs.size(); i < n; i++) {
+		if (!pairCollisions[i])
+			continue;
+
+		const IdPair& p = candidatePairs[i];
+
+		contacts[contactCursors[p.first ]++] = p.second;
+		contacts[contactCursors[p.second]++] = p.first;
+	}
+}
@@ -0,0 +1,57 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef UNIT_COLLISION_PAIRS_H
+#define UNIT_COLLISION_PAIRS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class CUnit;
+
+// per-frame list of colliding unit pairs for the movetype collision pass;
+// candidates are gathered from the (cached) neighbours of all units whose
+// movetype handles unit collisions, sorted and de-duplicated so that the
+// (symmetric) narrow-phase test runs once per pair instead of once from
+// each side, then stored as per-unit contact lists ordered by unit ID
+class UnitCollisionPairs {
+public:
+	struct ContactRange {
+		const int* begin() const { return b; }
+		const int* end() const { return e; }
+
+		const int* b;
+		const int* e;
+	};
+
+public:
+	void Init(unsigned int numObjects);
+	void Kill();
+
+	void Update(const std::vector<CUnit*>& units, bool multiThreaded);
+
+	// IDs of the units colliding with unit <id> this frame, ascending
+	ContactRange GetContacts(unsigned int id) const {
+		return {contacts.data() + contactOffsets[id], contacts.data() + contactOffsets[id + 1]};
+	}
+
+	size_t GetNumCandidatePairs() const { return candidatePairs.size(); }
+	size_t GetNumCollidingPairs() const { return (contacts.size() >> 1); }
+
+private:
+	typedef std::pair<int, int> IdPair;
+
+	// per-thread candidate lists, merged after the broad-phase
+	std::vector<std::vector<IdPair>> threadPairs;
+
+	std::vector<IdPair> candidatePairs;
+	std::vector<uint8_t> pairCollisions;
+
+	// CSR layout; contacts of unit i are [contactOffsets[i], contactOffsets[i + 1])
+	std::vector<int> contacts;
+	std::vector<unsigned int> contactOffsets;
+	std::vector<unsigned int> contactCursors;
+};
+
+#endif
@@ -0,0 +1,162 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "UnitNeighbourCache.h"
+#include "GroundMoveType.h"
+#include "MoveDefHandler.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/QuadField.h"
+#include "Sim/Units/Unit.h"
+#include "Sim/Units/UnitHandler.h"
+#include "System/Threading/ThreadPool.h"
+
+#include <algorithm>
+
+void UnitNeighbourCache::Init(unsigned int numObjects)
+{
+	unitInfos.clear();
+	unitInfos.resize(numObjects);
+	entries.clear();
+	entries.resize(numObjects);
+
+	fastMovers.clear();
+	fastMovers.reserve(MAX_FAST_MOVERS + 1);
+
+	maxSlowMoverDelta = 0.0f;
+	coversQueries = false;
+}
+
+void UnitNeighbourCache::Kill()
+{
+	unitInfos.clear();
+	entries.clear();
+
+	threadNeighbours.clear();
+	fastMovers.clear();
+}
+
+unsigned int UnitNeighbourCache::CalcFlags(const CUnit* unit)
+{
+	unsigned int flags = 0;
+
+	flags |= (FLAG_MOBILE    * (unit->moveDef != nullptr));
+	flags |= (FLAG_AIRBORNE  * (unit->IsInAir() || unit->IsFlying()));
+	flags |= (FLAG_CRUSHABLE * unit->crushable);
+	flags |= (FLAG_MOVABLE   * !unit->moveType->IsPushResistant());
+
+	// same order as CMoveMath::IsNonBlocking, minus the collider-dependent checks
+	if (unit->HasCollidableStateBit(CSolidObject::CSTATE_BIT_SOLIDOBJECTS) && unit->pos.IsInBounds() && unit->IsBlocking())
+		flags |= FLAG_BLOCKING;
+
+	return flags;
+}
+
+void UnitNeighbourCache::Update(const std::vector<CUnit*>& units)
+{
+	threadNeighbours.resize(std::max(threadNeighbours.size(), size_t(ThreadPool::GetMaxThreads())));
+
+	for (std::vector<int>& neighbours: threadNeighbours) {
+		neighbours.clear();
+	}
+
+	fastMovers.clear();
+
+	maxSlowMoverDelta = 0.0f;
+	coversQueries = true;
+
+	const int frameNum = gs->frameNum;
+
+	// nothing moves until the pre-collision pass is done, so the lists are
+	// exact for obstacle avoidance and only drift by what units move in it
+	for_mt(0, units.size(), [&](const int i) {
+		const CUnit* unit = units[i];
+
+		UnitInfo& info = unitInfos[unit->id];
+		info.pos = unit->pos;
+		info.radius = unit->radius;
+		info.crushResistance = unit->crushResistance;
+		info.flags = CalcFlags(unit);
+		info.frameNum = frameNum;
+
+		if (!unit->moveType->HandlesUnitCollisions())
+			return;
+
+		const CGroundMoveType* moveType = static_cast<const CGroundMoveType*>(unit->moveType);
+
+		const float avoidanceRadius = std::max(moveType->GetCurrentSpeed(), 1.0f) * (unit->radius * 2.0f);
+		const float collisionRadius = unit->speed.w + (unit->moveDef->CalcFootPrintMaxInteriorRadius() * 2.0f);
+
+		const int curThread = ThreadPool::GetThreadNum();
+
+		std::vector<int>& neighbours = threadNeighbours[curThread];
+
+		Entry& entry = entries[unit->id];
+		entry.radius = std::max(avoidanceRadius, collisionRadius) + QUERY_MARGIN;
+		entry.thread = curThread;
+		entry.offset = neighbours.size();
+		entry.frameNum = frameNum;
+
+		// cylindrical query, so lists also cover the spherical ones
+		QuadFieldQuery qfQuery;
+		qfQuery.threadOwner = curThread;
+		quadField.GetUnitsExact(qfQuery, unit->pos, entry.radius, false);
+
+		for (const CUnit* neighbour: *qfQuery.units) {
+			if (neighbour == unit)
+				continue;
+
+			neighbours.push_back(neighbour->id);
+		}
+
+		entry.count = neighbours.size() - entry.offset;
+	});
+}
+
+void UnitNeighbourCache::UpdateDisplacements(const std::vector<CUnit*>& units)
+{
+	if (!coversQueries)
+		return;
+
+	const SolidObjectKinematics& unitKinematics = unitHandler.GetUnitKinematics();
+
+	for (const CUnit* unit: units) {
+		// no collision query ever accepts these
+		if (unitKinematics.HasPhysicalStateBit(unit->id, CSolidObject::PSTATE_BIT_SKIDDING | CSolidObject::PSTATE_BIT_FLYING))
+			continue;
+
+		const UnitInfo& info = unitInfos[unit->id];
+
+		if (info.frameNum != gs->frameNum) {
+			fastMovers.push_back(unit->id);
+			continue;
+		}
+
+		const float delta = unit->pos.distance2D(info.pos) + std::max(0.0f, unit->radius - info.radius);
+
+		if (delta > MAX_SLOW_MOVER_DELTA) {
+			fastMovers.push_back(unit->id);
+			continue;
+		}
+
+		maxSlowMoverDelta = std::max(maxSlowMoverDelta, delta);
+	}
+
+	if (fastMovers.size() <= MAX_FAST_MOVERS)
+		return;
+
+	fastMovers.clear();
+	coversQueries = false;
+}
+
+bool UnitNeighbourCache::CoversQuery(const CUnit* unit, float radius) const
+{
+	const Entry& entry = entries[unit->id];
+	const UnitInfo& info = unitInfos[unit->id];
+
+	if (!coversQueries || entry.frameNum != gs->frameNum)
+		return false;
+
+	// a neighbour is missing only if the units approached each other by more than the margin
+	const float selfDelta = unit->pos.distance2D(info.pos) + std::max(0.0f, unit->radius - info.radius);
+
+	return ((radius + selfDelta + maxSlowMoverDelta + 0.1f) <= entry.radius);
+}
@@ -0,0 +1,105 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef UNIT_NEIGHBOUR_CACHE_H
+#define UNIT_NEIGHBOUR_CACHE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "System/float3.h"
+
+class CUnit;
+
+// per-frame neighbour lists of all units whose movetype handles unit
+// collisions, gathered in parallel right before the pre-collision pass
+// (while no unit moves) with a radius large enough for both obstacle
+// avoidance and the later collision broad-phase; also caches per-unit
+// flags so the avoidance loop needs no RTTI or MoveMath calls
+class UnitNeighbourCache {
+public:
+	enum {
+		FLAG_MOBILE    = 1 << 0, // has a MoveDef
+		FLAG_AIRBORNE  = 1 << 1, // IsInAir() or IsFlying()
+		FLAG_BLOCKING  = 1 << 2, // collider-independent part of CMoveMath::IsNonBlocking is false
+		FLAG_CRUSHABLE = 1 << 3,
+		FLAG_MOVABLE   = 1 << 4, // movetype is not push-resistant
+	};
+
+	struct IdRange {
+		const int* begin() const { return b; }
+		const int* end() const { return e; }
+
+		const int* b;
+		const int* e;
+	};
+
+public:
+	void Init(unsigned int numObjects);
+	void Kill();
+
+	void Update(const std::vector<CUnit*>& units);
+	// measures how far units moved since Update, once positions are final for the collision pass
+	void UpdateDisplacements(const std::vector<CUnit*>& units);
+
+	static unsigned int CalcFlags(const CUnit* unit);
+
+	// true if the list of <unit> was gathered this frame and is a superset of
+	// what an exact query with <radius> around its current position returns,
+	// except for the units in GetFastMovers() which callers have to test too
+	bool CoversQuery(const CUnit* unit, float radius) const;
+
+	IdRange GetNeighbours(unsigned int id) const {
+		const Entry& e = entries[id];
+		const int* b = threadNeighbours[e.thread].data() + e.offset;
+		return {b, b + e.count};
+	}
+
+	const std::vector<int>& GetFastMovers() const { return fastMovers; }
+
+	unsigned int GetFlags(unsigned int id) const { return unitInfos[id].flags; }
+	float GetCrushResistance(unsigned int id) const { return unitInfos[id].crushResistance; }
+
+private:
+	// added to the larger of the avoidance and collision query radii, so the
+	// lists still cover the latter after units moved during the frame
+	static constexpr float QUERY_MARGIN = 16.0f;
+	// units that moved further are handled via fastMovers
+	static constexpr float MAX_SLOW_MOVER_DELTA = 8.0f;
+	// beyond this many fast movers no list is considered to cover its query
+	static constexpr size_t MAX_FAST_MOVERS = 64;
+
+	struct UnitInfo {
+		float3 pos;
+
+		float radius = 0.0f;
+		float crushResistance = 0.0f;
+
+		unsigned int flags = 0;
+
+		int frameNum = -1;
+	};
+
+	struct Entry {
+		float radius = 0.0f;
+
+		unsigned int thread = 0;
+		unsigned int offset = 0;
+		unsigned int count = 0;
+
+		int frameNum = -1;
+	};
+
+	std::vector<UnitInfo> unitInfos;
+	std::vector<Entry> entries;
+
+	// entries index into the list of the thread that gathered them
+	std::vector<std::vector<int>> threadNeighbours;
+
+	std::vector<int> fastMovers;
+
+	float maxSlowMoverDelta = 0.0f;
+
+	bool coversQueries = false;
+};
+
+#endif
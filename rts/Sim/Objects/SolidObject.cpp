@@ -94,6 +94,17 @@ void CSolidObject::PostLoad()
 }
 
 
+void CSolidObject::StoreKinematics(float4& posRadius, float4& speedVec, unsigned int& physState, short& headingVal) const
+{
+	// mobile objects collide using their MoveDef footprint, static ones their own
+	const float colRadius = (moveDef != nullptr)? moveDef->CalcFootPrintMaxInteriorRadius(): CalcFootPrintMaxInteriorRadius();
+
+	posRadius = {pos, colRadius};
+	speedVec = speed;
+	physState = physicalState;
+	headingVal = heading;
+}
+
 void CSolidObject::UpdatePhysicalState(float eps)
 {
 	const float gh = CGround::GetHeightReal(pos.x, pos.z);
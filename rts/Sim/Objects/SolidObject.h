@@ -129,6 +129,9 @@ public:
 
 	virtual void UpdatePhysicalState(float eps);
 
+	// write the fields mirrored by SolidObjectKinematics
+	void StoreKinematics(float4& posRadius, float4& speedVec, unsigned int& physState, short& headingVal) const;
+
 	void Move(const float3& v, bool relative) {
 		const float3& dv = relative? v: (v - pos);
 
@@ -0,0 +1,32 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "SolidObjectKinematics.h"
+#include "SolidObject.h"
+
+void SolidObjectKinematics::Init(unsigned int numObjects)
+{
+	posRadii.clear();
+	posRadii.resize(numObjects, float4(0.0f, 0.0f, 0.0f, 0.0f));
+	speeds.clear();
+	speeds.resize(numObjects, float4(0.0f, 0.0f, 0.0f, 0.0f));
+
+	physicalStates.clear();
+	physicalStates.resize(numObjects, 0);
+	headings.clear();
+	headings.resize(numObjects, 0);
+}
+
+void SolidObjectKinematics::Kill()
+{
+	posRadii.clear();
+	speeds.clear();
+
+	physicalStates.clear();
+	headings.clear();
+}
+
+void SolidObjectKinematics::Store(const CSolidObject* obj)
+{
+	// each object only ever writes its own slot, safe to call from for_mt
+	obj->StoreKinematics(posRadii[obj->id], speeds[obj->id], physicalStates[obj->id], headings[obj->id]);
+}
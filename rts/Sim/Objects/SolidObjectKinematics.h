@@ -0,0 +1,52 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SOLID_OBJECT_KINEMATICS_H
+#define SOLID_OBJECT_KINEMATICS_H
+
+#include <vector>
+
+#include "System/float4.h"
+#include "System/SpringMath.h"
+
+class CSolidObject;
+
+// structure-of-arrays mirror of the fields that the movetype
+// collision passes read from *other* objects, indexed by object
+// ID; refreshed from the objects themselves (see CSolidObject::
+// StoreKinematics) at phase boundaries during which none of the
+// mirrored fields change, so reads are always exact
+class SolidObjectKinematics {
+public:
+	void Init(unsigned int numObjects);
+	void Kill();
+
+	void Store(const CSolidObject* obj);
+
+	// xyz := pos, w := footprint collision radius
+	const float4& GetPosRadius(unsigned int id) const { return posRadii[id]; }
+	// xyz := speed, w := |speed|
+	const float4& GetSpeed(unsigned int id) const { return speeds[id]; }
+
+	unsigned int GetPhysicalState(unsigned int id) const { return physicalStates[id]; }
+	short GetHeading(unsigned int id) const { return headings[id]; }
+
+	bool HasPhysicalStateBit(unsigned int id, unsigned int bit) const { return ((physicalStates[id] & bit) != 0); }
+
+	// circle-vs-circle test, necessary condition for every movetype collision
+	bool MayCollide(unsigned int id, const float3& pos, float radius) const {
+		const float4& pr = posRadii[id];
+		const float3 sv = pos - pr;
+		return ((sv.SqLength() - Square(radius + pr.w)) <= 0.01f);
+	}
+
+	unsigned int Size() const { return posRadii.size(); }
+
+private:
+	std::vector<float4> posRadii;
+	std::vector<float4> speeds;
+
+	std::vector<unsigned int> physicalStates;
+	std::vector<short> headings;
+};
+
+#endif
@@ -0,0 +1,158 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef HAPFS_PATH_FLOWFIELD_SEARCH_HDR
+#define HAPFS_PATH_FLOWFIELD_SEARCH_HDR
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "System/type2.h"
+#include "PathConstants.h"
+
+namespace HAPFS {
+namespace FlowFieldSearch {
+
+/**
+ * Dijkstra outwards from goalBlockIdx over an 8-connected grid of blocks.
+ * costs receives the cost of reaching the goal from every block, or
+ * PATHCOST_INFINITY if it can not. Ties are broken by block index so the
+ * result is identical on every client.
+ *
+ * edgeCost(blockIdx, pathDir) is the cost of the edge between blockIdx and
+ * its neighbour in direction pathDir (same in both directions, like the PE's
+ * vertex costs); nodeCost(blockIdx) the extra cost of stepping into blockIdx.
+ */
+template<typename EdgeCostFunc, typename NodeCostFunc>
+static void Integrate(
+	std::vector<float>& costs,
+	const int2 numBlocks,
+	const unsigned int goalBlockIdx,
+	EdgeCostFunc&& edgeCost,
+	NodeCostFunc&& nodeCost
+) {
+	typedef std::pair<float, unsigned int> OpenBlock;
+
+	std::vector<OpenBlock> openBlocks;
+	openBlocks.reserve(numBlocks.x + numBlocks.y);
+
+	costs.clear();
+	costs.resize(numBlocks.x * numBlocks.y, PATHCOST_INFINITY);
+	costs[goalBlockIdx] = 0.0f;
+
+	openBlocks.emplace_back(0.0f, goalBlockIdx);
+
+	while (!openBlocks.empty()) {
+		std::pop_heap(openBlocks.begin(), openBlocks.end(), std::greater<OpenBlock>());
+
+		const OpenBlock ob = openBlocks.back();
+		openBlocks.pop_back();
+
+		if (ob.first > costs[ob.second])
+			continue;
+
+		const int2 blockPos = {int(ob.second % numBlocks.x), int(ob.second / numBlocks.x)};
+
+		// stepping into this block from any neighbour, see CPathEstimator::TestBlock
+		const float blockNodeCost = nodeCost(ob.second);
+
+		for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+			const int2 nbrBlockPos = blockPos + PE_DIRECTION_VECTORS[pathDir];
+
+			if (static_cast<unsigned int>(nbrBlockPos.x) >= numBlocks.x)
+				continue;
+			if (static_cast<unsigned int>(nbrBlockPos.y) >= numBlocks.y)
+				continue;
+
+			const float blockEdgeCost = edgeCost(ob.second, pathDir);
+
+			if (blockEdgeCost >= PATHCOST_INFINITY)
+				continue;
+
+			const unsigned int nbrBlockIdx = nbrBlockPos.y * numBlocks.x + nbrBlockPos.x;
+			const float nbrCost = ob.first + blockEdgeCost + blockNodeCost;
+
+			if (nbrCost >= costs[nbrBlockIdx])
+				continue;
+
+			costs[nbrBlockIdx] = nbrCost;
+
+			openBlocks.emplace_back(nbrCost, nbrBlockIdx);
+			std::push_heap(openBlocks.begin(), openBlocks.end(), std::greater<OpenBlock>());
+		}
+	}
+}
+
+/**
+ * Walks down the field built by Integrate from startBlockIdx and stores the
+ * visited blocks (start first) to blocks. The walk stops at the goal block or
+ * at the first block for which isGoal returns true, and fails if a block is
+ * rejected by isAllowed or the start can not reach the goal.
+ */
+template<typename EdgeCostFunc, typename NodeCostFunc, typename IsGoalFunc, typename IsAllowedFunc>
+static bool Descend(
+	const std::vector<float>& costs,
+	const int2 numBlocks,
+	const unsigned int startBlockIdx,
+	EdgeCostFunc&& edgeCost,
+	NodeCostFunc&& nodeCost,
+	IsGoalFunc&& isGoal,
+	IsAllowedFunc&& isAllowed,
+	std::vector<unsigned int>& blocks
+) {
+	if (costs[startBlockIdx] >= PATHCOST_INFINITY)
+		return false;
+
+	blocks.clear();
+
+	unsigned int blockIdx = startBlockIdx;
+
+	while (true) {
+		if (!isAllowed(blockIdx))
+			return false;
+
+		blocks.push_back(blockIdx);
+
+		if (costs[blockIdx] <= 0.0f || isGoal(blockIdx))
+			return true;
+
+		const int2 blockPos = {int(blockIdx % numBlocks.x), int(blockIdx / numBlocks.x)};
+
+		unsigned int nextBlockIdx = blockIdx;
+		float nextBlockCost = PATHCOST_INFINITY;
+
+		// only strictly cheaper neighbours are considered, which
+		// guarantees the walk ends at the goal
+		for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+			const int2 nbrBlockPos = blockPos + PE_DIRECTION_VECTORS[pathDir];
+
+			if (static_cast<unsigned int>(nbrBlockPos.x) >= numBlocks.x)
+				continue;
+			if (static_cast<unsigned int>(nbrBlockPos.y) >= numBlocks.y)
+				continue;
+
+			const unsigned int nbrBlockIdx = nbrBlockPos.y * numBlocks.x + nbrBlockPos.x;
+
+			if (costs[nbrBlockIdx] >= costs[blockIdx])
+				continue;
+
+			const float stepCost = edgeCost(blockIdx, pathDir) + nodeCost(nbrBlockIdx) + costs[nbrBlockIdx];
+
+			if (stepCost >= nextBlockCost)
+				continue;
+
+			nextBlockIdx = nbrBlockIdx;
+			nextBlockCost = stepCost;
+		}
+
+		if (nextBlockIdx == blockIdx)
+			return false;
+
+		blockIdx = nextBlockIdx;
+	}
+}
+
+}
+}
+
+#endif
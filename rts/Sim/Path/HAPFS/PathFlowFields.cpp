@@ -0,0 +1,192 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "PathFlowFields.h"
+#include "PathConstants.h"
+#include "PathFinderDef.h"
+#include "PathFlowFieldSearch.h"
+#include "PathingState.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "System/SpringMath.h"
+
+#include <algorithm>
+
+namespace HAPFS {
+
+// fields older than this are rebuilt even if no cost change was signalled
+// (extra-cost overlays can change without notice)
+static constexpr int FLOW_FIELD_REBUILD_INTERVAL = GAME_SPEED * 2;
+// fields no request has used for this long are freed
+static constexpr int FLOW_FIELD_UNUSED_LIFETIME = GAME_SPEED * 10;
+
+PathFlowFields gPathFlowFields;
+
+void PathFlowFields::FreeInstance(PathFlowFields* pff) {
+	assert(pff == &gPathFlowFields);
+	pff->Kill();
+}
+
+void PathFlowFields::Init(PathingState* medResPS) {
+	pathingState = medResPS;
+
+	numBlocks = medResPS->GetNumBlocks();
+	blockSize = medResPS->GetBlockSize();
+
+	extraCostsVersion = 0;
+}
+
+void PathFlowFields::Kill() {
+	fields.clear();
+	freeFields.clear();
+
+	pathingState = nullptr;
+}
+
+void PathFlowFields::Update() {
+	for (size_t i = 0, n = fields.size(); i < n; i++) {
+		FlowField& field = fields[i];
+
+		if (field.key == -1llu)
+			continue;
+		if ((field.usedFrame + FLOW_FIELD_UNUSED_LIFETIME) > gs->frameNum)
+			continue;
+
+		field.key = -1llu;
+		field.costs.clear();
+		field.costs.shrink_to_fit();
+
+		freeFields.push_back(i);
+	}
+}
+
+
+unsigned int PathFlowFields::GetBlockIdx(const float3& pos) const {
+	const int bx = Clamp(int(pos.x / SQUARE_SIZE) / int(blockSize), 0, numBlocks.x - 1);
+	const int bz = Clamp(int(pos.z / SQUARE_SIZE) / int(blockSize), 0, numBlocks.y - 1);
+	return static_cast<unsigned int>(bz * numBlocks.x + bx);
+}
+
+bool PathFlowFields::GetPath(const MoveDef& moveDef, const CPathFinderDef& pfDef, unsigned int startBlockIdx, IPath::Path& path) {
+	if (pathingState == nullptr)
+		return false;
+
+	const unsigned int goalBlockIdx = GetBlockIdx(pfDef.wsGoalPos);
+
+	FlowField* field = GetField(std::uint64_t(moveDef.pathType) * (numBlocks.x * numBlocks.y) + goalBlockIdx);
+
+	const std::lock_guard<std::mutex> lock(field->mutex);
+
+	// every request that runs in the same frame and finds no up-to-date field
+	// would build the same one, so it does not matter which worker gets here
+	// first; the result depends only on the (synced) block costs
+	const std::uint32_t costsVersion = pathingState->GetVertexCostsVersion() + extraCostsVersion;
+
+	if (field->builtFrame < 0 || field->version != costsVersion || (field->builtFrame + FLOW_FIELD_REBUILD_INTERVAL) <= gs->frameNum) {
+		BuildField(*field, moveDef.pathType, goalBlockIdx);
+
+		field->version = costsVersion;
+		field->builtFrame = gs->frameNum;
+	}
+
+	field->usedFrame = gs->frameNum;
+
+	if (!ExtractPath(*field, moveDef, pfDef, startBlockIdx, path))
+		return false;
+
+	path.desiredGoal = pfDef.wsGoalPos;
+	return true;
+}
+
+PathFlowFields::FlowField* PathFlowFields::GetField(std::uint64_t key) {
+	const std::lock_guard<std::mutex> lock(fieldsMutex);
+
+	for (FlowField& field: fields) {
+		if (field.key == key)
+			return &field;
+	}
+
+	size_t fieldIdx = fields.size();
+
+	if (!freeFields.empty()) {
+		fieldIdx = freeFields.back();
+		freeFields.pop_back();
+	} else {
+		fields.emplace_back();
+	}
+
+	FlowField& field = fields[fieldIdx];
+	field.key = key;
+	field.builtFrame = -1;
+	field.usedFrame = gs->frameNum;
+	return &field;
+}
+
+
+float PathFlowFields::GetEdgeCost(unsigned int pathType, unsigned int blockIdx, unsigned int pathDir) const {
+	// vertex costs are bi-directional, see GetBlockVertexOffset
+	const unsigned int vertexBaseIdx = pathType * numBlocks.x * numBlocks.y * PATH_DIRECTION_VERTICES;
+	const unsigned int vertexCostIdx =
+		vertexBaseIdx +
+		blockIdx * PATH_DIRECTION_VERTICES +
+		GetBlockVertexOffset(pathDir, numBlocks.x);
+
+	return (pathingState->GetVertexCost(vertexCostIdx));
+}
+
+float PathFlowFields::GetNodeCost(unsigned int pathType, unsigned int blockIdx) const {
+	PathNodeStateBuffer& blockStates = pathingState->GetNodeStateBuffer();
+
+	const short2 square = blockStates.peNodeOffsets[pathType][blockIdx];
+
+	// fields are only used by synced requests
+	return (blockStates.GetNodeExtraCost(square.x, square.y, true));
+}
+
+void PathFlowFields::BuildField(FlowField& field, unsigned int pathType, unsigned int goalBlockIdx) const {
+	FlowFieldSearch::Integrate(
+		field.costs,
+		numBlocks,
+		goalBlockIdx,
+		[&](unsigned int blockIdx, unsigned int pathDir) { return (GetEdgeCost(pathType, blockIdx, pathDir)); },
+		[&](unsigned int blockIdx) { return (GetNodeCost(pathType, blockIdx)); }
+	);
+}
+
+bool PathFlowFields::ExtractPath(const FlowField& field, const MoveDef& moveDef, const CPathFinderDef& pfDef, unsigned int startBlockIdx, IPath::Path& path) const {
+	const std::vector<short2>& nodeOffsets = pathingState->GetNodeStateBuffer().peNodeOffsets[moveDef.pathType];
+
+	std::vector<unsigned int> blocks;
+
+	// same goal and constraint tests as CPathEstimator::DoSearch and TestBlock
+	const bool havePath = FlowFieldSearch::Descend(
+		field.costs,
+		numBlocks,
+		startBlockIdx,
+		[&](unsigned int blockIdx, unsigned int pathDir) { return (GetEdgeCost(moveDef.pathType, blockIdx, pathDir)); },
+		[&](unsigned int blockIdx) { return (GetNodeCost(moveDef.pathType, blockIdx)); },
+		[&](unsigned int blockIdx) { return (pfDef.IsGoal(nodeOffsets[blockIdx].x, nodeOffsets[blockIdx].y)); },
+		[&](unsigned int blockIdx) { return (pfDef.constraintDisabled || pfDef.WithinConstraints(nodeOffsets[blockIdx].x, nodeOffsets[blockIdx].y)); },
+		blocks
+	);
+
+	if (!havePath)
+		return false;
+
+	path.path.clear();
+	path.squares.clear();
+	path.path.reserve(blocks.size());
+
+	// waypoints are consumed from the back, goal first like CPathEstimator::FinishSearch
+	for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+		const short2 square = nodeOffsets[*it];
+
+		path.path.emplace_back(square.x * SQUARE_SIZE, CMoveMath::yLevel(moveDef, square.x, square.y), square.y * SQUARE_SIZE);
+	}
+
+	path.pathGoal = path.path[0];
+	path.pathCost = field.costs[startBlockIdx] - field.costs[blocks.back()];
+	return true;
+}
+
+}
@@ -0,0 +1,97 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef HAPFS_PATH_FLOWFIELDS_HDR
+#define HAPFS_PATH_FLOWFIELDS_HDR
+
+#include <cinttypes>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "IPath.h"
+#include "System/float3.h"
+#include "System/type2.h"
+
+struct MoveDef;
+class CPathFinderDef;
+
+namespace HAPFS {
+
+class PathingState;
+
+/**
+ * Integration fields over the med-res block graph, one per (path-type, goal
+ * block). Every long-range synced request towards a goal block reads its path
+ * off the shared field instead of running its own low- and med-res searches,
+ * which collapses the searches of a mass move order into a single Dijkstra.
+ * Fields are built on demand by whichever pathing worker first needs them and
+ * rebuilt after the block costs they were derived from have changed.
+ */
+class PathFlowFields {
+public:
+	static void FreeInstance(PathFlowFields*);
+
+	void Init(PathingState* medResPS);
+	void Kill();
+
+	// serial; drops fields no request has used for a while
+	void Update();
+	// called whenever the synced extra-costs change; vertex-cost updates
+	// are picked up from the pathing state
+	void Invalidate() { extraCostsVersion += 1; }
+
+	/**
+	 * Writes the med-res waypoints (goal first, like CPathEstimator) from
+	 * startBlockIdx towards the block containing pfDef's goal into path,
+	 * stopping at the first block within pfDef's goal radius.
+	 * Thread-safe; returns false if the start block cannot reach the goal
+	 * or the path leaves pfDef's (enabled) search constraint.
+	 */
+	bool GetPath(const MoveDef& moveDef, const CPathFinderDef& pfDef, unsigned int startBlockIdx, IPath::Path& path);
+	unsigned int GetBlockIdx(const float3& pos) const;
+
+	size_t GetNumFields() const { return (fields.size() - freeFields.size()); }
+
+private:
+	struct FlowField {
+		std::mutex mutex;
+
+		// cost to reach the goal block, per block; PATHCOST_INFINITY if unreachable
+		std::vector<float> costs;
+
+		std::uint64_t key = -1llu;
+		std::uint32_t version = 0;
+
+		int builtFrame = -1;
+		int usedFrame = -1;
+	};
+
+	FlowField* GetField(std::uint64_t key);
+
+	void BuildField(FlowField& field, unsigned int pathType, unsigned int goalBlockIdx) const;
+	bool ExtractPath(const FlowField& field, const MoveDef& moveDef, const CPathFinderDef& pfDef, unsigned int startBlockIdx, IPath::Path& path) const;
+
+	float GetEdgeCost(unsigned int pathType, unsigned int blockIdx, unsigned int pathDir) const;
+	float GetNodeCost(unsigned int pathType, unsigned int blockIdx) const;
+
+private:
+	// fields are never moved or freed outside of Update, so pointers handed
+	// out to pathing workers stay valid for the whole request phase
+	std::deque<FlowField> fields;
+	std::vector<unsigned int> freeFields;
+
+	std::mutex fieldsMutex;
+
+	PathingState* pathingState = nullptr;
+
+	int2 numBlocks;
+	unsigned int blockSize = 0;
+
+	std::uint32_t extraCostsVersion = 0;
+};
+
+extern PathFlowFields gPathFlowFields;
+
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "PathConstants.h"
 #include "PathFinder.h"
 #include "PathEstimator.h"
+#include "PathFlowFields.h"
 #include "PathFlowMap.hpp"
 #include "PathHeatMap.h"
 #include "PathLog.h"
@@ -59,6 +60,7 @@ CPathManager::CPathManager()
 // , lowResPE(nullptr)
 : pathFlowMap(nullptr)
 , pathHeatMap(nullptr)
+, pathFlowFields(nullptr)
 , nextPathID(0)
 {
 	IPathFinder::InitStatic();
@@ -69,6 +71,7 @@ CPathManager::CPathManager()
 	pathFlowMap = PathFlowMap::GetInstance();
 	gPathHeatMap.Init(PATH_HEATMAP_XSCALE, PATH_HEATMAP_ZSCALE);
 	pathHeatMap = &gPathHeatMap;
+	pathFlowFields = &gPathFlowFields;
 
 	pathMap.reserve(1024);
 
@@ -149,6 +152,7 @@ CPathManager::~CPathManager()
 		pathingStates[i].Terminate();
 
 	PathHeatMap::FreeInstance(pathHeatMap);
+	PathFlowFields::FreeInstance(pathFlowFields);
 	PathFlowMap::FreeInstance(pathFlowMap);
 	IPathFinder::KillStatic();
 	PathingState::KillStatic();
@@ -192,6 +196,8 @@ std::int64_t CPathManager::Finalize()
 		
 		pathingStates[PATH_MED_RES].Init(std::move(maxResList), nullptr,                      MEDRES_PE_BLOCKSIZE, "pe" , mapInfo->map.name);
 		pathingStates[PATH_LOW_RES].Init(std::move(medResList), &pathingStates[PATH_MED_RES], LOWRES_PE_BLOCKSIZE, "pe2", mapInfo->map.name);
+
+		pathFlowFields->Init(&pathingStates[PATH_MED_RES]);
 	}
 
 	finalized = true;
@@ -289,12 +295,27 @@ IPath::SearchResult CPathManager::ArrangePath(
 	//{lowResPE, medResPE, maxResPF};
 	IPath::Path* pathObjects[] = {&newPath->lowResPath, &newPath->medResPath, &newPath->maxResPath};
 
+	pfDef->useVerifiedStartBlock = ((caller != nullptr) && ThreadPool::InMultiThreadedSection());
+
+	// long-range requests towards the same goal block all read their path off
+	// one shared integration field, which replaces the low- and med-res steps
+	// the start block is picked (and verified) exactly as the med-res PE would
+	// and the walk honors the goal radius and constraint of pfDef
+	if (modInfo.pfFlowFields && pfDef->synced && heurGoalDist2D > searchDistances[PATH_MED_RES]) {
+		CPathEstimator& medResPE = medResPEs[currentThread];
+
+		pfDef->DisableConstraint(!useConstraints[PATH_MED_RES]);
+
+		if (medResPE.SetStartBlock(*moveDef, *pfDef, caller, startPos)) {
+			if (pathFlowFields->GetPath(*moveDef, *pfDef, medResPE.mStartBlockIdx, newPath->medResPath))
+				return IPath::Ok;
+		}
+	}
+
 	IPath::SearchResult bestResult = IPath::Error;
 
 	unsigned int bestSearch = -1u; // index
 
-	pfDef->useVerifiedStartBlock = ((caller != nullptr) && ThreadPool::inMultiThreadedSection);
-
 	{
 		if (heurGoalDist2D <= (MAXRES_SEARCH_DISTANCE * modInfo.pfRawDistMult)) {
 			pfDef->AllowRawPathSearch( true);
@@ -789,6 +810,7 @@ void CPathManager::Update()
 
 	//pathFlowMap->Update();
 	pathHeatMap->Update();
+	pathFlowFields->Update();
 
 	auto medResPE = &pathingStates[PATH_MED_RES];
 	auto lowResPE = &pathingStates[PATH_LOW_RES];
@@ -967,6 +989,10 @@ bool CPathManager::SetNodeExtraCost(unsigned int x, unsigned int z, float cost,
 	
 	medResBuf.SetNodeExtraCost(x, z, cost, synced);
 	lowResBuf.SetNodeExtraCost(x, z, cost, synced);
+
+	if (synced)
+		pathFlowFields->Invalidate();
+
 	return true;
 }
 
@@ -992,6 +1018,10 @@ bool CPathManager::SetNodeExtraCosts(const float* costs, unsigned int sizex, uns
 	// make all buffers share the same cost-overlay
 	medResBuf.SetNodeExtraCosts(costs, sizex, sizez, synced);
 	lowResBuf.SetNodeExtraCosts(costs, sizex, sizez, synced);
+
+	if (synced)
+		pathFlowFields->Invalidate();
+
 	return true;
 }
 
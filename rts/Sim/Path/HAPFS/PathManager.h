@@ -22,6 +22,7 @@ struct MoveDef;
 namespace HAPFS {
 
 class CPathEstimator;
+class PathFlowFields;
 class PathHeatMap;
 class PathingState;
 class CPathFinder;
@@ -183,6 +184,7 @@ public:
 
 	const PathFlowMap* GetPathFlowMap() const { return pathFlowMap; }
 	const PathHeatMap* GetPathHeatMap() const { return pathHeatMap; }
+	const PathFlowFields* GetPathFlowFields() const { return pathFlowFields; }
 	int GetPathFinderGroups() const { return pathFinderGroups; }
 
 	const spring::unordered_map<unsigned int, MultiPath>& GetPathMap() const { return pathMap; }
@@ -219,7 +221,7 @@ private:
 	}
 
 	const MultiPath* GetMultiPathConst(int pathID) const {
-		assert(!ThreadPool::inMultiThreadedSection);
+		assert(!ThreadPool::InMultiThreadedSection());
 		const auto pi = pathMap.find(pathID);
 		if (pi == pathMap.end())
 			return nullptr;
@@ -256,6 +258,7 @@ private:
 
 	PathFlowMap* pathFlowMap;
 	PathHeatMap* pathHeatMap;
+	PathFlowFields* pathFlowFields;
 
 	spring::unordered_map<unsigned int, MultiPath> pathMap;
 
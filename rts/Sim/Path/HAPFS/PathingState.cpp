@@ -767,6 +767,8 @@ void PathingState::UpdateVertexPathCosts(int blocksToUpdate)
 	}
 
 	std::for_each(blockIds.begin(), blockIds.end(), [this](int idx){ blockStates.nodeLinksObsoleteFlags[idx] = 0; });
+
+	vertexCostsVersion += (!consumedBlocks.empty());
 }
 
 
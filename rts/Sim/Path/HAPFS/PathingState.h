@@ -77,6 +77,9 @@ public:
 	 */
 	std::uint32_t GetPathChecksum() const { return pathChecksum; }
 
+	/// incremented whenever UpdateVertexPathCosts recalculated any block
+	std::uint32_t GetVertexCostsVersion() const { return vertexCostsVersion; }
+
     // Re-entrant - return value cannot be a ref to avoid race conditions
 	//const
 	CPathCache::CacheItem GetCache(
@@ -151,6 +154,7 @@ private:
     unsigned int BLOCKS_TO_UPDATE = 0;
 
     std::uint32_t pathChecksum = 0;
+    std::uint32_t vertexCostsVersion = 0;
     std::uint32_t fileHashCode = 0;
 
     mutable std::mutex cacheAccessLock;
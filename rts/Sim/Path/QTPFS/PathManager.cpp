@@ -14,6 +14,7 @@
 #include "Game/LoadScreen.h"
 #include "Map/MapInfo.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
@@ -145,11 +146,18 @@ QTPFS::PathManager::~PathManager() {
 	pathSearches.clear();
 	pathTypes.clear();
 	pathTraces.clear();
+	sharedPaths.clear();
+	failedSearchPathIDs.clear();
+
+	#ifdef QTPFS_TRACE_PATH_SEARCHES
+	layerPathTraces.clear();
+	#endif
 
 	numCurrExecutedSearches.clear();
 	numPrevExecutedSearches.clear();
+	searchStateOffsets.clear();
 
-	PathSearch::FreeGlobalQueue();
+	PathSearch::FreeGlobalQueues();
 
 	#ifdef QTPFS_ENABLE_THREADED_UPDATE
 	// at this point the thread is waiting, so notify it
@@ -186,20 +194,30 @@ void QTPFS::PathManager::InitStatic() {
 }
 
 void QTPFS::PathManager::Load() {
-	// NOTE: offset *must* start at a non-zero value
-	searchStateOffset = NODE_STATE_OFFSET;
 	numTerrainChanges = 0;
 	numPathRequests   = 0;
 	maxNumLeafNodes   = 0;
 
+	multiThreadedSearches = modInfo.qtpfsMultiThreadedSearches;
+
 	nodeTrees.resize(moveDefHandler.GetNumMoveDefs(), nullptr);
 	nodeLayers.resize(moveDefHandler.GetNumMoveDefs());
 	pathCaches.resize(moveDefHandler.GetNumMoveDefs());
 	pathSearches.resize(moveDefHandler.GetNumMoveDefs());
 
+	sharedPaths.resize(moveDefHandler.GetNumMoveDefs());
+	failedSearchPathIDs.resize(moveDefHandler.GetNumMoveDefs());
+
+	#ifdef QTPFS_TRACE_PATH_SEARCHES
+	layerPathTraces.resize(moveDefHandler.GetNumMoveDefs());
+	#endif
+
+	// NOTE: offsets *must* start at a non-zero value
+	searchStateOffsets.resize(moveDefHandler.GetNumMoveDefs(), NODE_STATE_OFFSET);
+
 	// add one extra element for object-less requests
-	numCurrExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
-	numPrevExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
+	numCurrExecutedSearches.resize(moveDefHandler.GetNumMoveDefs(), std::vector<unsigned int>(teamHandler.ActiveTeams() + 1, 0));
+	numPrevExecutedSearches.resize(moveDefHandler.GetNumMoveDefs(), std::vector<unsigned int>(teamHandler.ActiveTeams() + 1, 0));
 
 	{
 		const sha512::raw_digest& mapCheckSum = archiveScanner->GetArchiveCompleteChecksumBytes(gameSetup->mapName);
@@ -248,7 +266,7 @@ void QTPFS::PathManager::Load() {
 
 		{ SyncedUint tmp(pfsCheckSum); }
 
-		PathSearch::InitGlobalQueue(maxNumLeafNodes);
+		PathSearch::InitGlobalQueues(maxNumLeafNodes);
 	}
 
 	{
@@ -711,19 +729,34 @@ void QTPFS::PathManager::ThreadUpdate() {
 		static unsigned int minPathTypeUpdate = 0;
 		static unsigned int maxPathTypeUpdate = numPathTypeUpdates;
 
-		sharedPaths.clear();
+		if (multiThreadedSearches) {
+			// requeueing touches data shared by all layers, so do it up-front
+			for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+				#ifndef QTPFS_IGNORE_DEAD_PATHS
+				QueueDeadPathSearches(pathTypeUpdate);
+				#endif
+			}
 
-		for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
-			#ifndef QTPFS_IGNORE_DEAD_PATHS
-			QueueDeadPathSearches(pathTypeUpdate);
-			#endif
+			// each layer owns its nodes, queued updates and path-cache
+			// so layers can be processed independently; searches within
+			// one layer still run in queue-order which keeps the results
+			// identical on every client
+			for_mt(minPathTypeUpdate, maxPathTypeUpdate, [this](const int pathTypeUpdate) {
+				ExecuteQueuedLayerSearches(pathTypeUpdate);
+			});
 
-			#ifdef QTPFS_STAGGERED_LAYER_UPDATES
-			// NOTE: *must* be called between QueueDeadPathSearches and ExecuteQueuedSearches
-			ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty());
-			#endif
+			for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+				FinalizeQueuedSearches(pathTypeUpdate);
+			}
+		} else {
+			for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+				#ifndef QTPFS_IGNORE_DEAD_PATHS
+				QueueDeadPathSearches(pathTypeUpdate);
+				#endif
 
-			ExecuteQueuedSearches(pathTypeUpdate);
+				ExecuteQueuedLayerSearches(pathTypeUpdate);
+				FinalizeQueuedSearches(pathTypeUpdate);
+			}
 		}
 
 		std::copy(numCurrExecutedSearches.begin(), numCurrExecutedSearches.end(), numPrevExecutedSearches.begin());
@@ -748,6 +781,37 @@ void QTPFS::PathManager::ThreadUpdate() {
 
 
 
+// NOTE:
+//   must only touch data owned by layer <pathType>, since in
+//   multi-threaded mode all layers of an update are processed
+//   concurrently (see ThreadUpdate)
+void QTPFS::PathManager::ExecuteQueuedLayerSearches(unsigned int pathType) {
+	sharedPaths[pathType].clear();
+
+	#ifdef QTPFS_STAGGERED_LAYER_UPDATES
+	// NOTE: *must* be called between QueueDeadPathSearches and ExecuteQueuedSearches
+	ExecQueuedNodeLayerUpdates(pathType, !pathSearches[pathType].empty());
+	#endif
+
+	ExecuteQueuedSearches(pathType);
+}
+
+void QTPFS::PathManager::FinalizeQueuedSearches(unsigned int pathType) {
+	for (const unsigned int pathID: failedSearchPathIDs[pathType]) {
+		DeletePath(pathID);
+	}
+
+	failedSearchPathIDs[pathType].clear();
+
+	#ifdef QTPFS_TRACE_PATH_SEARCHES
+	for (const auto& p: layerPathTraces[pathType]) {
+		pathTraces[p.first] = p.second;
+	}
+
+	layerPathTraces[pathType].clear();
+	#endif
+}
+
 void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 	NodeLayer& nodeLayer = nodeLayers[pathType];
 	PathCache& pathCache = pathCaches[pathType];
@@ -760,7 +824,7 @@ void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 		// RequestPath and QueueDeadPathSearches
 		while (searchesIt != searches.end()) {
 			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, pathType)) {
-				searchStateOffset += NODE_STATE_OFFSET;
+				searchStateOffsets[pathType] += NODE_STATE_OFFSET;
 			}
 		}
 	}
@@ -801,9 +865,10 @@ bool QTPFS::PathManager::ExecuteSearch(
 
 	{
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
+		const SharedPathMap& layerSharedPaths = sharedPaths[pathType];
+		const SharedPathMap::const_iterator sharedPathsIt = layerSharedPaths.find(path->GetHash());
 
-		if (sharedPathsIt != sharedPaths.end()) {
+		if (sharedPathsIt != layerSharedPaths.end()) {
 			if (search->SharedFinalize(sharedPathsIt->second, path)) {
 				DeleteSearch(search, searches, searchesIt);
 				return false;
@@ -812,30 +877,34 @@ bool QTPFS::PathManager::ExecuteSearch(
 		#endif
 
 		#ifdef QTPFS_LIMIT_TEAM_SEARCHES
-		const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
-		const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
+		std::vector<unsigned int>& numCurrTeamSearches = numCurrExecutedSearches[GetSearchCounterIndex(pathType)];
+		std::vector<unsigned int>& numPrevTeamSearches = numPrevExecutedSearches[GetSearchCounterIndex(pathType)];
+
+		const unsigned int numCurrSearches = numCurrTeamSearches[search->GetTeam()];
+		const unsigned int numPrevSearches = numPrevTeamSearches[search->GetTeam()];
 
 		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
 			++searchesIt; return false;
 		}
 
-		numCurrExecutedSearches[search->GetTeam()] += 1;
+		numCurrTeamSearches[search->GetTeam()] += 1;
 		#endif
 	}
 
 	// removes path from temp-paths, adds it to live-paths
-	if (search->Execute(searchStateOffset, numTerrainChanges)) {
+	if (search->Execute(searchStateOffsets[pathType], numTerrainChanges)) {
 		search->Finalize(path);
 
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		sharedPaths[path->GetHash()] = path;
+		sharedPaths[pathType][path->GetHash()] = path;
 		#endif
 
 		#ifdef QTPFS_TRACE_PATH_SEARCHES
-		pathTraces[path->GetID()] = search->GetExecutionTrace();
+		layerPathTraces[pathType].emplace_back(path->GetID(), search->GetExecutionTrace());
 		#endif
 	} else {
-		DeletePath(path->GetID());
+		// DeletePath modifies maps shared by all layers, defer it
+		failedSearchPathIDs[pathType].push_back(path->GetID());
 	}
 
 	DeleteSearch(search, searches, searchesIt);
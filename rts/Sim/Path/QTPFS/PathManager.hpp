@@ -122,6 +122,8 @@ namespace QTPFS {
 		#endif
 
 		void ExecuteQueuedSearches(unsigned int pathType);
+		void ExecuteQueuedLayerSearches(unsigned int pathType);
+		void FinalizeQueuedSearches(unsigned int pathType);
 		void QueueDeadPathSearches(unsigned int pathType);
 
 		unsigned int QueueSearch(
@@ -144,6 +146,9 @@ namespace QTPFS {
 
 		bool IsFinalized() const { return (!nodeTrees.empty()); }
 
+		// in multi-threaded mode every node-layer keeps its own per-team search counters
+		unsigned int GetSearchCounterIndex(unsigned int pathType) const { return (pathType * multiThreadedSearches); }
+
 
 		std::string GetCacheDirName(const std::string& mapCheckSumHexStr, const std::string& modCheckSumHexStr) const;
 		void Serialize(const std::string& cacheFileDir);
@@ -156,16 +161,24 @@ namespace QTPFS {
 		spring::unordered_map<unsigned int, unsigned int> pathTypes;
 		spring::unordered_map<unsigned int, PathSearchTrace::Execution*> pathTraces;
 
-		// maps "hashes" of executed searches to the found paths
-		spring::unordered_map<std::uint64_t, IPath*> sharedPaths;
+		// maps "hashes" of executed searches to the found paths (per layer)
+		std::vector<SharedPathMap> sharedPaths;
+
+		// IDs of paths whose searches failed, deleted after all layers are done
+		std::vector< std::vector<unsigned int> > failedSearchPathIDs;
+		#ifdef QTPFS_TRACE_PATH_SEARCHES
+		std::vector< std::vector< std::pair<unsigned int, PathSearchTrace::Execution*> > > layerPathTraces;
+		#endif
 
-		std::vector<unsigned int> numCurrExecutedSearches;
-		std::vector<unsigned int> numPrevExecutedSearches;
+		std::vector< std::vector<unsigned int> > numCurrExecutedSearches;
+		std::vector< std::vector<unsigned int> > numPrevExecutedSearches;
 
 		static unsigned int LAYERS_PER_UPDATE;
 		static unsigned int MAX_TEAM_SEARCHES;
 
-		unsigned int searchStateOffset;
+		// node search-states are layer-local, so each layer has its own offset
+		std::vector<unsigned int> searchStateOffsets;
+
 		unsigned int numTerrainChanges;
 		unsigned int numPathRequests;
 		unsigned int maxNumLeafNodes;
@@ -174,6 +187,7 @@ namespace QTPFS {
 
 		bool layersInited;
 		bool haveCacheDir;
+		bool multiThreadedSearches;
 
 		#ifdef QTPFS_ENABLE_THREADED_UPDATE
 		spring::thread updateThread;
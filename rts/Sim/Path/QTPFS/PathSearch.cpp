@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 
@@ -15,7 +16,24 @@
 
 #include "System/float3.h"
 
-QTPFS::binary_heap<QTPFS::INode*> QTPFS::PathSearch::openNodes;
+std::array<QTPFS::binary_heap<QTPFS::INode*>, ThreadPool::MAX_THREADS> QTPFS::PathSearch::openNodeQueues;
+
+
+void QTPFS::PathSearch::InitGlobalQueues(unsigned int n) {
+	// the main thread's queue gets the full size, workers start
+	// out smaller and grow on demand (binary_heap doubles itself)
+	openNodeQueues[0].reserve(n);
+
+	for (int i = 1; i < ThreadPool::GetMaxThreads(); i++) {
+		openNodeQueues[i].reserve(std::max(n >> 4, 1024u));
+	}
+}
+
+void QTPFS::PathSearch::FreeGlobalQueues() {
+	for (binary_heap<INode*>& queue: openNodeQueues) {
+		queue.clear();
+	}
+}
 
 
 
@@ -49,6 +67,8 @@ bool QTPFS::PathSearch::Execute(
 	searchState = searchStateOffset; // starts at NODE_STATE_OFFSET
 	searchMagic = searchMagicNumber; // starts at numTerrainChanges
 
+	openNodes = &openNodeQueues[ThreadPool::GetThreadNum()];
+
 	haveFullPath = (srcNode == tgtNode);
 	havePartPath = false;
 
@@ -81,7 +101,7 @@ bool QTPFS::PathSearch::Execute(
 	ResetState(srcNode);
 	UpdateNode(srcNode, nullptr, 0);
 
-	while (!openNodes.empty()) {
+	while (!openNodes->empty()) {
 		IterateNodes(nodeLayer->GetNodes());
 
 		#ifdef QTPFS_TRACE_PATH_SEARCHES
@@ -93,7 +113,7 @@ bool QTPFS::PathSearch::Execute(
 		havePartPath = (minNode != srcNode);
 
 		if (haveFullPath)
-			openNodes.reset();
+			openNodes->reset();
 	}
 
 	if (srcNode->GetMoveCost() == 0.0f)
@@ -136,8 +156,8 @@ void QTPFS::PathSearch::ResetState(INode* node) {
 		hCosts[i] = 0.0f;
 	}
 
-	openNodes.reset();
-	openNodes.push(node);
+	openNodes->reset();
+	openNodes->push(node);
 }
 
 void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx) {
@@ -153,7 +173,7 @@ void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned in
 }
 
 void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
-	curNode = openNodes.top();
+	curNode = openNodes->top();
 	curNode->SetSearchState(searchState | NODE_STATE_CLOSED);
 	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
 	// in the non-conservative case, this is done from
@@ -161,8 +181,8 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 	curNode->SetMagicNumber(searchMagic);
 	#endif
 
-	openNodes.pop();
-	openNodes.check_heap_property(0);
+	openNodes->pop();
+	openNodes->check_heap_property(0);
 
 	#ifdef QTPFS_TRACE_PATH_SEARCHES
 	searchIter.SetPoppedNodeIdx(curNode->zmin() * mapDims.mapx + curNode->xmin());
@@ -267,8 +287,8 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		if (!isCurrent) {
 			UpdateNode(nxtNode, curNode, netPointIdx);
 
-			openNodes.push(nxtNode);
-			openNodes.check_heap_property(0);
+			openNodes->push(nxtNode);
+			openNodes->check_heap_property(0);
 
 			#ifdef QTPFS_TRACE_PATH_SEARCHES
 			searchIter.AddPushedNodeIdx(nxtNode->zmin() * mapDims.mapx + nxtNode->xmin());
@@ -279,7 +299,7 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		if (gCosts[netPointIdx] >= nxtNode->GetPathCost(NODE_PATH_COST_G))
 			continue;
 		if (isClosed)
-			openNodes.push(nxtNode);
+			openNodes->push(nxtNode);
 
 		UpdateNode(nxtNode, curNode, netPointIdx);
 
@@ -287,8 +307,8 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		// (changing the f-cost of an OPEN node messes up the
 		// queue's internal consistency; a pushed node remains
 		// OPEN until it gets popped)
-		openNodes.resort(nxtNode);
-		openNodes.check_heap_property(0);
+		openNodes->resort(nxtNode);
+		openNodes->check_heap_property(0);
 	}
 }
 
@@ -3,6 +3,7 @@
 #ifndef QTPFS_PATHSEARCH_HDR
 #define QTPFS_PATHSEARCH_HDR
 
+#include <array>
 #include <vector>
 
 #include "PathDefines.hpp"
@@ -10,6 +11,7 @@
 #include "NodeHeap.hpp"
 
 #include "System/float3.h"
+#include "System/Threading/ThreadPool.h"
 
 namespace QTPFS {
 	struct PathCache;
@@ -128,11 +130,15 @@ namespace QTPFS {
 			, curNode(NULL)
 			, nxtNode(NULL)
 			, minNode(NULL)
+			, openNodes(NULL)
 			, hCostMult(0.0f)
 			, haveFullPath(false)
 			, havePartPath(false)
 			{}
-		~PathSearch() { openNodes.reset(); }
+		~PathSearch() {
+			if (openNodes != NULL)
+				openNodes->reset();
+		}
 
 		void Initialize(
 			NodeLayer* layer,
@@ -151,8 +157,8 @@ namespace QTPFS {
 
 		const std::uint64_t GetHash(std::uint64_t N, std::uint32_t k) const;
 
-		static void InitGlobalQueue(unsigned int n) { openNodes.reserve(n); }
-		static void FreeGlobalQueue() { openNodes.clear(); }
+		static void InitGlobalQueues(unsigned int n);
+		static void FreeGlobalQueues();
 
 	private:
 		void ResetState(INode* node);
@@ -165,9 +171,10 @@ namespace QTPFS {
 		void SmoothPath(IPath* path) const;
 		bool SmoothPathIter(IPath* path) const;
 
-		// global queue: allocated once, re-used by all searches without clear()'s
+		// global queues: allocated once, re-used by all searches without clear()'s
 		// this relies on INode::operator< to sort the INode*'s by increasing f-cost
-		static binary_heap<INode*> openNodes;
+		// (one per thread, searches on different node-layers can run concurrently)
+		static std::array<binary_heap<INode*>, ThreadPool::MAX_THREADS> openNodeQueues;
 
 		NodeLayer* nodeLayer;
 		PathCache* pathCache;
@@ -182,6 +189,9 @@ namespace QTPFS {
 		INode *curNode, *nxtNode;
 		INode *minNode;
 
+		// queue owned by the thread executing this search
+		binary_heap<INode*>* openNodes;
+
 		float3 srcPoint;
 		float3 tgtPoint;
 
@@ -406,47 +406,97 @@ static bool CheckProjectileCollisionFlags(const CProjectile* p, const CUnit* u)
 }
 
 
-void CProjectileHandler::CheckUnitCollisions(
+static bool CanProjectileCollide(const CProjectile* p, const CUnit* unit)
+{
+	// if this unit fired this projectile, always ignore
+	if (unit == p->owner())
+		return false;
+	if (!unit->HasCollidableStateBit(CSolidObject::CSTATE_BIT_PROJECTILES))
+		return false;
+
+	return (CheckProjectileCollisionFlags(p, unit));
+}
+
+static bool CanProjectileCollide(const CProjectile* p, const CFeature* feature)
+{
+	return (feature->HasCollidableStateBit(CSolidObject::CSTATE_BIT_PROJECTILES));
+}
+
+
+template<typename T>
+static T* DetectProjectileHit(
+	const CProjectile* p,
+	const std::vector<T*>& objects,
+	const float3 ppos0,
+	const float3 ppos1,
+	CollisionQuery* cq
+) {
+	for (T* obj: objects) {
+		assert(obj != nullptr);
+
+		if (!CanProjectileCollide(p, obj))
+			continue;
+
+		if (CCollisionHandler::DetectHit(obj, obj->GetTransformMatrix(true), ppos0, ppos1, cq))
+			return obj;
+	}
+
+	return nullptr;
+}
+
+template<typename T>
+static void ApplyProjectileHit(CProjectile* p, T* obj, const CollisionQuery& cq, const float3 ppos0)
+{
+	if (cq.GetHitPiece() != nullptr)
+		obj->SetLastHitPiece(cq.GetHitPiece(), gs->frameNum, p->synced);
+
+	if (!cq.InsideHit()) {
+		p->SetPosition(cq.GetHitPos());
+		p->Collision(obj);
+		p->SetPosition(ppos0);
+	} else {
+		p->Collision(obj);
+	}
+}
+
+static bool IsShieldInterceptable(const CProjectile* p)
+{
+	// see CheckShieldCollisions
+	if (!p->weapon)
+		return false;
+
+	return (static_cast<const CWeaponProjectile*>(p)->GetWeaponDef()->interceptedByShieldType != 0);
+}
+
+template<typename T>
+static bool HasPieceTreeVolumes(const std::vector<T*>& objects)
+{
+	// piece matrices are lazily updated, not safe to test concurrently
+	const auto pred = [](const T* obj) { return (obj->collisionVolume.DefaultToPieceTree()); };
+	return (std::any_of(objects.begin(), objects.end(), pred));
+}
+
+
+bool CProjectileHandler::CheckUnitCollisions(
 	CProjectile* p,
 	std::vector<CUnit*>& tempUnits,
 	const float3 ppos0,
 	const float3 ppos1
 ) {
 	if (!p->checkCol)
-		return;
+		return false;
 
 	CollisionQuery cq;
+	CUnit* unit = DetectProjectileHit(p, tempUnits, ppos0, ppos1, &cq);
 
-	for (CUnit* unit: tempUnits) {
-		assert(unit != nullptr);
-
-		// if this unit fired this projectile, always ignore
-		if (unit == p->owner())
-			continue;
-		if (!unit->HasCollidableStateBit(CSolidObject::CSTATE_BIT_PROJECTILES))
-			continue;
-
-		if (!CheckProjectileCollisionFlags(p, unit))
-			continue;
-
-		if (CCollisionHandler::DetectHit(unit, unit->GetTransformMatrix(true), ppos0, ppos1, &cq)) {
-			if (cq.GetHitPiece() != nullptr)
-				unit->SetLastHitPiece(cq.GetHitPiece(), gs->frameNum, p->synced);
-
-			if (!cq.InsideHit()) {
-				p->SetPosition(cq.GetHitPos());
-				p->Collision(unit);
-				p->SetPosition(ppos0);
-			} else {
-				p->Collision(unit);
-			}
+	if (unit == nullptr)
+		return false;
 
-			break;
-		}
-	}
+	ApplyProjectileHit(p, unit, cq, ppos0);
+	return true;
 }
 
-void CProjectileHandler::CheckFeatureCollisions(
+bool CProjectileHandler::CheckFeatureCollisions(
 	CProjectile* p,
 	std::vector<CFeature*>& tempFeatures,
 	const float3 ppos0,
@@ -454,48 +504,33 @@ void CProjectileHandler::CheckFeatureCollisions(
 ) {
 	// already collided with unit?
 	if (!p->checkCol)
-		return;
+		return false;
 
 	if ((p->GetCollisionFlags() & Collision::NOFEATURES) != 0)
-		return;
+		return false;
 
 	CollisionQuery cq;
+	CFeature* feature = DetectProjectileHit(p, tempFeatures, ppos0, ppos1, &cq);
 
-	for (CFeature* feature: tempFeatures) {
-		assert(feature != nullptr);
-
-		if (!feature->HasCollidableStateBit(CSolidObject::CSTATE_BIT_PROJECTILES))
-			continue;
-
-		if (CCollisionHandler::DetectHit(feature, feature->GetTransformMatrix(true), ppos0, ppos1, &cq)) {
-			if (cq.GetHitPiece() != nullptr)
-				feature->SetLastHitPiece(cq.GetHitPiece(), gs->frameNum, p->synced);
-
-			if (!cq.InsideHit()) {
-				p->SetPosition(cq.GetHitPos());
-				p->Collision(feature);
-				p->SetPosition(ppos0);
-			} else {
-				p->Collision(feature);
-			}
+	if (feature == nullptr)
+		return false;
 
-			break;
-		}
-	}
+	ApplyProjectileHit(p, feature, cq, ppos0);
+	return true;
 }
 
 
-void CProjectileHandler::CheckShieldCollisions(
+bool CProjectileHandler::CheckShieldCollisions(
 	CProjectile* p,
 	std::vector<CPlasmaRepulser*>& tempRepulsers,
 	const float3 ppos0,
 	const float3 ppos1
 ) {
 	if (!p->checkCol)
-		return;
+		return false;
 	// skip unsynced and non-weapon projectiles
 	if (!p->weapon)
-		return;
+		return false;
 
 	CWeaponProjectile* wpro = static_cast<CWeaponProjectile*>(p);
 	const WeaponDef* wdef = wpro->GetWeaponDef();
@@ -505,10 +540,12 @@ void CProjectileHandler::CheckShieldCollisions(
 
 	// bail early
 	if (interceptType == 0)
-		return;
+		return false;
 
 	CollisionQuery cq;
 
+	bool interacted = false;
+
 	for (CPlasmaRepulser* repulser: tempRepulsers) {
 		assert(repulser != nullptr);
 
@@ -533,9 +570,63 @@ void CProjectileHandler::CheckShieldCollisions(
 		if (cq.InsideHit() && repulser->IgnoreInteriorHit(wpro))
 			continue;
 
+		// this runs the ShieldPreDamaged call-in even if not intercepted
+		interacted = true;
+
 		if (repulser->IncomingProjectile(wpro, cq.GetHitPos()))
-			return;
+			return true;
 	}
+
+	return interacted;
+}
+
+void CProjectileHandler::DetectUnitFeatureCollisions(bool synced)
+{
+	SCOPED_TIMER("Sim::Projectiles::Collisions::Detect");
+
+	const auto& pc = projectiles[synced];
+
+	projectileHits.clear();
+	projectileHits.resize(pc.size());
+
+	// broad- and narrow-phase only read simulation state, so run for all
+	// projectiles concurrently; each writes only its own projectileHits[i]
+	for_mt_chunk(0, pc.size(), [&](const int i) {
+		const CProjectile* p = pc[i];
+
+		if (!p->checkCol) return;
+		if ( p->deleteMe) return;
+
+		const int curThread = ThreadPool::GetThreadNum();
+
+		ProjectileHits& hits = projectileHits[i];
+		std::vector<CPlasmaRepulser*>& repulsers = hitRepulsers[curThread];
+
+		hits.ppos0 = p->pos;
+		hits.ppos1 = p->pos + p->speed;
+
+		QuadFieldQuery qfQuery;
+		qfQuery.threadOwner = curThread;
+		quadField.GetUnitsAndFeaturesColVol(qfQuery, p->pos, p->speed.w + p->radius, &repulsers);
+
+		const bool shieldable = (!repulsers.empty() && IsShieldInterceptable(p));
+
+		repulsers.clear();
+
+		// shield checks run call-ins, leave these to the serial path
+		if (shieldable)
+			return;
+		if (HasPieceTreeVolumes(*qfQuery.units) || HasPieceTreeVolumes(*qfQuery.features))
+			return;
+
+		hits.unit = DetectProjectileHit(p, *qfQuery.units, hits.ppos0, hits.ppos1, &hits.unitQuery);
+
+		// a unit hit is applied serially, the feature check has to see its effects
+		if (hits.unit == nullptr && (p->GetCollisionFlags() & Collision::NOFEATURES) == 0)
+			hits.feature = DetectProjectileHit(p, *qfQuery.features, hits.ppos0, hits.ppos1, &hits.featureQuery);
+
+		hits.detected = true;
+	});
 }
 
 void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
@@ -544,6 +635,16 @@ void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 	static std::vector<CFeature*> tempFeatures;
 	static std::vector<CPlasmaRepulser*> tempRepulsers;
 
+	DetectUnitFeatureCollisions(synced);
+
+	SCOPED_TIMER("Sim::Projectiles::Collisions::Apply");
+
+	// set once a collision or shield interception ran, after which units
+	// and features (through impulse or Lua call-ins) and projectiles may
+	// have moved; the detection results are then stale and every further
+	// projectile is checked serially, exactly as without the parallel pass
+	bool stateChanged = false;
+
 	//can't use iterators here, because instructions inside the loop modify projectiles[synced]
 	for (size_t i = 0; i < projectiles[synced].size(); ++i) {
 		CProjectile* p = projectiles[synced][i];
@@ -555,11 +656,40 @@ void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 		const float3 ppos1 = p->pos + p->speed;
 		// const float3 ppos1 = p->pos + p->dir * (p->speed.w + p->radius);
 
-		quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
+		// projectiles created by earlier collisions, or moved by them, were
+		// not (validly) covered by the detection pass; use the serial path
+		if (stateChanged || i >= projectileHits.size() || !projectileHits[i].detected || projectileHits[i].ppos0 != ppos0 || projectileHits[i].ppos1 != ppos1) {
+			quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
+
+			stateChanged |= CheckShieldCollisions (p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
+			stateChanged |= CheckUnitCollisions   (p, tempUnits    , ppos0, ppos1); tempUnits.clear();
+			stateChanged |= CheckFeatureCollisions(p, tempFeatures , ppos0, ppos1); tempFeatures.clear();
+			continue;
+		}
+
+		// nothing changed since detection and no shield could intercept p,
+		// so the detected first hit is still the first
+		const ProjectileHits& hits = projectileHits[i];
+
+		if (hits.unit != nullptr) {
+			// the features are gathered before the unit hit changes anything,
+			// as on the serial path, but only tested after it
+			quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures);
 
-		CheckShieldCollisions (p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
-		CheckUnitCollisions   (p, tempUnits    , ppos0, ppos1); tempUnits.clear();
-		CheckFeatureCollisions(p, tempFeatures , ppos0, ppos1); tempFeatures.clear();
+			ApplyProjectileHit(p, hits.unit, hits.unitQuery, ppos0);
+			CheckFeatureCollisions(p, tempFeatures, ppos0, ppos1);
+
+			tempUnits.clear();
+			tempFeatures.clear();
+
+			stateChanged = true;
+			continue;
+		}
+
+		if (hits.feature != nullptr) {
+			ApplyProjectileHit(p, hits.feature, hits.featureQuery, ppos0);
+			stateChanged = true;
+		}
 	}
 }
 
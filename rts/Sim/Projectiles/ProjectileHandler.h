@@ -8,8 +8,10 @@
 
 #include "Rendering/Models/3DModel.h"
 #include "Rendering/Env/Particles/Classes/FlyingPiece.h"
+#include "Sim/Misc/CollisionHandler.h"
 #include "System/float3.h"
 #include "System/FreeListMap.h"
+#include "System/Threading/ThreadPool.h"
 
 
 // bypass id and event handling for unsynced projectiles (faster)
@@ -43,10 +45,12 @@ public:
 		return projectiles[synced];
 	}
 
-	void CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3);
-	void CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3);
-	void CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3);
+	// these return true if they applied a collision (or ran a shield call-in)
+	bool CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3);
+	bool CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3);
+	bool CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3);
 	void CheckUnitFeatureCollisions(bool synced);
+	void DetectUnitFeatureCollisions(bool synced);
 	void CheckGroundCollisions(bool synced);
 	void CheckCollisions();
 
@@ -115,6 +119,29 @@ private:
 	// [1] contains only projectiles that can     change simulation state
 	spring::FreeListMapCompact<CProjectile*, int> projectiles[2];
 
+	// results of the parallel detection pass over projectiles[synced],
+	// computed against the state at the start of CheckCollisions and
+	// applied serially in index-order until the first collision changes
+	// that state (see CheckUnitFeatureCollisions)
+	struct ProjectileHits {
+		float3 ppos0;
+		float3 ppos1;
+
+		CUnit* unit = nullptr;
+		// only searched if no unit was hit
+		CFeature* feature = nullptr;
+
+		CollisionQuery unitQuery;
+		CollisionQuery featureQuery;
+
+		// false if this projectile has to take the serial path
+		bool detected = false;
+	};
+
+	std::vector<ProjectileHits> projectileHits;
+	// per-thread scratch for the repulser candidates of the detection pass
+	std::array<std::vector<CPlasmaRepulser*>, ThreadPool::MAX_THREADS> hitRepulsers;
+
 	static uint32_t UnsyncedRandInt(uint32_t N);
 	static uint32_t   SyncedRandInt(uint32_t N);
 
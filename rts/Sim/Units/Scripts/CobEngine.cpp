@@ -22,7 +22,9 @@ CR_REG_METADATA(CCobEngine, (
 	CR_IGNORED(curThread),
 
 	CR_MEMBER(currentTime),
-	CR_MEMBER(threadCounter)
+	CR_MEMBER(threadCounter),
+
+	CR_IGNORED(profiling)
 ))
 
 CR_BIND(CCobEngine::SleepingThread, )
@@ -90,6 +90,10 @@ public:
 	void ScheduleThread(const CCobThread* thread);
 	void SanityCheckThreads(const CCobInstance* owner);
 
+	/// enables the per-function counters in CCobFile::functionStats
+	void SetProfiling(bool b) { profiling = b; }
+	bool IsProfiling() const { return profiling; }
+
 	const auto& GetThreadInstances() const { return threadInstances; }
 //	const auto& GetTickAddedThreads() const { return tickAddedThreads; }
 //	const auto& GetTickRemovedThreads() const { return tickRemovedThreads; }
@@ -124,6 +128,8 @@ private:
 
 	int currentTime = 0;
 	int threadCounter = 0;
+
+	bool profiling = false;
 };
 
 
@@ -196,6 +196,10 @@ CCobFile::CCobFile(CFileHandler& in, const std::string& scriptName)
 
 		scriptIndex[pair.second] = fn;
 	}
+
+	DecodeInstrs();
+
+	functionStats.resize(scriptNames.size());
 }
 
 
@@ -208,3 +212,8 @@ int CCobFile::GetFunctionId(const std::string& name)
 
 	return -1;
 }
+
+void CCobFile::ResetFunctionStats()
+{
+	std::fill(functionStats.begin(), functionStats.end(), FunctionStats{});
+}
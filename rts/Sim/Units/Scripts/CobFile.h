@@ -4,6 +4,7 @@
 #define COB_FILE_H
 
 #include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -16,6 +17,7 @@ class CFileHandler;
 class CCobFile
 {
 public:
+	CCobFile() { scriptIndex.fill(-1); }
 	CCobFile(CFileHandler& in, const std::string& scriptName);
 	CCobFile(CCobFile&& f) { *this = std::move(f); }
 
@@ -23,6 +25,7 @@ public:
 		numStaticVars = f.numStaticVars;
 
 		code = std::move(f.code);
+		instrs = std::move(f.instrs);
 		scriptNames = std::move(f.scriptNames);
 		scriptOffsets = std::move(f.scriptOffsets);
 
@@ -32,6 +35,7 @@ public:
 		sounds = std::move(f.sounds);
 		luaScripts = std::move(f.luaScripts);
 		scriptMap = std::move(f.scriptMap);
+		functionStats = std::move(f.functionStats);
 
 		name = std::move(f.name);
 		return *this;
@@ -39,10 +43,78 @@ public:
 
 	int GetFunctionId(const std::string& name);
 
+	void ResetFunctionStats();
+
+	/// (re)builds <instrs> from <code> and the script offsets and lengths
+	void DecodeInstrs() {
+		DecodeCode();
+		FuseInstrs();
+	}
+
+private:
+	void DecodeCode();
+	void FuseInstrs();
+
+public:
+	/**
+	 * Pre-decoded form of the instruction starting at each offset into
+	 * <code>, operands resolved. Every offset gets an entry (even those
+	 * inside operands) so program counters and jump targets remain raw
+	 * code offsets, which keeps the serialized thread state unchanged.
+	 */
+	struct Instr {
+		enum Op: uint8_t {
+			Nop, // cache, dont-cache, shade, dont-shade, call or start of a zero-length function
+
+			Move, Turn, Spin, StopSpin, Show, Hide, MoveNow, TurnNow, EmitSfx,
+			WaitTurn, WaitMove, Sleep,
+
+			PushConstant, PushLocalVar, PushStatic, CreateLocalVar, PopLocalVar, PopStatic, PopStack,
+
+			// binary operators, also used as <aux> by the fused ops
+			Add, Sub, Mul, BitAnd, BitOr, BitXor,
+			SetLess, SetLessEqual, SetGreater, SetGreaterEqual, SetEqual, SetNotEqual,
+			LogicalAnd, LogicalOr, LogicalXor,
+
+			Div, Mod, BitNot, LogicalNot,
+			Rand, GetUnitValue, Get,
+
+			Start, Call, LuaCall, Jump, Return, JumpNotEqual, Signal, SetSignalMask,
+			Explode, PlaySound, Set, Attach, Drop,
+
+			// fused sequences
+			PushConstant2,   // push-constant, push-constant
+			BinOpConst,      // push-constant, binary operator <aux>
+			CmpJump,         // comparison <aux>, jump-not-equal
+			CmpConstJump,    // push-constant, comparison <aux>, jump-not-equal
+
+			Unknown,   // args[0] is the opcode
+			Truncated, // operands extend past the end of the code
+		};
+
+		static bool IsBinOp(uint8_t op) { return (op >= Add && op <= LogicalXor); }
+		static bool IsCmpOp(uint8_t op) { return (op >= SetLess && op <= SetNotEqual); }
+
+		Op op = Unknown;
+		uint8_t aux = 0;
+
+		/// offset of the instruction executed next unless this one jumps
+		int next = 0;
+		int args[3] = {0, 0, 0};
+	};
+
+	/// per-function counters, only updated while CCobEngine profiling is enabled
+	struct FunctionStats {
+		uint64_t numCalls = 0;
+		uint64_t numInstrs = 0; ///< dispatched (possibly fused) instructions
+		int64_t execTime = 0;   ///< nanoseconds, excluding called functions
+	};
+
 public:
 	int numStaticVars = 0;
 
 	std::vector<int> code;
+	std::vector<Instr> instrs;
 	std::vector<std::string> scriptNames;
 	std::vector<int> scriptOffsets;
 	/// Assumes that the scripts are sorted by offset in the file
@@ -52,6 +124,7 @@ public:
 	std::vector<int> sounds;
 	std::vector<LuaHashString> luaScripts;
 	spring::unordered_map<std::string, int> scriptMap;
+	std::vector<FunctionStats> functionStats;
 
 	std::string name;
 };
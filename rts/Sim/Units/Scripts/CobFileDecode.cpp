@@ -0,0 +1,289 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+
+#include "CobFile.h"
+
+
+// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
+// And some information from basm0.8 source (basm ops.txt)
+
+// Model interaction
+constexpr int MOVE       = 0x10001000;
+constexpr int TURN       = 0x10002000;
+constexpr int SPIN       = 0x10003000;
+constexpr int STOP_SPIN  = 0x10004000;
+constexpr int SHOW       = 0x10005000;
+constexpr int HIDE       = 0x10006000;
+constexpr int CACHE      = 0x10007000;
+constexpr int DONT_CACHE = 0x10008000;
+constexpr int MOVE_NOW   = 0x1000B000;
+constexpr int TURN_NOW   = 0x1000C000;
+constexpr int SHADE      = 0x1000D000;
+constexpr int DONT_SHADE = 0x1000E000;
+constexpr int EMIT_SFX   = 0x1000F000;
+
+// Blocking operations
+constexpr int WAIT_TURN  = 0x10011000;
+constexpr int WAIT_MOVE  = 0x10012000;
+constexpr int SLEEP      = 0x10013000;
+
+// Stack manipulation
+constexpr int PUSH_CONSTANT    = 0x10021001;
+constexpr int PUSH_LOCAL_VAR   = 0x10021002;
+constexpr int PUSH_STATIC      = 0x10021004;
+constexpr int CREATE_LOCAL_VAR = 0x10022000;
+constexpr int POP_LOCAL_VAR    = 0x10023002;
+constexpr int POP_STATIC       = 0x10023004;
+constexpr int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
+
+// Arithmetic operations
+constexpr int ADD         = 0x10031000;
+constexpr int SUB         = 0x10032000;
+constexpr int MUL         = 0x10033000;
+constexpr int DIV         = 0x10034000;
+constexpr int MOD		  = 0x10034001; ///< spring specific
+constexpr int BITWISE_AND = 0x10035000;
+constexpr int BITWISE_OR  = 0x10036000;
+constexpr int BITWISE_XOR = 0x10037000;
+constexpr int BITWISE_NOT = 0x10038000;
+
+// Native function calls
+constexpr int RAND           = 0x10041000;
+constexpr int GET_UNIT_VALUE = 0x10042000;
+constexpr int GET            = 0x10043000;
+
+// Comparison
+constexpr int SET_LESS             = 0x10051000;
+constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
+constexpr int SET_GREATER          = 0x10053000;
+constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
+constexpr int SET_EQUAL            = 0x10055000;
+constexpr int SET_NOT_EQUAL        = 0x10056000;
+constexpr int LOGICAL_AND          = 0x10057000;
+constexpr int LOGICAL_OR           = 0x10058000;
+constexpr int LOGICAL_XOR          = 0x10059000;
+constexpr int LOGICAL_NOT          = 0x1005A000;
+
+// Flow control
+constexpr int START           = 0x10061000;
+constexpr int CALL            = 0x10062000; ///< converted when executed
+constexpr int REAL_CALL       = 0x10062001; ///< spring custom
+constexpr int LUA_CALL        = 0x10062002; ///< spring custom
+constexpr int JUMP            = 0x10064000;
+constexpr int RETURN          = 0x10065000;
+constexpr int JUMP_NOT_EQUAL  = 0x10066000;
+constexpr int SIGNAL          = 0x10067000;
+constexpr int SET_SIGNAL_MASK = 0x10068000;
+
+// Piece destruction
+constexpr int EXPLODE    = 0x10071000;
+constexpr int PLAY_SOUND = 0x10072000;
+
+// Special functions
+constexpr int SET    = 0x10082000;
+constexpr int ATTACH = 0x10083000;
+constexpr int DROP   = 0x10084000;
+
+
+void CCobFile::DecodeCode()
+{
+	instrs.clear();
+	instrs.resize(code.size());
+
+	for (int pos = 0, size = code.size(); pos < size; pos++) {
+		Instr& instr = instrs[pos];
+
+		const int opcode = code[pos];
+
+		int numArgs = 0;
+		Instr::Op op = Instr::Unknown;
+
+		switch (opcode) {
+			case MOVE      : { op = Instr::Move    ; numArgs = 2; } break;
+			case TURN      : { op = Instr::Turn    ; numArgs = 2; } break;
+			case SPIN      : { op = Instr::Spin    ; numArgs = 2; } break;
+			case STOP_SPIN : { op = Instr::StopSpin; numArgs = 2; } break;
+			case SHOW      : { op = Instr::Show    ; numArgs = 1; } break;
+			case HIDE      : { op = Instr::Hide    ; numArgs = 1; } break;
+			case CACHE     : { op = Instr::Nop     ; numArgs = 1; } break;
+			case DONT_CACHE: { op = Instr::Nop     ; numArgs = 1; } break;
+			case MOVE_NOW  : { op = Instr::MoveNow ; numArgs = 2; } break;
+			case TURN_NOW  : { op = Instr::TurnNow ; numArgs = 2; } break;
+			case SHADE     : { op = Instr::Nop     ; numArgs = 1; } break;
+			case DONT_SHADE: { op = Instr::Nop     ; numArgs = 1; } break;
+			case EMIT_SFX  : { op = Instr::EmitSfx ; numArgs = 1; } break;
+
+			case WAIT_TURN: { op = Instr::WaitTurn; numArgs = 2; } break;
+			case WAIT_MOVE: { op = Instr::WaitMove; numArgs = 2; } break;
+			case SLEEP    : { op = Instr::Sleep   ; numArgs = 0; } break;
+
+			case PUSH_CONSTANT   : { op = Instr::PushConstant  ; numArgs = 1; } break;
+			case PUSH_LOCAL_VAR  : { op = Instr::PushLocalVar  ; numArgs = 1; } break;
+			case PUSH_STATIC     : { op = Instr::PushStatic    ; numArgs = 1; } break;
+			case CREATE_LOCAL_VAR: { op = Instr::CreateLocalVar; numArgs = 0; } break;
+			case POP_LOCAL_VAR   : { op = Instr::PopLocalVar   ; numArgs = 1; } break;
+			case POP_STATIC      : { op = Instr::PopStatic     ; numArgs = 1; } break;
+			case POP_STACK       : { op = Instr::PopStack      ; numArgs = 0; } break;
+
+			case ADD        : { op = Instr::Add   ; } break;
+			case SUB        : { op = Instr::Sub   ; } break;
+			case MUL        : { op = Instr::Mul   ; } break;
+			case DIV        : { op = Instr::Div   ; } break;
+			case MOD        : { op = Instr::Mod   ; } break;
+			case BITWISE_AND: { op = Instr::BitAnd; } break;
+			case BITWISE_OR : { op = Instr::BitOr ; } break;
+			case BITWISE_XOR: { op = Instr::BitXor; } break;
+			case BITWISE_NOT: { op = Instr::BitNot; } break;
+
+			case RAND          : { op = Instr::Rand        ; } break;
+			case GET_UNIT_VALUE: { op = Instr::GetUnitValue; } break;
+			case GET           : { op = Instr::Get         ; } break;
+
+			case SET_LESS            : { op = Instr::SetLess        ; } break;
+			case SET_LESS_OR_EQUAL   : { op = Instr::SetLessEqual   ; } break;
+			case SET_GREATER         : { op = Instr::SetGreater     ; } break;
+			case SET_GREATER_OR_EQUAL: { op = Instr::SetGreaterEqual; } break;
+			case SET_EQUAL           : { op = Instr::SetEqual       ; } break;
+			case SET_NOT_EQUAL       : { op = Instr::SetNotEqual    ; } break;
+			case LOGICAL_AND         : { op = Instr::LogicalAnd     ; } break;
+			case LOGICAL_OR          : { op = Instr::LogicalOr      ; } break;
+			case LOGICAL_XOR         : { op = Instr::LogicalXor     ; } break;
+			case LOGICAL_NOT         : { op = Instr::LogicalNot     ; } break;
+
+			case START          : { op = Instr::Start        ; numArgs = 2; } break;
+			case CALL           : { op = Instr::Call         ; numArgs = 2; } break;
+			case REAL_CALL      : { op = Instr::Call         ; numArgs = 2; } break;
+			case LUA_CALL       : { op = Instr::LuaCall      ; numArgs = 2; } break;
+			case JUMP           : { op = Instr::Jump         ; numArgs = 1; } break;
+			case RETURN         : { op = Instr::Return       ; numArgs = 0; } break;
+			case JUMP_NOT_EQUAL : { op = Instr::JumpNotEqual ; numArgs = 1; } break;
+			case SIGNAL         : { op = Instr::Signal       ; numArgs = 0; } break;
+			case SET_SIGNAL_MASK: { op = Instr::SetSignalMask; numArgs = 0; } break;
+
+			case EXPLODE   : { op = Instr::Explode  ; numArgs = 1; } break;
+			case PLAY_SOUND: { op = Instr::PlaySound; numArgs = 1; } break;
+
+			case SET   : { op = Instr::Set   ; } break;
+			case ATTACH: { op = Instr::Attach; } break;
+			case DROP  : { op = Instr::Drop  ; } break;
+
+			default: {
+				instr.op = Instr::Unknown;
+				instr.next = pos + 1;
+				instr.args[0] = opcode;
+				continue;
+			} break;
+		}
+
+		if ((pos + 1 + numArgs) > size) {
+			instr.op = Instr::Truncated;
+			instr.next = size;
+			continue;
+		}
+
+		instr.op = op;
+		instr.next = pos + 1 + numArgs;
+
+		for (int i = 0; i < numArgs; i++) {
+			instr.args[i] = code[pos + 1 + i];
+		}
+
+		// resolve function calls; an invalid function index is treated
+		// like an unknown opcode rather than read out of bounds
+		switch (op) {
+			case Instr::Call: {
+				const int funcID = instr.args[0];
+
+				if (static_cast<size_t>(funcID) >= scriptNames.size()) {
+					instr.op = Instr::Unknown;
+					instr.next = pos + 1;
+					instr.args[0] = opcode;
+					break;
+				}
+
+				if (opcode == CALL && scriptNames[funcID].find("lua_") == 0) {
+					instr.op = Instr::LuaCall;
+					break;
+				}
+
+				// do not call zero-length functions
+				if (scriptLengths[funcID] == 0) {
+					instr.op = Instr::Nop;
+					break;
+				}
+
+				instr.args[2] = scriptOffsets[funcID];
+			} break;
+			case Instr::Start: {
+				const int funcID = instr.args[0];
+
+				if (static_cast<size_t>(funcID) >= scriptNames.size()) {
+					instr.op = Instr::Unknown;
+					instr.next = pos + 1;
+					instr.args[0] = opcode;
+					break;
+				}
+
+				if (scriptLengths[funcID] == 0)
+					instr.op = Instr::Nop;
+
+			} break;
+			default: {
+			} break;
+		}
+	}
+}
+
+void CCobFile::FuseInstrs()
+{
+	// each fused instruction replaces only the entry of the first one in its
+	// sequence, jumps into the middle of a sequence still find the original
+	// instructions
+	for (int pos = 0, size = instrs.size(); pos < size; pos++) {
+		Instr& instr = instrs[pos];
+
+		if (instr.op != Instr::PushConstant && !Instr::IsCmpOp(instr.op))
+			continue;
+
+		const int pos1 = instr.next;
+		const int pos2 = (pos1 < size)? instrs[pos1].next: size;
+
+		if (pos1 >= size)
+			continue;
+
+		const Instr& instr1 = instrs[pos1];
+
+		if (instr.op != Instr::PushConstant) {
+			if (instr1.op != Instr::JumpNotEqual)
+				continue;
+
+			instr.aux = instr.op;
+			instr.op = Instr::CmpJump;
+			instr.next = instr1.next;
+			instr.args[0] = instr1.args[0];
+			continue;
+		}
+
+		if (Instr::IsCmpOp(instr1.op) && pos2 < size && instrs[pos2].op == Instr::JumpNotEqual) {
+			instr.aux = instr1.op;
+			instr.op = Instr::CmpConstJump;
+			instr.next = instrs[pos2].next;
+			instr.args[1] = instrs[pos2].args[0];
+			continue;
+		}
+
+		if (Instr::IsBinOp(instr1.op)) {
+			instr.aux = instr1.op;
+			instr.op = Instr::BinOpConst;
+			instr.next = instr1.next;
+			continue;
+		}
+
+		if (instr1.op == Instr::PushConstant) {
+			instr.op = Instr::PushConstant2;
+			instr.next = instr1.next;
+			instr.args[1] = instr1.args[0];
+			continue;
+		}
+	}
+}
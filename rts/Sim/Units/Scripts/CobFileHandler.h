@@ -22,6 +22,9 @@ public:
 	CCobFile* ReloadCobFile(const std::string& name);
 	const CCobFile* GetScriptFile(const std::string& name) const;
 
+	const std::deque<CCobFile>& GetCobFiles() const { return cobFileObjects; }
+	      std::deque<CCobFile>& GetCobFiles()       { return cobFileObjects; }
+
 private:
 	spring::unordered_map<std::string, size_t> cobFileHandles;
 	std::deque<CCobFile> cobFileObjects;
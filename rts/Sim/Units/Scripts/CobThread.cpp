@@ -7,7 +7,9 @@
 #include "CobEngine.h"
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "System/Misc/SpringTime.h"
 
+#include <stdexcept>
 #include <tracy/Tracy.hpp>
 
 CR_BIND(CCobThread, )
@@ -155,6 +157,9 @@ void CCobThread::Start(int functionId, int sigMask, const std::array<int, 1 + MA
 	ci.returnAddr = -1;
 	ci.stackTop   = 0;
 
+	if (cobEngine->IsProfiling())
+		cobFile->functionStats[functionId].numCalls++;
+
 	// copy arguments; args[0] holds the count
 	// handled by InitStack if thread has a parent that STARTs it,
 	// in which case args[0] is 0 and stack already contains data
@@ -220,86 +225,6 @@ void CCobThread::InitStack(unsigned int n, CCobThread* t)
 
 
 
-// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
-// And some information from basm0.8 source (basm ops.txt)
-
-// Model interaction
-constexpr int MOVE       = 0x10001000;
-constexpr int TURN       = 0x10002000;
-constexpr int SPIN       = 0x10003000;
-constexpr int STOP_SPIN  = 0x10004000;
-constexpr int SHOW       = 0x10005000;
-constexpr int HIDE       = 0x10006000;
-constexpr int CACHE      = 0x10007000;
-constexpr int DONT_CACHE = 0x10008000;
-constexpr int MOVE_NOW   = 0x1000B000;
-constexpr int TURN_NOW   = 0x1000C000;
-constexpr int SHADE      = 0x1000D000;
-constexpr int DONT_SHADE = 0x1000E000;
-constexpr int EMIT_SFX   = 0x1000F000;
-
-// Blocking operations
-constexpr int WAIT_TURN  = 0x10011000;
-constexpr int WAIT_MOVE  = 0x10012000;
-constexpr int SLEEP      = 0x10013000;
-
-// Stack manipulation
-constexpr int PUSH_CONSTANT    = 0x10021001;
-constexpr int PUSH_LOCAL_VAR   = 0x10021002;
-constexpr int PUSH_STATIC      = 0x10021004;
-constexpr int CREATE_LOCAL_VAR = 0x10022000;
-constexpr int POP_LOCAL_VAR    = 0x10023002;
-constexpr int POP_STATIC       = 0x10023004;
-constexpr int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
-
-// Arithmetic operations
-constexpr int ADD         = 0x10031000;
-constexpr int SUB         = 0x10032000;
-constexpr int MUL         = 0x10033000;
-constexpr int DIV         = 0x10034000;
-constexpr int MOD		  = 0x10034001; ///< spring specific
-constexpr int BITWISE_AND = 0x10035000;
-constexpr int BITWISE_OR  = 0x10036000;
-constexpr int BITWISE_XOR = 0x10037000;
-constexpr int BITWISE_NOT = 0x10038000;
-
-// Native function calls
-constexpr int RAND           = 0x10041000;
-constexpr int GET_UNIT_VALUE = 0x10042000;
-constexpr int GET            = 0x10043000;
-
-// Comparison
-constexpr int SET_LESS             = 0x10051000;
-constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
-constexpr int SET_GREATER          = 0x10053000;
-constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
-constexpr int SET_EQUAL            = 0x10055000;
-constexpr int SET_NOT_EQUAL        = 0x10056000;
-constexpr int LOGICAL_AND          = 0x10057000;
-constexpr int LOGICAL_OR           = 0x10058000;
-constexpr int LOGICAL_XOR          = 0x10059000;
-constexpr int LOGICAL_NOT          = 0x1005A000;
-
-// Flow control
-constexpr int START           = 0x10061000;
-constexpr int CALL            = 0x10062000; ///< converted when executed
-constexpr int REAL_CALL       = 0x10062001; ///< spring custom
-constexpr int LUA_CALL        = 0x10062002; ///< spring custom
-constexpr int JUMP            = 0x10064000;
-constexpr int RETURN          = 0x10065000;
-constexpr int JUMP_NOT_EQUAL  = 0x10066000;
-constexpr int SIGNAL          = 0x10067000;
-constexpr int SET_SIGNAL_MASK = 0x10068000;
-
-// Piece destruction
-constexpr int EXPLODE    = 0x10071000;
-constexpr int PLAY_SOUND = 0x10072000;
-
-// Special functions
-constexpr int SET    = 0x10082000;
-constexpr int ATTACH = 0x10083000;
-constexpr int DROP   = 0x10084000;
-
 // Indices for SET, GET, and GET_UNIT_VALUE for LUA return values
 #define LUA0 110 // (LUA0 returns the lua call status, 0 or 1)
 #define LUA1 111
@@ -312,90 +237,32 @@ constexpr int DROP   = 0x10084000;
 #define LUA8 118
 #define LUA9 119
 
-#if 0
-#define GET_LONG_PC() (cobFile->code[pc++])
-#else
-// mantis #5981
-#define GET_LONG_PC() (cobFile->code.at(pc++))
-#endif
+using Instr = CCobFile::Instr;
 
-
-#if 0
-static const char* GetOpcodeName(int opcode)
+// <a> was pushed before <b>, i.e. <b> is popped first
+static inline int EvalBinOp(uint8_t op, int a, int b)
 {
-	switch (opcode) {
-		case MOVE: return "move";
-		case TURN: return "turn";
-		case SPIN: return "spin";
-		case STOP_SPIN: return "stop-spin";
-		case SHOW: return "show";
-		case HIDE: return "hide";
-		case CACHE: return "cache";
-		case DONT_CACHE: return "dont-cache";
-		case TURN_NOW: return "turn-now";
-		case MOVE_NOW: return "move-now";
-		case SHADE: return "shade";
-		case DONT_SHADE: return "dont-shade";
-		case EMIT_SFX: return "sfx";
-
-		case WAIT_TURN: return "wait-for-turn";
-		case WAIT_MOVE: return "wait-for-move";
-		case SLEEP: return "sleep";
-
-		case PUSH_CONSTANT: return "pushc";
-		case PUSH_LOCAL_VAR: return "pushl";
-		case PUSH_STATIC: return "pushs";
-		case CREATE_LOCAL_VAR: return "clv";
-		case POP_LOCAL_VAR: return "popl";
-		case POP_STATIC: return "pops";
-		case POP_STACK: return "pop-stack";
-
-		case ADD: return "add";
-		case SUB: return "sub";
-		case MUL: return "mul";
-		case DIV: return "div";
-		case MOD: return "mod";
-		case BITWISE_AND: return "and";
-		case BITWISE_OR: return "or";
-		case BITWISE_XOR: return "xor";
-		case BITWISE_NOT: return "not";
-
-		case RAND: return "rand";
-		case GET_UNIT_VALUE: return "getuv";
-		case GET: return "get";
-
-		case SET_LESS: return "setl";
-		case SET_LESS_OR_EQUAL: return "setle";
-		case SET_GREATER: return "setg";
-		case SET_GREATER_OR_EQUAL: return "setge";
-		case SET_EQUAL: return "sete";
-		case SET_NOT_EQUAL: return "setne";
-		case LOGICAL_AND: return "land";
-		case LOGICAL_OR: return "lor";
-		case LOGICAL_XOR: return "lxor";
-		case LOGICAL_NOT: return "neg";
-
-		case START: return "start";
-		case CALL: return "call";
-		case REAL_CALL: return "call";
-		case LUA_CALL: return "lua_call";
-		case JUMP: return "jmp";
-		case RETURN: return "return";
-		case JUMP_NOT_EQUAL: return "jne";
-		case SIGNAL: return "signal";
-		case SET_SIGNAL_MASK: return "mask";
-
-		case EXPLODE: return "explode";
-		case PLAY_SOUND: return "play-sound";
-
-		case SET: return "set";
-		case ATTACH: return "attach";
-		case DROP: return "drop";
+	switch (op) {
+		case Instr::Add            : return (a + b);
+		case Instr::Sub            : return (a - b);
+		case Instr::Mul            : return (b * a);
+		case Instr::BitAnd         : return (b & a);
+		case Instr::BitOr          : return (b | a);
+		case Instr::BitXor         : return (b ^ a);
+		case Instr::SetLess        : return int(a <  b);
+		case Instr::SetLessEqual   : return int(a <= b);
+		case Instr::SetGreater     : return int(a >  b);
+		case Instr::SetGreaterEqual: return int(a >= b);
+		case Instr::SetEqual       : return int(b == a);
+		case Instr::SetNotEqual    : return int(b != a);
+		case Instr::LogicalAnd     : return int(b && a);
+		case Instr::LogicalOr      : return int(b || a);
+		case Instr::LogicalXor     : return int((!!b) ^ (!!a));
+		default                    : { assert(false); } break;
 	}
 
-	return "unknown";
+	return 0;
 }
-#endif
 
 
 bool CCobThread::Tick()
@@ -410,39 +277,80 @@ bool CCobThread::Tick()
 
 	state = Run;
 
+	if (cobEngine->IsProfiling())
+		return (Execute<true>());
+
+	return (Execute<false>());
+}
+
+template<bool profile>
+bool CCobThread::Execute()
+{
+	// cobFile is cleared if this thread gets stopped during execution
+	CCobFile* file = cobFile;
+
+	const std::vector<Instr>& instrs = file->instrs;
+
+	// time and instructions are attributed to the innermost function
+	int profFuncID = LocalFunctionID();
+	uint64_t profInstrs = 0;
+	spring_time profTime;
+
+	const auto FlushProfile = [&](int nextFuncID) {
+		if (!profile)
+			return;
+
+		const spring_time t = spring_gettime();
+
+		CCobFile::FunctionStats& stats = file->functionStats[profFuncID];
+		stats.numInstrs += profInstrs;
+		stats.execTime += (t - profTime).toNanoSecsi();
+
+		profFuncID = nextFuncID;
+		profInstrs = 0;
+		profTime = t;
+	};
+
+	if (profile)
+		profTime = spring_gettime();
+
 	int r1, r2, r3, r4, r5, r6;
 
 	while (state == Run) {
-		const int opcode = GET_LONG_PC();
+		// mantis #5981
+		const Instr& instr = instrs.at(pc);
 
-		switch (opcode) {
-			case PUSH_CONSTANT: {
-				r1 = GET_LONG_PC();
-				PushDataStack(r1);
+		pc = instr.next;
+		profInstrs += profile;
+
+		switch (instr.op) {
+			case Instr::PushConstant: {
+				PushDataStack(instr.args[0]);
+			} break;
+			case Instr::PushConstant2: {
+				PushDataStack(instr.args[0]);
+				PushDataStack(instr.args[1]);
 			} break;
-			case SLEEP: {
+			case Instr::Sleep: {
 				r1 = PopDataStack();
 				wakeTime = cobEngine->GetCurrentTime() + r1;
 				state = Sleep;
 
+				FlushProfile(-1);
 				cobEngine->ScheduleThread(this);
 				return true;
 			} break;
-			case SPIN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case Instr::Spin: {
 				r3 = PopDataStack();         // speed
 				r4 = PopDataStack();         // accel
-				cobInst->Spin(r1, r2, r3, r4);
+				cobInst->Spin(instr.args[0], instr.args[1], r3, r4);
 			} break;
-			case STOP_SPIN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case Instr::StopSpin: {
 				r3 = PopDataStack();         // decel
 
-				cobInst->StopSpin(r1, r2, r3);
+				cobInst->StopSpin(instr.args[0], instr.args[1], r3);
 			} break;
-			case RETURN: {
+			case Instr::Return: {
 				retCode = PopDataStack();
 
 				if (LocalReturnAddr() == -1) {
@@ -450,6 +358,7 @@ bool CCobThread::Tick()
 
 					// leave values intact on stack in case caller wants to check them
 					// callStackSize -= 1;
+					FlushProfile(-1);
 					return false;
 				}
 
@@ -459,98 +368,67 @@ bool CCobThread::Tick()
 					dataStack.resize(LocalStackFrame());
 
 				callStack.pop_back();
-			} break;
 
-
-			case SHADE: {
-				r1 = GET_LONG_PC();
-			} break;
-			case DONT_SHADE: {
-				r1 = GET_LONG_PC();
-			} break;
-			case CACHE: {
-				r1 = GET_LONG_PC();
+				FlushProfile(LocalFunctionID());
 			} break;
-			case DONT_CACHE: {
-				r1 = GET_LONG_PC();
-			} break;
-
 
-			case CALL: {
-				r1 = GET_LONG_PC();
-				pc--;
 
-				if (cobFile->scriptNames[r1].find("lua_") == 0) {
-					cobFile->code[pc - 1] = LUA_CALL;
-					LuaCall();
-					break;
-				}
+			case Instr::Nop: {
+			} break;
 
-				cobFile->code[pc - 1] = REAL_CALL;
 
-				// fall-through
-			}
-			case REAL_CALL: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case Instr::Call: {
+				FlushProfile(instr.args[0]);
 
-				// do not call zero-length functions
-				if (cobFile->scriptLengths[r1] == 0)
-					break;
+				if (profile)
+					file->functionStats[instr.args[0]].numCalls++;
 
 				CallInfo& ci = PushCallStackRef();
-				ci.functionId = r1;
+				ci.functionId = instr.args[0];
 				ci.returnAddr = pc;
-				ci.stackTop = dataStack.size() - r2;
+				ci.stackTop = dataStack.size() - instr.args[1];
 
-				paramCount = r2;
+				paramCount = instr.args[1];
 
 				// call cobFile->scriptNames[r1]
-				pc = cobFile->scriptOffsets[r1];
+				pc = instr.args[2];
 			} break;
-			case LUA_CALL: {
-				LuaCall();
+			case Instr::LuaCall: {
+				LuaCall(instr.args[0], instr.args[1]);
 			} break;
 
 
-			case POP_STATIC: {
-				r1 = GET_LONG_PC();
+			case Instr::PopStatic: {
+				r1 = instr.args[0];
 				r2 = PopDataStack();
 
 				if (static_cast<size_t>(r1) < cobInst->staticVars.size())
 					cobInst->staticVars[r1] = r2;
 			} break;
-			case POP_STACK: {
+			case Instr::PopStack: {
 				PopDataStack();
 			} break;
 
 
-			case START: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-
-				if (cobFile->scriptLengths[r1] == 0)
-					break;
-
-
+			case Instr::Start: {
 				CCobThread t(cobInst);
 
 				t.SetID(cobEngine->GenThreadID());
-				t.InitStack(r2, this);
-				t.Start(r1, signalMask, {{0}}, true);
+				t.InitStack(instr.args[1], this);
+				t.Start(instr.args[0], signalMask, {{0}}, true);
 
 				// calling AddThread directly might move <this>, defer it
 				cobEngine->QueueAddThread(std::move(t));
 			} break;
 
-			case CREATE_LOCAL_VAR: {
+			case Instr::CreateLocalVar: {
 				if (paramCount == 0) {
 					PushDataStack(0);
 				} else {
 					paramCount--;
 				}
 			} break;
-			case GET_UNIT_VALUE: {
+			case Instr::GetUnitValue: {
 				r1 = PopDataStack();
 				if ((r1 >= LUA0) && (r1 <= LUA9)) {
 					PushDataStack(luaArgs[r1 - LUA0]);
@@ -561,149 +439,120 @@ bool CCobThread::Tick()
 			} break;
 
 
-			case JUMP_NOT_EQUAL: {
-				r1 = GET_LONG_PC();
+			case Instr::JumpNotEqual: {
 				r2 = PopDataStack();
 
 				if (r2 == 0)
-					pc = r1;
+					pc = instr.args[0];
 
 			} break;
-			case JUMP: {
-				r1 = GET_LONG_PC();
+			case Instr::Jump: {
 				// this seem to be an error in the docs..
 				//r2 = cobFile->scriptOffsets[LocalFunctionID()] + r1;
-				pc = r1;
+				pc = instr.args[0];
 			} break;
+			case Instr::CmpJump: {
+				r2 = PopDataStack();
+				r1 = PopDataStack();
+
+				if (EvalBinOp(instr.aux, r1, r2) == 0)
+					pc = instr.args[0];
+
+			} break;
+			case Instr::CmpConstJump: {
+				r1 = PopDataStack();
 
+				if (EvalBinOp(instr.aux, r1, instr.args[0]) == 0)
+					pc = instr.args[1];
 
-			case POP_LOCAL_VAR: {
-				r1 = GET_LONG_PC();
+			} break;
+
+
+			case Instr::PopLocalVar: {
 				r2 = PopDataStack();
-				dataStack[LocalStackFrame() + r1] = r2;
+				dataStack[LocalStackFrame() + instr.args[0]] = r2;
 			} break;
-			case PUSH_LOCAL_VAR: {
-				r1 = GET_LONG_PC();
-				r2 = dataStack[LocalStackFrame() + r1];
+			case Instr::PushLocalVar: {
+				r2 = dataStack[LocalStackFrame() + instr.args[0]];
 				PushDataStack(r2);
 			} break;
 
 
-			case BITWISE_AND: {
-				r1 = PopDataStack();
+			case Instr::Add:
+			case Instr::Sub:
+			case Instr::Mul:
+			case Instr::BitAnd:
+			case Instr::BitOr:
+			case Instr::BitXor:
+			case Instr::SetLess:
+			case Instr::SetLessEqual:
+			case Instr::SetGreater:
+			case Instr::SetGreaterEqual:
+			case Instr::SetEqual:
+			case Instr::SetNotEqual:
+			case Instr::LogicalAnd:
+			case Instr::LogicalOr:
+			case Instr::LogicalXor: {
 				r2 = PopDataStack();
-				PushDataStack(r1 & r2);
-			} break;
-			case BITWISE_OR: {
 				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(r1 | r2);
+				PushDataStack(EvalBinOp(instr.op, r1, r2));
 			} break;
-			case BITWISE_XOR: {
+			case Instr::BinOpConst: {
 				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(r1 ^ r2);
+				PushDataStack(EvalBinOp(instr.aux, r1, instr.args[0]));
 			} break;
-			case BITWISE_NOT: {
+
+			case Instr::BitNot: {
 				r1 = PopDataStack();
 				PushDataStack(~r1);
 			} break;
 
-			case EXPLODE: {
-				r1 = GET_LONG_PC();
+			case Instr::Explode: {
 				r2 = PopDataStack();
-				cobInst->Explode(r1, r2);
+				cobInst->Explode(instr.args[0], r2);
 			} break;
 
-			case PLAY_SOUND: {
-				r1 = GET_LONG_PC();
+			case Instr::PlaySound: {
 				r2 = PopDataStack();
-				cobInst->PlayUnitSound(r1, r2);
+				cobInst->PlayUnitSound(instr.args[0], r2);
 			} break;
 
-			case PUSH_STATIC: {
-				r1 = GET_LONG_PC();
+			case Instr::PushStatic: {
+				r1 = instr.args[0];
 
 				if (static_cast<size_t>(r1) < cobInst->staticVars.size())
 					PushDataStack(cobInst->staticVars[r1]);
 			} break;
 
-			case SET_NOT_EQUAL: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-
-				PushDataStack(int(r1 != r2));
-			} break;
-			case SET_EQUAL: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-
-				PushDataStack(int(r1 == r2));
-			} break;
-
-			case SET_LESS: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				PushDataStack(int(r1 < r2));
-			} break;
-			case SET_LESS_OR_EQUAL: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				PushDataStack(int(r1 <= r2));
-			} break;
-
-			case SET_GREATER: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				PushDataStack(int(r1 > r2));
-			} break;
-			case SET_GREATER_OR_EQUAL: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				PushDataStack(int(r1 >= r2));
-			} break;
-
-			case RAND: {
+			case Instr::Rand: {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 				r3 = gsRNG.NextInt(r2 - r1 + 1) + r1;
 				PushDataStack(r3);
 			} break;
-			case EMIT_SFX: {
-				r1 = PopDataStack();
-				r2 = GET_LONG_PC();
-				cobInst->EmitSfx(r1, r2);
-			} break;
-			case MUL: {
+			case Instr::EmitSfx: {
 				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(r1 * r2);
+				cobInst->EmitSfx(r1, instr.args[0]);
 			} break;
 
 
-			case SIGNAL: {
+			case Instr::Signal: {
 				r1 = PopDataStack();
 				cobInst->Signal(r1);
 			} break;
-			case SET_SIGNAL_MASK: {
+			case Instr::SetSignalMask: {
 				r1 = PopDataStack();
 				signalMask = r1;
 			} break;
 
 
-			case TURN: {
+			case Instr::Turn: {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
-				r3 = GET_LONG_PC(); // piece
-				r4 = GET_LONG_PC(); // axis
 
-				cobInst->Turn(r3, r4, r1, r2);
+				cobInst->Turn(instr.args[0], instr.args[1], r1, r2);
 			} break;
-			case GET: {
+			case Instr::Get: {
 				r5 = PopDataStack();
 				r4 = PopDataStack();
 				r3 = PopDataStack();
@@ -716,19 +565,8 @@ bool CCobThread::Tick()
 				r6 = cobInst->GetUnitVal(r1, r2, r3, r4, r5);
 				PushDataStack(r6);
 			} break;
-			case ADD: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-				PushDataStack(r1 + r2);
-			} break;
-			case SUB: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-				r3 = r1 - r2;
-				PushDataStack(r3);
-			} break;
 
-			case DIV: {
+			case Instr::Div: {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
@@ -740,7 +578,7 @@ bool CCobThread::Tick()
 				}
 				PushDataStack(r3);
 			} break;
-			case MOD: {
+			case Instr::Mod: {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
@@ -753,52 +591,50 @@ bool CCobThread::Tick()
 			} break;
 
 
-			case MOVE: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case Instr::Move: {
 				r4 = PopDataStack();
 				r3 = PopDataStack();
-				cobInst->Move(r1, r2, r3, r4);
+				cobInst->Move(instr.args[0], instr.args[1], r3, r4);
 			} break;
-			case MOVE_NOW: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case Instr::MoveNow: {
 				r3 = PopDataStack();
-				cobInst->MoveNow(r1, r2, r3);
+				cobInst->MoveNow(instr.args[0], instr.args[1], r3);
 			} break;
-			case TURN_NOW: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case Instr::TurnNow: {
 				r3 = PopDataStack();
-				cobInst->TurnNow(r1, r2, r3);
+				cobInst->TurnNow(instr.args[0], instr.args[1], r3);
 			} break;
 
 
-			case WAIT_TURN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case Instr::WaitTurn: {
+				r1 = instr.args[0];
+				r2 = instr.args[1];
 
 				if (cobInst->NeedsWait(CCobInstance::ATurn, r1, r2)) {
 					state = WaitTurn;
 					waitPiece = r1;
 					waitAxis = r2;
+
+					FlushProfile(-1);
 					return true;
 				}
 			} break;
-			case WAIT_MOVE: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case Instr::WaitMove: {
+				r1 = instr.args[0];
+				r2 = instr.args[1];
 
 				if (cobInst->NeedsWait(CCobInstance::AMove, r1, r2)) {
 					state = WaitMove;
 					waitPiece = r1;
 					waitAxis = r2;
+
+					FlushProfile(-1);
 					return true;
 				}
 			} break;
 
 
-			case SET: {
+			case Instr::Set: {
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 
@@ -811,50 +647,34 @@ bool CCobThread::Tick()
 			} break;
 
 
-			case ATTACH: {
+			case Instr::Attach: {
 				r3 = PopDataStack();
 				r2 = PopDataStack();
 				r1 = PopDataStack();
 				cobInst->AttachUnit(r2, r1);
 			} break;
-			case DROP: {
+			case Instr::Drop: {
 				r1 = PopDataStack();
 				cobInst->DropUnit(r1);
 			} break;
 
 			// like bitwise ops, but only on values 1 and 0
-			case LOGICAL_NOT: {
+			case Instr::LogicalNot: {
 				r1 = PopDataStack();
 				PushDataStack(int(r1 == 0));
 			} break;
-			case LOGICAL_AND: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(int(r1 && r2));
-			} break;
-			case LOGICAL_OR: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(int(r1 || r2));
-			} break;
-			case LOGICAL_XOR: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(int((!!r1) ^ (!!r2)));
-			} break;
 
 
-			case HIDE: {
-				r1 = GET_LONG_PC();
-				cobInst->SetVisibility(r1, false);
+			case Instr::Hide: {
+				cobInst->SetVisibility(instr.args[0], false);
 			} break;
 
-			case SHOW: {
-				r1 = GET_LONG_PC();
+			case Instr::Show: {
+				r1 = instr.args[0];
 
 				int i;
 				for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
-					if (LocalFunctionID() == cobFile->scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
+					if (LocalFunctionID() == file->scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
 						break;
 
 				// if true, we are in a Fire-script and should show a special flare effect
@@ -865,26 +685,27 @@ bool CCobThread::Tick()
 				}
 			} break;
 
-			default: {
-				const char* name = cobFile->name.c_str();
-				const char* func = cobFile->scriptNames[LocalFunctionID()].c_str();
+			case Instr::Truncated: {
+				FlushProfile(-1);
+				throw std::out_of_range("[COBThread::Tick] instruction operands past end of code");
+			} break;
 
-				LOG_L(L_ERROR, "[COBThread::%s] unknown opcode %x (in %s:%s at %x)", __func__, opcode, name, func, pc - 1);
+			default: {
+				const char* name = file->name.c_str();
+				const char* func = file->scriptNames[LocalFunctionID()].c_str();
 
-				#if 0
-				auto ei = execTrace.begin();
-				while (ei != execTrace.end()) {
-					LOG_L(L_ERROR, "\tprogctr: %3x  opcode: %s", __func__, *ei, GetOpcodeName(cobFile->code[*ei]));
-					++ei;
-				}
-				#endif
+				LOG_L(L_ERROR, "[COBThread::%s] unknown opcode %x (in %s:%s at %x)", __func__, instr.args[0], name, func, pc - 1);
 
 				state = Dead;
+
+				FlushProfile(-1);
 				return false;
 			} break;
 		}
 	}
 
+	FlushProfile(-1);
+
 	// can arrive here as dead, through CCobInstance::Signal()
 	return (state != Dead);
 }
@@ -906,10 +727,9 @@ void CCobThread::ShowError(const char* msg)
 }
 
 
-void CCobThread::LuaCall()
+void CCobThread::LuaCall(int r1, int r2)
 {
-	const int r1 = GET_LONG_PC(); // script id
-	const int r2 = GET_LONG_PC(); // arg count
+	// r1: script id, r2: arg count
 
 	// setup the parameter array
 	const int size = static_cast<int>(dataStack.size());
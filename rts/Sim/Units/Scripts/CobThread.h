@@ -105,7 +105,10 @@ protected:
 		int stackTop = -1;
 	};
 
-	void LuaCall();
+	/// runs until the thread blocks or dies, profile is CCobEngine::IsProfiling
+	template<bool profile> bool Execute();
+
+	void LuaCall(int scriptID, int argCount);
 
 	void PushCallStack(CallInfo v) { callStack.push_back(v); }
 	void PushDataStack(int v) { dataStack.push_back(v); }
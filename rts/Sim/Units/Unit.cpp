@@ -1048,6 +1048,20 @@ void CUnit::SlowUpdate()
 }
 
 
+void CUnit::PreSlowUpdate()
+{
+	// runs before any unit of the SlowUpdate batch was updated, so this
+	// sees the same state regardless of how the batch is split up
+	havePreCloakEnemy = wantCloak;
+	preCloakEnemy = nullptr;
+
+	if (!havePreCloakEnemy)
+		return;
+
+	preCloakEnemy = CGameHelper::GetClosestEnemyUnitNoLosTest(this, midPos, decloakDistance, allyteam, unitDef->decloakSpherical, modInfo.decloakRequiresLineOfSight);
+}
+
+
 void CUnit::SlowUpdateWeapons()
 {
 	ZoneScoped;
@@ -2417,8 +2431,14 @@ bool CUnit::GetNewCloakState(bool stunCheck) {
 	// a nullptr s.t. Lua can deduce the context
 	const CUnit* closestEnemy = this;
 
-	if (!stunCheck)
-		closestEnemy = CGameHelper::GetClosestEnemyUnitNoLosTest(this, midPos, decloakDistance, allyteam, unitDef->decloakSpherical, modInfo.decloakRequiresLineOfSight);
+	if (!stunCheck) {
+		// the precomputed enemy might have been killed since, search again
+		if (havePreCloakEnemy && (preCloakEnemy == nullptr || !preCloakEnemy->isDead)) {
+			closestEnemy = preCloakEnemy;
+		} else {
+			closestEnemy = CGameHelper::GetClosestEnemyUnitNoLosTest(this, midPos, decloakDistance, allyteam, unitDef->decloakSpherical, modInfo.decloakRequiresLineOfSight);
+		}
+	}
 
 	return (eventHandler.AllowUnitCloak(this, closestEnemy));
 }
@@ -2438,6 +2458,9 @@ void CUnit::SlowUpdateCloak(bool stunCheck)
 	}
 
 	isCloaked = newCloak;
+
+	havePreCloakEnemy = false;
+	preCloakEnemy = nullptr;
 }
 
 
@@ -2938,6 +2961,8 @@ CR_REG_METADATA(CUnit, (
 
 	CR_MEMBER(wantCloak),
 	CR_MEMBER(isCloaked),
+	CR_IGNORED(preCloakEnemy),
+	CR_IGNORED(havePreCloakEnemy),
 	CR_MEMBER(decloakDistance),
 
 	CR_MEMBER(lastTerrainType),
@@ -84,6 +84,8 @@ public:
 
 	virtual void Update();
 	virtual void SlowUpdate();
+	/// read-only part of SlowUpdate, may run for different units concurrently
+	void PreSlowUpdate();
 
 	const SolidObjectDef* GetDef() const { return ((const SolidObjectDef*) unitDef); }
 
@@ -553,6 +555,11 @@ public:
 	// true if the unit currently wants to be cloaked
 	bool wantCloak = false;
 
+	// closest enemy within decloakDistance as found by PreSlowUpdate,
+	// consumed by the next SlowUpdateCloak
+	const CUnit* preCloakEnemy = nullptr;
+	bool havePreCloakEnemy = false;
+
 
 	// unsynced vars
 	bool noMinimap = false;
@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <cassert>
 
 #include "UnitHandler.h"
@@ -11,6 +12,7 @@
 #include "UnitTypes/Factory.h"
 
 #include "CommandAI/BuilderCAI.h"
+#include "Game/GameHelper.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
@@ -106,6 +108,10 @@ void CUnitHandler::Init() {
 		units.resize(maxUnits, nullptr);
 		activeUnits.reserve(maxUnits);
 
+		unitKinematics.Init(maxUnits);
+		unitCollisionPairs.Init(maxUnits);
+		unitNeighbourCache.Init(maxUnits);
+
 		unitMemPool.reserve(128);
 
 		// id's are used as indices, so they must lie in [0, units.size() - 1]
@@ -145,6 +151,10 @@ void CUnitHandler::Kill()
 		activeUnits.clear();
 		unitsToBeRemoved.clear();
 
+		unitKinematics.Kill();
+		unitCollisionPairs.Kill();
+		unitNeighbourCache.Kill();
+
 		// only iterated by unsynced code, GetBuilderCAIs has no synced callers
 		builderCAIs.clear();
 	}
@@ -319,6 +329,11 @@ void CUnitHandler::UpdateUnitMoveTypes()
 			moveType->UpdatePreCollisions();
 		}
 	} else {
+		{
+		SCOPED_TIMER("Sim::Unit::MoveType::0::NeighbourCacheMT");
+		unitNeighbourCache.Update(activeUnits);
+		}
+
 		{
 		SCOPED_TIMER("Sim::Unit::MoveType::1::UpdatePreCollisionsMT");
 		for_mt(0, activeUnits.size(), [this](const int i){
@@ -344,7 +359,15 @@ void CUnitHandler::UpdateUnitMoveTypes()
 		}
 	}
 
+	// positions are final until ::Update, mirror them for collision detection
+	UpdateUnitKinematics();
+	unitNeighbourCache.UpdateDisplacements(activeUnits);
+
 	if (modInfo.forceCollisionsSingleThreaded) {
+		{
+		SCOPED_TIMER("Sim::Unit::MoveType::3::CollisionPairsST");
+		unitCollisionPairs.Update(activeUnits, false);
+		}
 		{
 		SCOPED_TIMER("Sim::Unit::MoveType::3::CollisionDetectionST");
 		for (int i = 0; i < activeUnits.size(); ++i) {
@@ -355,6 +378,10 @@ void CUnitHandler::UpdateUnitMoveTypes()
 		}
 		}
 	} else {
+		{
+		SCOPED_TIMER("Sim::Unit::MoveType::3::CollisionPairsMT");
+		unitCollisionPairs.Update(activeUnits, true);
+		}
 		{
 		SCOPED_TIMER("Sim::Unit::MoveType::3::CollisionDetectionMT");
 		for_mt(0, activeUnits.size(), [this](const int i){
@@ -397,6 +424,15 @@ void CUnitHandler::UpdateUnitMoveTypes()
 	}
 }
 
+void CUnitHandler::UpdateUnitKinematics()
+{
+	SCOPED_TIMER("Sim::Unit::MoveType::3::UpdateKinematics");
+
+	for_mt(0, activeUnits.size(), [this](const int i){
+		unitKinematics.Store(activeUnits[i]);
+	});
+}
+
 void CUnitHandler::UpdateUnitLosStates()
 {
 	for (CUnit* unit: activeUnits) {
@@ -423,24 +459,119 @@ void CUnitHandler::SlowUpdateUnits()
 
 	activeSlowUpdateUnit = idxEnd;
 
-	{
-	SCOPED_TIMER("Sim::Unit::SlowUpdate");
+	if (modInfo.multiThreadedSlowUpdate) {
+		MultiThreadSlowUpdateUnits(idxBeg, idxEnd);
+	} else {
+		SCOPED_TIMER("Sim::Unit::SlowUpdate");
 
-	// stagger the SlowUpdate's
-	for (size_t i = idxBeg; i<idxEnd; ++i) {
-		CUnit* unit = activeUnits[i];
+		// stagger the SlowUpdate's
+		for (size_t i = idxBeg; i<idxEnd; ++i) {
+			CUnit* unit = activeUnits[i];
 
-		unit->SanityCheck();
-		unit->SlowUpdate();
-		unit->SlowUpdateWeapons();
-		unit->localModel.UpdateBoundingVolume();
-		unit->SanityCheck();
-	}
+			unit->SanityCheck();
+			unit->SlowUpdate();
+			unit->SlowUpdateWeapons();
+			unit->localModel.UpdateBoundingVolume();
+			unit->SanityCheck();
+		}
 	}
+
+	UpdateWeaponTargets();
+
 	// some paths are requested at slow rate
 	UpdateUnitPathing(idxBeg, idxEnd);
 }
 
+void CUnitHandler::MultiThreadSlowUpdateUnits(const size_t idxBeg, const size_t idxEnd)
+{
+	// SlowUpdate can create units and thereby shift activeUnits
+	slowUpdateUnits.assign(activeUnits.begin() + idxBeg, activeUnits.begin() + idxEnd);
+
+	{
+		SCOPED_TIMER("Sim::Unit::SlowUpdate::1::PreSlowUpdateMT");
+
+		for_mt(0, slowUpdateUnits.size(), [&](const int i) {
+			slowUpdateUnits[i]->PreSlowUpdate();
+		});
+	}
+	{
+		SCOPED_TIMER("Sim::Unit::SlowUpdate::2::SlowUpdateST");
+
+		// events, scripts and anything else that mutates shared state
+		for (CUnit* unit: slowUpdateUnits) {
+			unit->SanityCheck();
+			unit->SlowUpdate();
+			unit->SlowUpdateWeapons();
+			unit->SanityCheck();
+		}
+	}
+	{
+		SCOPED_TIMER("Sim::Unit::SlowUpdate::3::UpdateBoundingVolumeMT");
+
+		// only touches the unit's own model pieces
+		for_mt(0, slowUpdateUnits.size(), [&](const int i) {
+			slowUpdateUnits[i]->localModel.UpdateBoundingVolume();
+		});
+	}
+
+	slowUpdateUnits.clear();
+}
+
+void CUnitHandler::UpdateWeaponTargets()
+{
+	SCOPED_TIMER("Sim::Unit::Weapon::AutoTarget");
+
+	// apply in the same order regardless of which weapons queued first
+	std::sort(autoTargetWeapons.begin(), autoTargetWeapons.end(), [](const CWeapon* a, const CWeapon* b) {
+		if (a->owner->id != b->owner->id)
+			return (a->owner->id < b->owner->id);
+
+		return (a->weaponNum < b->weaponNum);
+	});
+
+	size_t numWeapons = 0;
+
+	slavedWeapons.clear();
+
+	// serial; AllowWeaponAutoTarget can call into Lua
+	for (CWeapon* weapon: autoTargetWeapons) {
+		if (weapon->owner->isDead)
+			continue;
+
+		if (weapon->slavedTo != nullptr) {
+			slavedWeapons.push_back(weapon);
+			continue;
+		}
+
+		if (!weapon->BeginAutoTarget())
+			continue;
+
+		autoTargetWeapons[numWeapons++] = weapon;
+	}
+
+	autoTargetWeapons.resize(numWeapons);
+	autoTargetCandidates.resize(std::max(autoTargetCandidates.size(), numWeapons));
+
+	// read-only spatial queries and scoring, each weapon writes its own candidates
+	for_mt(0, numWeapons, [&](const int i) {
+		const CWeapon* weapon = autoTargetWeapons[i];
+		CGameHelper::GenerateWeaponTargetCandidates(weapon, weapon->GetAutoTargetAvoidee(), autoTargetCandidates[i]);
+	});
+
+	// serial; scripts, synced RNG and Lua callins, in unit-id order
+	for (size_t i = 0; i < numWeapons; i++) {
+		autoTargetWeapons[i]->FinishAutoTarget(autoTargetCandidates[i]);
+	}
+
+	// slaved weapons follow the target their master has as of this frame
+	for (CWeapon* weapon: slavedWeapons) {
+		weapon->SetAttackTarget(weapon->slavedTo->GetCurrentTarget());
+	}
+
+	autoTargetWeapons.clear();
+	slavedWeapons.clear();
+}
+
 void CUnitHandler::UpdateUnitPathing(const size_t idxBeg, const size_t idxEnd)
 {
 	SCOPED_TIMER("Sim::Unit::RequestPath");
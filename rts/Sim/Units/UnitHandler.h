@@ -8,11 +8,16 @@
 
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/SimObjectIDPool.h"
+#include "Sim/MoveTypes/UnitCollisionPairs.h"
+#include "Sim/MoveTypes/UnitNeighbourCache.h"
+#include "Sim/Objects/SolidObjectKinematics.h"
+#include "Sim/Weapons/WeaponTarget.h"
 #include "System/creg/STL_Map.h"
 
 struct UnitDef;
 class CUnit;
 class CBuilderCAI;
+class CWeapon;
 
 class CUnitHandler
 {
@@ -73,6 +78,14 @@ public:
 
 	const spring::unordered_map<unsigned int, CBuilderCAI*>& GetBuilderCAIs() const { return builderCAIs; }
 
+	// only valid during the movetype collision-detection pass
+	const SolidObjectKinematics& GetUnitKinematics() const { return unitKinematics; }
+	const UnitCollisionPairs& GetUnitCollisionPairs() const { return unitCollisionPairs; }
+	const UnitNeighbourCache& GetUnitNeighbourCache() const { return unitNeighbourCache; }
+
+	// called by CWeapon::SlowUpdate, resolved at the end of SlowUpdateUnits
+	void QueueWeaponAutoTarget(CWeapon* weapon) { autoTargetWeapons.push_back(weapon); }
+
 private:
 	void InsertActiveUnit(CUnit* unit);
 	bool QueueDeleteUnit(CUnit* unit);
@@ -80,8 +93,11 @@ private:
 	void DeleteUnit(CUnit* unit);
 	void DeleteUnits();
 	void SlowUpdateUnits();
+	void MultiThreadSlowUpdateUnits(const size_t idxBeg, const size_t idxEnd);
+	void UpdateWeaponTargets();
 	void UpdateUnitPathing(const size_t idxBeg, const size_t idxEnd);
 	void UpdateUnitMoveTypes();
+	void UpdateUnitKinematics();
 	void UpdateUnitLosStates();
 	void UpdateUnits();
 	void UpdateUnitWeapons();
@@ -101,6 +117,21 @@ private:
 
 	spring::unordered_map<unsigned int, CBuilderCAI*> builderCAIs;
 
+	///< per-frame mirror of hot unit fields, not serialized
+	SolidObjectKinematics unitKinematics;
+	///< colliding unit pairs of the current movetype collision pass, not serialized
+	UnitCollisionPairs unitCollisionPairs;
+	///< neighbour lists and flags gathered before the pre-collision pass, not serialized
+	UnitNeighbourCache unitNeighbourCache;
+
+	///< units SlowUpdate'd this frame, only filled if modInfo.multiThreadedSlowUpdate
+	std::vector<CUnit*> slowUpdateUnits;
+
+	///< weapons due to AutoTarget this frame and their candidate targets, not serialized
+	std::vector<CWeapon*> autoTargetWeapons;
+	std::vector<CWeapon*> slavedWeapons;
+	std::vector<std::vector<SWeaponTargetCandidate>> autoTargetCandidates;
+
 
 	size_t activeSlowUpdateUnit = 0;  ///< first unit of batch that will be SlowUpdate'd this frame
 	size_t activeUpdateUnit = 0;      ///< first unit of batch that will be SlowUpdate'd this frame
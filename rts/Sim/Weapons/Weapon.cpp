@@ -23,6 +23,7 @@
 #include "Sim/Units/CommandAI/CommandAI.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
+#include "Sim/Units/UnitHandler.h"
 #include "Sim/Weapons/Cannon.h"
 #include "Sim/Weapons/NoWeapon.h"
 #include "System/EventHandler.h"
@@ -648,25 +649,38 @@ bool CWeapon::AllowWeaponAutoTarget() const
 }
 
 bool CWeapon::AutoTarget()
+{
+	if (!BeginAutoTarget())
+		return false;
+
+	auto& targetCandidates = helper->targetCandidates;
+
+	CGameHelper::GenerateWeaponTargetCandidates(this, GetAutoTargetAvoidee(), targetCandidates);
+	return (FinishAutoTarget(targetCandidates));
+}
+
+bool CWeapon::BeginAutoTarget()
 {
 	if (!AllowWeaponAutoTarget())
 		return false;
 
 	// search for other in-range targets
 	lastTargetRetry = gs->frameNum;
+	return true;
+}
 
-	const CUnit* avoidUnit = (avoidTarget && HaveUnitTarget()) ? currentTarget.unit : nullptr;
-
+bool CWeapon::FinishAutoTarget(const std::vector<SWeaponTargetCandidate>& targetCandidates)
+{
 	CUnit* goodTargetUnit = nullptr;
 	CUnit*  badTargetUnit = nullptr;
 
 	auto& targetPairs = helper->targetPairs;
 
 	// NOTE:
-	//   GenerateWeaponTargets sorts by INCREASING order of priority, so lower equals better
+	//   ScoreWeaponTargets sorts by INCREASING order of priority, so lower equals better
 	//   <targetPairs> is normally sorted such that all bad TargetCategory units live at the
 	//   end, but Lua can mess with the ordering arbitrarily
-	for (size_t i = 0, n = CGameHelper::GenerateWeaponTargets(this, avoidUnit, targetPairs); i < n; i++, assert(n == targetPairs.size())) {
+	for (size_t i = 0, n = CGameHelper::ScoreWeaponTargets(this, targetCandidates, targetPairs); i < n; i++, assert(n == targetPairs.size())) {
 		CUnit* unit = targetPairs[i].second;
 
 		// save the "best" bad target in case we have no other
@@ -717,11 +731,13 @@ void CWeapon::SlowUpdate()
 	// HoldFire: if Weapon Target isn't valid
 	HoldIfTargetInvalid();
 
-	// SlavedWeapon: Update Weapon Target
+	// SlavedWeapon: clone the target of the weapon we are slaved to once
+	// its queued AutoTarget has run (see CUnitHandler::UpdateWeaponTargets)
 	if (slavedTo != nullptr) {
-		// clone targets from the weapon we are slaved to
-		SetAttackTarget(slavedTo->currentTarget);
-	} else
+		unitHandler.QueueWeaponAutoTarget(this);
+		return;
+	}
+
 	if (weaponDef->interceptor) {
 		// keep track of the closest projectile heading our way (if any)
 		UpdateInterceptTarget();
@@ -735,8 +751,9 @@ void CWeapon::SlowUpdate()
 		//Try to return fire
 		Attack(owner->lastAttacker);
 	}
-	// AutoTarget: Find new/better Target
-	AutoTarget();
+	// AutoTarget: Find new/better Target; batched with the searches
+	// of all other weapons SlowUpdate'd this frame
+	unitHandler.QueueWeaponAutoTarget(this);
 }
 
 
@@ -83,6 +83,11 @@ public:
 	virtual void UpdateRange(const float val) { range = val; }
 
 	bool AutoTarget();
+	/// AutoTarget split into its serial first and last steps, the search in
+	/// between is read-only (see CUnitHandler::UpdateWeaponTargets)
+	bool BeginAutoTarget();
+	bool FinishAutoTarget(const std::vector<SWeaponTargetCandidate>& targetCandidates);
+	const CUnit* GetAutoTargetAvoidee() const { return ((avoidTarget && HaveUnitTarget())? currentTarget.unit: nullptr); }
 	void AimReady(const int value);
 	void Fire(const bool scriptCall);
 
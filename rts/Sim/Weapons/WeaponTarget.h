@@ -48,4 +48,14 @@ public:
 	float3 groundPos;             // if targettype=ground: the ground position
 };
 
+
+// a unit found by CGameHelper::GenerateWeaponTargetCandidates, not yet
+// weighted by scripts, synced randomness or Lua (see ScoreWeaponTargets)
+struct SWeaponTargetCandidate {
+	CUnit* unit;
+
+	float priority;
+	unsigned short losStatus;
+};
+
 #endif // WEAPONTARGET_H
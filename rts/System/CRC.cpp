@@ -12,15 +12,11 @@ CRC::CRC(): crc(CRC_INIT_VAL)
 
 uint32_t CRC::InitTable()
 {
-	static bool crcTableInitialized = false;
+	// archives can be opened from several threads at once; the
+	// initializer of a function-local static runs exactly once
+	static const bool crcTableInitialized = (CrcGenerateTable(), true);
 
-	if (crcTableInitialized)
-		return 1;
-
-	CrcGenerateTable();
-
-	crcTableInitialized = true;
-	return 0;
+	return crcTableInitialized;
 }
 
 uint32_t CRC::CalcDigest(const void* data, size_t size)
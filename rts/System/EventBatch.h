@@ -0,0 +1,85 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef EVENT_BATCH_H
+#define EVENT_BATCH_H
+
+#include <cstdint>
+#include <vector>
+
+// columnar per-frame buffers for the *Batch call-ins; filled by
+// eventHandler while at least one client wants the batched event
+// and flushed at the end of every sim-frame (DeliverBatchedEvents)
+// entry i of every member describes the same event, attackerIDs
+// and projectileIDs are -1 if there was no attacker or projectile
+
+struct UnitDamagedEventBatch {
+	void Clear() {
+		unitIDs.clear();
+		unitDefIDs.clear();
+		unitTeams.clear();
+		unitAllyTeams.clear();
+		damages.clear();
+		paralyzers.clear();
+		weaponDefIDs.clear();
+		projectileIDs.clear();
+		attackerIDs.clear();
+	}
+
+	size_t Size() const { return unitIDs.size(); }
+
+	std::vector<int> unitIDs;
+	std::vector<int> unitDefIDs;
+	std::vector<int> unitTeams;
+	std::vector<int> unitAllyTeams;
+	std::vector<float> damages;
+	std::vector<uint8_t> paralyzers;
+	std::vector<int> weaponDefIDs;
+	std::vector<int> projectileIDs;
+	std::vector<int> attackerIDs;
+};
+
+struct FeatureDamagedEventBatch {
+	void Clear() {
+		featureIDs.clear();
+		featureDefIDs.clear();
+		featureTeams.clear();
+		featureAllyTeams.clear();
+		damages.clear();
+		weaponDefIDs.clear();
+		projectileIDs.clear();
+		attackerIDs.clear();
+	}
+
+	size_t Size() const { return featureIDs.size(); }
+
+	std::vector<int> featureIDs;
+	std::vector<int> featureDefIDs;
+	std::vector<int> featureTeams;
+	std::vector<int> featureAllyTeams;
+	std::vector<float> damages;
+	std::vector<int> weaponDefIDs;
+	std::vector<int> projectileIDs;
+	std::vector<int> attackerIDs;
+};
+
+struct ProjectileCreatedEventBatch {
+	void Clear() {
+		projectileIDs.clear();
+		ownerIDs.clear();
+		allyTeams.clear();
+		weaponDefIDs.clear();
+		isPiece.clear();
+	}
+
+	size_t Size() const { return projectileIDs.size(); }
+
+	std::vector<int> projectileIDs;
+	std::vector<int> ownerIDs;
+	// allyteam of the owner at creation time, -1 if unowned
+	std::vector<int> allyTeams;
+	// -1 for piece-projectiles
+	std::vector<int> weaponDefIDs;
+	std::vector<uint8_t> isPiece;
+};
+
+#endif
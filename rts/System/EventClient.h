@@ -28,6 +28,9 @@ class CProjectile;
 struct Command;
 class IArchive;
 struct SRectangle;
+struct UnitDamagedEventBatch;
+struct FeatureDamagedEventBatch;
+struct ProjectileCreatedEventBatch;
 struct UnitDef;
 struct BuildInfo;
 struct FeatureDef;
@@ -62,6 +65,10 @@ class CEventClient
 		inline int                GetOrder()  const { return order;  }
 		inline bool               GetSynced() const { return synced_; }
 
+		// true if the Update call-in may run on a worker thread, concurrently
+		// with those of other clients (see CEventHandler::Update)
+		virtual bool AllowConcurrentUpdate() const { return false; }
+
 		/**
 		 * Used by the eventHandler to register
 		 * call-ins when an EventClient is being added.
@@ -140,6 +147,7 @@ class CEventClient
 			int weaponDefID,
 			int projectileID,
 			bool paralyzer) {}
+		virtual void UnitDamagedBatch(const UnitDamagedEventBatch& batch) {}
 		virtual void UnitStunned(const CUnit* unit, bool stunned) {}
 		virtual void UnitExperience(const CUnit* unit, float oldExperience) {}
 		virtual void UnitHarvestStorageFull(const CUnit* unit) {}
@@ -181,6 +189,7 @@ class CEventClient
 			float damage,
 			int weaponDefID,
 			int projectileID) {}
+		virtual void FeatureDamagedBatch(const FeatureDamagedEventBatch& batch) {}
 		virtual void FeatureMoved(const CFeature* feature, const float3& oldpos) {}
 
 		virtual void RenderFeaturePreCreated(const CFeature* feature) {}
@@ -189,6 +198,7 @@ class CEventClient
 
 		virtual void ProjectileCreated(const CProjectile* proj) {}
 		virtual void ProjectileDestroyed(const CProjectile* proj) {}
+		virtual void ProjectileCreatedBatch(const ProjectileCreatedEventBatch& batch) {}
 
 		virtual void RenderProjectileCreated(const CProjectile* proj) {}
 		virtual void RenderProjectileDestroyed(const CProjectile* proj) {}
@@ -364,6 +374,8 @@ class CEventClient
 		virtual void LoadProgress(const std::string& msg, const bool replace_lastline);
 
 		virtual void CollectGarbage(bool forced) {}
+		// spends idle time until <deadline> on GC work skipped by CollectGarbage
+		virtual void CollectDeferredGarbage(spring_time deadline) {}
 		virtual void DbgTimingInfo(DbgTimingInfoType type, const spring_time start, const spring_time end) {}
 		virtual void Pong(uint8_t pingTag, const spring_time pktSendTime, const spring_time pktRecvTime) {}
 		virtual void MetalMapChanged(const int x, const int z) {}
@@ -4,9 +4,12 @@
 
 #include "Lua/LuaCallInCheck.h"
 #include "Lua/LuaOpenGL.h"  // FIXME -- should be moved
+#include "Sim/Projectiles/WeaponProjectiles/WeaponProjectile.h"
+#include "Sim/Weapons/WeaponDef.h"
 
 #include "System/Config/ConfigHandler.h"
 #include "System/Platform/Threading.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/GlobalConfig.h"
 
 #include <tracy/Tracy.hpp>
@@ -40,7 +43,14 @@ void CEventHandler::ResetState()
 	handles.clear();
 	handles.reserve(16);
 
+	for (int i = BATCH_SYNCED; i < BATCH_COUNT; i++) {
+		unitDamagedBatches[i].Clear();
+		featureDamagedBatches[i].Clear();
+		projectileCreatedBatches[i].Clear();
+	}
+
 	SetupEvents();
+	UpdateBatchMasks();
 }
 
 void CEventHandler::SetupEvents()
@@ -78,6 +88,9 @@ void CEventHandler::AddClient(CEventClient* ec)
 
 void CEventHandler::RemoveClient(CEventClient* ec)
 {
+	if (DeferListChange(ec, "", DEFERRED_REMOVE_CLIENT))
+		return;
+
 	if (mouseOwner == ec)
 		mouseOwner = nullptr;
 
@@ -144,6 +157,9 @@ bool CEventHandler::IsController(const std::string& eName) const
 
 bool CEventHandler::InsertEvent(CEventClient* ec, const std::string& ciName)
 {
+	if (DeferListChange(ec, ciName, DEFERRED_INSERT_EVENT))
+		return true;
+
 	const auto comp = [](const EventPair& a, const EventPair& b) { return (a.first < b.first); };
 	const auto iter = std::lower_bound(eventMap.begin(), eventMap.end(), EventPair{ciName, {}}, comp);
 
@@ -154,12 +170,16 @@ bool CEventHandler::InsertEvent(CEventClient* ec, const std::string& ciName)
 		return false;
 
 	ListInsert(*iter->second.GetList(), ec);
+	UpdateBatchMasks();
 	return true;
 }
 
 
 bool CEventHandler::RemoveEvent(CEventClient* ec, const std::string& ciName)
 {
+	if (DeferListChange(ec, ciName, DEFERRED_REMOVE_EVENT))
+		return true;
+
 	const auto comp = [](const EventPair& a, const EventPair& b) { return (a.first < b.first); };
 	const auto iter = std::lower_bound(eventMap.begin(), eventMap.end(), EventPair{ciName, {}}, comp);
 
@@ -167,12 +187,25 @@ bool CEventHandler::RemoveEvent(CEventClient* ec, const std::string& ciName)
 		return false;
 
 	ListRemove(*(iter->second.GetList()), ec);
+	UpdateBatchMasks();
 	return true;
 }
 
 
 /******************************************************************************/
 
+bool CEventHandler::DeferListChange(CEventClient* ec, const std::string& ciName, int type)
+{
+	// the lists are only modified by the main thread, which is
+	// free to iterate over them while clients update concurrently
+	if (!concurrentUpdate.load() || Threading::IsMainThread())
+		return false;
+
+	std::lock_guard<spring::mutex> lock(deferredListChangesMutex);
+	deferredListChanges.push_back({ec, ciName, type});
+	return true;
+}
+
 void CEventHandler::ListInsert(EventClientList& ecList, CEventClient* ec)
 {
 	for (auto it = ecList.begin(); it != ecList.end(); ++it) {
@@ -207,6 +240,25 @@ void CEventHandler::ListRemove(EventClientList& ecList, CEventClient* ec)
 }
 
 
+static unsigned int GetBatchMask(const std::vector<CEventClient*>& ecList, unsigned int syncedBit, unsigned int unsyncedBit)
+{
+	unsigned int mask = 0;
+
+	for (const CEventClient* ec: ecList) {
+		mask |= (ec->GetSynced()? syncedBit: unsyncedBit);
+	}
+
+	return mask;
+}
+
+void CEventHandler::UpdateBatchMasks()
+{
+	unitDamagedBatchMask = GetBatchMask(listUnitDamagedBatch, 1 << BATCH_SYNCED, 1 << BATCH_UNSYNCED);
+	featureDamagedBatchMask = GetBatchMask(listFeatureDamagedBatch, 1 << BATCH_SYNCED, 1 << BATCH_UNSYNCED);
+	projectileCreatedBatchMask = GetBatchMask(listProjectileCreatedBatch, 1 << BATCH_SYNCED, 1 << BATCH_UNSYNCED);
+}
+
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -611,6 +663,13 @@ void CEventHandler::CollectGarbage(bool forced)
 	ITERATE_EVENTCLIENTLIST(CollectGarbage, forced);
 }
 
+void CEventHandler::CollectDeferredGarbage(spring_time deadline)
+{
+	ZoneScoped;
+	// not a separate event, every client that collects garbage can defer it
+	IterateEventClientList(listCollectGarbage, &CEventClient::CollectDeferredGarbage, deadline);
+}
+
 void CEventHandler::DbgTimingInfo(DbgTimingInfoType type, const spring_time start, const spring_time end)
 {
 	ITERATE_EVENTCLIENTLIST(DbgTimingInfo, type, start, end);
@@ -626,7 +685,93 @@ void CEventHandler::Pong(uint8_t pingTag, const spring_time pktSendTime, const s
 void CEventHandler::Update()
 {
 	ZoneScoped;
-	ITERATE_EVENTCLIENTLIST_NA(Update);
+
+	serialUpdateClients.clear();
+	concurrentUpdateClients.clear();
+
+	for (CEventClient* ec: listUpdate) {
+		if (ThreadPool::HasThreads() && ec->AllowConcurrentUpdate()) {
+			concurrentUpdateClients.push_back(ec);
+		} else {
+			serialUpdateClients.push_back(ec);
+		}
+	}
+
+	if (concurrentUpdateClients.empty()) {
+		ITERATE_EVENTCLIENTLIST_NA(Update);
+		return;
+	}
+
+#ifdef THREADPOOL
+	// hand the concurrent clients to the workers while the main thread
+	// runs the rest; anything (call-in or callout) that could race with
+	// them from the main thread calls WaitForConcurrentUpdates first
+	const auto UpdateTask = [](CEventClient* ec) { ec->Update(); };
+
+	using UpdateTaskGroup = TTaskGroup<decltype(UpdateTask), void, CEventClient*>;
+
+	updateTaskGroups.clear();
+	updateTaskGroups.reserve(concurrentUpdateClients.size());
+	concurrentUpdate.store(true);
+
+	for (size_t i = 0, n = concurrentUpdateClients.size(); i < n; i++) {
+		auto taskGroup = std::make_shared<UpdateTaskGroup>(1);
+		taskGroup->Enqueue(UpdateTask, concurrentUpdateClients[i]);
+		// pinned s.t. the main thread can not pick these up while it
+		// waits on some unrelated for_mt, only in WaitForFinished
+		taskGroup->wantedThread.store(1 + i % (ThreadPool::GetNumThreads() - 1));
+
+		ThreadPool::PushTaskGroup(taskGroup);
+		updateTaskGroups.emplace_back(std::move(taskGroup));
+	}
+
+	for (CEventClient* ec: serialUpdateClients) {
+		// an earlier call-in may have removed this client
+		if (std::find(listUpdate.begin(), listUpdate.end(), ec) == listUpdate.end())
+			continue;
+
+		ec->Update();
+	}
+
+	WaitForConcurrentUpdates();
+#endif
+}
+
+bool CEventHandler::IsUpdatingConcurrently(const CEventClient* ec) const
+{
+	if (!concurrentUpdate.load(std::memory_order_relaxed))
+		return false;
+
+	return (std::find(concurrentUpdateClients.begin(), concurrentUpdateClients.end(), ec) != concurrentUpdateClients.end());
+}
+
+void CEventHandler::WaitForConcurrentUpdates()
+{
+	assert(Threading::IsMainThread());
+
+	if (!concurrentUpdate.load())
+		return;
+
+#ifdef THREADPOOL
+	for (auto& taskGroup: updateTaskGroups) {
+		ThreadPool::WaitForFinished(taskGroup);
+	}
+#endif
+
+	updateTaskGroups.clear();
+	concurrentUpdateClients.clear();
+	concurrentUpdate.store(false);
+
+	for (const DeferredListChange& c: deferredListChanges) {
+		switch (c.type) {
+			case DEFERRED_REMOVE_CLIENT: { RemoveClient(c.client             ); } break;
+			case DEFERRED_INSERT_EVENT : { InsertEvent (c.client, c.ciName); } break;
+			case DEFERRED_REMOVE_EVENT : { RemoveEvent (c.client, c.ciName); } break;
+			default: { assert(false); } break;
+		}
+	}
+
+	deferredListChanges.clear();
 }
 
 
@@ -934,6 +1079,129 @@ void CEventHandler::MetalMapChanged(const int x, const int z)
 	ITERATE_EVENTCLIENTLIST(MetalMapChanged, x, z);
 }
 
+/******************************************************************************/
+/******************************************************************************/
+
+void CEventHandler::RecordUnitDamaged(
+	const CUnit* unit,
+	const CUnit* attacker,
+	float damage,
+	int weaponDefID,
+	int projectileID,
+	bool paralyzer
+) {
+	for (int i = BATCH_SYNCED; i < BATCH_COUNT; i++) {
+		if ((unitDamagedBatchMask & (1 << i)) == 0)
+			continue;
+
+		UnitDamagedEventBatch& b = unitDamagedBatches[i];
+
+		b.unitIDs.push_back(unit->id);
+		b.unitDefIDs.push_back(unit->unitDef->id);
+		b.unitTeams.push_back(unit->team);
+		b.unitAllyTeams.push_back(unit->allyteam);
+		b.damages.push_back(damage);
+		b.paralyzers.push_back(paralyzer);
+		b.weaponDefIDs.push_back(weaponDefID);
+		b.projectileIDs.push_back(projectileID);
+		b.attackerIDs.push_back((attacker != nullptr)? attacker->id: -1);
+	}
+}
+
+void CEventHandler::RecordFeatureDamaged(
+	const CFeature* feature,
+	const CUnit* attacker,
+	float damage,
+	int weaponDefID,
+	int projectileID
+) {
+	for (int i = BATCH_SYNCED; i < BATCH_COUNT; i++) {
+		if ((featureDamagedBatchMask & (1 << i)) == 0)
+			continue;
+
+		FeatureDamagedEventBatch& b = featureDamagedBatches[i];
+
+		b.featureIDs.push_back(feature->id);
+		b.featureDefIDs.push_back(feature->def->id);
+		b.featureTeams.push_back(feature->team);
+		b.featureAllyTeams.push_back(feature->allyteam);
+		b.damages.push_back(damage);
+		b.weaponDefIDs.push_back(weaponDefID);
+		b.projectileIDs.push_back(projectileID);
+		b.attackerIDs.push_back((attacker != nullptr)? attacker->id: -1);
+	}
+}
+
+void CEventHandler::RecordProjectileCreated(const CProjectile* proj, int allyTeam)
+{
+	// same subset as passed to the per-projectile ProjectileCreated call-in
+	if (!proj->weapon && !proj->piece)
+		return;
+
+	const WeaponDef* wd = proj->weapon? static_cast<const CWeaponProjectile*>(proj)->GetWeaponDef(): nullptr;
+
+	if (proj->weapon && wd == nullptr)
+		return;
+
+	const CUnit* owner = proj->owner();
+
+	for (int i = BATCH_SYNCED; i < BATCH_COUNT; i++) {
+		if ((projectileCreatedBatchMask & (1 << i)) == 0)
+			continue;
+
+		ProjectileCreatedEventBatch& b = projectileCreatedBatches[i];
+
+		b.projectileIDs.push_back(proj->id);
+		b.ownerIDs.push_back((owner != nullptr)? owner->id: -1);
+		b.allyTeams.push_back(allyTeam);
+		b.weaponDefIDs.push_back((wd != nullptr)? wd->id: -1);
+		b.isPiece.push_back(proj->piece);
+	}
+}
+
+// delivers each batch only to the clients of the kind it was recorded for
+template<typename B, typename F> static void DeliverBatches(
+	std::vector<CEventClient*>& ecList,
+	std::array<B, 2>& batches,
+	std::array<B, 2>& pendingBatches,
+	unsigned int mask,
+	const F& func
+) {
+	for (int k = 0; k < 2; k++) {
+		// if the last client wanting a batch went away, drop what it left behind
+		if ((mask & (1 << k)) == 0)
+			batches[k].Clear();
+
+		if (batches[k].Size() == 0)
+			continue;
+
+		std::swap(batches[k], pendingBatches[k]);
+
+		for (size_t i = 0; i < ecList.size(); ) {
+			CEventClient* ec = ecList[i];
+
+			if (ec->GetSynced() == (k == 0))
+				(ec->*func)(pendingBatches[k]);
+
+			// the call-in may remove itself from the list
+			i += (i < ecList.size() && ec == ecList[i]);
+		}
+
+		pendingBatches[k].Clear();
+	}
+}
+
+void CEventHandler::DeliverBatchedEvents()
+{
+	ZoneScoped;
+
+	static_assert(BATCH_SYNCED == 0 && BATCH_COUNT == 2, "");
+
+	DeliverBatches(listUnitDamagedBatch, unitDamagedBatches, pendingUnitDamagedBatches, unitDamagedBatchMask, &CEventClient::UnitDamagedBatch);
+	DeliverBatches(listFeatureDamagedBatch, featureDamagedBatches, pendingFeatureDamagedBatches, featureDamagedBatchMask, &CEventClient::FeatureDamagedBatch);
+	DeliverBatches(listProjectileCreatedBatch, projectileCreatedBatches, pendingProjectileCreatedBatches, projectileCreatedBatchMask, &CEventClient::ProjectileCreatedBatch);
+}
+
 void CEventHandler::DrawOpaqueUnitsLua(bool deferredPass, bool drawReflection, bool drawRefraction)
 {
 	ZoneScoped;
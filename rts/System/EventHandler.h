@@ -3,10 +3,15 @@
 #ifndef EVENT_HANDLER_H
 #define EVENT_HANDLER_H
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "System/EventClient.h"
+#include "System/EventBatch.h"
+#include "System/Threading/SpringThreading.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Features/Feature.h"
 #include "Sim/Projectiles/Projectile.h"
@@ -15,6 +20,7 @@ class CWeapon;
 struct Command;
 struct BuildInfo;
 class LuaMaterial;
+class ITaskGroup;
 
 class CEventHandler
 {
@@ -303,11 +309,22 @@ class CEventHandler
 		void GameProgress(int gameFrame);
 
 		void CollectGarbage(bool forced);
+		void CollectDeferredGarbage(spring_time deadline);
 		void DbgTimingInfo(DbgTimingInfoType type, const spring_time start, const spring_time end);
 		void Pong(uint8_t pingTag, const spring_time pktSendTime, const spring_time pktRecvTime);
 		void MetalMapChanged(const int x, const int z);
+
+		/// @brief passes the events recorded this frame to the *Batch call-ins
+		void DeliverBatchedEvents();
 		/// @}
 
+		/// true while the Update call-in of some clients runs on worker threads
+		bool InConcurrentUpdate() const { return concurrentUpdate.load(std::memory_order_relaxed); }
+		/// true if ec's Update call-in is (or is about to be) running on a worker
+		bool IsUpdatingConcurrently(const CEventClient* ec) const;
+		/// main thread only; blocks until all concurrent Update call-ins have returned
+		void WaitForConcurrentUpdates();
+
 	private:
 		typedef std::vector<CEventClient*> EventClientList;
 
@@ -343,6 +360,13 @@ class CEventHandler
 		                EventClientList* list, int props);
 		void ListInsert(EventClientList& ciList, CEventClient* ec);
 		void ListRemove(EventClientList& ciList, CEventClient* ec);
+		bool DeferListChange(CEventClient* ec, const std::string& ciName, int type);
+
+		void UpdateBatchMasks();
+
+		void RecordUnitDamaged(const CUnit* unit, const CUnit* attacker, float damage, int weaponDefID, int projectileID, bool paralyzer);
+		void RecordFeatureDamaged(const CFeature* feature, const CUnit* attacker, float damage, int weaponDefID, int projectileID);
+		void RecordProjectileCreated(const CProjectile* proj, int allyTeam);
 
 	private:
 		CEventClient* mouseOwner;
@@ -352,6 +376,55 @@ class CEventHandler
 
 		EventClientList handles;
 
+		// synced clients get their own batches, recorded only while one of
+		// them is in the corresponding *Batch list; what they receive must
+		// not depend on whether some unsynced client (e.g. a widget) wants
+		// the batch as well
+		enum {
+			BATCH_SYNCED   = 0,
+			BATCH_UNSYNCED = 1,
+			BATCH_COUNT    = 2,
+		};
+
+		// bit BATCH_{UN}SYNCED is set iff a client of that kind wants the batch
+		unsigned int unitDamagedBatchMask = 0;
+		unsigned int featureDamagedBatchMask = 0;
+		unsigned int projectileCreatedBatchMask = 0;
+
+		// swapped with the pending buffers during delivery such that any
+		// events raised by the call-ins themselves go into the next batch
+		std::array<UnitDamagedEventBatch, BATCH_COUNT> unitDamagedBatches;
+		std::array<FeatureDamagedEventBatch, BATCH_COUNT> featureDamagedBatches;
+		std::array<ProjectileCreatedEventBatch, BATCH_COUNT> projectileCreatedBatches;
+
+		std::array<UnitDamagedEventBatch, BATCH_COUNT> pendingUnitDamagedBatches;
+		std::array<FeatureDamagedEventBatch, BATCH_COUNT> pendingFeatureDamagedBatches;
+		std::array<ProjectileCreatedEventBatch, BATCH_COUNT> pendingProjectileCreatedBatches;
+
+		// set while the Update call-ins of concurrentUpdateClients run on
+		// worker threads; list changes requested by those are deferred to
+		// WaitForConcurrentUpdates
+		std::atomic<bool> concurrentUpdate = {false};
+
+		enum {
+			DEFERRED_REMOVE_CLIENT = 0,
+			DEFERRED_INSERT_EVENT  = 1,
+			DEFERRED_REMOVE_EVENT  = 2,
+		};
+
+		struct DeferredListChange {
+			CEventClient* client;
+			std::string ciName;
+			int type;
+		};
+
+		spring::mutex deferredListChangesMutex;
+		std::vector<DeferredListChange> deferredListChanges;
+
+		EventClientList serialUpdateClients;
+		EventClientList concurrentUpdateClients;
+		std::vector<std::shared_ptr<ITaskGroup>> updateTaskGroups;
+
 	#define SETUP_EVENT(name, props) EventClientList list ## name;
 	#define SETUP_UNMANAGED_EVENT(name, props)
 		#include "Events.def"
@@ -537,6 +610,9 @@ inline void CEventHandler::UnitDamaged(
 	bool paralyzer)
 {
 	ITERATE_UNIT_ALLYTEAM_EVENTCLIENTLIST(UnitDamaged, unit, attacker, damage, weaponDefID, projectileID, paralyzer)
+
+	if (unitDamagedBatchMask != 0)
+		RecordUnitDamaged(unit, attacker, damage, weaponDefID, projectileID, paralyzer);
 }
 
 inline void CEventHandler::UnitStunned(
@@ -638,6 +714,9 @@ inline void CEventHandler::FeatureDamaged(
 		if (featureAllyTeam < 0 || ec->CanReadAllyTeam(featureAllyTeam))
 			ec->FeatureDamaged(feature, attacker, damage, weaponDefID, projectileID);
 	}
+
+	if (featureDamagedBatchMask != 0)
+		RecordFeatureDamaged(feature, attacker, damage, weaponDefID, projectileID);
 }
 
 inline void CEventHandler::FeatureMoved(const CFeature* feature, const float3& oldpos)
@@ -663,6 +742,9 @@ inline void CEventHandler::ProjectileCreated(const CProjectile* proj, int allyTe
 			ec->ProjectileCreated(proj);
 		}
 	}
+
+	if (projectileCreatedBatchMask != 0)
+		RecordProjectileCreated(proj, allyTeam);
 }
 
 
@@ -14,6 +14,7 @@
 #include "DataDirLocater.h"
 #include "Archives/IArchive.h"
 #include "Archives/DirArchive.h"
+#include "Archives/PoolArchive.h"
 #include "FileFilter.h"
 #include "DataDirsAccess.h"
 #include "FileSystem.h"
@@ -27,6 +28,7 @@
 #include "System/Log/ILog.h"
 #include "System/Threading/SpringThreading.h"
 #include "System/UnorderedMap.hpp"
+#include "System/UnorderedSet.hpp"
 
 #if !defined(DEDICATED) && !defined(UNITSYNC)
 	#include "System/Misc/UnfreezeSpring.h"
@@ -380,6 +382,13 @@ bool CArchiveScanner::ArchiveData::GetInfoValueBool(const std::string& key) cons
 static spring::recursive_mutex scannerMutex;
 static std::atomic<uint32_t> numScannedArchives{0};
 
+struct ScanScope {
+	 ScanScope(bool* b) { p = b; *p =  true; }
+	~ScanScope(       ) {        *p = false; }
+
+	bool* p = nullptr;
+};
+
 
 /*
  * CArchiveScanner
@@ -396,9 +405,7 @@ CArchiveScanner::CArchiveScanner()
 
 CArchiveScanner::~CArchiveScanner()
 {
-	if (!isDirty)
-		return;
-
+	// pool file hashes can be added without any archive being rescanned
 	WriteCacheData(GetFilepath());
 }
 
@@ -499,14 +506,65 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs)
 		}
 	}*/
 
-	// Create archiveInfos etc. if not in cache already
+	// Create archiveInfos etc. if not in cache already; the cache is checked
+	// serially and in order, archives that need to be opened are then read in
+	// parallel and merged back in their original order. An archive sharing its
+	// name with an earlier one is scanned afterwards, s.t. CheckCachedData can
+	// reject it as a duplicate like a serial scan would
+	std::vector<std::pair<std::string, unsigned>> newArchives;
+	std::vector<std::string> dupArchives;
+	spring::unordered_set<std::string> newArchiveNames;
+
 	for (const std::string& archive: foundArchives) {
-		ScanArchive(archive, false);
+		unsigned modifiedTime = 0;
+
+		if (CheckCachedData(archive, modifiedTime, false))
+			continue;
+
+		if (!newArchiveNames.insert(StringToLower(FileSystem::GetFilename(archive))).second) {
+			dupArchives.push_back(archive);
+			continue;
+		}
+
+		newArchives.emplace_back(archive, modifiedTime);
+	}
+
+	// bounded batches keep the watchdog fed and memory of open archives in check
+	const size_t batchSize = std::max(ThreadPool::GetNumThreads(), 1) * 4;
+
+	std::vector<ScanResult> results;
+
+	for (size_t i = 0; i < newArchives.size(); i += batchSize) {
+		const size_t n = std::min(batchSize, newArchives.size() - i);
+
+		results.clear();
+		results.resize(n);
+
+		{
+			const ScanScope scanScope(&isInScan);
+
+			for_mt(0, n, [&](const int j) {
+				try {
+					ReadArchive(newArchives[i + j].first, newArchives[i + j].second, results[j]);
+				} catch (...) {
+					results[j].error = std::current_exception();
+				}
+			});
+		}
+
+		for (ScanResult& result: results) {
+			AddScanResult(result);
+		}
+
 	#if !defined(DEDICATED) && !defined(UNITSYNC)
 		Watchdog::ClearTimer();
 	#endif
 	}
 
+	for (const std::string& archive: dupArchives) {
+		ScanArchive(archive, false);
+	}
+
 	// Now we'll have to parse the replaces-stuff found in the mods
 	for (const auto& archiveInfo: archiveInfos) {
 		const std::string& lcOriginalName = StringToLower(archiveInfo.origName);
@@ -653,17 +711,22 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		return;
 
 	isDirty = true;
-	isInScan = true;
 
-	struct ScanScope {
-		 ScanScope(bool* b) { p = b; *p =  true; }
-		~ScanScope(       ) {        *p = false; }
+	ScanResult result;
 
-		bool* p = nullptr;
-	};
+	{
+		const ScanScope scanScope(&isInScan);
+		ReadArchive(fullName, modifiedTime, result);
+	}
 
-	const ScanScope scanScope(&isInScan);
+	if (result.opened && !result.broken)
+		result.archiveInfo.hashed = doChecksum && GetArchiveChecksum(fullName, result.archiveInfo);
 
+	AddScanResult(result);
+}
+
+void CArchiveScanner::ReadArchive(const std::string& fullName, unsigned modifiedTime, ScanResult& result)
+{
 	const std::string& fname = FileSystem::GetFilename(fullName);
 	const std::string& fpath = FileSystem::GetDirectory(fullName);
 	const std::string& lcfn  = StringToLower(fname);
@@ -674,7 +737,8 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		LOG_L(L_WARNING, "[AS::%s] unable to open archive \"%s\"", __func__, fullName.c_str());
 
 		// record it as broken, so we don't need to look inside everytime
-		BrokenArchive& ba = GetAddBrokenArchive(lcfn);
+		BrokenArchive& ba = result.brokenArchive;
+		result.broken = true;
 		ba.name = lcfn;
 		ba.path = fpath;
 		ba.modified = modifiedTime;
@@ -695,7 +759,9 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	const bool hasMapInfo = ar->FileExists("mapinfo.lua");
 
 
-	ArchiveInfo ai;
+	result.opened = true;
+
+	ArchiveInfo& ai = result.archiveInfo;
 	ArchiveData& ad = ai.archiveData;
 
 	// execute the respective .lua, otherwise assume this archive is a map
@@ -718,7 +784,8 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		LOG_L(L_WARNING, "[AS::%s] failed to scan \"%s\" (%s)", __func__, fullName.c_str(), error.c_str());
 
 		// mark archive as broken, so we don't need to look inside everytime
-		BrokenArchive& ba = GetAddBrokenArchive(lcfn);
+		BrokenArchive& ba = result.brokenArchive;
+		result.broken = true;
 		ba.name = lcfn;
 		ba.path = fpath;
 		ba.modified = modifiedTime;
@@ -768,14 +835,28 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 
 	ai.origName = fname;
 	ai.updated = true;
-	ai.hashed = doChecksum && GetArchiveChecksum(fullName, ai);
-
-	archiveInfosIndex.insert(lcfn, archiveInfos.size());
-	archiveInfos.emplace_back(std::move(ai));
 
 	numScannedArchives += 1;
 }
 
+void CArchiveScanner::AddScanResult(ScanResult& result)
+{
+	if (result.error)
+		std::rethrow_exception(result.error);
+
+	if (result.broken) {
+		const std::string lcfn = result.brokenArchive.name;
+		GetAddBrokenArchive(lcfn) = std::move(result.brokenArchive);
+		return;
+	}
+
+	if (!result.opened)
+		return;
+
+	archiveInfosIndex.insert(StringToLower(result.archiveInfo.origName), archiveInfos.size());
+	archiveInfos.emplace_back(std::move(result.archiveInfo));
+}
+
 
 bool CArchiveScanner::CheckCachedData(const std::string& fullName, unsigned& modified, bool doChecksum)
 {
@@ -1012,9 +1093,16 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 }
 
 
+static std::string GetPoolHashCacheFile(const std::string& cacheFile)
+{
+	return (FileSystem::GetDirectory(cacheFile) + IntToString(INTERNAL_VER, "PoolFileHashes%i.bin"));
+}
+
 void CArchiveScanner::ReadCacheData(const std::string& filename)
 {
 	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
+	CPoolArchive::ReadFileHashCache(GetPoolHashCacheFile(filename));
+
 	if (!FileSystem::FileExists(filename)) {
 		LOG_L(L_INFO, "[AS::%s] ArchiveCache %s doesn't exist", __func__, filename.c_str());
 		return;
@@ -1113,6 +1201,8 @@ void FilterDep(std::vector<std::string>& deps, const std::string& exclude)
 void CArchiveScanner::WriteCacheData(const std::string& filename)
 {
 	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
+	CPoolArchive::WriteFileHashCache(GetPoolHashCacheFile(filename));
+
 	if (!isDirty)
 		return;
 
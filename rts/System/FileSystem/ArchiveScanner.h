@@ -4,6 +4,7 @@
 #define _ARCHIVE_SCANNER_H
 
 #include <cstring> // memset
+#include <exception>
 #include <string>
 #include <deque>
 #include <vector>
@@ -184,6 +185,17 @@ private:
 		uint32_t modified = 0;
 		bool updated = false;
 	};
+	// outcome of reading an archive that was not (validly) cached
+	struct ScanResult {
+		ArchiveInfo archiveInfo;
+		BrokenArchive brokenArchive;
+
+		// rethrown when merged, e.g. unreadable pool archive index
+		std::exception_ptr error;
+
+		bool opened = false;
+		bool broken = false;
+	};
 
 private:
 	ArchiveInfo& GetAddArchiveInfo(const std::string& lcfn);
@@ -192,6 +204,13 @@ private:
 	void ScanDirs(const std::vector<std::string>& dirs);
 	void ScanDir(const std::string& curPath, std::deque<std::string>& foundArchives);
 
+	/**
+	 * Opens an archive and parses its {mod,map}info; does not touch any
+	 * scanner state and may be called for different archives in parallel.
+	 */
+	void ReadArchive(const std::string& fullName, unsigned modifiedTime, ScanResult& result);
+	void AddScanResult(ScanResult& result);
+
 	/// scan mapinfo / modinfo lua files
 	bool ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai, std::string& err);
 
@@ -0,0 +1,247 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "ArchiveMemberCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+#include "System/GlobalConfig.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/Log/ILog.h"
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#else
+	#include <windows.h>
+#endif
+
+
+CArchiveMemberCache archiveMemberCache;
+
+static constexpr char ENTRY_MAGIC[8] = {'S', 'P', 'R', 'A', 'M', 'C', '\0', '\0'};
+static constexpr uint32_t ENTRY_VERSION = 1;
+
+
+namespace {
+	// read-only view of an entire file, the mapping outlives the descriptor
+	struct MappedFile {
+		MappedFile(const std::string& path) {
+		#ifndef _WIN32
+			const int fd = open(path.c_str(), O_RDONLY);
+
+			if (fd < 0)
+				return;
+
+			struct stat st;
+
+			if (fstat(fd, &st) == 0 && st.st_size > 0) {
+				void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+				if (ptr != MAP_FAILED) {
+					data = static_cast<const uint8_t*>(ptr);
+					size = st.st_size;
+				}
+			}
+
+			close(fd);
+		#else
+			const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE)
+				return;
+
+			LARGE_INTEGER fileSize;
+
+			if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+				const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+				if (mapping != nullptr) {
+					const void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+					if (ptr != nullptr) {
+						data = static_cast<const uint8_t*>(ptr);
+						size = fileSize.QuadPart;
+					}
+
+					CloseHandle(mapping);
+				}
+			}
+
+			CloseHandle(file);
+		#endif
+		}
+
+		~MappedFile() {
+			if (data == nullptr)
+				return;
+
+		#ifndef _WIN32
+			munmap(const_cast<uint8_t*>(data), size);
+		#else
+			UnmapViewOfFile(data);
+		#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator = (const MappedFile&) = delete;
+
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+	};
+}
+
+
+bool CArchiveMemberCache::IsEnabled()
+{
+	if (globalConfig.vfsPersistentCacheSize <= 0)
+		return false;
+
+	std::call_once(initFlag, [this]() { Init(); });
+	return (!cacheDir.empty());
+}
+
+void CArchiveMemberCache::Init()
+{
+	static_assert(sizeof(EntryHeader) == (sizeof(ENTRY_MAGIC) + 2 * sizeof(uint32_t) + sha512::SHA_LEN), "");
+
+	cacheDir = dataDirsAccess.LocateDir(FileSystem::GetCacheDir() + "/archives/", FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+	maxBytes = uint64_t(globalConfig.vfsPersistentCacheSize) << 20;
+
+	if (cacheDir.empty()) {
+		LOG_L(L_WARNING, "[ArchiveMemberCache::%s] could not create the cache directory, disabled", __func__);
+		return;
+	}
+
+	cacheDir = FileSystem::EnsurePathSepAtEnd(cacheDir);
+
+	struct DirEntry {
+		std::filesystem::file_time_type time;
+		std::filesystem::path path;
+		uint64_t size;
+	};
+
+	std::vector<DirEntry> entries;
+	std::error_code ec;
+
+	for (const auto& de: std::filesystem::directory_iterator(cacheDir, ec)) {
+		if (!de.is_regular_file(ec))
+			continue;
+
+		entries.push_back({de.last_write_time(ec), de.path(), de.file_size(ec)});
+		usedBytes += entries.back().size;
+	}
+
+	// evict least recently used entries (Load refreshes the timestamp) down
+	// to 3/4 of the limit, so the next few launches can store without this
+	if (usedBytes > maxBytes) {
+		std::sort(entries.begin(), entries.end(), [](const DirEntry& a, const DirEntry& b) { return (a.time < b.time); });
+
+		for (const DirEntry& e: entries) {
+			if (usedBytes <= (maxBytes / 4) * 3)
+				break;
+
+			if (std::filesystem::remove(e.path, ec))
+				usedBytes -= e.size;
+		}
+	}
+
+	LOG_L(L_INFO, "[ArchiveMemberCache::%s] dir=\"%s\" entries=%u used=%uMB limit=%uMB", __func__, cacheDir.c_str(), static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(usedBytes >> 20), static_cast<uint32_t>(maxBytes >> 20));
+}
+
+
+std::string CArchiveMemberCache::GetEntryPath(const Key& key) const
+{
+	constexpr const char table[] = "0123456789abcdef";
+
+	// half of the key keeps paths short (Windows), the full key is in the header
+	char name[sha512::SHA_LEN + 1] = {0};
+
+	for (size_t i = 0; i < (sha512::SHA_LEN / 2); i++) {
+		name[2 * i    ] = table[(key[i] >> 4) & 0xf];
+		name[2 * i + 1] = table[ key[i]       & 0xf];
+	}
+
+	return (cacheDir + name);
+}
+
+
+bool CArchiveMemberCache::Load(const Key& key, std::vector<std::uint8_t>& buffer)
+{
+	const std::string& path = GetEntryPath(key);
+	const MappedFile file(path);
+
+	if (file.data == nullptr || file.size < sizeof(EntryHeader))
+		return false;
+
+	EntryHeader header;
+	std::memcpy(&header, file.data, sizeof(header));
+
+	if (std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0)
+		return false;
+	if (header.version != ENTRY_VERSION || header.key != key)
+		return false;
+	if (header.size != (file.size - sizeof(header)))
+		return false;
+
+	buffer.resize(header.size);
+	std::memcpy(buffer.data(), file.data + sizeof(header), header.size);
+
+	// eviction is by age, mark the entry as recently used
+	std::error_code ec;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+	return true;
+}
+
+void CArchiveMemberCache::Store(const Key& key, const std::vector<std::uint8_t>& buffer)
+{
+	const uint64_t entryBytes = sizeof(EntryHeader) + buffer.size();
+
+	// stay within the limit, space is reclaimed on the next launch
+	if ((usedBytes += entryBytes) > maxBytes) {
+		usedBytes -= entryBytes;
+		return;
+	}
+
+	const std::string& path = GetEntryPath(key);
+	// other threads and engine instances might be storing the same entry
+	const std::string& temp = path + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()) ^ std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+
+	EntryHeader header;
+	std::memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+	header.version = ENTRY_VERSION;
+	header.size = buffer.size();
+	header.key = key;
+
+	FILE* file = fopen(temp.c_str(), "wb");
+
+	if (file == nullptr) {
+		usedBytes -= entryBytes;
+		return;
+	}
+
+	bool written = true;
+	written &= (fwrite(&header, sizeof(header), 1, file) == 1);
+	written &= (buffer.empty() || fwrite(buffer.data(), buffer.size(), 1, file) == 1);
+	written &= (fclose(file) == 0);
+
+	std::error_code ec;
+
+	// readers only ever see complete entries
+	if (written)
+		std::filesystem::rename(temp, path, ec);
+
+	if (!written || ec) {
+		std::filesystem::remove(temp, ec);
+		usedBytes -= entryBytes;
+	}
+}
@@ -0,0 +1,59 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _ARCHIVE_MEMBER_CACHE_H
+#define _ARCHIVE_MEMBER_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "System/Sync/SHA512.hpp"
+
+/**
+ * Persistent on-disk cache of decompressed archive files, shared by every
+ * engine instance using the same write-dir.
+ * Entries are content-addressed by a SHA512 key the archive derives from
+ * its index (without extracting the file), written once via rename and
+ * read back through a read-only memory mapping.
+ * Disabled unless VFSPersistentCacheSize is non-zero.
+ */
+class CArchiveMemberCache
+{
+public:
+	typedef sha512::raw_digest Key;
+
+	bool IsEnabled();
+	// files smaller than this are cheaper to extract than to look up
+	bool WantsFile(size_t size) const { return (size >= MIN_FILE_SIZE); }
+
+	bool Load(const Key& key, std::vector<std::uint8_t>& buffer);
+	void Store(const Key& key, const std::vector<std::uint8_t>& buffer);
+
+private:
+	void Init();
+
+	std::string GetEntryPath(const Key& key) const;
+
+private:
+	static constexpr size_t MIN_FILE_SIZE = 32 * 1024;
+
+	struct EntryHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t size;
+		Key key;
+	};
+
+	std::once_flag initFlag;
+	std::string cacheDir;
+
+	uint64_t maxBytes = 0;
+
+	std::atomic<uint64_t> usedBytes = {0};
+};
+
+extern CArchiveMemberCache archiveMemberCache;
+
+#endif // _ARCHIVE_MEMBER_CACHE_H
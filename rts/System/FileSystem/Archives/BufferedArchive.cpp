@@ -1,14 +1,14 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "BufferedArchive.h"
+#include "ArchiveMemberCache.h"
 #include "System/GlobalConfig.h"
 #include "System/MainDefines.h"
 #include "System/Log/ILog.h"
+#include "System/Threading/ThreadPool.h"
 
 #include <cassert>
 
-spring::mutex CBufferedArchive::archiveLock;
-
 
 CBufferedArchive::~CBufferedArchive()
 {
@@ -19,50 +19,168 @@ CBufferedArchive::~CBufferedArchive()
 	LOG_L(L_INFO, "[%s][name=%s] %u bytes cached in %u files", __func__, archiveFile.c_str(), cacheSize, fileCount);
 }
 
+
+int CBufferedArchive::ReadFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
+{
+	sha512::raw_digest key;
+
+	if (!archiveMemberCache.IsEnabled() || !GetMemberCacheKey(fid, key) || !archiveMemberCache.WantsFile(FileInfo(fid).second))
+		return (ExtractFile(fid, buffer));
+
+	if (archiveMemberCache.Load(key, buffer))
+		return 1;
+
+	const int ret = ExtractFile(fid, buffer);
+
+	if (ret == 1)
+		archiveMemberCache.Store(key, buffer);
+
+	return ret;
+}
+
+int CBufferedArchive::ExtractFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
+{
+	if (concurrentReads)
+		return (GetFileImpl(fid, buffer));
+
+	std::lock_guard<spring::mutex> lck(archiveLock);
+	return (GetFileImpl(fid, buffer));
+}
+
 bool CBufferedArchive::GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
-	std::scoped_lock lck(archiveLock);
 	assert(IsFileId(fid));
 
 	int ret = 0;
 
 	if (!globalConfig.vfsCacheArchiveFiles || noCache) {
-		if ((ret = GetFileImpl(fid, buffer)) != 1)
+		if ((ret = ReadFile(fid, buffer)) != 1)
 			LOG_L(L_WARNING, "[BufferedArchive::%s(fid=%u)][noCache=%d,vfsCache=%d] name=%s ret=%d size=" _STPF_, __func__, fid, static_cast<int>(noCache), static_cast<int>(globalConfig.vfsCacheArchiveFiles), archiveFile.c_str(), ret, buffer.size());
 
 		return (ret == 1);
 	}
 
-	// NumFiles is virtual, can't do this in ctor
-	if (fileCache.empty())
-		fileCache.resize(NumFiles());
+	bool populate = false;
 
-	FileBuffer& fb = fileCache.at(fid);
+	{
+		std::lock_guard<spring::mutex> lck(cacheLock);
 
-	fb.numAccessed++;
-	if (!fb.populated) {
-		if (fb.numAccessed > 1) {
-			fb.exists = ((ret = GetFileImpl(fid, fb.data)) == 1);
-			fb.populated = true;
+		// NumFiles is virtual, can't do this in ctor
+		if (fileCache.empty())
+			fileCache.resize(NumFiles());
+
+		FileBuffer& fb = fileCache.at(fid);
+
+		fb.numAccessed++;
 
-			cacheSize += fb.data.size();
-			fileCount += fb.exists;
+		if (fb.prefetched) {
+			// hand the data over, a later access caches the file as usual
+			buffer.swap(fb.data);
+
+			cacheSize -= buffer.size();
+			fileCount -= fb.exists;
+
+			fb.data = {};
+			fb.populated = false;
+			fb.prefetched = false;
+			return fb.exists;
 		}
-		else { // most files are only accessed once, don't bother with those
-			ret = GetFileImpl(fid, buffer);
-			return (ret == 1);
+
+		if (fb.populated) {
+			if (!fb.exists) {
+				LOG_L(L_WARNING, "[BufferedArchive::%s(fid=%u)][!fb.exists] name=%s size=" _STPF_, __func__, fid, archiveFile.c_str(), fb.data.size());
+				return false;
+			}
+
+			// TODO: zero-copy access
+			buffer.assign(fb.data.begin(), fb.data.end());
+			return true;
 		}
+
+		// most files are only accessed once, don't bother with those
+		populate = (fb.numAccessed > 1);
+	}
+
+	// extract without holding cacheLock so other files can be served meanwhile
+	ret = ReadFile(fid, buffer);
+
+	if (!populate)
+		return (ret == 1);
+
+	std::lock_guard<spring::mutex> lck(cacheLock);
+	FileBuffer& fb = fileCache[fid];
+
+	// another thread might have raced us to it
+	if (!fb.populated) {
+		fb.exists = (ret == 1);
+		fb.populated = true;
+
+		if (fb.exists)
+			fb.data.assign(buffer.begin(), buffer.end());
+
+		cacheSize += fb.data.size();
+		fileCount += fb.exists;
 	}
 
-	if (!fb.exists) {
+	if (!fb.exists)
 		LOG_L(L_WARNING, "[BufferedArchive::%s(fid=%u)][!fb.exists] name=%s ret=%d size=" _STPF_, __func__, fid, archiveFile.c_str(), ret, fb.data.size());
-		return false;
+
+	return fb.exists;
+}
+
+void CBufferedArchive::PrefetchFiles(const std::vector<unsigned int>& fids)
+{
+	// extraction from archives that serialize GetFileImpl can not be sped up
+	if (!globalConfig.vfsCacheArchiveFiles || noCache || !concurrentReads)
+		return;
+
+	std::vector<unsigned int> pending;
+	std::vector< std::vector<std::uint8_t> > buffers;
+	std::vector<int> results;
+
+	{
+		std::lock_guard<spring::mutex> lck(cacheLock);
+
+		if (fileCache.empty())
+			fileCache.resize(NumFiles());
+
+		pending.reserve(fids.size());
+
+		for (const unsigned int fid: fids) {
+			if (!IsFileId(fid) || fileCache[fid].populated)
+				continue;
+
+			pending.push_back(fid);
+		}
 	}
 
-	if (buffer.size() != fb.data.size())
-		buffer.resize(fb.data.size());
+	if (pending.empty())
+		return;
+
+	buffers.resize(pending.size());
+	results.resize(pending.size(), 0);
+
+	for_mt(0, pending.size(), [&](const int i) {
+		results[i] = ReadFile(pending[i], buffers[i]);
+	});
 
-	// TODO: zero-copy access
-	std::copy(fb.data.begin(), fb.data.end(), buffer.begin());
-	return true;
+	std::lock_guard<spring::mutex> lck(cacheLock);
+
+	for (size_t i = 0, n = pending.size(); i < n; i++) {
+		FileBuffer& fb = fileCache[pending[i]];
+
+		// fetched by GetFile while we were busy
+		if (fb.populated)
+			continue;
+
+		fb.exists = (results[i] == 1);
+		fb.populated = true;
+		fb.prefetched = true;
+
+		if (fb.exists)
+			fb.data = std::move(buffers[i]);
+
+		cacheSize += fb.data.size();
+		fileCount += fb.exists;
+	}
 }
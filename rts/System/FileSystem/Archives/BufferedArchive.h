@@ -7,14 +7,20 @@
 #include "System/Threading/SpringThreading.h"
 
 /**
- * Provides a helper implementation for archive types that can only uncompress
- * one file to memory at a time.
+ * Provides a helper implementation for archive types that extract files
+ * whole into memory, with optional caching of repeatedly accessed files.
  */
 class CBufferedArchive : public IArchive
 {
 public:
-	CBufferedArchive(const std::string& name, bool cached = true): IArchive(name) {
+	/**
+	 * @param cached keep files in memory after their second access
+	 * @param concurrent GetFileImpl may be called from several threads at
+	 *   once, otherwise calls are serialized per archive instance
+	 */
+	CBufferedArchive(const std::string& name, bool cached = true, bool concurrent = false): IArchive(name) {
 		noCache = !cached;
+		concurrentReads = concurrent;
 	}
 
 	virtual ~CBufferedArchive();
@@ -22,10 +28,23 @@ public:
 	virtual int GetType() const override { return ARCHIVE_TYPE_BUF; }
 
 	bool GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+	void PrefetchFiles(const std::vector<unsigned int>& fids) override;
 
 protected:
 	virtual int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) = 0;
 
+	/**
+	 * Identifies the contents of a file for the persistent member cache
+	 * using only the archive index, i.e. without extracting it.
+	 * @return false if the archive has no such identity for its files
+	 */
+	virtual bool GetMemberCacheKey(unsigned int fid, sha512::raw_digest& key) const { return false; }
+
+	// from the persistent member cache if possible, otherwise
+	// GetFileImpl (under archiveLock unless reads may run concurrently)
+	int ReadFile(unsigned int fid, std::vector<std::uint8_t>& buffer);
+	int ExtractFile(unsigned int fid, std::vector<std::uint8_t>& buffer);
+
 	struct FileBuffer {
 		FileBuffer() = default;
 		FileBuffer(const FileBuffer& fb) = delete;
@@ -37,23 +56,26 @@ protected:
 		uint32_t numAccessed = 0;
 		bool populated = false; // files may be empty (0 bytes)
 		bool exists = false;
+		bool prefetched = false; // data is handed out (not copied) on the next access
 
 		std::vector<std::uint8_t> data;
 	};
 
-	// indexed by file-id
+	// indexed by file-id, guarded by cacheLock
 	std::vector<FileBuffer> fileCache;
-	// neither 7zip (.sd7) nor minizip (.sdz) are thread-safe
-	// zlib (used to extract pool archive .gz entries) should
-	// not need this, but currently each buffered GetFileImpl
-	// call is protected
-	static spring::mutex archiveLock;
+
+	spring::mutex cacheLock;
+	// neither 7zip (.sd7) nor a single minizip (.sdz) handle are
+	// thread-safe; archives that can not extract several files at
+	// once are serialized by this (per-instance) lock
+	spring::mutex archiveLock;
 
 private:
 	uint32_t cacheSize = 0;
 	uint32_t fileCount = 0;
 
 	bool noCache = false;
+	bool concurrentReads = false;
 };
 
 #endif // _BUFFERED_ARCHIVE_H
@@ -81,6 +81,12 @@ public:
 	 * @see GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
 	 */
 	bool GetFile(const std::string& name, std::vector<std::uint8_t>& buffer);
+	/**
+	 * Hints that the given files will be fetched soon, so they can be
+	 * extracted in parallel ahead of the GetFile calls.
+	 * Archives that do not benefit from this ignore the hint.
+	 */
+	virtual void PrefetchFiles(const std::vector<unsigned int>& fids) {}
 
 	std::pair<std::string, int> FileInfo(unsigned int fid) const {
 		std::pair<std::string, int> info;
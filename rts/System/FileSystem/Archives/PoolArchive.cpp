@@ -16,6 +16,8 @@
 #include "System/Exceptions.h"
 #include "System/StringUtil.h"
 #include "System/Log/ILog.h"
+#include "System/Threading/SpringThreading.h"
+#include "System/UnorderedMap.hpp"
 
 
 CPoolArchiveFactory::CPoolArchiveFactory(): IArchiveFactory("sdp")
@@ -45,8 +47,107 @@ static bool gz_really_read(gzFile file, voidp buf, unsigned int len)
 }
 
 
+namespace {
+	typedef std::array<uint8_t, 16> MD5Digest;
 
-CPoolArchive::CPoolArchive(const std::string& name): CBufferedArchive(name)
+	struct MD5DigestHash {
+		// digests are uniformly distributed already
+		size_t operator () (const MD5Digest& d) const {
+			size_t h = 0;
+			std::memcpy(&h, d.data(), sizeof(h));
+			return h;
+		}
+	};
+
+	struct FileHashCacheHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t count;
+	};
+
+	constexpr char FILE_HASH_CACHE_MAGIC[8] = {'P', 'O', 'O', 'L', 'S', 'H', 'A', '\0'};
+	constexpr uint32_t FILE_HASH_CACHE_VERSION = 1;
+
+	spring::mutex fileHashesMutex;
+	spring::unordered_map<MD5Digest, sha512::raw_digest, MD5DigestHash> fileHashes;
+
+	bool fileHashesDirty = false;
+}
+
+
+bool CPoolArchive::ReadFileHashCache(const std::string& path)
+{
+	FILE* in = fopen(path.c_str(), "rb");
+
+	if (in == nullptr)
+		return false;
+
+	FileHashCacheHeader header;
+
+	if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, FILE_HASH_CACHE_MAGIC, sizeof(FILE_HASH_CACHE_MAGIC)) != 0 || header.version != FILE_HASH_CACHE_VERSION) {
+		fclose(in);
+		return false;
+	}
+
+	std::lock_guard<spring::mutex> lck(fileHashesMutex);
+
+	fileHashes.reserve(header.count);
+
+	MD5Digest md5;
+	sha512::raw_digest sha;
+
+	for (uint32_t n = 0; n < header.count; n++) {
+		if (fread(md5.data(), md5.size(), 1, in) != 1 || fread(sha.data(), sha.size(), 1, in) != 1)
+			break;
+
+		fileHashes[md5] = sha;
+	}
+
+	fclose(in);
+	return true;
+}
+
+bool CPoolArchive::WriteFileHashCache(const std::string& path)
+{
+	std::lock_guard<spring::mutex> lck(fileHashesMutex);
+
+	if (!fileHashesDirty)
+		return true;
+
+	FILE* out = fopen(path.c_str(), "wb");
+
+	if (out == nullptr) {
+		LOG_L(L_ERROR, "[PoolArchive::%s] failed to write to \"%s\"", __func__, path.c_str());
+		return false;
+	}
+
+	FileHashCacheHeader header;
+	std::memcpy(header.magic, FILE_HASH_CACHE_MAGIC, sizeof(FILE_HASH_CACHE_MAGIC));
+	header.version = FILE_HASH_CACHE_VERSION;
+	header.count = fileHashes.size();
+
+	bool written = (fwrite(&header, sizeof(header), 1, out) == 1);
+
+	for (const auto& pair: fileHashes) {
+		written &= (fwrite(pair.first.data(), pair.first.size(), 1, out) == 1);
+		written &= (fwrite(pair.second.data(), pair.second.size(), 1, out) == 1);
+	}
+
+	written &= (fclose(out) == 0);
+
+	if (!written) {
+		LOG_L(L_ERROR, "[PoolArchive::%s] failed to write to \"%s\"", __func__, path.c_str());
+		return false;
+	}
+
+	fileHashesDirty = false;
+	return true;
+}
+
+
+
+// every pool file is an independent gzip stream, no need to serialize reads
+CPoolArchive::CPoolArchive(const std::string& name): CBufferedArchive(name, true, true)
 {
 	memset(&dummyFileHash, 0, sizeof(dummyFileHash));
 
@@ -123,6 +224,36 @@ CPoolArchive::~CPoolArchive()
 	}
 }
 
+bool CPoolArchive::CalcHash(uint32_t fid, uint8_t hash[sha512::SHA_LEN], std::vector<std::uint8_t>& fb)
+{
+	assert(IsFileId(fid));
+
+	FileData& fd = files[fid];
+
+	// pool-entry hashes are not calculated until GetFileImpl, must check JIT
+	if (memcmp(fd.shasum.data(), dummyFileHash.data(), sizeof(fd.shasum)) == 0) {
+		std::unique_lock<spring::mutex> lck(fileHashesMutex);
+
+		const auto iter = fileHashes.find(fd.md5sum);
+
+		if (iter != fileHashes.end()) {
+			fd.shasum = iter->second;
+		} else {
+			lck.unlock();
+			GetFileImpl(fid, fb);
+			lck.lock();
+
+			if (memcmp(fd.shasum.data(), dummyFileHash.data(), sizeof(fd.shasum)) != 0) {
+				fileHashes[fd.md5sum] = fd.shasum;
+				fileHashesDirty = true;
+			}
+		}
+	}
+
+	memcpy(hash, fd.shasum.data(), sha512::SHA_LEN);
+	return (memcmp(fd.shasum.data(), dummyFileHash.data(), sizeof(fd.shasum)) != 0);
+}
+
 int CPoolArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
 	assert(IsFileId(fid));
@@ -88,21 +88,34 @@ public:
 		name = files[fid].name;
 		size = files[fid].size;
 	}
-	bool CalcHash(uint32_t fid, uint8_t hash[sha512::SHA_LEN], std::vector<std::uint8_t>& fb) override {
+	bool CalcHash(uint32_t fid, uint8_t hash[sha512::SHA_LEN], std::vector<std::uint8_t>& fb) override;
+
+	/**
+	 * SHA512's of pool files are remembered by their MD5 (i.e. content) name
+	 * across archives, so checksumming a new version of a rapid archive only
+	 * has to inflate the pool files it does not share with earlier versions.
+	 * These persist the table between runs, writing only if it grew.
+	 */
+	static bool ReadFileHashCache(const std::string& path);
+	static bool WriteFileHashCache(const std::string& path);
+
+protected:
+	int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+	bool GetMemberCacheKey(unsigned int fid, sha512::raw_digest& key) const override {
 		assert(IsFileId(fid));
 
 		const FileData& fd = files[fid];
 
-		// pool-entry hashes are not calculated until GetFileImpl, must check JIT
-		if (memcmp(fd.shasum.data(), dummyFileHash.data(), sizeof(fd.shasum)) == 0)
-			GetFileImpl(fid, fb);
+		// pool files are content-addressed by their MD5, so cache
+		// entries are shared by every archive (version) using them
+		sha512::msg_vector msg(fd.md5sum.begin(), fd.md5sum.end());
 
-		memcpy(hash, fd.shasum.data(), sha512::SHA_LEN);
-		return (memcmp(fd.shasum.data(), dummyFileHash.data(), sizeof(fd.shasum)) != 0);
-	}
+		msg.insert(msg.end(), reinterpret_cast<const uint8_t*>(&fd.crc32), reinterpret_cast<const uint8_t*>(&fd.crc32) + sizeof(fd.crc32));
+		msg.insert(msg.end(), reinterpret_cast<const uint8_t*>(&fd.size ), reinterpret_cast<const uint8_t*>(&fd.size ) + sizeof(fd.size ));
 
-protected:
-	int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+		sha512::calc_digest(msg, key);
+		return true;
+	}
 
 	std::pair<uint64_t, uint64_t> GetSums() const {
 		std::pair<uint64_t, uint64_t> p;
@@ -72,7 +72,7 @@ static std::optional<std::string> GetFileName(const CSzArEx* db, int i)
 	uint16_t utf16Buffer[bufferSize];
 	char tempBuffer[bufferSize];
 
-	// caller has archiveLock
+	// only called from the constructor
 	const size_t utf16len = SzArEx_GetFileNameUtf16(db, i, nullptr);
 	if (utf16len >= bufferSize)
 		return std::nullopt;
@@ -140,8 +140,6 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name)
 	, allocImp({SzAlloc, SzFree})
 	, allocTempImp({SzAllocTemp, SzFreeTemp})
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
-
 	constexpr const size_t kInputBufSize = (size_t)1 << 18;
 
 	const WRes wres = InFile_Open(&archiveStream.file, name.c_str());
@@ -199,8 +197,6 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name)
 
 CSevenZipArchive::~CSevenZipArchive()
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
-
 	if (outBuffer != nullptr) {
 		IAlloc_Free(&allocImp, outBuffer);
 	}
@@ -213,7 +209,8 @@ CSevenZipArchive::~CSevenZipArchive()
 
 int CSevenZipArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
-	// assert(archiveLock.locked());
+	// caller (CBufferedArchive::ReadFile) has archiveLock, the
+	// decoder state (current solid block) is shared by all files
 	assert(IsFileId(fid));
 
 	size_t offset = 0;
@@ -8,6 +8,7 @@
 #include <cassert>
 
 #include "System/StringUtil.h"
+#include "System/FileSystem/FileSystem.h"
 #include "System/Log/ILog.h"
 
 
@@ -17,10 +18,8 @@ IArchive* CZipArchiveFactory::DoCreateArchive(const std::string& filePath) const
 }
 
 
-CZipArchive::CZipArchive(const std::string& archiveName): CBufferedArchive(archiveName)
+CZipArchive::CZipArchive(const std::string& archiveName): CBufferedArchive(archiveName, true, true)
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
-
 	if ((zip = unzOpen(archiveName.c_str())) == nullptr) {
 		LOG_L(L_ERROR, "[%s] error opening \"%s\"", __func__, archiveName.c_str());
 		return;
@@ -59,16 +58,23 @@ CZipArchive::CZipArchive(const std::string& archiveName): CBufferedArchive(archi
 		lcNameIndex.emplace(StringToLower(fd.origName), fileEntries.size());
 		fileEntries.emplace_back(std::move(fd));
 	}
+
+	idleHandles.push_back(zip);
+
+	archiveStamp  = FileSystem::GetFilename(archiveName);
+	archiveStamp += "/" + IntToString(FileSystem::GetFileSize(archiveName));
+	archiveStamp += "/" + IntToString(FileSystem::GetFileModificationTime(archiveName));
 }
 
 CZipArchive::~CZipArchive()
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
-
-	if (zip != nullptr) {
-		unzClose(zip);
-		zip = nullptr;
+	// no extraction can be in progress, every handle is idle
+	for (unzFile handle: idleHandles) {
+		unzClose(handle);
 	}
+
+	idleHandles.clear();
+	zip = nullptr;
 }
 
 
@@ -81,24 +87,78 @@ void CZipArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 }
 
 
+bool CZipArchive::GetMemberCacheKey(unsigned int fid, sha512::raw_digest& key) const
+{
+	assert(IsFileId(fid));
+
+	const FileEntry& fe = fileEntries[fid];
+
+	// the CRC alone is too weak to identify contents, tie
+	// the entry to this exact version of the archive file
+	sha512::msg_vector msg(archiveStamp.begin(), archiveStamp.end());
+
+	msg.insert(msg.end(), fe.origName.begin(), fe.origName.end());
+	msg.insert(msg.end(), reinterpret_cast<const uint8_t*>(&fe.crc ), reinterpret_cast<const uint8_t*>(&fe.crc ) + sizeof(fe.crc ));
+	msg.insert(msg.end(), reinterpret_cast<const uint8_t*>(&fe.size), reinterpret_cast<const uint8_t*>(&fe.size) + sizeof(fe.size));
+
+	sha512::calc_digest(msg, key);
+	return true;
+}
+
+
+unzFile CZipArchive::AcquireHandle()
+{
+	{
+		std::lock_guard<spring::mutex> lck(handleLock);
+
+		if (!idleHandles.empty()) {
+			const unzFile handle = idleHandles.back();
+			idleHandles.pop_back();
+			return handle;
+		}
+	}
+
+	// every handle is busy extracting, open another one
+	return (unzOpen(archiveFile.c_str()));
+}
+
+void CZipArchive::ReleaseHandle(unzFile handle)
+{
+	std::lock_guard<spring::mutex> lck(handleLock);
+	idleHandles.push_back(handle);
+}
+
+
 // To simplify things, files are always read completely into memory from
-// the zip-file, since zlib does not provide any way of reading more
-// than one file at a time
+// the zip-file, since a minizip handle can only have one file open at a
+// time; concurrent calls each extract through their own handle
 int CZipArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
 	// Prevent opening files on missing/invalid archives
 	if (zip == nullptr)
 		return -4;
 
-	// assert(archiveLock.locked());
 	assert(IsFileId(fid));
 
-	unzGoToFilePos(zip, &fileEntries[fid].fp);
+	const unzFile handle = AcquireHandle();
+
+	if (handle == nullptr)
+		return -4;
+
+	const int ret = ReadFileEntry(handle, fid, buffer);
+
+	ReleaseHandle(handle);
+	return ret;
+}
+
+int CZipArchive::ReadFileEntry(unzFile handle, unsigned int fid, std::vector<std::uint8_t>& buffer)
+{
+	unzGoToFilePos(handle, &fileEntries[fid].fp);
 
 	unz_file_info fi;
-	unzGetCurrentFileInfo(zip, &fi, nullptr, 0, nullptr, 0, nullptr, 0);
+	unzGetCurrentFileInfo(handle, &fi, nullptr, 0, nullptr, 0, nullptr, 0);
 
-	if (unzOpenCurrentFile(zip) != UNZ_OK)
+	if (unzOpenCurrentFile(handle) != UNZ_OK)
 		return -3;
 
 	buffer.clear();
@@ -106,9 +166,9 @@ int CZipArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer
 
 	int ret = 1;
 
-	if (!buffer.empty() && unzReadCurrentFile(zip, buffer.data(), buffer.size()) != buffer.size())
+	if (!buffer.empty() && unzReadCurrentFile(handle, buffer.data(), buffer.size()) != buffer.size())
 		ret -= 2;
-	if (unzCloseCurrentFile(zip) == UNZ_CRCERROR)
+	if (unzCloseCurrentFile(handle) == UNZ_CRCERROR)
 		ret -= 1;
 
 	if (ret != 1)
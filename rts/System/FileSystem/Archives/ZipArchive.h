@@ -47,9 +47,21 @@ public:
 	}
 	#endif
 
+protected:
+	unzFile AcquireHandle();
+	void ReleaseHandle(unzFile handle);
+
+	int ReadFileEntry(unzFile handle, unsigned int fid, std::vector<std::uint8_t>& buffer);
+
 protected:
 	unzFile zip;
 
+	// minizip handles keep their own stream and inflate state, so files
+	// can be extracted concurrently through distinct handles; idle ones
+	// (including zip) are kept here for reuse
+	std::vector<unzFile> idleHandles;
+	spring::mutex handleLock;
+
 	// actual data is in BufferedArchive
 	struct FileEntry {
 		unz_file_pos fp;
@@ -61,6 +73,10 @@ protected:
 	std::vector<FileEntry> fileEntries;
 
 	int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+	bool GetMemberCacheKey(unsigned int fid, sha512::raw_digest& key) const override;
+
+	// name, size and modification time of the archive file
+	std::string archiveStamp;
 };
 
 #endif // _ZIP_ARCHIVE_H
@@ -166,6 +166,49 @@ bool CFileHandler::FileExists(const std::string& filePath, const std::string& mo
 }
 
 
+void CFileHandler::PrefetchFiles(const std::vector<std::string>& filePaths, const std::string& modes)
+{
+#ifndef TOOLS
+	if (vfsHandler == nullptr)
+		return;
+
+	std::vector<std::string> pending = filePaths;
+	std::vector<std::string> remaining;
+	std::vector<std::string> sectionFiles;
+
+	// resolve every file to the first mode that has it, just like Open
+	for (char c: modes) {
+		if (pending.empty())
+			break;
+
+		const CVFSHandler::Section section = CVFSHandler::GetModeSection(c);
+
+		remaining.clear();
+		sectionFiles.clear();
+
+		for (const std::string& filePath: pending) {
+			if (section != CVFSHandler::Section::Error) {
+				if (vfsHandler->FileExists(filePath, section) == 1) {
+					sectionFiles.push_back(filePath);
+					continue;
+				}
+			} else if (FileExists(filePath, std::string(1, c))) {
+				// raw or pwd, read directly and nothing to prefetch
+				continue;
+			}
+
+			remaining.push_back(filePath);
+		}
+
+		if (!sectionFiles.empty())
+			vfsHandler->PrefetchFiles(sectionFiles, section);
+
+		pending.swap(remaining);
+	}
+#endif
+}
+
+
 int CFileHandler::Read(void* buf, int length)
 {
 	if (ifs.is_open()) {
@@ -458,6 +458,34 @@ int CVFSHandler::LoadFile(const std::string& filePath, std::vector<std::uint8_t>
 	return (fileData.ar->GetFile(normalizedPath, buffer));
 }
 
+void CVFSHandler::PrefetchFiles(const std::vector<std::string>& filePaths, Section section)
+{
+	LOG_L(L_DEBUG, "[%s::%s<this=%p>(#filePaths=%u, section=%d)]", vfsName, __func__, this, static_cast<uint32_t>(filePaths.size()), section);
+
+	std::vector< std::pair<IArchive*, std::vector<unsigned int>> > archiveFiles;
+
+	for (const std::string& filePath: filePaths) {
+		const std::string& normalizedPath = GetNormalizedPath(filePath);
+		const FileData& fileData = GetFileData(normalizedPath, section);
+
+		if (fileData.ar == nullptr)
+			continue;
+
+		const auto pred = [&](const std::pair<IArchive*, std::vector<unsigned int>>& p) { return (p.first == fileData.ar); };
+		const auto iter = std::find_if(archiveFiles.begin(), archiveFiles.end(), pred);
+
+		if (iter == archiveFiles.end()) {
+			archiveFiles.emplace_back(fileData.ar, std::vector<unsigned int>{fileData.ar->FindFile(normalizedPath)});
+		} else {
+			iter->second.push_back(fileData.ar->FindFile(normalizedPath));
+		}
+	}
+
+	for (const auto& p: archiveFiles) {
+		p.first->PrefetchFiles(p.second);
+	}
+}
+
 int CVFSHandler::FileExists(const std::string& filePath, Section section)
 {
 	LOG_L(L_DEBUG, "[%s::%s<this=%p>(filePath=\"%s\", section=%d)]", vfsName, __func__, this, filePath.c_str(), section);
@@ -104,6 +104,14 @@ public:
 	 */
 	int LoadFile(const std::string& filePath, std::vector<std::uint8_t>& buffer, Section section);
 
+	/**
+	 * Lets the archives containing the given files extract them in
+	 * parallel ahead of the LoadFile calls that are about to follow.
+	 * @param filePaths raw file paths, case-insensitive; paths not in
+	 *   the VFS are ignored
+	 */
+	void PrefetchFiles(const std::vector<std::string>& filePaths, Section section);
+
 
 	/**
 	 * Returns all the files in the given (virtual) directory without the
@@ -59,6 +59,7 @@ CONFIG(bool, UseNetMessageSmoothingBuffer).defaultValue(true).description("Buffe
 
 CONFIG(bool, LuaWritableConfigFile).defaultValue(true);
 CONFIG(bool, VFSCacheArchiveFiles).defaultValue(true);
+CONFIG(int, VFSPersistentCacheSize).defaultValue(0).minimumValue(0).description("Size limit in MB of the on-disk cache of decompressed archive files under the write-dir. Lets later launches read large files of pool and .sdz archives without inflating them again. 0 disables the cache.");
 
 CONFIG(bool, DumpGameStateOnDesync).defaultValue(false).description("Enable writing clientgamestate and servergamestate dumps when a desync is detected");
 
@@ -91,6 +92,7 @@ void GlobalConfig::Init()
 	useNetMessageSmoothingBuffer = configHandler->GetBool("UseNetMessageSmoothingBuffer");
 	luaWritableConfigFile = configHandler->GetBool("LuaWritableConfigFile");
 	vfsCacheArchiveFiles = configHandler->GetBool("VFSCacheArchiveFiles");
+	vfsPersistentCacheSize = configHandler->GetInt("VFSPersistentCacheSize");
 
 	dumpGameStateOnDesync = configHandler->GetBool("DumpGameStateOnDesync");
 
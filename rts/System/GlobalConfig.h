@@ -106,6 +106,14 @@ public:
 	 */
 	bool vfsCacheArchiveFiles = true;
 
+	/**
+	 * @brief vfsPersistentCacheSize
+	 *
+	 * Size limit in MB of the on-disk cache of decompressed (pool and zip)
+	 * archive files, 0 disables it
+	 */
+	int vfsPersistentCacheSize = 0;
+
 	/**
 	 * @brief dumpGameStateOnDesync
 	 *
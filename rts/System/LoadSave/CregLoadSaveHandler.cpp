@@ -20,6 +20,7 @@
 #include "Rendering/Textures/ColorMap.h"
 #include "Rendering/Units/UnitDrawer.h"
 #include "Sim/Features/FeatureHandler.h"
+#include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Misc/BuildingMaskMap.h"
 #include "Sim/Misc/GroundBlockingObjectMap.h"
@@ -116,7 +117,7 @@ class CLuaStateCollector
 
 public:
 	CLuaStateCollector() = default;
-	void Read(const CSplitLuaHandle* handle);
+	void Read(const CSplitLuaHandle* handle, bool collectGarbage);
 	void Write(CSplitLuaHandle* handle);
 
 	bool valid;
@@ -146,7 +147,7 @@ CR_REG_METADATA(CLuaStateCollector, (
 	CR_SERIALIZER(Serialize)
 ))
 
-void CLuaStateCollector::Read(const CSplitLuaHandle* handle) {
+void CLuaStateCollector::Read(const CSplitLuaHandle* handle, bool collectGarbage) {
 	valid = (handle != nullptr) && handle->syncedLuaHandle.IsValid();
 	if (!valid)
 		return;
@@ -164,7 +165,11 @@ void CLuaStateCollector::Read(const CSplitLuaHandle* handle) {
 	 * just a regular Lua table. So just a shallow copy is sufficient. */
 	delayedCallsByFrame = handle->syncedLuaHandle.delayedCallsByFrame;
 
-	lua_gc(L_GC, LUA_GCCOLLECT, 0);
+	// a full collection changes when finalizers run (and thereby the synced
+	// state), so it must be skipped for demo snapshots; the incremental GC's
+	// progress is serialized along with the rest of the state
+	if (collectGarbage)
+		lua_gc(L_GC, LUA_GCCOLLECT, 0);
 }
 
 void CLuaStateCollector::Write(CSplitLuaHandle* handle) {
@@ -219,10 +224,10 @@ static void ReadString(std::istream& s, std::string& str)
 }
 
 
-static void SaveLuaState(CSplitLuaHandle* handle, creg::COutputStreamSerializer& os, std::stringstream& oss)
+static void SaveLuaState(CSplitLuaHandle* handle, creg::COutputStreamSerializer& os, std::stringstream& oss, bool collectGarbage)
 {
 	CLuaStateCollector lsc;
-	lsc.Read(handle);
+	lsc.Read(handle, collectGarbage);
 	os.SavePackage(&oss, &lsc, lsc.GetClass());
 }
 
@@ -245,55 +250,63 @@ static void LoadLuaState(CSplitLuaHandle* handle, creg::CInputStreamSerializer&
 }
 
 
-void CCregLoadSaveHandler::SaveGame(const std::string& path)
+void CCregLoadSaveHandler::SaveGameState(std::stringstream& oss, bool snapshot)
 {
 #ifdef USING_CREG
-	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
+	// write our own header. SavePackage() will add its own
+	WriteString(oss, SpringVersion::GetSync());
+	WriteString(oss, gameSetup->setupText);
+	WriteString(oss, modName);
+	WriteString(oss, mapName);
 
-	// NB: Selection leaves CObject reference as Unit's listener,
-	//     But isn't serialized - leak on load.
-	selectedUnitsHandler.ClearSelected();
+	creg::COutputStreamSerializer os;
 
-	try {
-		std::stringstream oss;
+	// save lua state first as lua unit scripts depend on it
+	const int luaStart = oss.tellp();
+	SaveLuaState(luaGaia, os, oss, !snapshot);
+	SaveLuaState(luaRules, os, oss, !snapshot);
+	PrintSize("Lua", ((int)oss.tellp()) - luaStart);
 
-		// write our own header. SavePackage() will add its own
-		WriteString(oss, SpringVersion::GetSync());
-		WriteString(oss, gameSetup->setupText);
-		WriteString(oss, modName);
-		WriteString(oss, mapName);
+	// save creg state
+	const int gameStart = oss.tellp();
+	CGameStateCollector gsc;
+	os.SavePackage(&oss, &gsc, gsc.GetClass());
+	PrintSize("Game", ((int)oss.tellp()) - gameStart);
 
 
-		{
-			creg::COutputStreamSerializer os;
+	// save AI state
+	const int aiStart = oss.tellp();
 
-			// save lua state first as lua unit scripts depend on it
-			const int luaStart = oss.tellp();
-			SaveLuaState(luaGaia, os, oss);
-			SaveLuaState(luaRules, os, oss);
-			PrintSize("Lua", ((int)oss.tellp()) - luaStart);
+	for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
+		std::stringstream aiData;
 
-			// save creg state
-			const int gameStart = oss.tellp();
-			CGameStateCollector gsc;
-			os.SavePackage(&oss, &gsc, gsc.GetClass());
-			PrintSize("Game", ((int)oss.tellp()) - gameStart);
+		// AIs do not run during demo playback and must not see the save
+		// event in the recorded game, so snapshots contain no AI data
+		if (!snapshot)
+			eoh->Save(&aiData, ai.first);
 
+		std::uint64_t aiSize = aiData.tellp();
+		creg::WriteUInt(&oss, aiSize);
+		if (aiSize > 0)
+			oss << aiData.rdbuf();
+	}
+	PrintSize("AIs", ((int)oss.tellp()) - aiStart);
+#endif //USING_CREG
+}
 
-			// save AI state
-			const int aiStart = oss.tellp();
+void CCregLoadSaveHandler::SaveGame(const std::string& path)
+{
+#ifdef USING_CREG
+	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
 
-			for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
-				std::stringstream aiData;
-				eoh->Save(&aiData, ai.first);
+	// NB: Selection leaves CObject reference as Unit's listener,
+	//     But isn't serialized - leak on load.
+	selectedUnitsHandler.ClearSelected();
 
-				std::uint64_t aiSize = aiData.tellp();
-				creg::WriteUInt(&oss, aiSize);
-				if (aiSize > 0)
-					oss << aiData.rdbuf();
-			}
-			PrintSize("AIs", ((int)oss.tellp()) - aiStart);
-		}
+	try {
+		std::stringstream oss;
+
+		SaveGameState(oss, false);
 
 		{
 			gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
@@ -332,20 +345,85 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 #endif //USING_CREG
 }
 
+/// saves the game-state into <data> (same format as an uncompressed save-file) without side-effects
+bool CCregLoadSaveHandler::SaveSnapshot(std::string& data)
+{
+#ifdef USING_CREG
+	// selection has to be detached as in SaveGame, but must not change for the
+	// user; ClearSelected and AddUnit would cause SelectionChanged events
+	std::vector<CUnit*> selectedUnits;
+	selectedUnits.reserve(selectedUnitsHandler.selectedUnits.size());
+
+	for (const int unitID: selectedUnitsHandler.selectedUnits) {
+		CUnit* unit = unitHandler.GetUnit(unitID);
+
+		if (unit == nullptr)
+			continue;
+
+		selectedUnitsHandler.DeleteDeathDependence(unit, DEPENDENCE_SELECTED);
+		unit->isSelected = false;
+		selectedUnits.push_back(unit);
+	}
+
+	bool ret = false;
+
+	try {
+		std::stringstream oss;
+
+		SaveGameState(oss, true);
+
+		data = std::move(oss.str());
+		ret = true;
+	} catch (const content_error& ex) {
+		LOG_L(L_ERROR, "[LSH::%s] content error \"%s\"", __func__, ex.what());
+	} catch (const std::exception& ex) {
+		LOG_L(L_ERROR, "[LSH::%s] exception \"%s\"", __func__, ex.what());
+	} catch (...) {
+		LOG_L(L_ERROR, "[LSH::%s] unknown error", __func__);
+	}
+
+	for (CUnit* unit: selectedUnits) {
+		selectedUnitsHandler.AddDeathDependence(unit, DEPENDENCE_SELECTED);
+		unit->isSelected = true;
+	}
+
+	return ret;
+#else //USING_CREG
+	return false;
+#endif //USING_CREG
+}
+
 /// loads the data (map&mod-name,setup-script) needed by PreGame
 bool CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 {
 	CGZFileHandler saveFile(dataDirsAccess.LocateFile(FindSaveFile(path)), SPRING_VFS_RAW_FIRST);
 
 	std::stringbuf* sbuf = iss.rdbuf();
-	std::string saveVersion;
-	std::string syncVersion = SpringVersion::GetSync();
 
 	char buf[4096];
 	int len;
 	while ((len = saveFile.Read(buf, sizeof(buf))) > 0)
 		sbuf->sputn(buf, len);
 
+	const bool ret = ReadGameStartInfo(path);
+
+	CGameSetup::LoadSavedScript(path, scriptText);
+	return ret;
+}
+
+/// like LoadGameStartInfo, for a snapshot embedded in a demo (which provides the setup-script)
+bool CCregLoadSaveHandler::LoadSnapshotStartInfo(const std::string& name, const std::string& data)
+{
+	iss.rdbuf()->sputn(data.data(), data.size());
+
+	return (ReadGameStartInfo(name));
+}
+
+bool CCregLoadSaveHandler::ReadGameStartInfo(const std::string& path)
+{
+	std::string saveVersion;
+	std::string syncVersion = SpringVersion::GetSync();
+
 	ReadString(iss, saveVersion);
 
 	// check saved engine version against current build
@@ -359,7 +437,6 @@ bool CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 	ReadString(iss, modName);
 	ReadString(iss, mapName);
 
-	CGameSetup::LoadSavedScript(path, scriptText);
 	return (saveVersion == syncVersion);
 }
 
@@ -18,6 +18,13 @@ public:
 	void LoadAIData() override;
 	void SaveGame(const std::string& path) override;
 
+	bool SaveSnapshot(std::string& data);
+	bool LoadSnapshotStartInfo(const std::string& name, const std::string& data);
+
+protected:
+	void SaveGameState(std::stringstream& oss, bool snapshot);
+	bool ReadGameStartInfo(const std::string& path);
+
 protected:
 	std::stringstream iss;
 };
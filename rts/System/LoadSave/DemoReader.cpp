@@ -15,13 +15,22 @@ CONFIG(bool, DisableDemoVersionCheck).defaultValue(false).description("Allow to
 #include "System/Log/ILog.h"
 #include "System/Net/RawPacket.h"
 
+#include <zlib.h>
+
+#include <algorithm>
 #include <array>
 #include <climits>
+#include <cstddef>
 #include <stdexcept>
 #include <cassert>
 #include <cstring>
 
 
+// size of the (minor version) header before the snapshot fields were added
+static constexpr size_t DEMOFILE_HEADER_SIZE_NO_SNAPSHOTS = offsetof(DemoFileHeader, numSnapshots);
+// magic, version and headerSize are common to all minor versions
+static constexpr size_t DEMOFILE_HEADER_SIZE_PREFIX = offsetof(DemoFileHeader, headerSize) + sizeof(int);
+
 static bool CheckDemoHeader(const DemoFileHeader& fileHeader)
 {
 	if (memcmp(fileHeader.magic, DEMOFILE_MAGIC, sizeof(fileHeader.magic)) != 0)
@@ -30,7 +39,10 @@ static bool CheckDemoHeader(const DemoFileHeader& fileHeader)
 	if (fileHeader.version != DEMOFILE_VERSION)
 		return false;
 
-	if (fileHeader.headerSize != sizeof(DemoFileHeader))
+	// older minor versions lack the fields at the end of the header
+	if (fileHeader.headerSize < int(DEMOFILE_HEADER_SIZE_NO_SNAPSHOTS))
+		return false;
+	if (fileHeader.headerSize > int(sizeof(DemoFileHeader)))
 		return false;
 
 	if (fileHeader.playerStatElemSize != sizeof(PlayerStatistics))
@@ -58,8 +70,24 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 	if (!playbackDemo->FileExists())
 		throw user_error("Demofile not found: " + filename);
 
-	playbackDemo->Read((char*)&fileHeader, sizeof(fileHeader));
-	fileHeader.swab();
+	{
+		// read only as much as this minor version of the header contains,
+		// fields it does not have (e.g. the snapshot sizes) remain zero
+		memset(&fileHeader, 0, sizeof(fileHeader));
+		playbackDemo->Read((char*)&fileHeader, DEMOFILE_HEADER_SIZE_PREFIX);
+
+		int headerSize = fileHeader.headerSize;
+		swabDWordInPlace(headerSize);
+
+		const int readSize = std::min(std::max(headerSize, int(DEMOFILE_HEADER_SIZE_PREFIX)), int(sizeof(fileHeader)));
+
+		playbackDemo->Read(reinterpret_cast<char*>(&fileHeader) + DEMOFILE_HEADER_SIZE_PREFIX, readSize - DEMOFILE_HEADER_SIZE_PREFIX);
+		fileHeader.swab();
+
+		// newer header (only accepted with DisableDemoVersionCheck), skip what we do not know
+		if (fileHeader.headerSize > readSize)
+			playbackDemo->Seek(fileHeader.headerSize);
+	}
 
 	if (!CheckDemoHeader(fileHeader)) {
 			char buf[1024];
@@ -100,6 +128,8 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 		bytesRemaining = playbackDemoSize - curPos;
 	}
 	playbackDemo->Seek(curPos);
+
+	LoadSnapshotIndex();
 }
 
 
@@ -125,6 +155,7 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 			return nullptr;
 		}
 		bytesRemaining -= chunkHeader.length;
+		streamOffset += (sizeof(chunkHeader) + chunkHeader.length);
 
 		if (!ReachedEnd()) {
 			// read next chunk header
@@ -153,6 +184,86 @@ bool CDemoReader::ReachedEnd()
 }
 
 
+void CDemoReader::LoadSnapshotIndex()
+{
+	// the index follows the stats, which are missing if Spring crashed
+	if (fileHeader.demoStreamSize == 0 || fileHeader.numSnapshots <= 0)
+		return;
+	// demos recorded before snapshots existed have a shorter header
+	if (fileHeader.headerSize < int(sizeof(DemoFileHeader)))
+		return;
+	if (fileHeader.snapshotIndexSize != int(fileHeader.numSnapshots * sizeof(DemoSnapshotEntry)))
+		return;
+
+	const int curPos = playbackDemo->GetPos();
+	const int idxPos = fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize + fileHeader.winningAllyTeamsSize + fileHeader.playerStatSize + fileHeader.teamStatSize;
+
+	playbackDemo->Seek(idxPos);
+	snapshots.resize(fileHeader.numSnapshots);
+
+	if (playbackDemo->Read(reinterpret_cast<char*>(snapshots.data()), fileHeader.snapshotIndexSize) < fileHeader.snapshotIndexSize) {
+		LOG_L(L_WARNING, "[DemoReader::%s] truncated snapshot index", __func__);
+		snapshots.clear();
+	}
+
+	for (DemoSnapshotEntry& entry: snapshots) {
+		entry.swab();
+
+		if ((entry.streamOffset > unsigned(fileHeader.demoStreamSize)) || ((entry.dataOffset + entry.dataSize) > unsigned(fileHeader.snapshotDataSize))) {
+			LOG_L(L_WARNING, "[DemoReader::%s] invalid snapshot index entry for frame %d", __func__, entry.frameNum);
+			snapshots.clear();
+			break;
+		}
+	}
+
+	playbackDemo->Seek(curPos);
+}
+
+int CDemoReader::FindSnapshot(int minFrameNum, int maxFrameNum) const
+{
+	// entries are ordered by frame
+	for (int i = int(snapshots.size()) - 1; i >= 0; i--) {
+		if (snapshots[i].frameNum > maxFrameNum)
+			continue;
+
+		return ((snapshots[i].frameNum > minFrameNum)? i: -1);
+	}
+
+	return -1;
+}
+
+bool CDemoReader::ReadSnapshot(int snapshotNum, std::string& data)
+{
+	if (snapshotNum < 0 || snapshotNum >= int(snapshots.size()))
+		return false;
+
+	const DemoSnapshotEntry& entry = snapshots[snapshotNum];
+
+	const int curPos = playbackDemo->GetPos();
+	const int dataPos = fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize + fileHeader.winningAllyTeamsSize + fileHeader.playerStatSize + fileHeader.teamStatSize + fileHeader.snapshotIndexSize;
+
+	std::vector<Bytef> packedData(entry.dataSize);
+
+	playbackDemo->Seek(dataPos + entry.dataOffset);
+	const bool haveData = (playbackDemo->Read(reinterpret_cast<char*>(packedData.data()), entry.dataSize) == int(entry.dataSize));
+	playbackDemo->Seek(curPos);
+
+	if (!haveData)
+		return false;
+
+	uLongf rawSize = entry.rawSize;
+	data.resize(rawSize);
+
+	if (uncompress(reinterpret_cast<Bytef*>(&data[0]), &rawSize, packedData.data(), packedData.size()) != Z_OK || rawSize != entry.rawSize) {
+		LOG_L(L_WARNING, "[DemoReader::%s] corrupt snapshot for frame %d", __func__, entry.frameNum);
+		data.clear();
+		return false;
+	}
+
+	return true;
+}
+
+
 void CDemoReader::LoadStats()
 {
 	// Stats are not available if Spring crashed while writing the demo.
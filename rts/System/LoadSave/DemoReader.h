@@ -39,6 +39,9 @@ public:
 	*/
 	bool ReachedEnd();
 
+	/// @return offset into the demo stream of the next chunk GetData will return
+	unsigned int GetStreamOffset() const { return streamOffset; }
+
 	float GetModGameTime() const { return chunkHeader.modGameTime; }
 	float GetDemoTimeOffset() const { return demoTimeOffset; }
 	float GetNextDemoReadTime() const { return nextDemoReadTime; }
@@ -55,6 +58,18 @@ public:
 	/// Not needed for normal demo watching
 	void LoadStats();
 
+	const std::vector<DemoSnapshotEntry>& GetSnapshots() const { return snapshots; }
+	/**
+	@brief find the latest snapshot taken after a frame in (minFrameNum, maxFrameNum]
+	@return index into GetSnapshots() or -1 if there is none
+	*/
+	int FindSnapshot(int minFrameNum, int maxFrameNum) const;
+	/// decompress a snapshot; the result can be loaded like a creg savegame
+	bool ReadSnapshot(int snapshotNum, std::string& data);
+
+private:
+	void LoadSnapshotIndex();
+
 private:
 	CFileHandler* playbackDemo;
 
@@ -62,6 +77,7 @@ private:
 	float nextDemoReadTime;
 	int bytesRemaining;
 	int playbackDemoSize;
+	unsigned int streamOffset = 0;
 
 	DemoStreamChunkHeader chunkHeader;
 
@@ -70,6 +86,8 @@ private:
 	std::vector<PlayerStatistics> playerStats; // one stat per player
 	std::vector< std::vector<TeamStatistics> > teamStats; // many stats per team
 	std::vector<unsigned char> winningAllyTeams;
+
+	std::vector<DemoSnapshotEntry> snapshots;
 };
 
 #endif
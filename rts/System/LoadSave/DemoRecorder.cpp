@@ -1,5 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cerrno>
 #include <cstring>
@@ -7,6 +9,7 @@
 
 #include "DemoRecorder.h"
 #include "Game/GameVersion.h"
+#include "Net/Protocol/BaseNetProtocol.h"
 #include "Sim/Misc/TeamStatistics.h"
 #include "System/TimeUtil.h"
 #include "System/StringUtil.h"
@@ -45,12 +48,17 @@ CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modN
 
 CDemoRecorder::~CDemoRecorder()
 {
-	if (file == nullptr)
+	if (file == nullptr) {
+		if (snapshotFile != nullptr)
+			fclose(snapshotFile);
+
 		return;
+	}
 
 	WriteWinnerList();
 	WritePlayerStats();
 	WriteTeamStats();
+	WriteSnapshots();
 	WriteFileHeader(true);
 	WriteDemoFile();
 }
@@ -83,24 +91,42 @@ void CDemoRecorder::WriteDemoFile()
 	// functions use stdio library routines, and most of zlib's functions use the library memory
 	// allocation routines by default" (so code below should be OK)
 	// gz* should usually be finished before ctor runs again when reloading, but take no chances
+	// the snapshot data follows the stream, index and stats and is appended from its spool-file
 	std::string& data = demoStreams[isServerDemo];
-	std::function<void(gzFile, std::string&)> func = [](gzFile file, std::string& data) {
+	std::function<void(gzFile, std::string&, FILE*, size_t)> func = [](gzFile file, std::string& data, FILE* snapshotFile, size_t snapshotDataSize) {
 		std::lock_guard<spring::mutex> lock(demoMutex);
 
 		gzwrite(file, data.c_str(), data.size());
+
+		if (snapshotFile != nullptr) {
+			std::array<char, 64 * 1024> buf;
+			size_t len = 0;
+
+			rewind(snapshotFile);
+
+			while (snapshotDataSize > 0 && (len = fread(buf.data(), 1, std::min(buf.size(), snapshotDataSize), snapshotFile)) > 0) {
+				gzwrite(file, buf.data(), len);
+				snapshotDataSize -= len;
+			}
+
+			fclose(snapshotFile);
+		}
+
 		gzflush(file, Z_FINISH);
 		gzclose(file);
 	};
 
-	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), data.size());
+	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), data.size() + snapshotDataSize);
 
 	#ifndef _WIN32
 	// NOTE: can not use ThreadPool for this directly here, workers are already gone
 	// FIXME: does not currently (august 2017) compile on Windows mingw buildbots
-	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data)));
+	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data), snapshotFile, snapshotDataSize));
 	#else
-	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data))));
+	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data), snapshotFile, snapshotDataSize)));
 	#endif
+
+	snapshotFile = nullptr;
 }
 
 void CDemoRecorder::WriteSetupText(const std::string& text)
@@ -129,6 +155,75 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
 	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
+
+	if (length == 0 || (buf[0] != NETMSG_NEWFRAME && buf[0] != NETMSG_KEYFRAME))
+		return;
+
+	// frames are recorded before they are simulated, remember where
+	// the stream continues so a snapshot taken afterwards can refer
+	// to it; several frames can be buffered before they are simulated
+	if (snapshotInterval <= 0 || (++numFrames % snapshotInterval) != 0)
+		return;
+
+	DemoSnapshotEntry entry;
+	entry.frameNum = numFrames;
+	entry.modGameTime = modGameTime;
+	entry.streamOffset = fileHeader.demoStreamSize;
+	entry.dataOffset = 0;
+	entry.dataSize = 0;
+	entry.rawSize = 0;
+
+	pendingSnapshots.push_back(entry);
+}
+
+
+bool CDemoRecorder::WantSnapshot(int frameNum)
+{
+	// frames are simulated in order, so pending entries for earlier
+	// frames will never get their snapshot (e.g. if taking it failed)
+	while (!pendingSnapshots.empty() && pendingSnapshots.front().frameNum < frameNum)
+		pendingSnapshots.pop_front();
+
+	return (!pendingSnapshots.empty() && pendingSnapshots.front().frameNum == frameNum);
+}
+
+void CDemoRecorder::SaveSnapshot(int frameNum, const std::string& data)
+{
+	if (!WantSnapshot(frameNum) || data.empty())
+		return;
+
+	DemoSnapshotEntry entry = pendingSnapshots.front();
+	pendingSnapshots.pop_front();
+
+	if (snapshotFile == nullptr && (snapshotFile = tmpfile()) == nullptr) {
+		LOG_L(L_WARNING, "[DemoRecorder::%s] failed to create spool-file for snapshots (%s)", __func__, strerror(errno));
+		return;
+	}
+
+	// compress snapshots individually (and quickly) so they can be read
+	// back one at a time without inflating the whole demo
+	uLongf packedSize = compressBound(data.size());
+	std::vector<Bytef> packedData(packedSize);
+
+	if (compress2(packedData.data(), &packedSize, reinterpret_cast<const Bytef*>(data.data()), data.size(), Z_BEST_SPEED) != Z_OK) {
+		LOG_L(L_WARNING, "[DemoRecorder::%s] failed to compress snapshot for frame %d", __func__, frameNum);
+		return;
+	}
+
+	if (fwrite(packedData.data(), 1, packedSize, snapshotFile) != packedSize) {
+		LOG_L(L_WARNING, "[DemoRecorder::%s] failed to spool snapshot for frame %d (%s)", __func__, frameNum, strerror(errno));
+
+		// rewind to the end of the last complete snapshot
+		fseek(snapshotFile, snapshotDataSize, SEEK_SET);
+		return;
+	}
+
+	entry.dataOffset = snapshotDataSize;
+	entry.dataSize = packedSize;
+	entry.rawSize = data.size();
+
+	snapshotIndex.push_back(entry);
+	snapshotDataSize += packedSize;
 }
 
 void CDemoRecorder::SetName(const std::string& mapName, const std::string& modName)
@@ -307,3 +402,22 @@ void CDemoRecorder::WriteTeamStats()
 
 	teamStats.clear();
 }
+
+/** @brief Write the snapshot index at the current position in the file. */
+void CDemoRecorder::WriteSnapshots()
+{
+	const size_t pos = demoStreams[isServerDemo].size();
+
+	for (DemoSnapshotEntry& entry: snapshotIndex) {
+		entry.swab();
+		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&entry), sizeof(DemoSnapshotEntry));
+	}
+
+	fileHeader.numSnapshots = snapshotIndex.size();
+	fileHeader.snapshotIndexSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.snapshotDataSize = snapshotDataSize;
+
+	// the data itself is copied from the spool-file by WriteDemoFile
+	snapshotIndex.clear();
+	pendingSnapshots.clear();
+}
@@ -3,6 +3,8 @@
 #ifndef DEMO_RECORDER
 #define DEMO_RECORDER
 
+#include <cstdio>
+#include <deque>
 #include <vector>
 #include <sstream>
 #include <zlib.h>
@@ -38,6 +40,13 @@ public:
 		std::swap(playerStats, r.playerStats);
 		std::swap(teamStats, r.teamStats);
 		std::swap(winningAllyTeams, r.winningAllyTeams);
+		std::swap(snapshotIndex, r.snapshotIndex);
+		std::swap(pendingSnapshots, r.pendingSnapshots);
+		std::swap(snapshotFile, r.snapshotFile);
+		std::swap(snapshotDataSize, r.snapshotDataSize);
+
+		std::swap(snapshotInterval, r.snapshotInterval);
+		std::swap(numFrames, r.numFrames);
 
 		std::swap(isServerDemo, r.isServerDemo);
 		return *this;
@@ -62,12 +71,22 @@ public:
 	void SetTeamStats(int teamNum, const std::vector<TeamStatistics>& stats);
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
+	/// take a game-state snapshot every <frames> sim-frames, 0 disables snapshots
+	void SetSnapshotInterval(int frames) { snapshotInterval = frames; }
+	/**
+	 * @return true if a snapshot of the state after <frameNum> should be passed to SaveSnapshot
+	 * NOTE: called once per sim-frame, forgets pending snapshots of earlier frames
+	 */
+	bool WantSnapshot(int frameNum);
+	void SaveSnapshot(int frameNum, const std::string& data);
+
 private:
 	unsigned int WriteFileHeader(bool updateStreamLength);
 	void SetFileHeader();
 	void WritePlayerStats();
 	void WriteTeamStats();
 	void WriteWinnerList();
+	void WriteSnapshots();
 	void WriteDemoFile();
 
 private:
@@ -77,6 +96,18 @@ private:
 	std::vector< std::vector<TeamStatistics> > teamStats;
 	std::vector<unsigned char> winningAllyTeams;
 
+	std::vector<DemoSnapshotEntry> snapshotIndex;
+	// frames already recorded but not yet simulated, which want a snapshot
+	std::deque<DemoSnapshotEntry> pendingSnapshots;
+
+	// compressed snapshots are spooled to a temporary file rather than being
+	// kept in memory until the demo is written, they can be large and many
+	FILE* snapshotFile = nullptr;
+	size_t snapshotDataSize = 0;
+
+	int snapshotInterval = 0;
+	int numFrames = 0;
+
 	bool isServerDemo = false;
 };
 
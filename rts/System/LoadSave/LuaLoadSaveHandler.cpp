@@ -241,6 +241,7 @@ void CLuaLoadSaveHandler::LoadHeightmap()
 			readMap->SetHeight(i, newHeight);
 		}
 		mapDamage->RecalcArea(0, mapDims.mapx, 0, mapDims.mapy);
+		mapDamage->FlushRecalcAreas();
 	} else {
 		LOG_L(L_ERROR, "Unable to load heightmap from save file \"%s\"", filename.c_str());
 	}
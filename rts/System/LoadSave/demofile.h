@@ -40,15 +40,23 @@
  *         CTeam::Statistics for each team.
  *       - Array of all CTeam::Statistics (total number of items is the
  *         sum of the elements in the array of dwords).
+ *     - Snapshot index, one DemoSnapshotEntry for each snapshot
+ *     - Snapshot data (snapshotDataSize), zlib-compressed creg game-states
+ *       in the same format as the contents of a .ssf savegame
  *
  * The header is designed to be extensible: it contains a version field and a
  * headerSize field to support this. The version field is a major version number
  * of the file format, if this changes, anything may have changed in the file.
  * It is not supposed to change often (if at all). The headerSize field is a
  * minor version number, which happens to be equal to sizeof(DemoFileHeader).
+ * Readers accept shorter headers of older minor versions and treat the fields
+ * those lack as zero.
  *
  * If Spring did not cleanup properly (crashed), the demoStreamSize is 0 and it
  * can be assumed the demo stream continues until the end of the file.
+ *
+ * Snapshots are optional (see DemoSnapshotInterval) and only written by
+ * clients that simulate the game, never by a (dedicated) server.
  */
 struct DemoFileHeader
 {
@@ -70,6 +78,9 @@ struct DemoFileHeader
 	int teamStatElemSize;         ///< sizeof(CTeam::Statistics)
 	int teamStatPeriod;           ///< Interval (in seconds) between team stats.
 	int winningAllyTeamsSize;     ///< The size of the vector of the winning ally teams
+	int numSnapshots;             ///< Number of game-state snapshots.
+	int snapshotIndexSize;        ///< Size of the snapshot index chunk.
+	int snapshotDataSize;         ///< Size of the snapshot data chunk.
 
 
 	/// Change structure from host endian to little endian or vice versa.
@@ -89,6 +100,9 @@ struct DemoFileHeader
 		swabDWordInPlace(teamStatElemSize);
 		swabDWordInPlace(teamStatPeriod);
 		swabDWordInPlace(winningAllyTeamsSize);
+		swabDWordInPlace(numSnapshots);
+		swabDWordInPlace(snapshotIndexSize);
+		swabDWordInPlace(snapshotDataSize);
 	}
 };
 
@@ -115,6 +129,34 @@ struct DemoStreamChunkHeader
 	}
 };
 
+/**
+ * @brief Spring demo snapshot index entry
+ *
+ * Each snapshot holds the game-state after sim-frame frameNum; playback can
+ * resume from it by loading the snapshot and continuing to read the demo
+ * stream at streamOffset (the chunk following the NETMSG_NEWFRAME of that
+ * frame) instead of simulating all preceding frames.
+ */
+struct DemoSnapshotEntry
+{
+	std::int32_t frameNum;      ///< Sim-frame after which the snapshot was taken.
+	float modGameTime;          ///< Gametime of the chunk containing that frame.
+	std::uint32_t streamOffset; ///< Offset into the demo stream at which to resume reading.
+	std::uint32_t dataOffset;   ///< Offset of the snapshot into the snapshot data chunk.
+	std::uint32_t dataSize;     ///< Compressed size of the snapshot.
+	std::uint32_t rawSize;      ///< Uncompressed size of the snapshot.
+
+	/// Change structure from host endian to little endian or vice versa.
+	void swab() {
+		swabDWordInPlace(frameNum);
+		swabFloatInPlace(modGameTime);
+		swabDWordInPlace(streamOffset);
+		swabDWordInPlace(dataOffset);
+		swabDWordInPlace(dataSize);
+		swabDWordInPlace(rawSize);
+	}
+};
+
 #pragma pack(pop)
 
 #endif // DEMO_FILE_H
@@ -21,6 +21,8 @@
 		#include <sys/prctl.h>
 	#endif
 	#include <sched.h>
+	#include <sys/resource.h>
+	#include <sys/syscall.h>
 #endif
 
 #ifndef _WIN32
@@ -244,6 +246,25 @@ namespace Threading {
 	}
 
 
+	void SetThreadBackgroundPriority()
+	{
+	#if defined(__APPLE__) || defined(__FreeBSD__)
+		// no-op
+
+	#elif defined(_WIN32)
+		::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+	#else
+		// Linux applies nice-values per thread (not POSIX-conform)
+		// note that unprivileged threads can not raise it back up
+		const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+		if (setpriority(PRIO_PROCESS, tid, getpriority(PRIO_PROCESS, tid) + 5) != 0)
+			LOG_L(L_WARNING, "[Threading::%s] failed to lower priority of thread %d", __func__, int(tid));
+	#endif
+	}
+
+
 	NativeThreadHandle GetCurrentThread()
 	{
 	#ifdef _WIN32
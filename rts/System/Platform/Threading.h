@@ -129,6 +129,12 @@ namespace Threading {
 	 */
 	void SetThreadScheduler();
 
+	/**
+	 * Lower the OS priority of the calling thread, for threads running
+	 * background jobs that should not compete with the sim for cpu time
+	 */
+	void SetThreadBackgroundPriority();
+
 	/**
 	 * Used to detect the main-thread which runs SDL, GL, Input, Sim, ...
 	 */
@@ -17,6 +17,7 @@
 #include "System/Platform/CpuID.h"
 #include "System/Platform/Threading.h"
 #include "System/Threading/SpringThreading.h"
+#include "System/Threading/WorkStealingDeque.h"
 
 #ifdef   likely
 #undef   likely
@@ -25,7 +26,10 @@
 
 #include <utility>
 #include <functional>
+#include <algorithm>
 #include <cinttypes>
+#include <cstdio>
+#include <cstring>
 
 #define USE_TASK_STATS_TRACKING
 
@@ -62,8 +66,17 @@ struct ThreadStats {
 static std::vector< spring::thread > extThreads;
 static std::vector< std::future<void> > extFutures;
 
-bool ThreadPool::inMultiThreadedSection;
+std::atomic_int ThreadPool::numMultiThreadedSections = {0};
 
+// for_mt call-sites seen so far, registered on their first call
+static std::vector<ThreadPool::CallSiteStats*> callSiteStats;
+static spring::mutex callSiteMutex;
+
+// all containers below exist once per priority class, [false] holds the
+// latency-critical tasks (for_mt and parallel slices) which only run on the
+// regular workers and [true] the background AsyncTask's (disk IO, caching,
+// loading) which only run on the async workers at a lower OS priority
+//
 // global [idx = 0] and smaller per-thread [idx > 0] queues; the latter are
 // for tasks that want to execute on specific threads, e.g. parallel_reduce
 // note: std::shared_ptr<T> can not be made atomic, queues must store T*'s
@@ -73,12 +86,21 @@ static std::array<boost::lockfree::queue<ITaskGroup*>, ThreadPool::MAX_THREADS>
 static std::array<moodycamel::ConcurrentQueue<ITaskGroup*>, ThreadPool::MAX_THREADS> taskQueues[2];
 #endif
 
+// per-worker deques for unpinned tasks pushed by the workers themselves, e.g.
+// nested for_mt's; owners pop the most recent task while idle workers steal
+// the oldest (tasks pushed by the main or external threads go into queue 0)
+static std::array<WorkStealingDeque<ITaskGroup*, 256>, ThreadPool::MAX_THREADS> stealQueues[2];
+
 static std::vector<void*> workerThreads[2];
 static std::array<bool, ThreadPool::MAX_THREADS> exitFlags;
 static std::array<ThreadStats, ThreadPool::MAX_THREADS> threadStats[2];
 static spring::signal newTasksSignal[2];
 
 static _threadlocal int threadnum(0);
+// priority class of the worker running on this thread, -1 for non-workers
+static _threadlocal int threadclass(-1);
+// number of for_mt's this thread is (nested) inside of
+static _threadlocal int sectiondepth(0);
 
 #ifndef UNITSYNC
 // if enabled, allows OpenGL calls from ThreadPool tasks
@@ -98,6 +120,11 @@ namespace ThreadPool {
 
 int GetThreadNum() { return threadnum; }
 static void SetThreadNum(const int idx) { threadnum = idx; }
+static void SetThreadClass(const bool async) { threadclass = async; }
+
+// regular and async workers share thread numbers, so per-thread queues and
+// deques of a class may only be served (or owned) by a worker of that class
+static bool IsClassWorker(int tid, bool async) { return (tid != 0 && threadclass == int(async)); }
 
 static int GetConfigNumWorkers() {
 	#ifndef UNIT_TEST
@@ -132,6 +159,89 @@ int GetMaxThreads() { return std::min(MAX_THREADS, Threading::GetLogicalCpuCores
 bool HasThreads() { return !workerThreads[false].empty(); }
 
 
+int EnterMultiThreadedSection()
+{
+	numMultiThreadedSections.fetch_add(1, std::memory_order_relaxed);
+	// a worker only runs for_mt's from within some task
+	return ((sectiondepth++) + (threadclass >= 0));
+}
+
+void LeaveMultiThreadedSection()
+{
+	assert(sectiondepth > 0);
+	sectiondepth -= 1;
+	numMultiThreadedSections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+CallSiteStats::CallSiteStats(const char* file, int line)
+{
+	const char* fileName = file;
+
+	// strip the path, the file name is unique enough
+	for (const char* c = file; *c != 0; ++c) {
+		if (*c == '/' || *c == '\\')
+			fileName = c + 1;
+	}
+
+	snprintf(name, sizeof(name), "ThreadPool::for_mt::%s:%d", fileName, line);
+	nameHash = hashString(name);
+
+	#if (!defined(UNITSYNC) && !defined(UNIT_TEST))
+	CTimeProfiler::RegisterTimer(name);
+	#endif
+
+	std::lock_guard<spring::mutex> lock(callSiteMutex);
+	callSiteStats.push_back(this);
+}
+
+void UpdateCallSiteStats(CallSiteStats& stats, const ITaskGroup& taskGroup, const spring_time callTime, bool nested)
+{
+	const spring_time now = spring_now();
+
+	const uint64_t wallTime = (now - callTime).toNanoSecsi();
+	const uint64_t execTime = taskGroup.sliceSumTime.load(std::memory_order_relaxed);
+	// time all participating threads would have spent if each took as long as the slowest
+	const uint64_t spanTime = taskGroup.sliceMaxTime.load(std::memory_order_relaxed) * std::max(taskGroup.sliceThreads.load(std::memory_order_relaxed), 1);
+
+	stats.numCalls += 1;
+	stats.numNestedCalls += nested;
+	stats.sumExecTime += execTime;
+	stats.sumIdleTime += (spanTime - std::min(spanTime, execTime));
+	stats.sumWaitTime += (wallTime - std::min(wallTime, taskGroup.ownSliceTime));
+
+	#if (!defined(UNITSYNC) && !defined(UNIT_TEST))
+	CTimeProfiler::GetInstance().AddTime(stats.nameHash, callTime, now - callTime, false, false, false);
+	#endif
+}
+
+std::vector<const CallSiteStats*> GetCallSiteStats()
+{
+	std::lock_guard<spring::mutex> lock(callSiteMutex);
+	return {callSiteStats.begin(), callSiteStats.end()};
+}
+
+
+
+static void RunTask(ITaskGroup* tg, int tid, bool async)
+{
+	assert(!async || tg->IsAsyncTask());
+
+	#ifdef USE_TASK_STATS_TRACKING
+	const uint64_t wdt = tg->GetDeltaTime(spring_now());
+	const uint64_t edt = tg->ExecuteLoop(tid, false);
+
+	threadStats[async][tid].numTasksRun += 1;
+	threadStats[async][tid].sumExecTime += edt;
+	threadStats[async][tid].sumWaitTime += wdt;
+	threadStats[async][tid].minExecTime  = std::min(threadStats[async][tid].minExecTime, edt);
+	threadStats[async][tid].maxExecTime  = std::max(threadStats[async][tid].maxExecTime, edt);
+	threadStats[async][tid].minWaitTime  = std::min(threadStats[async][tid].minWaitTime, wdt);
+	threadStats[async][tid].maxWaitTime  = std::max(threadStats[async][tid].maxWaitTime, wdt);
+	#else
+	tg->ExecuteLoop(tid, false);
+	#endif
+}
 
 static bool DoTask(int tid, bool async)
 {
@@ -141,67 +251,67 @@ static bool DoTask(int tid, bool async)
 
 	ITaskGroup* tg = nullptr;
 
-	// any external thread calling WaitForFinished will have
-	// id=0 and *only* processes tasks from the global queue
-	for (int idx = 0; idx <= tid; idx += std::max(tid, 1)) {
-		auto& queue = taskQueues[async][idx];
+	bool haveTask = false;
+	const bool ownQueues = IsClassWorker(tid, async);
 
+	// tasks pinned to this thread first, then the ones it pushed itself (most
+	// recent first) while those are still hot in its cache
+	// any external thread calling WaitForFinished will have id=0 and *only*
+	// processes tasks from the global queue
+	if (ownQueues) {
 		#ifdef USE_BOOST_LOCKFREE_QUEUE
-		if (queue.pop(tg)) {
+		while (taskQueues[async][tid].pop(tg)) {
 		#else
-		if (queue.try_dequeue(tg)) {
+		while (taskQueues[async][tid].try_dequeue(tg)) {
 		#endif
-			// inform other workers when there is global work to do
-			// waking is an expensive kernel-syscall, so better shift this
-			// cost to the workers too (the main thread only wakes when ALL
-			// workers are sleeping)
-			if (idx == 0)
-				NotifyWorkerThreads(true, async);
-
-			assert(!async || tg->IsAsyncTask());
-
-			#ifdef USE_TASK_STATS_TRACKING
-			const uint64_t wdt = tg->GetDeltaTime(spring_now());
-			const uint64_t edt = tg->ExecuteLoop(tid, false);
-
-			threadStats[async][tid].numTasksRun += 1;
-			threadStats[async][tid].sumExecTime += edt;
-			threadStats[async][tid].sumWaitTime += wdt;
-			threadStats[async][tid].minExecTime  = std::min(threadStats[async][tid].minExecTime, edt);
-			threadStats[async][tid].maxExecTime  = std::max(threadStats[async][tid].maxExecTime, edt);
-			threadStats[async][tid].minWaitTime  = std::min(threadStats[async][tid].minWaitTime, wdt);
-			threadStats[async][tid].maxWaitTime  = std::max(threadStats[async][tid].maxWaitTime, wdt);
-			#else
-			tg->ExecuteLoop(tid, false);
-			#endif
+			RunTask(tg, tid, async);
+			haveTask = true;
 		}
 
+		while (stealQueues[async][tid].Pop(tg)) {
+			RunTask(tg, tid, async);
+			haveTask = true;
+		}
+	}
+
+	#ifdef USE_BOOST_LOCKFREE_QUEUE
+	if (taskQueues[async][0].pop(tg)) {
+	#else
+	if (taskQueues[async][0].try_dequeue(tg)) {
+	#endif
+		// inform other workers when there is global work to do
+		// waking is an expensive kernel-syscall, so better shift this
+		// cost to the workers too (the main thread only wakes when ALL
+		// workers are sleeping)
+		NotifyWorkerThreads(true, async);
+
+		do {
+			RunTask(tg, tid, async);
 		#ifdef USE_BOOST_LOCKFREE_QUEUE
-		while (queue.pop(tg)) {
+		} while (taskQueues[async][0].pop(tg));
 		#else
-		while (queue.try_dequeue(tg)) {
+		} while (taskQueues[async][0].try_dequeue(tg));
 		#endif
-			assert(!async || tg->IsAsyncTask());
-
-			#ifdef USE_TASK_STATS_TRACKING
-			const uint64_t wdt = tg->GetDeltaTime(spring_now());
-			const uint64_t edt = tg->ExecuteLoop(tid, false);
-
-			threadStats[async][tid].numTasksRun += 1;
-			threadStats[async][tid].sumExecTime += edt;
-			threadStats[async][tid].sumWaitTime += wdt;
-			threadStats[async][tid].minExecTime  = std::min(threadStats[async][tid].minExecTime, edt);
-			threadStats[async][tid].maxExecTime  = std::max(threadStats[async][tid].maxExecTime, edt);
-			threadStats[async][tid].minWaitTime  = std::min(threadStats[async][tid].minWaitTime, wdt);
-			threadStats[async][tid].maxWaitTime  = std::max(threadStats[async][tid].maxWaitTime, wdt);
-			#else
-			tg->ExecuteLoop(tid, false);
-			#endif
-		}
+
+		haveTask = true;
+	}
+
+	if (haveTask || !ownQueues)
+		return haveTask;
+
+	// out of work, steal the oldest task of another worker before going to sleep
+	// start at the next one to spread thieves over the victims
+	for (int i = 1, n = GetNumThreads(); i < n; ++i) {
+		const int victim = 1 + ((tid - 1 + i) % (n - 1));
+
+		if (!stealQueues[async][victim].Steal(tg))
+			continue;
+
+		RunTask(tg, tid, async);
+		return true;
 	}
 
-	// if true, queue contained at least one element
-	return (tg != nullptr);
+	return false;
 }
 
 
@@ -210,10 +320,15 @@ static void WorkerLoop(int tid, bool async)
 {
 	assert(tid != 0);
 	SetThreadNum(tid);
+	SetThreadClass(async);
 	#ifndef UNIT_TEST
-	Threading::SetThreadName(IntToString(tid, "worker%i"));
+	Threading::SetThreadName(IntToString(tid, async? "asyncworker%i": "worker%i"));
 	#endif
 
+	// background tasks should never take cpu time from the sim-critical ones
+	if (async)
+		Threading::SetThreadBackgroundPriority();
+
 	// make first worker spin a while before sleeping/waiting on the thread signal
 	// this increases the chance that at least one worker is awake when a new task
 	// is inserted, which can then take over the job of waking up sleeping workers
@@ -265,7 +380,7 @@ void WaitForFinished(std::shared_ptr<ITaskGroup>&& taskGroup)
 			DoTask(tid, false);
 		}
 
-		taskGroup->ResetState(false, taskGroup->IsInTaskPool(), false);
+		taskGroup->ResetState(false, taskGroup->IsInTaskPool(), taskGroup->IsInPoolUse());
 		return;
 	}
 
@@ -290,7 +405,7 @@ void WaitForFinished(std::shared_ptr<ITaskGroup>&& taskGroup)
 		DoTask(tid, false);
 	}
 
-	taskGroup->ResetState(false, taskGroup->IsInTaskPool(), false);
+	taskGroup->ResetState(false, taskGroup->IsInTaskPool(), taskGroup->IsInPoolUse());
 }
 
 
@@ -301,7 +416,10 @@ void WaitForFinished(std::shared_ptr<ITaskGroup>&& taskGroup)
 void PushTaskGroup(std::shared_ptr<ITaskGroup>&& taskGroup) { PushTaskGroup(taskGroup.get()); }
 void PushTaskGroup(ITaskGroup* taskGroup)
 {
-	auto& queue = taskQueues[ taskGroup->IsAsyncTask() ][ taskGroup->WantedThread() ];
+	const bool async = taskGroup->IsAsyncTask();
+	const int tid = GetThreadNum();
+
+	auto& queue = taskQueues[async][ taskGroup->WantedThread() ];
 
 	#if 0
 	// fake single-task group, handled by WaitForFinished to
@@ -312,11 +430,17 @@ void PushTaskGroup(ITaskGroup* taskGroup)
 
 	taskGroup->SetTimeStamp(spring_now());
 
-	#ifdef USE_BOOST_LOCKFREE_QUEUE
-	while (!queue.push(taskGroup));
-	#else
-	while (!queue.enqueue(taskGroup));
-	#endif
+	// unpinned tasks pushed by a worker stay local (and can be stolen) unless
+	// its deque is full; everything else goes to the global or pinned queues
+	const bool pushLocal = (taskGroup->WantedThread() == 0 && IsClassWorker(tid, async));
+
+	if (!pushLocal || !stealQueues[async][tid].Push(taskGroup)) {
+		#ifdef USE_BOOST_LOCKFREE_QUEUE
+		while (!queue.push(taskGroup));
+		#else
+		while (!queue.enqueue(taskGroup));
+		#endif
+	}
 
 	#if 1
 	// AsyncTask's do not care about wakeup-latency as much
@@ -411,6 +535,15 @@ static void KillThreads(int wantedNumThreads, int curNumThreads)
 		while (taskQueues[false][i].try_dequeue(tg));
 		while (taskQueues[ true][i].try_dequeue(tg));
 		#endif
+
+		// owners are gone, drain from the thief end; dropped
+		// slice copies must not keep their group from reuse
+		while (stealQueues[false][i].Steal(tg)) {
+			if (tg->IsSliceTask())
+				tg->queuedSlices.fetch_sub(1, std::memory_order_release);
+		}
+
+		while (stealQueues[ true][i].Steal(tg));
 	}
 
 	assert((wantedNumThreads != 0) || workerThreads[false].empty());
@@ -463,6 +596,7 @@ void SetThreadCount(int wantedNumThreads)
 		"[ThreadPool::%s][2] workers=%u",
 		"\t[async=%d] threads=%d tasks=%" PRIu64 " {sum,avg}{exec,wait}time={{%.3f, %.3f}, {%.3f, %.3f}}ms",
 		"\t\tthread=%d tasks=%" PRIu64 " {sum,min,max,avg}{exec,wait}time={{%.3f, %.3f, %.3f, %.3f}, {%.3f, %.3f, %.3f, %.3f}}ms",
+		"\t[%s] calls=%" PRIu64 " {nested,serial}={%" PRIu64 ", %" PRIu64 "} {sum,avg}{exec,wait}time={{%.3f, %.3f}, {%.3f, %.3f}}ms imbalance=%.1f%%",
 	};
 
 	// total number of tasks executed by pool; total time spent in DoTask
@@ -492,6 +626,17 @@ void SetThreadCount(int wantedNumThreads)
 				threadStats[async][i].maxWaitTime = std::numeric_limits<uint64_t>::min();
 			}
 		}
+
+		std::lock_guard<spring::mutex> lock(callSiteMutex);
+
+		for (CallSiteStats* css: callSiteStats) {
+			css->numCalls = 0;
+			css->numNestedCalls = 0;
+			css->numSerialCalls = 0;
+			css->sumExecTime = 0;
+			css->sumIdleTime = 0;
+			css->sumWaitTime = 0;
+		}
 		#endif
 	}
 
@@ -557,6 +702,30 @@ void SetThreadCount(int wantedNumThreads)
 				LOG(fmts[3], i, ts.numTasksRun,  tSumExecTime, tMinExecTime, tMaxExecTime, tAvgExecTime,  tSumWaitTime, tMinWaitTime, tMaxWaitTime, tAvgWaitTime);
 			}
 		}
+
+		std::vector<const CallSiteStats*> sortedStats = GetCallSiteStats();
+
+		// most expensive call-sites first
+		std::sort(sortedStats.begin(), sortedStats.end(), [](const CallSiteStats* a, const CallSiteStats* b) {
+			return (a->sumExecTime > b->sumExecTime);
+		});
+
+		for (const CallSiteStats* css: sortedStats) {
+			const uint64_t numCalls = css->numCalls;
+
+			if (numCalls == 0)
+				continue;
+
+			const float cSumExecTime = css->sumExecTime * 1e-6f; // ms
+			const float cSumWaitTime = css->sumWaitTime * 1e-6f; // ms
+			const float cSumIdleTime = css->sumIdleTime * 1e-6f; // ms
+			const float cAvgExecTime = cSumExecTime / numCalls;
+			const float cAvgWaitTime = cSumWaitTime / numCalls;
+			// share of the participating threads' time spent idle behind the slowest one
+			const float cImbalance = (cSumIdleTime * 100.0f) / std::max(cSumExecTime + cSumIdleTime, 1e-6f);
+
+			LOG(fmts[4], css->name, numCalls, uint64_t(css->numNestedCalls), uint64_t(css->numSerialCalls),  cSumExecTime, cAvgExecTime,  cSumWaitTime, cAvgWaitTime,  cImbalance);
+		}
 	}
 	#endif
 
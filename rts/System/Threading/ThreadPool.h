@@ -109,7 +109,32 @@ namespace ThreadPool {
 	int GetNumThreads();
 	void NotifyWorkerThreads(bool force, bool async);
 
-	extern bool inMultiThreadedSection;
+	// for_mt timings aggregated per call-site (i.e. per loop-body lambda type)
+	struct CallSiteStats {
+		CallSiteStats(const char* file, int line);
+
+		char name[64];
+		unsigned nameHash;
+
+		std::atomic<uint64_t> numCalls = {0};
+		std::atomic<uint64_t> numNestedCalls = {0}; // made from inside another for_mt
+		std::atomic<uint64_t> numSerialCalls = {0}; // every pooled group was held by an enclosing call
+		std::atomic<uint64_t> sumExecTime = {0}; // ns spent running slices, summed over all threads
+		std::atomic<uint64_t> sumIdleTime = {0}; // ns participating threads were done before the slowest one
+		std::atomic<uint64_t> sumWaitTime = {0}; // ns the caller waited on other threads after running out of slices
+	};
+
+	void UpdateCallSiteStats(CallSiteStats& stats, const ITaskGroup& taskGroup, const spring_time callTime, bool nested);
+	std::vector<const CallSiteStats*> GetCallSiteStats();
+
+	// number of for_mt's in progress, on any thread
+	extern std::atomic_int numMultiThreadedSections;
+
+	inline bool InMultiThreadedSection() { return (numMultiThreadedSections.load(std::memory_order_relaxed) > 0); }
+
+	// Enter returns how deeply the call is nested inside other for_mt's or pool tasks
+	int EnterMultiThreadedSection();
+	void LeaveMultiThreadedSection();
 
 	static constexpr int MAX_THREADS = 32;
 }
@@ -120,7 +145,15 @@ namespace ThreadPool {
 class ITaskGroup
 {
 public:
-	ITaskGroup(const bool getid = true, const bool pooled = false): id(getid ? lastId.fetch_add(1) : -1u), ts(0) {
+	ITaskGroup(const bool getid = true, const bool pooled = false)
+		: queuedSlices(0)
+		, sliceSumTime(0)
+		, sliceMaxTime(0)
+		, sliceThreads(0)
+		, ownSliceTime(0)
+		, id(getid ? lastId.fetch_add(1) : -1u)
+		, ts(0)
+	{
 		ResetState(!pooled, pooled, false);
 	}
 
@@ -136,18 +169,30 @@ public:
 	uint64_t ExecuteLoop(int tid, bool wffCall) {
 		const spring_time t0 = spring_now();
 
-		while (ExecuteStep());
+		int numSteps = 0;
+
+		while (ExecuteStep()) {
+			numSteps += 1;
+		}
 
 		const spring_time t1 = spring_now();
 		const spring_time dt = t1 - t0;
 
 		if (IsSliceTask()) {
+			if (numSteps > 0)
+				AddSliceTime(dt.toNanoSecsi());
+
 			// inTaskQueue would be set to false prematurely by the
 			// first slice to finish, let it be handled by WFF which
 			// blocks until all threads are
-			if (!wffCall)
+			if (!wffCall) {
+				// last access; the pool may hand out this group again
+				// once the final copy has been popped from the queues
+				queuedSlices.fetch_sub(1, std::memory_order_release);
 				return (dt.toNanoSecsi());
+			}
 
+			ownSliceTime = dt.toNanoSecsi();
 			inTaskQueue.store(false);
 		} else {
 			// do not set this to false from WFF, defeats the purpose
@@ -202,14 +247,50 @@ public:
 		execLoopDone.store(false);
 	}
 
+	void ResetSliceTimes() {
+		sliceSumTime.store(0, std::memory_order_relaxed);
+		sliceMaxTime.store(0, std::memory_order_relaxed);
+		sliceThreads.store(0, std::memory_order_relaxed);
+		ownSliceTime = 0;
+	}
+
+	void AddSliceTime(uint64_t dt) {
+		uint64_t maxTime = sliceMaxTime.load(std::memory_order_relaxed);
+
+		sliceSumTime.fetch_add(dt, std::memory_order_relaxed);
+		sliceThreads.fetch_add(1, std::memory_order_relaxed);
+
+		while (maxTime < dt && !sliceMaxTime.compare_exchange_weak(maxTime, dt, std::memory_order_relaxed));
+	}
+
+	// pooled groups stay in use after WFF until their TaskPool gets them back;
+	// claiming fails while that has not happened or copies are still queued
+	bool TryClaim() {
+		int mask = (1 << 0);
+
+		if (queuedSlices.load(std::memory_order_acquire) != 0)
+			return false;
+
+		return (taskPoolMask.compare_exchange_strong(mask, mask | (1 << 1)));
+	}
+
+	void Release() { taskPoolMask.fetch_and(~(1 << 1)); }
+
 public:
 	std::atomic_int remainingTasks;
 	std::atomic_int wantedThread; // if 0 (default), task will be executed by an arbitrary thread
 	std::atomic_int taskPoolMask; // whether this task is managed (owned) and in use by a TaskPool
+	std::atomic_int queuedSlices; // number of (slice-task) copies of this group not yet popped by a worker
 
 	std::atomic_bool inTaskQueue; // whether this task is still in a thread's queue
 	std::atomic_bool execLoopDone; // whether the thread running this task is about to exit ExecLoop
 
+	// slice timings of the current use, see ThreadPool::CallSiteStats
+	std::atomic<uint64_t> sliceSumTime;
+	std::atomic<uint64_t> sliceMaxTime;
+	std::atomic_int sliceThreads;
+	uint64_t ownSliceTime; // only accessed by the thread calling WFF
+
 private:
 	static std::atomic_uint lastId;
 
@@ -608,6 +689,7 @@ public:
 
 		remainingTasks.store((step == 1) ? (to - from) : ((to - from + step - 1) / step));
 		ctr.store(0);
+		ResetSliceTimes();
 
 		this->from = from;
 		this->to   = to;
@@ -651,9 +733,10 @@ struct TaskPool {
 	typedef TG<F> FuncTaskGroup;
 	typedef std::shared_ptr<FuncTaskGroup> FuncTaskGroupPtr;
 
-	// more than 256 nested for_mt's or parallel's should be uncommon
+	// every (nested) for_mt or parallel of this call-site in progress
+	// holds one group, more than 256 at once should be uncommon
 	std::array<FuncTaskGroupPtr, 256> tgPool;
-	std::atomic_int pos = {0};
+	std::atomic<uint32_t> pos = {0};
 
 	TaskPool() {
 		for (size_t i = 0; i < tgPool.size(); ++i) {
@@ -662,16 +745,29 @@ struct TaskPool {
 	}
 
 
+	// returns null if all groups are held by enclosing calls
 	FuncTaskGroupPtr GetTaskGroup() {
-		auto tg = tgPool[pos.fetch_add(1) % tgPool.size()];
+		for (size_t n = 0; n < tgPool.size(); n++) {
+			const auto& tg = tgPool[pos.fetch_add(1) % tgPool.size()];
+
+			// skip groups still in use, or with stale copies left in some queue
+			if (!tg->TryClaim())
+				continue;
 
-		assert(tg->IsFinished());
-		assert(tg->IsInTaskPool());
-		assert(!tg->IsInJobQueue());
-		assert(!tg->IsInPoolUse());
+			assert(tg->IsFinished());
+			assert(tg->IsInTaskPool());
+			assert(!tg->IsInJobQueue());
 
-		tg->ResetState(true, true, true);
-		return tg;
+			tg->ResetState(true, true, true);
+			return tg;
+		}
+
+		return nullptr;
+	}
+
+	void ReturnTaskGroup(const FuncTaskGroupPtr& tg) {
+		assert(tg->IsInPoolUse());
+		tg->Release();
 	}
 };
 
@@ -683,11 +779,23 @@ struct TaskPool {
 
 
 template <typename F>
-static inline void for_mt(int start, int end, int step, F&& f)
+static inline void for_mt(int start, int end, int step, F&& f, const char* file = __builtin_FILE(), int line = __builtin_LINE())
 {
-	ThreadPool::inMultiThreadedSection = true;
+	const int depth = ThreadPool::EnterMultiThreadedSection();
+
+	// static, so TaskGroup's are recycled
+	static TaskPool<ForTaskGroup, F> pool;
+	// named after the first caller, lambda types are unique per call-site
+	static ThreadPool::CallSiteStats stats(file, line);
+
+	typename TaskPool<ForTaskGroup, F>::FuncTaskGroupPtr taskGroup;
 
-	if (!ThreadPool::HasThreads() || ((end - start) < step)) {
+	if (ThreadPool::HasThreads() && ((end - start) >= step)) {
+		if ((taskGroup = pool.GetTaskGroup()) == nullptr)
+			stats.numSerialCalls += 1;
+	}
+
+	if (taskGroup == nullptr) {
 		for (int i = start; i < end; i += step) {
 			f(i);
 		}
@@ -695,40 +803,43 @@ static inline void for_mt(int start, int end, int step, F&& f)
 	else {
 		SCOPED_MT_TIMER("ThreadPool::AddTask");
 
-		// static, so TaskGroup's are recycled
-		static TaskPool<ForTaskGroup, F> pool;
-		auto taskGroup = pool.GetTaskGroup();
+		const spring_time t0 = spring_now();
 
 		taskGroup->Enqueue(start, end, step, f);
 		taskGroup->UpdateId();
 
 		assert(taskGroup->IsInJobQueue());
 
-		#if 0
-		ThreadPool::PushTaskGroup(taskGroup);
-		#else
-		// store the group in all worker queues s.t. each executes a slice
+		// push one (unpinned) copy of the group per worker s.t. each can execute
+		// slices; copies pushed from a worker (nested for_mt) land in its deque
+		// and are stolen by idle workers instead of waiting for a busy one
+		// the group is not handed out again before every copy has been popped
+		taskGroup->queuedSlices.fetch_add(ThreadPool::GetNumThreads() - 1, std::memory_order_release);
+
 		for (size_t i = 1; i < ThreadPool::GetNumThreads(); ++i) {
-			taskGroup->wantedThread.store(i);
 			ThreadPool::PushTaskGroup(taskGroup);
 		}
-		#endif
 
-		// make calling thread also run ExecuteLoop
+		// make calling thread also run ExecuteLoop; a nested caller pops
+		// the copies from its own deque first, i.e. helps drain its own
+		// slices before picking up unrelated work while it waits
 		ThreadPool::WaitForFinished(taskGroup);
+		ThreadPool::UpdateCallSiteStats(stats, *taskGroup, t0, depth > 0);
+
+		pool.ReturnTaskGroup(taskGroup);
 	}
 
-	ThreadPool::inMultiThreadedSection = false;
+	ThreadPool::LeaveMultiThreadedSection();
 }
 
 template <typename F>
-static inline void for_mt(int start, int end, F&& f)
+static inline void for_mt(int start, int end, F&& f, const char* file = __builtin_FILE(), int line = __builtin_LINE())
 {
-	for_mt(start, end, 1, f);
+	for_mt(start, end, 1, f, file, line);
 }
 
 template <typename F>
-static inline void for_mt_chunk(int b, int e, F&& f, int chunkOrMinChinkSize = 0)
+static inline void for_mt_chunk(int b, int e, F&& f, int chunkOrMinChinkSize = 0, const char* file = __builtin_FILE(), int line = __builtin_LINE())
 {
 	const int numElems = e - b;
 	if (numElems <= 0)
@@ -761,7 +872,7 @@ static inline void for_mt_chunk(int b, int e, F&& f, int chunkOrMinChinkSize = 0
 
 		for (int i = bb; i < ee; ++i)
 			std::forward<F>(f)(i);
-	});
+	}, file, line);
 }
 
 
@@ -777,6 +888,9 @@ static inline void parallel(F&& f)
 	static TaskPool<Parallel2TaskGroup, F> pool;
 	auto taskGroup = pool.GetTaskGroup();
 
+	if (taskGroup == nullptr)
+		return f();
+
 	taskGroup->Enqueue(f);
 	taskGroup->UpdateId();
 
@@ -785,6 +899,8 @@ static inline void parallel(F&& f)
 	// note: child-tasks are pushed, parent itself should not be
 	// ThreadPool::PushTaskGroup(taskGroup);
 	ThreadPool::WaitForFinished(taskGroup);
+
+	pool.ReturnTaskGroup(taskGroup);
 }
 
 
@@ -855,11 +971,9 @@ namespace ThreadPool {
 		auto task = new AsyncTask<F, Args...>(std::forward<F>(f), std::forward<Args>(args)...);
 		auto fut = task->GetFuture();
 
-		// minor hack: assume AsyncTask's will cause (heavy) disk IO
-		// although these can never block the main thread, the async
-		// workers might still be handed an uneven work distribution
-		task->wantedThread.store(1 + task->GetId() % (ThreadPool::GetNumThreads() - 1));
-
+		// not pinned, any idle async worker picks it up (or steals it)
+		// async workers never execute for_mt slices and run at a lower
+		// OS priority, so background jobs can not delay the sim
 		ThreadPool::PushTaskGroup(task);
 		return fut;
 	}
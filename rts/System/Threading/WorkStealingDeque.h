@@ -0,0 +1,102 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+
+/**
+ * Bounded single-owner work-stealing deque (Chase-Lev, with the memory
+ * orderings from Le et al., "Correct and Efficient Work-Stealing for Weak
+ * Memory Models", PPoPP 2013).
+ *
+ * Only the owning thread may call Push and Pop, which operate on the bottom
+ * end (LIFO); any thread may call Steal, which takes from the top end (FIFO).
+ * Push fails instead of growing when the deque holds N items, callers should
+ * then fall back to a shared queue.
+ */
+template<typename T, size_t N>
+class WorkStealingDeque {
+	static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+	static_assert(std::is_trivially_copyable<T>::value, "items must be trivially copyable");
+
+public:
+	WorkStealingDeque() = default;
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator = (const WorkStealingDeque&) = delete;
+
+	bool Push(T item) {
+		const int64_t b = bottom.load(std::memory_order_relaxed);
+		const int64_t t = top.load(std::memory_order_acquire);
+
+		if ((b - t) >= int64_t(N))
+			return false;
+
+		items[b & (N - 1)].store(item, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool Pop(T& item) {
+		const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		int64_t t = top.load(std::memory_order_relaxed);
+
+		if (t > b) {
+			// empty
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		item = items[b & (N - 1)].load(std::memory_order_relaxed);
+
+		if (t != b)
+			return true;
+
+		// last item, race against thieves for it
+		const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return won;
+	}
+
+	bool Steal(T& item) {
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+			return false;
+
+		item = items[t & (N - 1)].load(std::memory_order_relaxed);
+
+		// fails if the owner or another thief took it first
+		return (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed));
+	}
+
+	/// approximate unless called by the owner with no concurrent thieves
+	size_t Size() const {
+		const int64_t b = bottom.load(std::memory_order_relaxed);
+		const int64_t t = top.load(std::memory_order_relaxed);
+		return ((b > t)? size_t(b - t): 0);
+	}
+
+	constexpr static size_t Capacity() { return N; }
+
+private:
+	alignas(64) std::atomic<int64_t> top = {0};
+	alignas(64) std::atomic<int64_t> bottom = {0};
+
+	alignas(64) std::array<std::atomic<T>, N> items = {};
+};
+
+#endif
@@ -233,7 +233,7 @@ const char* spring_lua_get_handle_name(lua_State* L)
 static constexpr const char* LUA_OOM_FMT_STR = "[%s][handle=%s][OOM] synced=%d {alloced,maximum}={" _STPF_ "," _STPF_ "}bytes\n";
 
 // tracks allocations across all states
-static SLuaAllocState gLuaAllocState = {{0}, {0}, {0}, {0}};
+static SLuaAllocState gLuaAllocState = {{0}, {0}, {0}, {0}, {0}};
 static SLuaAllocError gLuaAllocError = {};
 
 void spring_lua_alloc_log_error(const luaContextData* lcd)
@@ -263,6 +263,11 @@ void* spring_lua_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
 	las->allocedBytes -= osize;
 	las->allocedBytes += nsize;
 
+	if (nsize > osize) {
+		gLuaAllocState.grossAllocBytes += (nsize - osize);
+		las->grossAllocBytes += (nsize - osize);
+	}
+
 	if (nsize == 0) {
 		// deallocation; must return NULL
 		lmp->Free(ptr, osize);
@@ -297,6 +302,7 @@ void spring_lua_alloc_get_stats(SLuaAllocState* state)
 	state->allocedBytes.store(gLuaAllocState.allocedBytes.load());
 	state->numLuaAllocs.store(gLuaAllocState.numLuaAllocs.load());
 	state->luaAllocTime.store(gLuaAllocState.luaAllocTime.load());
+	state->grossAllocBytes.store(gLuaAllocState.grossAllocBytes.load());
 
 #if (ENABLE_USERSTATE_LOCKS != 0)
 	state->numLuaStates.store(mutexes.size() - coroutines.size();
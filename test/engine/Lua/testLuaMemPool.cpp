@@ -0,0 +1,135 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Lua/LuaMemPool.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+#define TEST_RUNS 20000
+#define MAX_ALLOC_SIZE 1024
+
+
+struct Allocation {
+	uint8_t* ptr;
+	size_t size;
+	uint8_t fill;
+};
+
+static bool CheckFill(const Allocation& a)
+{
+	for (size_t i = 0; i < a.size; i++) {
+		if (a.ptr[i] != a.fill)
+			return false;
+	}
+
+	return true;
+}
+
+
+TEST_CASE("LuaMemPool")
+{
+	LuaMemPool::InitStatic(true);
+
+	std::mt19937 rng(4321);
+	std::uniform_int_distribution<int> sizeDist(1, MAX_ALLOC_SIZE);
+	std::uniform_int_distribution<int> opDist(0, 2);
+
+	LuaMemPool* pool = LuaMemPool::AcquirePtr(false, false);
+	std::vector<Allocation> allocs;
+
+	for (int n = 0; n < TEST_RUNS; ++n) {
+		const int op = (allocs.empty())? 0: opDist(rng);
+
+		switch (op) {
+			case 0: {
+				const size_t size = sizeDist(rng);
+				Allocation a = {static_cast<uint8_t*>(pool->Alloc(size)), size, uint8_t(n)};
+
+				// slots are at least pointer-aligned
+				REQUIRE((reinterpret_cast<uintptr_t>(a.ptr) % sizeof(void*)) == 0);
+
+				std::memset(a.ptr, a.fill, a.size);
+				allocs.push_back(a);
+			} break;
+			case 1: {
+				Allocation& a = allocs[rng() % allocs.size()];
+				const size_t size = sizeDist(rng);
+
+				a.ptr = static_cast<uint8_t*>(pool->Realloc(a.ptr, size, a.size));
+
+				// contents up to the smaller size must survive
+				a.size = std::min(a.size, size);
+				REQUIRE(CheckFill(a));
+
+				a.size = size;
+				std::memset(a.ptr, a.fill, a.size);
+			} break;
+			case 2: {
+				const size_t i = rng() % allocs.size();
+
+				REQUIRE(CheckFill(allocs[i]));
+				pool->Free(allocs[i].ptr, allocs[i].size);
+
+				allocs[i] = allocs.back();
+				allocs.pop_back();
+			} break;
+		}
+	}
+
+	const LuaMemPool::SlabStats liveStats = pool->GetSlabStats();
+
+	REQUIRE(liveStats.numSlabs > 0);
+	REQUIRE(liveStats.slotBytes >= liveStats.requestedBytes);
+	REQUIRE(liveStats.reservedBytes >= liveStats.slotBytes);
+	REQUIRE(liveStats.peakReservedBytes >= liveStats.reservedBytes);
+
+	for (const Allocation& a: allocs) {
+		REQUIRE(CheckFill(a));
+		pool->Free(a.ptr, a.size);
+	}
+
+	const LuaMemPool::SlabStats freeStats = pool->GetSlabStats();
+
+	REQUIRE(freeStats.slotBytes == 0);
+	REQUIRE(freeStats.requestedBytes == 0);
+	REQUIRE(freeStats.externalBytes == 0);
+
+	// releasing a pool without live allocations returns its slabs in bulk
+	LuaMemPool::ReleasePtr(pool, nullptr);
+	REQUIRE(pool->GetSlabStats().numSlabs == 0);
+
+	LuaMemPool::KillStatic();
+}
+
+TEST_CASE("LuaMemPoolFreeNull")
+{
+	LuaMemPool::InitStatic(true);
+
+	LuaMemPool* pool = LuaMemPool::AcquirePtr(false, false);
+
+	// frealloc(ud, NULL, 0, 0) is legal and must be a no-op
+	pool->Free(nullptr, 0);
+	pool->Free(nullptr, 16);
+
+	const LuaMemPool::SlabStats stats = pool->GetSlabStats();
+
+	REQUIRE(stats.slotBytes == 0);
+	REQUIRE(stats.requestedBytes == 0);
+	REQUIRE(stats.externalBytes == 0);
+
+	// the free-lists must still be intact afterwards
+	void* ptr = pool->Alloc(16);
+
+	REQUIRE(ptr != nullptr);
+	pool->Free(ptr, 16);
+	REQUIRE(pool->GetSlabStats().slotBytes == 0);
+
+	LuaMemPool::ReleasePtr(pool, nullptr);
+	LuaMemPool::KillStatic();
+}
@@ -0,0 +1,96 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/LosMapKernels.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+#define TEST_RUNS 10000
+#define MAX_SPAN_SIZE 300
+
+
+TEST_CASE("AddSquareSpan")
+{
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> spanDist(0, MAX_SPAN_SIZE);
+	std::uniform_int_distribution<int> amountDist(-3, 3);
+	std::uniform_int_distribution<int> squareDist(0, 0xFFFF);
+
+	std::vector<unsigned short> squaresRef(MAX_SPAN_SIZE + 16);
+	std::vector<unsigned short> squaresVec(MAX_SPAN_SIZE + 16);
+
+	for (int n = 0; n < TEST_RUNS; ++n) {
+		for (unsigned short& s: squaresRef) {
+			s = squareDist(rng);
+		}
+
+		squaresVec = squaresRef;
+
+		// unaligned start and arbitrary length, includes wrap-around
+		const int offset = spanDist(rng) % 16;
+		const int count = spanDist(rng);
+		const int amount = amountDist(rng);
+
+		LosMapKernels::AddSquareSpanScalar(&squaresRef[offset], count, amount);
+		LosMapKernels::AddSquareSpan(&squaresVec[offset], count, amount);
+
+		REQUIRE(squaresRef == squaresVec);
+	}
+}
+
+
+TEST_CASE("CalcRayAngles")
+{
+	std::mt19937 rng(5678);
+	std::uniform_int_distribution<int> radiusDist(1, MAX_SPAN_SIZE / 2);
+	std::uniform_real_distribution<float> heightDist(-200.0f, 800.0f);
+
+	std::vector<float> isqrtTable;
+	std::vector<float> heights(MAX_SPAN_SIZE + 1);
+
+	std::vector<float> anglesRef(MAX_SPAN_SIZE + 1);
+	std::vector<float> anglesVec(MAX_SPAN_SIZE + 1);
+	std::vector<char> visibleRef(MAX_SPAN_SIZE + 1);
+	std::vector<char> visibleVec(MAX_SPAN_SIZE + 1);
+
+	for (int i = 0, n = (MAX_SPAN_SIZE + 1) * (MAX_SPAN_SIZE + 1); i < n; ++i) {
+		isqrtTable.push_back(1.0f / std::sqrt(float(std::max(i, 1))));
+	}
+
+	for (int n = 0; n < TEST_RUNS; ++n) {
+		const int radius = radiusDist(rng);
+		// exercise spans crossing the origin (0, 0) that must be skipped
+		const int offY = ((n % 4) == 0)? 0: std::uniform_int_distribution<int>(-radius, radius)(rng);
+		const int offX = std::uniform_int_distribution<int>(-radius, radius)(rng);
+		const int count = std::uniform_int_distribution<int>(0, radius - offX + 1)(rng);
+		const float losHeight = heightDist(rng);
+
+		for (float& h: heights) {
+			h = heightDist(rng);
+		}
+
+		// signed zeros
+		if ((n % 3) == 0) {
+			heights[n % (count + 1)] = -0.0f;
+		}
+
+		std::fill(anglesRef.begin(), anglesRef.end(), -1e8f);
+		std::fill(visibleRef.begin(), visibleRef.end(), false);
+
+		anglesVec = anglesRef;
+		visibleVec = visibleRef;
+
+		LosMapKernels::CalcRayAnglesScalar(anglesRef.data(), visibleRef.data(), heights.data(), isqrtTable.data(), offX, offY, count, losHeight, 5.0f);
+		LosMapKernels::CalcRayAngles(anglesVec.data(), visibleVec.data(), heights.data(), isqrtTable.data(), offX, offY, count, losHeight, 5.0f);
+
+		// bit-exact, not just approximately equal
+		REQUIRE(std::memcmp(anglesRef.data(), anglesVec.data(), anglesRef.size() * sizeof(float)) == 0);
+		REQUIRE(visibleRef == visibleVec);
+	}
+}
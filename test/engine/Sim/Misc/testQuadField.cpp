@@ -99,3 +99,83 @@ TEST_CASE("QuadField")
 	INFO("Too little quads returned!");
 	CHECK_FALSE(fail);
 }
+
+
+TEST_CASE("AdaptiveQuadSize")
+{
+	const int2 mapSize = {1024 * SQUARE_SIZE, 512 * SQUARE_SIZE};
+
+	// within the hysteresis band nothing changes
+	CHECK(CQuadField::GetAdaptiveQuadSize(mapSize, 128, 32, 512, 8.0f, 8.0f) == 128);
+	CHECK(CQuadField::GetAdaptiveQuadSize(mapSize, 128, 32, 512, 16.0f, 8.0f) == 128);
+	CHECK(CQuadField::GetAdaptiveQuadSize(mapSize, 128, 32, 512, 1.0f, 8.0f) == 128);
+
+	// overloaded quads are split, underloaded ones merged
+	CHECK(CQuadField::GetAdaptiveQuadSize(mapSize, 128, 32, 512, 16.5f, 8.0f) == 64);
+	CHECK(CQuadField::GetAdaptiveQuadSize(mapSize, 128, 32, 512, 0.5f, 8.0f) == 256);
+
+	// limits
+	CHECK(CQuadField::GetAdaptiveQuadSize(mapSize, 32, 32, 512, 100.0f, 8.0f) == 32);
+	CHECK(CQuadField::GetAdaptiveQuadSize(mapSize, 512, 32, 512, 0.0f, 8.0f) == 512);
+
+	// the new size must divide the map size
+	CHECK(CQuadField::GetAdaptiveQuadSize({192 * SQUARE_SIZE, 192 * SQUARE_SIZE}, 512, 32, 2048, 0.0f, 8.0f) == 512);
+}
+
+TEST_CASE("QuadFieldStats")
+{
+	CHECK(CQuadField::GetHistogramBin(0) == 0);
+	CHECK(CQuadField::GetHistogramBin(1) == 1);
+	CHECK(CQuadField::GetHistogramBin(2) == 2);
+	CHECK(CQuadField::GetHistogramBin(3) == 2);
+	CHECK(CQuadField::GetHistogramBin(4) == 3);
+	CHECK(CQuadField::GetHistogramBin(1 << 20) == CQuadField::Stats::NUM_HISTOGRAM_BINS - 1);
+
+	quadField.Init(int2(64, 32), 64);
+
+	const CQuadField::Stats stats = quadField.GetStats();
+
+	CHECK(stats.unitHistogram[0] == (quadField.GetNumQuadsX() * quadField.GetNumQuadsZ()));
+	CHECK(stats.numOccupiedQuads == 0);
+	CHECK(stats.avgUnits == 0.0f);
+}
+
+TEST_CASE("QuadFieldQueryCounters")
+{
+	quadField.Init(int2(64, 32), 64);
+	quadField.ResetQueryCounters();
+
+	{
+		// not counted by default
+		QuadFieldQuery qfQuery;
+		quadField.GetQuadsOnRay(qfQuery, float3(8.0f, 0.0f, 8.0f), float3(1.0f, 0.0f, 0.0f), 64.0f * SQUARE_SIZE);
+		CHECK(quadField.GetStats().queryCounters[CQuadField::QUERY_QUADS_ON_RAY].numCalls == 0);
+	}
+
+	quadField.SetCountQueries(true);
+
+	size_t numQuads = 0;
+
+	{
+		QuadFieldQuery qfQuery;
+		quadField.GetQuadsOnRay(qfQuery, float3(8.0f, 0.0f, 8.0f), float3(1.0f, 0.0f, 0.0f), 64.0f * SQUARE_SIZE);
+		numQuads += qfQuery.quads->size();
+	}
+	{
+		QuadFieldQuery qfQuery;
+		quadField.GetQuadsOnRay(qfQuery, float3(8.0f, 0.0f, 8.0f), float3(0.0f, 0.0f, 1.0f), 1.0f);
+		numQuads += qfQuery.quads->size();
+	}
+
+	const CQuadField::Stats stats = quadField.GetStats();
+	const CQuadField::QueryCounter& qc = stats.queryCounters[CQuadField::QUERY_QUADS_ON_RAY];
+
+	CHECK(numQuads > 2);
+	CHECK(qc.numCalls == 2);
+	CHECK(qc.numCandidates == numQuads);
+	CHECK(qc.numResults == numQuads);
+
+	quadField.ResetQueryCounters();
+	quadField.SetCountQueries(false);
+	CHECK(quadField.GetStats().queryCounters[CQuadField::QUERY_QUADS_ON_RAY].numCalls == 0);
+}
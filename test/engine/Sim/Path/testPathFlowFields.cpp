@@ -0,0 +1,109 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Path/HAPFS/PathFlowFieldSearch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+using namespace HAPFS;
+
+
+// 8x8 blocks with a wall at x=4 that has a single gap at the top row
+static constexpr int GRID_SIZE = 8;
+
+static const int2 numBlocks = {GRID_SIZE, GRID_SIZE};
+
+static int2 BlockPos(unsigned int blockIdx) { return {int(blockIdx % GRID_SIZE), int(blockIdx / GRID_SIZE)}; }
+static unsigned int BlockIdx(int x, int z) { return (z * GRID_SIZE + x); }
+
+static bool IsWall(unsigned int blockIdx)
+{
+	const int2 pos = BlockPos(blockIdx);
+	return (pos.x == 4 && pos.y != (GRID_SIZE - 1));
+}
+
+static float EdgeCost(unsigned int blockIdx, unsigned int pathDir)
+{
+	const int2 nbrPos = BlockPos(blockIdx) + PE_DIRECTION_VECTORS[pathDir];
+
+	if (IsWall(blockIdx) || IsWall(BlockIdx(nbrPos.x, nbrPos.y)))
+		return PATHCOST_INFINITY;
+
+	return (((pathDir & 1) != 0)? 1.4142f: 1.0f);
+}
+
+static float NodeCost(unsigned int blockIdx) { return 0.0f; }
+static bool NoGoal(unsigned int blockIdx) { return false; }
+static bool AllAllowed(unsigned int blockIdx) { return true; }
+
+
+TEST_CASE("FlowFieldIntegrate")
+{
+	std::vector<float> costs;
+
+	FlowFieldSearch::Integrate(costs, numBlocks, BlockIdx(7, 0), EdgeCost, NodeCost);
+
+	REQUIRE(costs.size() == (GRID_SIZE * GRID_SIZE));
+	CHECK(costs[BlockIdx(7, 0)] == 0.0f);
+	CHECK(costs[BlockIdx(6, 0)] == 1.0f);
+	CHECK(costs[BlockIdx(4, 0)] == PATHCOST_INFINITY);
+	CHECK(costs[BlockIdx(4, 7)] < PATHCOST_INFINITY);
+
+	// blocks left of the wall have to go around it through the gap
+	CHECK(costs[BlockIdx(3, 0)] > 7.0f);
+	CHECK(costs[BlockIdx(0, 0)] > costs[BlockIdx(3, 0)]);
+}
+
+TEST_CASE("FlowFieldDescend")
+{
+	std::vector<float> costs;
+	std::vector<unsigned int> blocks;
+
+	FlowFieldSearch::Integrate(costs, numBlocks, BlockIdx(7, 0), EdgeCost, NodeCost);
+
+	SECTION("reaches the goal through the gap") {
+		REQUIRE(FlowFieldSearch::Descend(costs, numBlocks, BlockIdx(0, 0), EdgeCost, NodeCost, NoGoal, AllAllowed, blocks));
+
+		CHECK(blocks.front() == BlockIdx(0, 0));
+		CHECK(blocks.back() == BlockIdx(7, 0));
+		CHECK(std::find(blocks.begin(), blocks.end(), BlockIdx(4, 7)) != blocks.end());
+
+		for (size_t i = 1; i < blocks.size(); i++) {
+			const int2 prvPos = BlockPos(blocks[i - 1]);
+			const int2 curPos = BlockPos(blocks[i]);
+
+			CHECK(std::abs(curPos.x - prvPos.x) <= 1);
+			CHECK(std::abs(curPos.y - prvPos.y) <= 1);
+			CHECK(costs[blocks[i]] < costs[blocks[i - 1]]);
+			CHECK(!IsWall(blocks[i]));
+		}
+	}
+
+	SECTION("stops at the first block within the goal radius") {
+		const auto InGoalRadius = [](unsigned int blockIdx) {
+			const int2 pos = BlockPos(blockIdx);
+			return ((pos.x - 7) * (pos.x - 7) + pos.y * pos.y <= 9);
+		};
+
+		REQUIRE(FlowFieldSearch::Descend(costs, numBlocks, BlockIdx(0, 0), EdgeCost, NodeCost, InGoalRadius, AllAllowed, blocks));
+
+		CHECK(blocks.back() != BlockIdx(7, 0));
+		CHECK(InGoalRadius(blocks.back()));
+		CHECK(std::count_if(blocks.begin(), blocks.end(), InGoalRadius) == 1);
+	}
+
+	SECTION("fails when the path leaves the constraint") {
+		const auto BelowTopRow = [](unsigned int blockIdx) { return (BlockPos(blockIdx).y < (GRID_SIZE - 1)); };
+
+		CHECK(!FlowFieldSearch::Descend(costs, numBlocks, BlockIdx(0, 0), EdgeCost, NodeCost, NoGoal, BelowTopRow, blocks));
+		CHECK(FlowFieldSearch::Descend(costs, numBlocks, BlockIdx(6, 3), EdgeCost, NodeCost, NoGoal, BelowTopRow, blocks));
+	}
+
+	SECTION("fails when the start can not reach the goal") {
+		CHECK(!FlowFieldSearch::Descend(costs, numBlocks, BlockIdx(4, 0), EdgeCost, NodeCost, NoGoal, AllAllowed, blocks));
+	}
+}
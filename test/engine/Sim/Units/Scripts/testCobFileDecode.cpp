@@ -0,0 +1,137 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobFile.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// raw opcodes, see CobFileDecode.cpp
+static constexpr int MOVE             = 0x10001000;
+static constexpr int PUSH_CONSTANT    = 0x10021001;
+static constexpr int PUSH_LOCAL_VAR   = 0x10021002;
+static constexpr int ADD              = 0x10031000;
+static constexpr int SET_LESS         = 0x10051000;
+static constexpr int SET_EQUAL        = 0x10055000;
+static constexpr int START            = 0x10061000;
+static constexpr int CALL             = 0x10062000;
+static constexpr int REAL_CALL        = 0x10062001;
+static constexpr int JUMP             = 0x10064000;
+static constexpr int RETURN           = 0x10065000;
+static constexpr int JUMP_NOT_EQUAL   = 0x10066000;
+
+typedef CCobFile::Instr Instr;
+
+
+static CCobFile MakeCobFile(const std::vector<int>& code)
+{
+	CCobFile cobFile;
+	cobFile.code = code;
+	cobFile.scriptNames = {"Main", "Empty", "lua_Foo", "Bar"};
+	cobFile.scriptOffsets = {0, 12, 12, 12};
+	cobFile.scriptLengths = {12, 0, 0, int(code.size()) - 12};
+	cobFile.DecodeInstrs();
+	return cobFile;
+}
+
+
+TEST_CASE("CobDecode")
+{
+	const CCobFile cobFile = MakeCobFile({
+		MOVE, 1, 2,          //  0
+		CALL, 1, 0,          //  3: zero-length function
+		CALL, 2, 0,          //  6: lua_ function
+		REAL_CALL, 3, 0,     //  9
+		RETURN,              // 12
+		START, 7, 0,         // 13: invalid function index
+		0x12345678,          // 16: unknown opcode
+		JUMP,                // 17: operand missing
+	});
+
+	const std::vector<Instr>& instrs = cobFile.instrs;
+
+	// every code offset has an entry, so jumps can target any of them
+	REQUIRE(instrs.size() == cobFile.code.size());
+
+	CHECK(instrs[0].op == Instr::Move);
+	CHECK(instrs[0].next == 3);
+	CHECK(instrs[0].args[0] == 1);
+	CHECK(instrs[0].args[1] == 2);
+
+	CHECK(instrs[1].op == Instr::Unknown);
+	CHECK(instrs[1].next == 2);
+	CHECK(instrs[1].args[0] == 1);
+
+	CHECK(instrs[3].op == Instr::Nop);
+	CHECK(instrs[3].next == 6);
+
+	CHECK(instrs[6].op == Instr::LuaCall);
+	CHECK(instrs[6].args[0] == 2);
+
+	CHECK(instrs[9].op == Instr::Call);
+	CHECK(instrs[9].next == 12);
+	CHECK(instrs[9].args[2] == 12);
+
+	CHECK(instrs[12].op == Instr::Return);
+
+	CHECK(instrs[13].op == Instr::Unknown);
+	CHECK(instrs[13].next == 14);
+	CHECK(instrs[13].args[0] == START);
+
+	CHECK(instrs[16].op == Instr::Unknown);
+	CHECK(instrs[16].args[0] == 0x12345678);
+
+	CHECK(instrs[17].op == Instr::Truncated);
+	CHECK(instrs[17].next == int(cobFile.code.size()));
+}
+
+TEST_CASE("CobFuse")
+{
+	const CCobFile cobFile = MakeCobFile({
+		PUSH_CONSTANT, 1,     //  0
+		PUSH_CONSTANT, 2,     //  2
+		ADD,                  //  4
+		PUSH_LOCAL_VAR, 0,    //  5
+		SET_LESS,             //  7
+		JUMP_NOT_EQUAL, 0,    //  8
+		PUSH_CONSTANT, 3,     // 10
+		SET_EQUAL,            // 12
+		JUMP_NOT_EQUAL, 5,    // 13
+		RETURN,               // 15
+	});
+
+	const std::vector<Instr>& instrs = cobFile.instrs;
+
+	REQUIRE(instrs.size() == cobFile.code.size());
+
+	CHECK(instrs[0].op == Instr::PushConstant2);
+	CHECK(instrs[0].next == 4);
+	CHECK(instrs[0].args[0] == 1);
+	CHECK(instrs[0].args[1] == 2);
+
+	// a jump to the second push still finds it, fused with the add
+	CHECK(instrs[2].op == Instr::BinOpConst);
+	CHECK(instrs[2].aux == Instr::Add);
+	CHECK(instrs[2].next == 5);
+	CHECK(instrs[2].args[0] == 2);
+
+	CHECK(instrs[4].op == Instr::Add);
+	CHECK(instrs[5].op == Instr::PushLocalVar);
+
+	CHECK(instrs[7].op == Instr::CmpJump);
+	CHECK(instrs[7].aux == Instr::SetLess);
+	CHECK(instrs[7].next == 10);
+	CHECK(instrs[7].args[0] == 0);
+
+	CHECK(instrs[10].op == Instr::CmpConstJump);
+	CHECK(instrs[10].aux == Instr::SetEqual);
+	CHECK(instrs[10].next == 15);
+	CHECK(instrs[10].args[0] == 3);
+	CHECK(instrs[10].args[1] == 5);
+
+	CHECK(instrs[12].op == Instr::CmpJump);
+	CHECK(instrs[12].next == 15);
+
+	CHECK(instrs[13].op == Instr::JumpNotEqual);
+	CHECK(instrs[15].op == Instr::Return);
+}
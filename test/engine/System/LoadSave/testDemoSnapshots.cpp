@@ -0,0 +1,130 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/LoadSave/DemoReader.h"
+#include "System/LoadSave/DemoRecorder.h"
+#include "System/FileSystem/FileSystem.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static std::string RecordDemo(int numFrames, int snapshotInterval, const std::vector<int>& snapshotFrames)
+{
+	CDemoRecorder recorder("testMap.smf", "testMod", false);
+	recorder.SetSnapshotInterval(snapshotInterval);
+	recorder.WriteSetupText("[game] {}");
+
+	const unsigned char newFrameMsg = NETMSG_NEWFRAME;
+
+	// all frames are recorded before any is simulated, as when the
+	// client falls behind the server
+	for (int frameNum = 1; frameNum <= numFrames; frameNum++)
+		recorder.SaveToDemo(&newFrameMsg, sizeof(newFrameMsg), frameNum * 0.1f);
+
+	for (int frameNum = 1; frameNum <= numFrames; frameNum++) {
+		if (!recorder.WantSnapshot(frameNum))
+			continue;
+		if (std::find(snapshotFrames.begin(), snapshotFrames.end(), frameNum) == snapshotFrames.end())
+			continue;
+
+		recorder.SaveSnapshot(frameNum, "state after frame " + std::to_string(frameNum));
+	}
+
+	// the demo is written when the recorder goes out of scope
+	return recorder.GetName();
+}
+
+
+TEST_CASE("DemoSnapshotIndex")
+{
+	// snapshots are wanted for frames 3, 6 and 9; the one for frame 6 is not taken
+	const std::string demoName = RecordDemo(10, 3, {3, 9});
+	REQUIRE(FileSystem::FileExists(demoName));
+
+	{
+		CDemoReader reader(demoName, 0.0f);
+
+		const std::vector<DemoSnapshotEntry>& snapshots = reader.GetSnapshots();
+		const unsigned int chunkSize = sizeof(DemoStreamChunkHeader) + 1;
+
+		REQUIRE(snapshots.size() == 2);
+		CHECK(snapshots[0].frameNum == 3);
+		CHECK(snapshots[1].frameNum == 9);
+		CHECK(snapshots[0].streamOffset == 3 * chunkSize);
+		CHECK(snapshots[1].streamOffset == 9 * chunkSize);
+
+		CHECK(reader.FindSnapshot(0, 2) == -1);
+		CHECK(reader.FindSnapshot(0, 8) == 0);
+		CHECK(reader.FindSnapshot(0, 10) == 1);
+		CHECK(reader.FindSnapshot(9, 10) == -1);
+
+		std::string data;
+
+		CHECK(reader.ReadSnapshot(0, data));
+		CHECK(data == "state after frame 3");
+		CHECK(reader.ReadSnapshot(1, data));
+		CHECK(data == "state after frame 9");
+		CHECK(!reader.ReadSnapshot(2, data));
+	}
+
+	FileSystem::DeleteFile(demoName);
+}
+
+TEST_CASE("DemoWithoutSnapshots")
+{
+	const std::string demoName = RecordDemo(10, 0, {});
+	REQUIRE(FileSystem::FileExists(demoName));
+
+	{
+		CDemoReader reader(demoName, 0.0f);
+		CHECK(reader.GetSnapshots().empty());
+	}
+
+	FileSystem::DeleteFile(demoName);
+}
+
+TEST_CASE("DemoWithOldHeader")
+{
+	const std::string demoName = RecordDemo(10, 3, {3, 6, 9});
+	REQUIRE(FileSystem::FileExists(demoName));
+
+	{
+		// rewrite the demo with the header of the minor version before snapshots
+		std::string data;
+		std::vector<char> buf(4096);
+
+		gzFile file = gzopen(demoName.c_str(), "rb");
+		for (int len = 0; (len = gzread(file, buf.data(), buf.size())) > 0; )
+			data.append(buf.data(), len);
+		gzclose(file);
+
+		const int oldHeaderSize = offsetof(DemoFileHeader, numSnapshots);
+		const int numRemoved = sizeof(DemoFileHeader) - oldHeaderSize;
+
+		REQUIRE(data.size() > sizeof(DemoFileHeader));
+		const int headerSizeLE = swabDWord(oldHeaderSize);
+
+		std::memcpy(&data[offsetof(DemoFileHeader, headerSize)], &headerSizeLE, sizeof(headerSizeLE));
+		data.erase(oldHeaderSize, numRemoved);
+
+		file = gzopen(demoName.c_str(), "wb");
+		gzwrite(file, data.data(), data.size());
+		gzclose(file);
+	}
+	{
+		CDemoReader reader(demoName, 0.0f);
+
+		CHECK(reader.GetSnapshots().empty());
+		CHECK(reader.GetSetupScript() == "[game] {}");
+	}
+
+	FileSystem::DeleteFile(demoName);
+}
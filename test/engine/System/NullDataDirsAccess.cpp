@@ -0,0 +1,11 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/FileSystem/DataDirsAccess.h"
+
+// no data-dirs, files are located relative to the working directory
+DataDirsAccess dataDirsAccess;
+
+std::string DataDirsAccess::LocateFile(std::string file, int flags) const
+{
+	return file;
+}
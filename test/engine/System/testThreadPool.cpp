@@ -1,12 +1,16 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "System/Threading/ThreadPool.h"
+#include "System/Threading/WorkStealingDeque.h"
 #include "System/Log/ILog.h"
 #include "System/Threading/SpringThreading.h"
 #include "System/Misc/SpringTime.h"
 #include "System/SpringMath.h"
+#include "System/StringUtil.h"
 #include "System/GlobalRNG.h"
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <atomic>
 #include <future>
@@ -145,6 +149,55 @@ TEST_CASE("test_nested_for_mt")
 	});
 }
 
+static void nested_for_mt_kernel(std::atomic<int>& numCalls, int depth)
+{
+	// same lambda at every level, so all share one TaskPool
+	for_mt(0, 4, [&](const int i) {
+		SAFE_CHECK(ThreadPool::InMultiThreadedSection());
+		numCalls += 1;
+
+		if (i == 0 && depth > 0)
+			nested_for_mt_kernel(numCalls, depth - 1);
+	});
+}
+
+TEST_CASE("test_deeply_nested_for_mt")
+{
+	LOG("[%s::test_deeply_nested_for_mt]", __func__);
+
+	std::atomic<int> numCalls = {0};
+
+	// deeper than the pool, innermost calls must fall back to serial
+	nested_for_mt_kernel(numCalls, 300);
+
+	CHECK(numCalls == 301 * 4);
+	CHECK(!ThreadPool::InMultiThreadedSection());
+}
+
+TEST_CASE("test_for_mt_callsite_stats")
+{
+	LOG("[%s::test_for_mt_callsite_stats]", __func__);
+
+	const int line = __LINE__ + 2;
+
+	for_mt(0, 100, [&](const int i) {
+		spring_sleep(spring_time::fromMicroSecs(10));
+	});
+
+	if (!ThreadPool::HasThreads())
+		return;
+
+	const auto stats = ThreadPool::GetCallSiteStats();
+	const auto iter = std::find_if(stats.begin(), stats.end(), [&](const ThreadPool::CallSiteStats* s) {
+		return (strstr(s->name, IntToString(line, "testThreadPool.cpp:%i").c_str()) != nullptr);
+	});
+
+	REQUIRE(iter != stats.end());
+	CHECK((*iter)->numCalls == 1);
+	CHECK((*iter)->numNestedCalls == 0);
+	CHECK((*iter)->sumExecTime >= 100 * 10 * 1000);
+}
+
 TEST_CASE("test_nested_parallel")
 {
 	#if 0
@@ -184,6 +237,85 @@ TEST_CASE("test_null_for_mt")
 }
 
 
+TEST_CASE("test_work_stealing_deque")
+{
+	LOG("[%s::test_work_stealing_deque]", __func__);
+
+	constexpr int NUM_ITEMS = 100000;
+	constexpr int NUM_THIEVES = 3;
+
+	// items are offset by one, deque slots hold nullptr-like zeros
+	WorkStealingDeque<int, 64> deque;
+	std::vector<std::atomic<int>> taken(NUM_ITEMS);
+	std::atomic<bool> done = {false};
+
+	for (auto& t: taken)
+		t.store(0);
+
+	std::vector<spring::thread> thieves;
+
+	for (int n = 0; n < NUM_THIEVES; ++n) {
+		thieves.emplace_back([&]() {
+			int item = 0;
+
+			while (!done.load()) {
+				if (deque.Steal(item))
+					taken[item - 1] += 1;
+			}
+		});
+	}
+
+	// owner, pops about every third item itself
+	for (int i = 1; i <= NUM_ITEMS; ++i) {
+		int item = 0;
+
+		while (!deque.Push(i)) {
+			if (deque.Pop(item))
+				taken[item - 1] += 1;
+		}
+
+		if ((i % 3) == 0 && deque.Pop(item))
+			taken[item - 1] += 1;
+	}
+
+	for (int item = 0; deque.Pop(item); ) {
+		taken[item - 1] += 1;
+	}
+
+	done.store(true);
+
+	for (auto& t: thieves)
+		t.join();
+
+	int numBad = 0;
+
+	for (const auto& t: taken)
+		numBad += (t.load() != 1);
+
+	CHECK(numBad == 0);
+	CHECK(deque.Size() == 0);
+}
+
+
+TEST_CASE("test_enqueue")
+{
+	LOG("[%s::test_enqueue]", __func__);
+
+	std::vector< std::shared_ptr< std::future<int> > > futures;
+
+	for (int i = 0; i < 100; ++i) {
+		futures.emplace_back(ThreadPool::Enqueue([i]() { return i; }));
+	}
+
+	int sum = 0;
+
+	for (auto& f: futures)
+		sum += f->get();
+
+	CHECK(sum == (99 * 100) / 2);
+}
+
+
 TEST_CASE("test_sse_for_mt")
 {
 	LOG("[%s::test_sse_for_mt]", __func__);
@@ -5,10 +5,12 @@
 #include <iostream>
 #include <gflags/gflags.h>
 #include <iomanip> //hex
+#include <zlib.h>
 
 #include "StringSerializer.h"
 
 #include "Net/Protocol/BaseNetProtocol.h"
+#include "Sim/Misc/GlobalConstants.h"
 #include "System/LoadSave/DemoReader.h"
 #include "System/Net/RawPacket.h"
 #include "Sim/Units/CommandAI/Command.h"
@@ -32,6 +34,9 @@ no console output (you still could use this.exe > z.tzt though).
 	DEFINE_bool  (teamstats,    false, "Print teamstats");
 	DEFINE_int32 (team,         -1,    "Select team");
 	DEFINE_string(teamsstatcsv, "",    "Write teamstats in a csv file");
+	DEFINE_bool  (snapshots,    false, "Print the game-state snapshot index");
+	DEFINE_int32 (snapshot,     -1,    "Select snapshot");
+	DEFINE_string(snapshotfile, "",    "Write the selected snapshot as a savegame (.ssf)");
 
 
 void TrafficDump(CDemoReader& reader, bool trafficStats);
@@ -68,6 +73,19 @@ int main (int argc, char* argv[])
 		}
 		WriteTeamstatHistory(reader, (unsigned) FLAGS_team, FLAGS_teamsstatcsv);
 	}
+	if (!FLAGS_snapshotfile.empty())
+	{
+		std::string data;
+		if (!reader.ReadSnapshot(FLAGS_snapshot, data))
+		{
+			std::cout << "snapshotfile requires a valid snapshot to select" << std::endl;
+			exit(1);
+		}
+		// savegames are gzip'ed, the snapshot itself is not
+		gzFile file = gzopen(FLAGS_snapshotfile.c_str(), "wb5");
+		gzwrite(file, data.data(), data.size());
+		gzclose(file);
+	}
 
 	if (FLAGS_header || FLAGS_stats)
 	{
@@ -110,6 +128,17 @@ int main (int argc, char* argv[])
 		}
 		std::wcout << buf.str();
 	}
+	if (FLAGS_snapshots)
+	{
+		const std::vector<DemoSnapshotEntry>& snapshots = reader.GetSnapshots();
+		for (unsigned i = 0; i < snapshots.size(); ++i)
+		{
+			std::cout << "Snapshot " << i << ": frame " << snapshots[i].frameNum;
+			std::cout << " (game second " << (snapshots[i].frameNum / GAME_SPEED) << ")";
+			std::cout << " StreamOffset: " << snapshots[i].streamOffset;
+			std::cout << " Size: " << snapshots[i].dataSize << "/" << snapshots[i].rawSize << std::endl;
+		}
+	}
 	return 0;
 }
 
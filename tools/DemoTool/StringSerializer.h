@@ -41,6 +41,9 @@ wstringstream& operator<<(wstringstream& str, const DemoFileHeader& header)
 	str<<L"TeamStatElemSize: " <<header.teamStatElemSize<<endl;
 	str<<L"TeamStatPeriod: " <<header.teamStatPeriod<<endl;
 	str<<L"WinningAllyTeamsSize: " << header.winningAllyTeamsSize<<endl;
+	str<<L"NumSnapshots: " <<header.numSnapshots<<endl;
+	str<<L"SnapshotIndexSize: " <<header.snapshotIndexSize<<endl;
+	str<<L"SnapshotDataSize: " <<header.snapshotDataSize<<endl;
 	return str;
 }
 